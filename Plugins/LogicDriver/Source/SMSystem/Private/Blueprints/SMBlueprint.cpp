@@ -14,6 +14,7 @@ USMBlueprint::USMBlueprint(const FObjectInitializer& ObjectInitializer)
 	BlueprintType = BPTYPE_Normal;
 #if WITH_EDITORONLY_DATA
 	BlueprintCategory = "State Machines";
+	InheritedGraphFingerprint = 0;
 #endif
 }
 
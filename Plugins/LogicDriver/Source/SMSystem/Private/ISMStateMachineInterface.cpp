@@ -55,4 +55,9 @@ bool ISMStateMachineNetworkedInterface::ShouldReplicateStates() const
 	return false;
 }
 
+int32 ISMStateMachineNetworkedInterface::GetReplicatedStatesBaselineInterval() const
+{
+	return 0;
+}
+
 #undef LOCTEXT_NAMESPACE
@@ -3,12 +3,183 @@
 #include "SMUtils.h"
 #include "SMLogging.h"
 #include "SMNodeInstance.h"
+#include "SMInstance.h"
 
 
+void FSMPackedTransactions::Add(const FSMPackedTransaction& Transaction)
+{
+	if (Transactions.Num() < MaxTransactions)
+	{
+		Transactions.SetNum(MaxTransactions);
+	}
+
+	if (Count == MaxTransactions)
+	{
+		// Drop the oldest.
+		Head = (Head + 1) % MaxTransactions;
+		Count--;
+	}
+
+	Transactions[(Head + Count) % MaxTransactions] = Transaction;
+	Count++;
+	Revision++;
+}
+
+void FSMPackedTransactions::AddOrFlush(const FSMPackedTransaction& Transaction, TFunctionRef<void(const FSMPackedTransactions&)> Flush)
+{
+	if (IsFull())
+	{
+		Flush(*this);
+		Empty();
+	}
+
+	Add(Transaction);
+}
+
+void FSMPackedTransactions::Append(const FSMPackedTransactions& Other)
+{
+	for (int32 Idx = 0; Idx < Other.Num(); ++Idx)
+	{
+		Add(Other[Idx]);
+	}
+}
+
+void FSMPackedTransactions::RemoveExpired(const FDateTime& CurrentTime, const FTimespan& Timeout)
+{
+	const int64 ExpiredTicks = (CurrentTime - Timeout).GetTicks();
+
+	int32 NumRemoved = 0;
+	while (Count > 0 && Transactions[Head].TimestampTicks <= ExpiredTicks)
+	{
+		Head = (Head + 1) % MaxTransactions;
+		Count--;
+		NumRemoved++;
+	}
+
+	if (NumRemoved > 0)
+	{
+		Revision++;
+	}
+}
+
+void FSMPackedTransactions::Empty()
+{
+	Head = Count = 0;
+	Revision++;
+}
+
+bool FSMPackedTransactions::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint32 NumTransactions = Count;
+	Ar.SerializeIntPacked(NumTransactions);
+
+	if (Ar.IsLoading())
+	{
+		if (NumTransactions > MaxTransactions)
+		{
+			bOutSuccess = false;
+			Ar.SetError();
+			return false;
+		}
+
+		Empty();
+		Transactions.SetNum(MaxTransactions);
+	}
+
+	if (NumTransactions == 0)
+	{
+		return true;
+	}
+
+	// Timestamps are sent in milliseconds relative to the oldest transaction.
+	int64 BaseTicks = Ar.IsSaving() ? (*this)[0].TimestampTicks : 0;
+	Ar << BaseTicks;
+
+	for (uint32 Idx = 0; Idx < NumTransactions; ++Idx)
+	{
+		FSMPackedTransaction& Transaction = Ar.IsSaving() ? Transactions[(Head + Idx) % MaxTransactions] : Transactions[Idx];
+
+		uint32 StateMachineIndex = Transaction.StateMachineIndex;
+		uint32 NodeIndex = Transaction.NodeIndex;
+		uint32 OffsetMs = (uint32)FMath::Max<int64>((Transaction.TimestampTicks - BaseTicks) / ETimespan::TicksPerMillisecond, 0);
+		uint8 Flags = (Transaction.bIsTransition ? 1 : 0) | (Transaction.bIsActive ? 2 : 0);
+
+		Ar.SerializeIntPacked(StateMachineIndex);
+		Ar.SerializeIntPacked(NodeIndex);
+		Ar << Transaction.TransactionId;
+		Ar.SerializeIntPacked(OffsetMs);
+		Ar.SerializeBits(&Flags, 2);
+
+		if (Ar.IsLoading())
+		{
+			Transaction.StateMachineIndex = StateMachineIndex;
+			Transaction.NodeIndex = NodeIndex;
+			Transaction.TimestampTicks = BaseTicks + (int64)OffsetMs * ETimespan::TicksPerMillisecond;
+			Transaction.bIsTransition = (Flags & 1) != 0;
+			Transaction.bIsActive = (Flags & 2) != 0;
+		}
+	}
+
+	if (Ar.IsLoading())
+	{
+		Count = NumTransactions;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+void FSMTransactionHistory::Add(uint32 TransactionId, const FDateTime& Time)
+{
+	if (Ids.Contains(TransactionId))
+	{
+		return;
+	}
+
+	if (Count == Entries.Num())
+	{
+		// Unwrap into a larger ring, starting at the replicated window size.
+		TArray<FEntry> GrownEntries;
+		GrownEntries.Reserve(FMath::Max(Count * 2, FSMPackedTransactions::MaxTransactions));
+		for (int32 Idx = 0; Idx < Count; ++Idx)
+		{
+			GrownEntries.Add(Entries[(Head + Idx) % Count]);
+		}
+		GrownEntries.SetNum(GrownEntries.Max());
+
+		Entries = MoveTemp(GrownEntries);
+		Head = 0;
+	}
+
+	FEntry& Entry = Entries[(Head + Count) % Entries.Num()];
+	Entry.TransactionId = TransactionId;
+	Entry.Time = Time;
+	Ids.Add(TransactionId);
+	Count++;
+}
+
+void FSMTransactionHistory::RemoveExpired(const FDateTime& CurrentTime, const FTimespan& Timeout)
+{
+	while (Count > 0 && Entries[Head].Time + Timeout <= CurrentTime)
+	{
+		Ids.Remove(Entries[Head].TransactionId);
+		Head = (Head + 1) % Entries.Num();
+		Count--;
+	}
+}
+
+void FSMTransactionHistory::Empty()
+{
+	Ids.Reset();
+	Head = Count = 0;
+}
+
 FSMNode_Base::FSMNode_Base() : TimeInState(0), bIsInEndState(false), bHasUpdated(false), DuplicateId(0),
 OwnerNode(nullptr),
 OwningInstance(nullptr), NodeInstance(nullptr), NodeInstanceClass(nullptr),
-bInitialized(false), bIsActive(false)
+bInitialized(false), bIsActive(false), bNodeInstanceDeferred(false)
 {
 	/*
 	 * Originally the Guid was initialized here. This caused warnings to show up during packaging because
@@ -32,6 +203,15 @@ void FSMNode_Base::Initialize(UObject* Instance)
 	{
 		FunctionHandler.Initialize(Instance);
 	}
+
+	// Deferred instances are created the first time the node is activated, its graphs run, or the instance is requested.
+	if (OwningInstance && OwningInstance->ShouldCreateNodeInstancesOnDemand())
+	{
+		NodeInstance = nullptr;
+		StackNodeInstances.Reset();
+		bNodeInstanceDeferred = true;
+		return;
+	}
 	
 	CreateNodeInstance();
 }
@@ -105,6 +285,10 @@ void FSMNode_Base::SetOwnerNode(FSMNode_Base* Owner)
 
 void FSMNode_Base::CreateNodeInstance()
 {
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMNode_Base::CreateNodeInstance"), STAT_SMNode_Base_CreateNodeInstance, STATGROUP_LogicDriver);
+
+	// Cleared first since construction scripts may request the instance.
+	bNodeInstanceDeferred = false;
 	GraphProperties.Reset();
 	
 	if (!NodeInstanceClass)
@@ -156,6 +340,32 @@ void FSMNode_Base::CreateStackInstances()
 	}
 }
 
+void FSMNode_Base::ResetRuntimeData()
+{
+	bIsActive = false;
+	TimeInState = 0.f;
+	bIsInEndState = false;
+	bHasUpdated = false;
+
+#if WITH_EDITORONLY_DATA
+	bWasActive = false;
+#endif
+
+	if (NodeInstance)
+	{
+		UObject* TemplateInstance = TemplateName != NAME_None && OwningInstance ? USMUtils::FindTemplateFromInstance(OwningInstance, TemplateName) : nullptr;
+		USMUtils::ResetObjectToArchetype(NodeInstance, TemplateInstance);
+	}
+
+	// Stack instances are only created for templates which could be found, so the names only line up when none were missing.
+	const bool bStackMatchesTemplates = StackNodeInstances.Num() == StackTemplateNames.Num();
+	for (int32 Idx = 0; Idx < StackNodeInstances.Num(); ++Idx)
+	{
+		UObject* TemplateInstance = bStackMatchesTemplates && OwningInstance ? USMUtils::FindTemplateFromInstance(OwningInstance, StackTemplateNames[Idx]) : nullptr;
+		USMUtils::ResetObjectToArchetype(StackNodeInstances[Idx], TemplateInstance);
+	}
+}
+
 void FSMNode_Base::SetNodeInstanceClass(UClass* NewNodeInstanceClass)
 {
 	if (NewNodeInstanceClass && !IsNodeInstanceClassCompatible(NewNodeInstanceClass))
@@ -174,8 +384,28 @@ bool FSMNode_Base::IsNodeInstanceClassCompatible(UClass* NewNodeInstanceClass) c
 	return false;
 }
 
+const USMNodeInstance* FSMNode_Base::GetNodeInstanceDefaults() const
+{
+	if (NodeInstance || !bNodeInstanceDeferred)
+	{
+		return NodeInstance;
+	}
+
+	if (TemplateName != NAME_None && OwningInstance)
+	{
+		if (const USMNodeInstance* Template = Cast<USMNodeInstance>(USMUtils::FindTemplateFromInstance(OwningInstance, TemplateName)))
+		{
+			return Template;
+		}
+	}
+
+	UClass* DefaultsClass = NodeInstanceClass ? NodeInstanceClass : GetDefaultNodeInstanceClass();
+	return DefaultsClass ? DefaultsClass->GetDefaultObject<USMNodeInstance>() : nullptr;
+}
+
 USMNodeInstance* FSMNode_Base::GetNodeInStack(int32 Index) const
 {
+	EnsureNodeInstance();
 	if (Index >= 0 && Index < StackNodeInstances.Num())
 	{
 		return StackNodeInstances[Index];
@@ -206,11 +436,13 @@ void FSMNode_Base::AddStackTemplateName(const FName& Name)
 
 void FSMNode_Base::ExecuteInitializeNodes()
 {
+	EnsureNodeInstance();
 	USMUtils::ExecuteGraphFunctions(TransitionInitializedGraphEvaluators);
 }
 
 void FSMNode_Base::ExecuteShutdownNodes()
 {
+	EnsureNodeInstance();
 	USMUtils::ExecuteGraphFunctions(TransitionShutdownGraphEvaluators);
 }
 
@@ -221,6 +453,9 @@ void FSMNode_Base::Execute()
 		return;
 	}
 
+	// Compiled graphs read the node instance directly.
+	EnsureNodeInstance();
+
 	UpdateReadStates();
 
 	GraphEvaluator.Execute();
@@ -232,11 +467,19 @@ void FSMNode_Base::SetActive(bool bValue)
 	bWasActive = bIsActive;
 #endif
 	bIsActive = bValue;
+
+	if (bIsActive)
+	{
+		EnsureNodeInstance();
+	}
 }
 
 void FSMNode_Base::ExecuteGraphProperties(bool bVariablesOnly)
 {
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMNode_Base::ExecuteGraphProperties"), STAT_SMNode_Base_ExecuteGraphProperties, STATGROUP_LogicDriver);
+
+	// Graph properties are gathered from the node instance when it's created.
+	EnsureNodeInstance();
 	
 	for (FSMGraphProperty_Base_Runtime& GraphProperty : VariableGraphProperties)
 	{
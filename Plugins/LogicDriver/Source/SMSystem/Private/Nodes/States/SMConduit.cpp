@@ -3,6 +3,7 @@
 #include "SMConduit.h"
 #include "SMConduitInstance.h"
 #include "SMUtils.h"
+#include "SMProfiler.h"
 
 FSMConduit::FSMConduit() : Super(), bCanEnterTransition(false), bCanEvaluate(true), bEvalWithTransitions(false),
                            bIsEvaluating(false), bCheckedForTransitions(false)
@@ -82,7 +83,10 @@ bool FSMConduit::GetValidTransition(TArray<TArray<FSMTransition*>>& Transitions)
 #endif
 	
 	// First check that the conduit passes.
-	Execute();
+	{
+		SM_TRACE_SCOPE_RESULT(this, ESMTraceEventType::TransitionEvaluated, &bCanEnterTransition);
+		Execute();
+	}
 
 	bIsEvaluating = false;
 	
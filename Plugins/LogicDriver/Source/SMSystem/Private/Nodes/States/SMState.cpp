@@ -6,6 +6,7 @@
 #include "SMStateInstance.h"
 #include "SMUtils.h"
 #include "SMLogging.h"
+#include "SMProfiler.h"
 
 void FSMState_Base::UpdateReadStates()
 {
@@ -56,6 +57,15 @@ void FSMState_Base::Reset()
 	ResetReadStates();
 }
 
+void FSMState_Base::ResetRuntimeData()
+{
+	Super::ResetRuntimeData();
+	ResetReadStates();
+	PreviousEnteredState = nullptr;
+	bReenteredByParallelState = false;
+	NextTransition = nullptr;
+}
+
 bool FSMState_Base::IsNodeInstanceClassCompatible(UClass* NewNodeInstanceClass) const
 {
 	return NewNodeInstanceClass && NewNodeInstanceClass->IsChildOf<USMStateInstance>();
@@ -182,7 +192,12 @@ void FSMState_Base::OnStartedByInstance(USMInstance* Instance)
 		{
 			ExecuteGraphProperties();
 		}
-		OnRootStateMachineStartedGraphEvaluator.Execute();
+
+		if (OnRootStateMachineStartedGraphEvaluator.IsBound())
+		{
+			EnsureNodeInstance();
+			OnRootStateMachineStartedGraphEvaluator.Execute();
+		}
 	}
 }
 
@@ -196,7 +211,12 @@ void FSMState_Base::OnStoppedByInstance(USMInstance* Instance)
 		{
 			ExecuteGraphProperties();
 		}
-		OnRootStateMachineStoppedGraphEvaluator.Execute();
+
+		if (OnRootStateMachineStoppedGraphEvaluator.IsBound())
+		{
+			EnsureNodeInstance();
+			OnRootStateMachineStoppedGraphEvaluator.Execute();
+		}
 	}
 }
 
@@ -253,7 +273,8 @@ void FSMState_Base::SetCanExecuteLogic(bool bValue)
 
 bool FSMState_Base::CanExecuteGraphProperties(uint32 OnEvent) const
 {
-	if (USMStateInstance_Base* StateInstance = Cast<USMStateInstance_Base>(GetNodeInstance()))
+	// Defaults so every state of an instance creating node instances on demand isn't instantiated on root start and stop.
+	if (const USMStateInstance_Base* StateInstance = Cast<USMStateInstance_Base>(GetNodeInstanceDefaults()))
 	{
 		if (!StateInstance->bAutoEvalExposedProperties)
 		{
@@ -396,6 +417,8 @@ void FSMState::ExecuteShutdownNodes()
 
 bool FSMState::StartState()
 {
+	SM_TRACE_SCOPE(this, ESMTraceEventType::StateBegin);
+
 	if(!Super::StartState())
 	{
 		return false;
@@ -419,6 +442,8 @@ bool FSMState::StartState()
 
 bool FSMState::UpdateState(float DeltaSeconds)
 {
+	SM_TRACE_SCOPE(this, ESMTraceEventType::StateUpdate);
+
 	if (!Super::UpdateState(DeltaSeconds))
 	{
 		return false;
@@ -442,6 +467,8 @@ bool FSMState::UpdateState(float DeltaSeconds)
 
 bool FSMState::EndState(float DeltaSeconds, const FSMTransition* TransitionToTake)
 {
+	SM_TRACE_SCOPE(this, ESMTraceEventType::StateEnd);
+
 	if (!Super::EndState(DeltaSeconds, TransitionToTake))
 	{
 		return false;
@@ -467,6 +494,13 @@ bool FSMState::EndState(float DeltaSeconds, const FSMTransition* TransitionToTak
 void FSMState::OnStartedByInstance(USMInstance* Instance)
 {
 	Super::OnStartedByInstance(Instance);
+
+	// Stack instances are notified directly so they must exist.
+	if (StackTemplateNames.Num() > 0)
+	{
+		EnsureNodeInstance();
+	}
+	
 	for (USMNodeInstance* StackInstance : StackNodeInstances)
 	{
 		if (USMStateInstance* StateInstance = Cast<USMStateInstance>(StackInstance))
@@ -479,6 +513,13 @@ void FSMState::OnStartedByInstance(USMInstance* Instance)
 void FSMState::OnStoppedByInstance(USMInstance* Instance)
 {
 	Super::OnStoppedByInstance(Instance);
+
+	// Stack instances are notified directly so they must exist.
+	if (StackTemplateNames.Num() > 0)
+	{
+		EnsureNodeInstance();
+	}
+	
 	for (USMNodeInstance* StackInstance : StackNodeInstances)
 	{
 		if (USMStateInstance* StateInstance = Cast<USMStateInstance>(StackInstance))
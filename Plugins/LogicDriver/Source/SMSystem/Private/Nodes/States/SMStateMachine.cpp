@@ -2,6 +2,7 @@
 #include "SMStateMachine.h"
 #include "SMInstance.h"
 #include "SMLogging.h"
+#include "SMProfiler.h"
 #include "SMUtils.h"
 #include "SMStateMachineInstance.h"
 
@@ -180,7 +181,7 @@ bool FSMStateMachine::ProcessTransition(FSMTransition* Transition, const FSMNetw
 	// If the client is continuing execution while the server is processing this can prevent a double fire.
 	if (bServerUpdate)
 	{
-		if (!ensureAlwaysMsgf(Transaction->IsTransition(), TEXT("Attempted to process a state network transaction when it was expecting a transition network transaction.")) || PreviousTransactions.Contains(Transaction->TransactionGuid))
+		if (!ensureAlwaysMsgf(Transaction->IsTransition(), TEXT("Attempted to process a state network transaction when it was expecting a transition network transaction.")) || PreviousTransactions.Contains(Transaction->GetTransactionId()))
 		{
 			return false;
 		}
@@ -229,7 +230,7 @@ bool FSMStateMachine::ProcessTransition(FSMTransition* Transition, const FSMNetw
 		// Don't follow this transition a second time.
 		if (bCanTransitionNow)
 		{
-			PreviousTransactions.Add(NewTransition.TransactionGuid, NewTransition);
+			PreviousTransactions.Add(NewTransition.GetTransactionId(), NewTransition.Timestamp);
 		}
 		else
 		{
@@ -241,8 +242,8 @@ bool FSMStateMachine::ProcessTransition(FSMTransition* Transition, const FSMNetw
 	}
 	else if (bServerUpdate && Transaction)
 	{
-		// Don't record a server transition more than once either.
-		PreviousTransactions.Add(Transaction->TransactionGuid, *Transaction);
+		// Don't record a server transition more than once either. Recorded with local time so the history stays in time order.
+		PreviousTransactions.Add(Transaction->GetTransactionId(), CurrentTime ? *CurrentTime : FDateTime::UtcNow());
 	}
 
 	return bCanTransitionNow;
@@ -251,24 +252,7 @@ bool FSMStateMachine::ProcessTransition(FSMTransition* Transition, const FSMNetw
 void FSMStateMachine::CleanupPreviousTransactions(const FDateTime& CurrentTime, float PreviousTransactionTimeout)
 {
 	// Check for and remove expired transactions.
-	if (PreviousTransactions.Num())
-	{
-		TArray<FGuid> TransactionsToRemove;
-		const FTimespan Seconds = FTimespan::FromSeconds((double)PreviousTransactionTimeout);
-		for (const auto& PreviousTransaction : PreviousTransactions)
-		{
-			FDateTime ExpirationDate = PreviousTransaction.Value.Timestamp + Seconds;
-			if (ExpirationDate <= CurrentTime)
-			{
-				TransactionsToRemove.Add(PreviousTransaction.Key);
-			}
-		}
-
-		for (const FGuid& Id : TransactionsToRemove)
-		{
-			PreviousTransactions.Remove(Id);
-		}
-	}
+	PreviousTransactions.RemoveExpired(CurrentTime, FTimespan::FromSeconds((double)PreviousTransactionTimeout));
 }
 
 void FSMStateMachine::SetReuseCurrentState(bool bValue, bool bOnlyWhenNotInEndState)
@@ -337,7 +321,7 @@ void FSMStateMachine::AddActiveState(FSMState_Base* State, bool bReplicate)
 void FSMStateMachine::RemoveActiveState(FSMState_Base* State, bool bReplicate)
 {
 	State->EndState(0.f);
-	ActiveStates.Remove(State);
+	RemoveFromActiveStates(State);
 
 	if (USMInstance* Instance = GetOwningInstance())
 	{
@@ -363,7 +347,7 @@ void FSMStateMachine::SetCurrentState(FSMState_Base* ToState, FSMState_Base* Fro
 	
 	if (FromState && !FromState->bStayActiveOnStateChange)
 	{
-		ActiveStates.Remove(FromState);
+		RemoveFromActiveStates(FromState);
 	}
 
 	if (ToState)
@@ -376,7 +360,7 @@ void FSMStateMachine::SetCurrentState(FSMState_Base* ToState, FSMState_Base* Fro
 		}
 		else
 		{
-			ActiveStates.Add(ToState);
+			AddToActiveStates(ToState);
 		}
 	}
 
@@ -400,6 +384,29 @@ void FSMStateMachine::SetCurrentState(FSMState_Base* ToState, FSMState_Base* Fro
 	}
 }
 
+void FSMStateMachine::AddToActiveStates(FSMState_Base* State)
+{
+	ActiveStates.Add(State);
+
+	for (USMInstance* Instance = GetOwningInstance(); Instance; Instance = Instance->GetRootStateMachine().GetReferencedByInstance())
+	{
+		Instance->AddToActiveStateList(State);
+	}
+}
+
+void FSMStateMachine::RemoveFromActiveStates(FSMState_Base* State)
+{
+	if (ActiveStates.Remove(State) == 0)
+	{
+		return;
+	}
+
+	for (USMInstance* Instance = GetOwningInstance(); Instance; Instance = Instance->GetRootStateMachine().GetReferencedByInstance())
+	{
+		Instance->RemoveFromActiveStateList(State);
+	}
+}
+
 void FSMStateMachine::Initialize(UObject* Instance)
 {
 	Super::Initialize(Instance);
@@ -427,8 +434,24 @@ void FSMStateMachine::Reset()
 	EndStateGraphEvaluator.Reset();
 }
 
+void FSMStateMachine::ResetRuntimeData()
+{
+	Super::ResetRuntimeData();
+	for (FSMState_Base* State : ActiveStates.Array())
+	{
+		RemoveFromActiveStates(State);
+	}
+	ActiveStates.Empty();
+	ProcessingStates.Empty();
+	ClearTemporaryInitialStates();
+	PreviousTransactions.Empty();
+	bWaitingForTransitionUpdate = false;
+}
+
 bool FSMStateMachine::StartState()
 {
+	SM_TRACE_SCOPE(this, ESMTraceEventType::StateBegin);
+
 	if (!Super::StartState())
 	{
 		return false;
@@ -478,6 +501,8 @@ bool FSMStateMachine::StartState()
 
 bool FSMStateMachine::UpdateState(float DeltaSeconds)
 {
+	SM_TRACE_SCOPE(this, ESMTraceEventType::StateUpdate);
+
 	if (!Super::UpdateState(DeltaSeconds))
 	{
 		return false;
@@ -526,6 +551,8 @@ bool FSMStateMachine::UpdateState(float DeltaSeconds)
 
 bool FSMStateMachine::EndState(float DeltaSeconds, const FSMTransition* TransitionToTake)
 {
+	SM_TRACE_SCOPE(this, ESMTraceEventType::StateEnd);
+
 	if (!Super::EndState(DeltaSeconds, TransitionToTake))
 	{
 		return false;
@@ -876,6 +903,16 @@ USMNodeInstance* FSMStateMachine::GetNodeInstance() const
 	return Super::GetNodeInstance();
 }
 
+const USMNodeInstance* FSMStateMachine::GetNodeInstanceDefaults() const
+{
+	if (ReferencedStateMachine)
+	{
+		return ReferencedStateMachine->GetRootStateMachine().GetNodeInstanceDefaults();
+	}
+
+	return Super::GetNodeInstanceDefaults();
+}
+
 UClass* FSMStateMachine::GetDefaultNodeInstanceClass() const
 {
 	return USMStateMachineInstance::StaticClass();
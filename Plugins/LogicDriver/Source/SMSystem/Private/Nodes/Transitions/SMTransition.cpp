@@ -6,6 +6,7 @@
 #include "SMTransitionInstance.h"
 #include "SMLogging.h"
 #include "SMUtils.h"
+#include "SMProfiler.h"
 
 struct TransitionEvaluatorHelper
 {
@@ -102,6 +103,8 @@ void FSMTransition::ExecuteShutdownNodes()
 
 void FSMTransition::TakeTransition()
 {
+	SM_TRACE_SCOPE(this, ESMTraceEventType::TransitionTaken);
+
 	SetActive(true);
 
 	if (USMTransitionInstance* TransitionInstance = Cast<USMTransitionInstance>(NodeInstance))
@@ -128,6 +131,8 @@ bool FSMTransition::DoesTransitionPass()
 		return false;
 	}
 	
+	// Declared before the evaluator so the post evaluate graph is included in the timing.
+	SM_TRACE_SCOPE_RESULT(this, ESMTraceEventType::TransitionEvaluated, &bCanEnterTransition);
 	TransitionEvaluatorHelper Evaluator(this);	// Sets bIsEvaluating = false on destruct.
 
 	if (CanEvaluateFromEvent() && bCanEnterTransitionFromEvent)
@@ -0,0 +1,105 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+
+#include "SMDormancyManager.h"
+#include "SMInstance.h"
+#include "SMLogging.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dormant Instances"), STAT_SMDormantInstances, STATGROUP_LogicDriver);
+
+static FSMDormancyManager* GlobalDormancyManager = nullptr;
+
+FSMDormancyManager::FSMDormancyManager() : FTickableGameObject(), LastTickFrame(MAX_uint64)
+{
+}
+
+FSMDormancyManager& FSMDormancyManager::Get()
+{
+	if (!GlobalDormancyManager)
+	{
+		GlobalDormancyManager = new FSMDormancyManager();
+	}
+
+	return *GlobalDormancyManager;
+}
+
+void FSMDormancyManager::Shutdown()
+{
+	if (GlobalDormancyManager)
+	{
+		while (UObjectInitialized() && GlobalDormancyManager->DormantInstances.Num() > 0)
+		{
+			GlobalDormancyManager->DormantInstances.Last()->WakeUp();
+		}
+
+		delete GlobalDormancyManager;
+		GlobalDormancyManager = nullptr;
+	}
+}
+
+void FSMDormancyManager::AddInstance(USMInstance* Instance)
+{
+	check(Instance);
+	if (Instance->DormantIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	Instance->DormantIndex = DormantInstances.Add(Instance);
+	SET_DWORD_STAT(STAT_SMDormantInstances, DormantInstances.Num());
+}
+
+void FSMDormancyManager::RemoveInstance(USMInstance* Instance)
+{
+	check(Instance);
+	const int32 RemovedIndex = Instance->DormantIndex;
+	if (!DormantInstances.IsValidIndex(RemovedIndex) || DormantInstances[RemovedIndex] != Instance)
+	{
+		return;
+	}
+
+	Instance->DormantIndex = INDEX_NONE;
+	DormantInstances.RemoveAtSwap(RemovedIndex, 1, false);
+
+	// Fix up the index of the instance swapped into the removed slot.
+	if (DormantInstances.IsValidIndex(RemovedIndex))
+	{
+		DormantInstances[RemovedIndex]->DormantIndex = RemovedIndex;
+	}
+
+	SET_DWORD_STAT(STAT_SMDormantInstances, DormantInstances.Num());
+}
+
+void FSMDormancyManager::TickDormantInstances(float DeltaTime)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMDormancyManager::TickDormantInstances"), STAT_SMDormancyManager_Tick, STATGROUP_LogicDriver);
+
+	// Backwards so instances woken and swap removed have already been visited.
+	for (int32 Idx = DormantInstances.Num() - 1; Idx >= 0; --Idx)
+	{
+		if (DormantInstances.IsValidIndex(Idx))
+		{
+			DormantInstances[Idx]->UpdateDormant(DeltaTime);
+		}
+	}
+}
+
+void FSMDormancyManager::Tick(float DeltaTime)
+{
+	if (LastTickFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	LastTickFrame = GFrameCounter;
+	TickDormantInstances(DeltaTime);
+}
+
+bool FSMDormancyManager::IsTickable() const
+{
+	return DormantInstances.Num() > 0;
+}
+
+TStatId FSMDormancyManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FSMDormancyManager, STATGROUP_Tickables);
+}
@@ -6,9 +6,94 @@
 #include "SMLogging.h"
 #include "SMUtils.h"
 #include "SMStateMachineComponent.h"
+#include "SMDormancyManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
 
 #define LOCTEXT_NAMESPACE "SMInstance"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replicated State Changes"), STAT_SMReplicatedStateChanges, STATGROUP_LogicDriver);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Awake Instances"), STAT_SMAwakeInstances, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dormant Wakes"), STAT_SMDormantWakes, STATGROUP_LogicDriver);
+
+bool FSMReplicatedActiveState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PackedIndex = StateIndex;
+	Ar.SerializeIntPacked(PackedIndex);
+	StateIndex = PackedIndex;
+
+	bOutSuccess = true;
+	return true;
+}
+
+int32 FSMReplicatedActiveStates::Update(const TArray<int32>& ActiveStateIndices, int32 BaselineInterval)
+{
+	const TSet<int32> ActiveStateSet(ActiveStateIndices);
+	TSet<int32> ReplicatedStateSet;
+	ReplicatedStateSet.Reserve(Items.Num());
+
+	int32 NumRemoved = 0;
+	for (int32 ItemIdx = Items.Num() - 1; ItemIdx >= 0; --ItemIdx)
+	{
+		if (!ActiveStateSet.Contains(Items[ItemIdx].StateIndex))
+		{
+			Items.RemoveAtSwap(ItemIdx, 1, false);
+			NumRemoved++;
+		}
+		else
+		{
+			ReplicatedStateSet.Add(Items[ItemIdx].StateIndex);
+		}
+	}
+
+	if (NumRemoved > 0)
+	{
+		MarkArrayDirty();
+	}
+
+	int32 NumAdded = 0;
+	for (int32 StateIndex : ActiveStateIndices)
+	{
+		bool bAlreadyReplicated = false;
+		ReplicatedStateSet.Add(StateIndex, &bAlreadyReplicated);
+		if (!bAlreadyReplicated)
+		{
+			MarkItemDirty(Items.Add_GetRef(FSMReplicatedActiveState(StateIndex)));
+			NumAdded++;
+		}
+	}
+
+	const int32 NumChanged = NumRemoved + NumAdded;
+	if (NumChanged > 0 && BaselineInterval > 0 && ++ChangesSinceBaseline >= BaselineInterval)
+	{
+		// Send every state again so clients which changed their states another way are brought back in line.
+		for (FSMReplicatedActiveState& Item : Items)
+		{
+			MarkItemDirty(Item);
+		}
+		ChangesSinceBaseline = 0;
+	}
+
+	return NumChanged;
+}
+
+void FSMReplicatedActiveStates::Reset()
+{
+	Items.Reset();
+	ChangesSinceBaseline = 0;
+	MarkArrayDirty();
+}
+
+void FSMReplicatedActiveStates::GetStateIndices(TArray<int32>& OutStateIndices) const
+{
+	OutStateIndices.Reset(Items.Num());
+	for (const FSMReplicatedActiveState& Item : Items)
+	{
+		OutStateIndices.Add(Item.StateIndex);
+	}
+}
+
 // Execute the function on the top most reference owner.
 #define EXECUTE_ON_MASTER(function) \
 		if (const USMInstance* Master = GetMasterReferenceOwnerConst()) \
@@ -25,6 +110,17 @@ USMInstance::USMInstance() : Super()
 	bCanEvaluateTransitionsLocally = true;
 	bCanTakeTransitionsLocally = true;
 	bCanExecuteStateLogic = true;
+	StateLayoutHash = 0;
+	InstanceTemplate = nullptr;
+	bIsPooled = false;
+	WakeTimeRemaining = -1.f;
+	DormantIndex = INDEX_NONE;
+	IdleUpdates = 0;
+	DormantWakeFrame = MAX_uint64;
+	DormantSleepFrame = MAX_uint64;
+	bIsDormant = false;
+	bHadActivityThisUpdate = false;
+	bCountedAwake = false;
 }
 
 bool USMInstance::IsTickable() const
@@ -32,7 +128,7 @@ bool USMInstance::IsTickable() const
 	// Don't check CDO.
 	// On IsPendingKillOrUnreachable can cause tick lookup function to crash debug / package builds.
 	// Intermittently IsTemplate may fail in this scenario so it should be checked last.
-	if (IsPendingKillOrUnreachable() || (!IsInitialized() && !bTickBeforeInitialize) || !CanEverTick() || IsTemplate())
+	if (IsPendingKillOrUnreachable() || (!IsInitialized() && !bTickBeforeInitialize) || !CanEverTick() || bIsPooled || bIsDormant || IsTemplate())
 	{
 		return false;
 	}
@@ -80,6 +176,7 @@ void USMInstance::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifet
 void USMInstance::BeginDestroy()
 {
 	Shutdown();
+	WakeUp();
 	Super::BeginDestroy();
 }
 
@@ -156,6 +253,7 @@ void USMInstance::Start()
 	DoStart();
 
 	R_bHasStarted = true;
+	UpdateDormancyStats();
 }
 
 void USMInstance::Update(float DeltaSeconds)
@@ -165,6 +263,9 @@ void USMInstance::Update(float DeltaSeconds)
 		return;
 	}
 
+	// A manual update always wakes the instance.
+	WakeUp();
+
 	if (!RootStateMachine.IsActive())
 	{
 		return;
@@ -194,6 +295,22 @@ void USMInstance::Update(float DeltaSeconds)
 
 	Internal_Update(DeltaSeconds);
 
+	if (WakeTimeRemaining > 0.f)
+	{
+		WakeTimeRemaining -= DeltaSeconds;
+	}
+
+	// References are updated by their owner and networked instances are driven by the server.
+	if (bCanGoDormant && !ReferenceOwner && !ServerStateMachine.GetObject() && RootStateMachine.IsActive())
+	{
+		IdleUpdates = bHadActivityThisUpdate ? 0 : IdleUpdates + 1;
+		if (IdleUpdates >= IdleUpdatesBeforeDormant)
+		{
+			GoDormant();
+		}
+	}
+	bHadActivityThisUpdate = false;
+
 	// End update.
 	bIsUpdating = false;
 }
@@ -232,6 +349,11 @@ void USMInstance::Internal_Update(float DeltaSeconds)
 
 void USMInstance::Internal_EventCleanup(const FGuid& NodeGuid)
 {
+	// The event may allow a transition, the owner has to be awake to take it.
+	USMInstance* MasterInstance = GetMasterReferenceOwner();
+	MasterInstance->bHadActivityThisUpdate = true;
+	MasterInstance->WakeUp();
+	
 	if (FSMTransition* Transition = GetTransitionByGuid(NodeGuid))
 	{
 		// Auto-bound events will set bIsEvaluating to true primarily for debugging. However if two events fire at the exact same time
@@ -254,6 +376,8 @@ void USMInstance::Stop()
 	}
 
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::Stop"), STAT_SMInstance_Stop, STATGROUP_LogicDriver);
+
+	WakeUp();
 	
 	RootStateMachine.EndState(0.f);
 
@@ -268,6 +392,7 @@ void USMInstance::Stop()
 
 	ReplicateStates();
 	R_bHasStarted = false;
+	UpdateDormancyStats();
 }
 
 void USMInstance::Shutdown()
@@ -293,6 +418,12 @@ void USMInstance::Shutdown()
 	GuidNodeMap.Empty();
 	GuidStateMap.Empty();
 	GuidTransitionMap.Empty();
+	IndexedStates.Empty();
+	StateIndexMap.Empty();
+	IndexedTransitions.Empty();
+	TransitionIndexMap.Empty();
+	StateLayoutHash = 0;
+	PendingSnapshotTimes.Empty();
 
 	bInitialized = false;
 }
@@ -303,12 +434,246 @@ void USMInstance::StartWithNewContext(UObject* Context)
 	Start();
 }
 
+bool USMInstance::ResetToInitialState()
+{
+	if (!CheckIsInitialized())
+	{
+		return false;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::ResetToInitialState"), STAT_SMInstance_ResetToInitialState, STATGROUP_LogicDriver);
+
+	if (IsActive())
+	{
+		Stop();
+	}
+
+	// Includes the nodes of all references.
+	RootStateMachine.ResetRuntimeData();
+	for (FSMNode_Base* Node : RootStateMachine.GetAllNodes(true))
+	{
+		Node->ResetRuntimeData();
+	}
+
+	TArray<USMInstance*> Instances = GetAllReferencedInstances(true);
+	Instances.Insert(this, 0);
+
+	for (USMInstance* Instance : Instances)
+	{
+		USMUtils::ResetObjectToArchetype(Instance, Instance->InstanceTemplate);
+
+		Instance->OnStateMachineInitializedEvent.Clear();
+		Instance->OnStateMachineStartedEvent.Clear();
+		Instance->OnStateMachineUpdatedEvent.Clear();
+		Instance->OnStateMachineStoppedEvent.Clear();
+		Instance->OnStateMachineTransitionTakenEvent.Clear();
+		Instance->OnStateMachineStateChangedEvent.Clear();
+
+		Instance->R_ActiveStates.Reset();
+		Instance->ActiveTransactions.Reset();
+		Instance->PendingSnapshotTimes.Reset();
+		Instance->R_bHasStarted = false;
+		Instance->TimeSinceAllowedTick = 0.f;
+		Instance->WatchedProperties.Reset();
+		Instance->WakeTimeRemaining = -1.f;
+		Instance->IdleUpdates = 0;
+	}
+
+	return true;
+}
+
+void USMInstance::GoDormant()
+{
+	// References are updated by their owner and networked instances are driven by the server.
+	if (bIsDormant || ReferenceOwner || ServerStateMachine.GetObject() || !IsActive())
+	{
+		return;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::GoDormant"), STAT_SMInstance_GoDormant, STATGROUP_LogicDriver);
+
+	for (FSMWatchedProperty& WatchedProperty : WatchedProperties)
+	{
+		WatchedProperty.Capture();
+	}
+
+	bIsDormant = true;
+	IdleUpdates = 0;
+	DormantSleepFrame = bIsUpdating ? GFrameCounter : MAX_uint64;
+	FSMDormancyManager::Get().AddInstance(this);
+	UpdateDormancyStats();
+}
+
+void USMInstance::WakeUp()
+{
+	if (!bIsDormant)
+	{
+		return;
+	}
+
+	bIsDormant = false;
+	IdleUpdates = 0;
+	FSMDormancyManager::Get().RemoveInstance(this);
+
+	INC_DWORD_STAT(STAT_SMDormantWakes);
+	UpdateDormancyStats();
+}
+
+void USMInstance::SetCanGoDormant(bool bValue)
+{
+	bCanGoDormant = bValue;
+	if (!bCanGoDormant)
+	{
+		WakeUp();
+	}
+}
+
+bool USMInstance::AddWatchedProperty(UObject* Object, FName PropertyName)
+{
+	if (!Object)
+	{
+		return false;
+	}
+
+	FProperty* Property = Object->GetClass()->FindPropertyByName(PropertyName);
+	if (!Property)
+	{
+		LD_LOG_WARNING(TEXT("Could not watch property %s on %s for state machine %s. The property does not exist."), *PropertyName.ToString(), *Object->GetName(), *GetName());
+		return false;
+	}
+
+	for (const FSMWatchedProperty& WatchedProperty : WatchedProperties)
+	{
+		if (WatchedProperty.Matches(Object, PropertyName))
+		{
+			return true;
+		}
+	}
+
+	FSMWatchedProperty& WatchedProperty = WatchedProperties.Add_GetRef(FSMWatchedProperty(Object, Property));
+	WatchedProperty.Capture();
+	return true;
+}
+
+void USMInstance::RemoveWatchedProperty(UObject* Object, FName PropertyName)
+{
+	WatchedProperties.RemoveAll([&](const FSMWatchedProperty& WatchedProperty)
+	{
+		return WatchedProperty.Matches(Object, PropertyName);
+	});
+}
+
+void USMInstance::ClearWatchedProperties()
+{
+	WatchedProperties.Reset();
+}
+
+void USMInstance::SetWakeTimer(float Seconds)
+{
+	WakeTimeRemaining = Seconds > 0.f ? Seconds : -1.f;
+}
+
+bool USMInstance::UpdateDormant(float DeltaSeconds)
+{
+	if (!bIsDormant)
+	{
+		return false;
+	}
+
+	// Accumulate like a skipped tick so the first update after waking receives the full time.
+	// Instances ticked before the manager, such as by a component, may have gone to sleep after already consuming this frame.
+	if (DormantSleepFrame != GFrameCounter)
+	{
+		TimeSinceAllowedTick += DeltaSeconds;
+	}
+	DormantSleepFrame = MAX_uint64;
+
+	bool bWake = false;
+	if (WakeTimeRemaining > 0.f)
+	{
+		WakeTimeRemaining -= DeltaSeconds;
+		bWake = WakeTimeRemaining <= 0.f;
+	}
+
+	for (int32 Idx = 0; !bWake && Idx < WatchedProperties.Num(); ++Idx)
+	{
+		bWake = WatchedProperties[Idx].HasChanged();
+	}
+
+	if (bWake)
+	{
+		WakeUp();
+		DormantWakeFrame = GFrameCounter;
+	}
+
+	return bWake;
+}
+
+void USMInstance::UpdateDormancyStats()
+{
+	const bool bAwake = !ReferenceOwner && !bIsDormant && RootStateMachine.IsActive();
+	if (bAwake != bCountedAwake)
+	{
+		bCountedAwake = bAwake;
+		if (bAwake)
+		{
+			INC_DWORD_STAT(STAT_SMAwakeInstances);
+		}
+		else
+		{
+			DEC_DWORD_STAT(STAT_SMAwakeInstances);
+		}
+	}
+}
+
+void FSMWatchedProperty::Capture()
+{
+	ReadValue(ValueHash, ValueText);
+}
+
+bool FSMWatchedProperty::HasChanged() const
+{
+	uint32 CurrentHash;
+	FString CurrentText;
+	if (!ReadValue(CurrentHash, CurrentText))
+	{
+		return true;
+	}
+
+	return CurrentHash != ValueHash || CurrentText != ValueText;
+}
+
+bool FSMWatchedProperty::ReadValue(uint32& OutHash, FString& OutText) const
+{
+	OutHash = 0;
+	OutText.Reset();
+
+	UObject* WatchedObject = Object.Get();
+	if (!WatchedObject || !Property)
+	{
+		return false;
+	}
+
+	const void* Value = Property->ContainerPtrToValuePtr<void>(WatchedObject);
+	if (Property->HasAllPropertyFlags(CPF_HasGetValueTypeHash))
+	{
+		OutHash = Property->GetValueTypeHash(Value);
+	}
+	else
+	{
+		Property->ExportTextItem(OutText, Value, nullptr, nullptr, PPF_None);
+	}
+
+	return true;
+}
+
 void USMInstance::EvaluateTransitions()
 {
 	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::EvaluateTransitions"), STAT_SMInstance_EvaluateTransitions, STATGROUP_LogicDriver);
 	
 	USMInstance* StateMachineInstance = GetMasterReferenceOwner();
 	check(StateMachineInstance);
+	StateMachineInstance->WakeUp();
 	StateMachineInstance->GetRootStateMachine().ProcessStates(0.f, true);
 }
 
@@ -347,6 +712,254 @@ void USMInstance::LoadFromMultipleStates(const TArray<FGuid>& FromGuids)
 	}
 }
 
+bool USMInstance::SaveSnapshot(TArray<uint8>& OutSnapshot, bool bIncludeNodeInstanceProperties) const
+{
+	OutSnapshot.Reset();
+	FMemoryWriter Writer(OutSnapshot);
+	return WriteSnapshot(Writer, bIncludeNodeInstanceProperties);
+}
+
+bool USMInstance::LoadFromSnapshot(const TArray<uint8>& Snapshot)
+{
+	FMemoryReader Reader(Snapshot);
+	return ReadSnapshot(Reader);
+}
+
+/** Identifies a state machine snapshot. */
+static const uint32 SnapshotMagic = 0x5353444C; // LDSS
+
+/** Increment when the snapshot layout changes. */
+static const uint8 SnapshotVersion = 1;
+
+/** Whether the class has any properties the user opted in to saving. */
+static bool HasSaveGameProperties(UClass* Class)
+{
+	for (TFieldIterator<FProperty> It(Class); It; ++It)
+	{
+		if (It->HasAnyPropertyFlags(CPF_SaveGame))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool USMInstance::WriteSnapshot(FArchive& Ar, bool bIncludeNodeInstanceProperties) const
+{
+	check(Ar.IsSaving());
+
+	if (!CheckIsInitialized())
+	{
+		return false;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::WriteSnapshot"), STAT_SMInstance_WriteSnapshot, STATGROUP_LogicDriver);
+
+	uint32 Magic = SnapshotMagic;
+	uint8 Version = SnapshotVersion;
+	uint32 NumStates = IndexedStates.Num();
+	uint32 LayoutHash = StateLayoutHash;
+	uint8 bHasNodeInstanceProperties = bIncludeNodeInstanceProperties ? 1 : 0;
+
+	Ar << Magic;
+	Ar << Version;
+	Ar.SerializeIntPacked(NumStates);
+	Ar << LayoutHash;
+	Ar << bHasNodeInstanceProperties;
+
+	TArray<int32> ActiveIndices;
+	GetAllActiveStateIndices(ActiveIndices);
+
+	uint32 NumActive = ActiveIndices.Num();
+	Ar.SerializeIntPacked(NumActive);
+	for (int32 Index : ActiveIndices)
+	{
+		uint32 PackedIndex = Index;
+		float Time = IndexedStates[Index]->GetActiveTime();
+		Ar.SerializeIntPacked(PackedIndex);
+		Ar << Time;
+	}
+
+	if (bHasNodeInstanceProperties)
+	{
+		TArray<int32> InstanceIndices;
+		for (int32 Index = 0; Index < IndexedStates.Num(); ++Index)
+		{
+			// Node instances not created yet still match their template.
+			USMNodeInstance* NodeInstance = IndexedStates[Index]->GetNodeInstanceIfCreated();
+			if (NodeInstance && HasSaveGameProperties(NodeInstance->GetClass()))
+			{
+				InstanceIndices.Add(Index);
+			}
+		}
+
+		uint32 NumInstances = InstanceIndices.Num();
+		Ar.SerializeIntPacked(NumInstances);
+
+		TArray<uint8> InstanceBytes;
+		for (int32 Index : InstanceIndices)
+		{
+			InstanceBytes.Reset();
+			FMemoryWriter InstanceWriter(InstanceBytes);
+			FObjectAndNameAsStringProxyArchive InstanceAr(InstanceWriter, true);
+			InstanceAr.ArIsSaveGame = true;
+			IndexedStates[Index]->GetNodeInstance()->Serialize(InstanceAr);
+
+			// Size prefixed so a reader can skip an instance it can't apply.
+			uint32 PackedIndex = Index;
+			uint32 NumBytes = InstanceBytes.Num();
+			Ar.SerializeIntPacked(PackedIndex);
+			Ar.SerializeIntPacked(NumBytes);
+			Ar.Serialize(InstanceBytes.GetData(), InstanceBytes.Num());
+		}
+	}
+
+	return !Ar.IsError();
+}
+
+bool USMInstance::ReadSnapshot(FArchive& Ar)
+{
+	check(Ar.IsLoading());
+
+	if (!CheckIsInitialized())
+	{
+		return false;
+	}
+
+	if (IsActive())
+	{
+		LD_LOG_WARNING(TEXT("Loading a snapshot into State Machine Instance %s while it is running. The snapshot will apply on the next Start."), *GetName());
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstance::ReadSnapshot"), STAT_SMInstance_ReadSnapshot, STATGROUP_LogicDriver);
+
+	uint32 Magic = 0;
+	uint8 Version = 0;
+	uint32 NumStates = 0;
+	uint32 LayoutHash = 0;
+	uint8 bHasNodeInstanceProperties = 0;
+
+	Ar << Magic;
+	Ar << Version;
+	Ar.SerializeIntPacked(NumStates);
+	Ar << LayoutHash;
+	Ar << bHasNodeInstanceProperties;
+
+	if (Ar.IsError() || Magic != SnapshotMagic)
+	{
+		LD_LOG_ERROR(TEXT("Snapshot could not be loaded into State Machine Instance %s. The data is not a state machine snapshot."), *GetName());
+		return false;
+	}
+
+	if (Version > SnapshotVersion)
+	{
+		LD_LOG_ERROR(TEXT("Snapshot could not be loaded into State Machine Instance %s. Snapshot version %d is newer than the supported version %d."), *GetName(), Version, SnapshotVersion);
+		return false;
+	}
+
+	if (NumStates != (uint32)IndexedStates.Num() || LayoutHash != StateLayoutHash)
+	{
+		LD_LOG_ERROR(TEXT("Snapshot could not be loaded into State Machine Instance %s. It was saved from a different state machine."), *GetName());
+		return false;
+	}
+
+	uint32 NumActive = 0;
+	Ar.SerializeIntPacked(NumActive);
+	if (NumActive > NumStates)
+	{
+		LD_LOG_ERROR(TEXT("Snapshot could not be loaded into State Machine Instance %s. The data is malformed."), *GetName());
+		return false;
+	}
+
+	PendingSnapshotTimes.Reset(NumActive);
+	for (uint32 i = 0; i < NumActive; ++i)
+	{
+		uint32 Index = 0;
+		float Time = 0.f;
+		Ar.SerializeIntPacked(Index);
+		Ar << Time;
+
+		if (Ar.IsError() || Index >= NumStates)
+		{
+			LD_LOG_ERROR(TEXT("Snapshot could not be loaded into State Machine Instance %s. The data is malformed."), *GetName());
+			PendingSnapshotTimes.Reset();
+			return false;
+		}
+
+		LoadFromStateIndex(Index);
+		PendingSnapshotTimes.Emplace(Index, Time);
+	}
+
+	if (bHasNodeInstanceProperties)
+	{
+		uint32 NumInstances = 0;
+		Ar.SerializeIntPacked(NumInstances);
+
+		TArray<uint8> InstanceBytes;
+		for (uint32 i = 0; i < NumInstances && !Ar.IsError(); ++i)
+		{
+			uint32 Index = 0;
+			uint32 NumBytes = 0;
+			Ar.SerializeIntPacked(Index);
+			Ar.SerializeIntPacked(NumBytes);
+
+			if (Ar.IsError() || (Ar.TotalSize() >= 0 && Ar.TotalSize() - Ar.Tell() < (int64)NumBytes))
+			{
+				break;
+			}
+
+			InstanceBytes.SetNumUninitialized(NumBytes, false);
+			Ar.Serialize(InstanceBytes.GetData(), NumBytes);
+
+			USMNodeInstance* NodeInstance = Index < NumStates ? IndexedStates[Index]->GetNodeInstance() : nullptr;
+			if (NodeInstance)
+			{
+				FMemoryReader InstanceReader(InstanceBytes);
+				FObjectAndNameAsStringProxyArchive InstanceAr(InstanceReader, true);
+				InstanceAr.ArIsSaveGame = true;
+				NodeInstance->Serialize(InstanceAr);
+			}
+		}
+	}
+
+	if (Ar.IsError())
+	{
+		LD_LOG_ERROR(TEXT("Snapshot could not be fully loaded into State Machine Instance %s. The data is malformed."), *GetName());
+		return false;
+	}
+
+	return true;
+}
+
+void USMInstance::LoadFromStateIndex(int32 StateIndex)
+{
+	// Same as LoadFromState without parents, the parents are expected to be loaded as well.
+	FSMState_Base* State = IndexedStates[StateIndex];
+	if (FSMStateMachine* ParentSM = (FSMStateMachine*)State->GetOwnerNode())
+	{
+		// Don't set when parent is a reference as it will just be forwarded back to this state.
+		if (ParentSM->GetInstanceReference() == nullptr)
+		{
+			ParentSM->AddTemporaryInitialState(State);
+		}
+	}
+}
+
+void USMInstance::ApplyPendingSnapshotTimes()
+{
+	for (const TPair<int32, float>& IndexTime : PendingSnapshotTimes)
+	{
+		FSMState_Base* State = IndexedStates[IndexTime.Key];
+		if (State->IsActive())
+		{
+			State->TimeInState = IndexTime.Value;
+		}
+	}
+
+	PendingSnapshotTimes.Reset();
+}
+
 FString USMInstance::GetActiveStateName() const
 {
 	if (FSMState_Base* CurrentState = GetSingleActiveState())
@@ -449,17 +1062,32 @@ FGuid USMInstance::GetSingleActiveStateGuid(bool bCheckNested) const
 
 TArray<FSMState_Base*> USMInstance::GetAllActiveStates() const
 {
-	return RootStateMachine.GetAllNestedActiveStates();
+	TArray<FSMState_Base*> InitialStates;
+	return GetActiveStatesOrInitial(InitialStates);
+}
+
+const TArray<FSMState_Base*>& USMInstance::GetActiveStatesOrInitial(TArray<FSMState_Base*>& InitialStates) const
+{
+	if (ActiveStateList.Num() > 0)
+	{
+		return ActiveStateList;
+	}
+
+	// Loaded states are reported as active before the instance starts.
+	InitialStates = RootStateMachine.GetAllNestedActiveStates();
+	return InitialStates;
 }
 
 void USMInstance::GetAllActiveStateGuids(TArray<FGuid>& ActiveGuids) const
 {
-	ActiveGuids.Reset();
-	
-	TArray<FSMState_Base*> CurrentStates = GetAllActiveStates();
-	for (FSMState_Base* State : CurrentStates)
+	TArray<FSMState_Base*> InitialStates;
+	const TArray<FSMState_Base*>& ActiveStates = GetActiveStatesOrInitial(InitialStates);
+	ActiveGuids.Reset(ActiveStates.Num());
+
+	// A state is only ever in the list once.
+	for (FSMState_Base* State : ActiveStates)
 	{
-		ActiveGuids.AddUnique(State->GetGuid());
+		ActiveGuids.Add(State->GetGuid());
 	}
 }
 
@@ -471,6 +1099,91 @@ TArray<FGuid> USMInstance::GetAllActiveStateGuidsCopy() const
 	return OutGuids;
 }
 
+void USMInstance::GetAllActiveStateIndices(TArray<int32>& OutStateIndices) const
+{
+	TArray<FSMState_Base*> InitialStates;
+	const TArray<FSMState_Base*>& ActiveStates = GetActiveStatesOrInitial(InitialStates);
+	OutStateIndices.Reset(ActiveStates.Num());
+
+	for (FSMState_Base* State : ActiveStates)
+	{
+		if (const int32* Index = StateIndexMap.Find(State))
+		{
+			OutStateIndices.Add(*Index);
+		}
+	}
+}
+
+bool USMInstance::PackTransaction(const FSMNetworkedTransaction& Transaction, FSMPackedTransaction& OutPackedTransaction) const
+{
+	FSMState_Base* const* StateMachine = GuidStateMap.Find(Transaction.StateMachineGuid);
+	const int32* StateMachineIndex = StateMachine ? StateIndexMap.Find(*StateMachine) : nullptr;
+	if (!StateMachineIndex)
+	{
+		return false;
+	}
+
+	const int32* NodeIndex = nullptr;
+	if (Transaction.IsTransition())
+	{
+		FSMTransition* const* Transition = GuidTransitionMap.Find(Transaction.BaseGuid);
+		NodeIndex = Transition ? TransitionIndexMap.Find(*Transition) : nullptr;
+	}
+	else
+	{
+		FSMState_Base* const* State = GuidStateMap.Find(Transaction.BaseGuid);
+		NodeIndex = State ? StateIndexMap.Find(*State) : nullptr;
+	}
+
+	if (!NodeIndex)
+	{
+		return false;
+	}
+
+	OutPackedTransaction.StateMachineIndex = *StateMachineIndex;
+	OutPackedTransaction.NodeIndex = *NodeIndex;
+	OutPackedTransaction.TransactionId = Transaction.GetTransactionId();
+	OutPackedTransaction.TimestampTicks = Transaction.Timestamp.GetTicks();
+	OutPackedTransaction.bIsTransition = Transaction.IsTransition();
+	OutPackedTransaction.bIsActive = Transaction.bIsActive;
+	return true;
+}
+
+TArray<FGuid> USMInstance::GetReplicatedStates() const
+{
+	TArray<int32> StateIndices;
+	R_ActiveStates.GetStateIndices(StateIndices);
+
+	TArray<FGuid> Guids;
+	Guids.Reserve(StateIndices.Num());
+	for (int32 Index : StateIndices)
+	{
+		if (IndexedStates.IsValidIndex(Index))
+		{
+			Guids.Add(IndexedStates[Index]->GetGuid());
+		}
+	}
+
+	return Guids;
+}
+
+void USMInstance::LoadFromReplicatedStates()
+{
+	TArray<int32> StateIndices;
+	R_ActiveStates.GetStateIndices(StateIndices);
+
+	for (int32 Index : StateIndices)
+	{
+		if (!IndexedStates.IsValidIndex(Index))
+		{
+			LD_LOG_ERROR(TEXT("Replicated state index %d is out of range for State Machine Instance %s."), Index, *GetName());
+			continue;
+		}
+
+		LoadFromStateIndex(Index);
+	}
+}
+
 USMStateInstance_Base* USMInstance::GetActiveStateInstance(bool bCheckNested) const
 {
 	return GetSingleActiveStateInstance(bCheckNested);
@@ -488,9 +1201,11 @@ USMStateInstance_Base* USMInstance::GetSingleActiveStateInstance(bool bCheckNest
 
 void USMInstance::GetAllActiveStateInstances(TArray<USMStateInstance_Base*>& ActiveStateInstances) const
 {
-	ActiveStateInstances.Reset();
+	TArray<FSMState_Base*> InitialStates;
+	const TArray<FSMState_Base*>& ActiveStates = GetActiveStatesOrInitial(InitialStates);
+	ActiveStateInstances.Reset(ActiveStates.Num());
 
-	for (FSMState_Base* State : GetAllActiveStates())
+	for (FSMState_Base* State : ActiveStates)
 	{
 		if (USMStateInstance_Base* StateInstance = Cast<USMStateInstance_Base>(State->GetNodeInstance()))
 		{
@@ -812,6 +1527,8 @@ void USMInstance::NotifyTransitionTaken(const FSMTransition& Transition)
 
 void USMInstance::NotifyStateChange(FSMState_Base* ToState, FSMState_Base* FromState)
 {
+	GetMasterReferenceOwner()->bHadActivityThisUpdate = true;
+
 	const FSMStateInfo ToStateInfo(ToState ? *ToState : FSMState_Base());
 	const FSMStateInfo FromStateInfo(FromState ? *FromState : FSMState_Base());
 
@@ -906,8 +1623,13 @@ void USMInstance::Tick_Implementation(float DeltaTime)
 		return;
 	}
 
-	// Check if we are allowed to tick depending on the interval.
-	TimeSinceAllowedTick += DeltaTime;
+	// Check if we are allowed to tick depending on the interval. When the dormancy manager woke us this frame it already applied the delta.
+	if (DormantWakeFrame != GFrameCounter)
+	{
+		TimeSinceAllowedTick += DeltaTime;
+	}
+	DormantWakeFrame = MAX_uint64;
+	
 	if (TimeSinceAllowedTick < TickInterval)
 	{
 		return;
@@ -968,6 +1690,15 @@ void USMInstance::BuildStateMachineMap(FSMStateMachine* StateMachine, TSet<USMIn
 	{
 		GuidNodeMap.Add(StateMachineGuid, StateMachine);
 		GuidStateMap.Add(StateMachineGuid, StateMachine);
+		AddIndexedState(StateMachine);
+	}
+	else if (FSMState_Base** ReferencingState = GuidStateMap.Find(StateMachineGuid))
+	{
+		// Root of a reference, share the index of the node referencing it.
+		if (const int32* ReferencingIndex = StateIndexMap.Find(*ReferencingState))
+		{
+			StateIndexMap.Add(StateMachine, *ReferencingIndex);
+		}
 	}
 
 	// Build out guids of all contained nodes in references.
@@ -995,6 +1726,7 @@ void USMInstance::BuildStateMachineMap(FSMStateMachine* StateMachine, TSet<USMIn
 		
 		GuidNodeMap.Add(Guid, Transition);
 		GuidTransitionMap.Add(Guid, Transition);
+		TransitionIndexMap.Add(Transition, IndexedTransitions.Add(Transition));
 	}
 
 	for (FSMState_Base* State : StateMachine->GetStates())
@@ -1011,6 +1743,7 @@ void USMInstance::BuildStateMachineMap(FSMStateMachine* StateMachine, TSet<USMIn
 		
 		GuidNodeMap.Add(Guid, State);
 		GuidStateMap.Add(Guid, State);
+		AddIndexedState(State);
 		
 		if (State->IsStateMachine())
 		{
@@ -1019,6 +1752,38 @@ void USMInstance::BuildStateMachineMap(FSMStateMachine* StateMachine, TSet<USMIn
 	}
 }
 
+void USMInstance::AddIndexedState(FSMState_Base* State)
+{
+	const int32 Index = IndexedStates.Add(State);
+	StateIndexMap.Add(State, Index);
+	StateLayoutHash = HashCombine(StateLayoutHash, GetTypeHash(State->GetGuid()));
+}
+
+void USMInstance::AddToActiveStateList(FSMState_Base* State)
+{
+	if (!ActiveStateListIndices.Contains(State))
+	{
+		ActiveStateListIndices.Add(State, ActiveStateList.Add(State));
+	}
+}
+
+void USMInstance::RemoveFromActiveStateList(FSMState_Base* State)
+{
+	int32 RemovedIndex;
+	if (!ActiveStateListIndices.RemoveAndCopyValue(State, RemovedIndex))
+	{
+		return;
+	}
+
+	ActiveStateList.RemoveAtSwap(RemovedIndex, 1, false);
+
+	// Fix up the index of the state swapped into the removed slot.
+	if (ActiveStateList.IsValidIndex(RemovedIndex))
+	{
+		ActiveStateListIndices.Add(ActiveStateList[RemovedIndex], RemovedIndex);
+	}
+}
+
 bool USMInstance::CheckIsInitialized() const
 {
 	if (!IsInitialized())
@@ -1055,7 +1820,10 @@ void USMInstance::ReplicateStates()
 {
 	if (ServerStateMachine.GetObject() && ServerStateMachine->ShouldReplicateStates())
 	{
-		GetAllActiveStateGuids(R_ActiveStates);
+		TArray<int32> ActiveIndices;
+		GetAllActiveStateIndices(ActiveIndices);
+		const int32 NumChanged = R_ActiveStates.Update(ActiveIndices, ServerStateMachine->GetReplicatedStatesBaselineInterval());
+		INC_DWORD_STAT_BY(STAT_SMReplicatedStateChanges, NumChanged);
 	}
 }
 
@@ -1072,6 +1840,7 @@ void USMInstance::DoStart()
 	}
 	
 	RootStateMachine.StartState();
+	ApplyPendingSnapshotTimes();
 	UpdateTime();
 
 	ReplicateStates();
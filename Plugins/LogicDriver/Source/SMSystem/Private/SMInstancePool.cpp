@@ -0,0 +1,248 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+
+#include "SMInstancePool.h"
+#include "SMInstance.h"
+#include "SMLogging.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectHash.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Instances"), STAT_SMPooledInstances, STATGROUP_LogicDriver);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Objects"), STAT_SMPooledObjects, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Hits"), STAT_SMPoolHits, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Misses"), STAT_SMPoolMisses, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Objects Recycled"), STAT_SMPoolObjectsRecycled, STATGROUP_LogicDriver);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Pool Hit Rate"), STAT_SMPoolHitRate, STATGROUP_LogicDriver);
+
+static USMInstancePool* GlobalInstancePool = nullptr;
+
+USMInstancePool::USMInstancePool() : Super(), MaxPooledPerArchetype(32)
+{
+}
+
+USMInstancePool* USMInstancePool::Get(bool bCreateIfMissing)
+{
+	if (!GlobalInstancePool && bCreateIfMissing)
+	{
+		GlobalInstancePool = NewObject<USMInstancePool>(GetTransientPackage(), NAME_None, RF_Transient);
+		GlobalInstancePool->AddToRoot();
+	}
+
+	return GlobalInstancePool;
+}
+
+void USMInstancePool::ShutdownPool()
+{
+	if (GlobalInstancePool)
+	{
+		if (UObjectInitialized())
+		{
+			GlobalInstancePool->Empty();
+			GlobalInstancePool->RemoveFromRoot();
+		}
+		GlobalInstancePool = nullptr;
+	}
+}
+
+USMInstance* USMInstancePool::Acquire(UClass* StateMachineClass, UObject* Context, USMInstance* Template)
+{
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstancePool::Acquire"), STAT_SMInstancePool_Acquire, STATGROUP_LogicDriver);
+
+	USMInstance* Instance = nullptr;
+
+	FSMInstancePoolEntry* Entry = PooledInstances.Find(GetArchetype(StateMachineClass, Template));
+	while (Entry && Entry->Instances.Num() > 0 && !Instance)
+	{
+		// Instances can be marked pending kill while pooled, those are just dropped.
+		USMInstance* PooledInstance = Entry->Instances.Pop(false);
+		if (IsValid(PooledInstance) && PooledInstance->IsInitialized())
+		{
+			Instance = PooledInstance;
+		}
+	}
+
+	if (!Instance)
+	{
+		Stats.Misses++;
+		INC_DWORD_STAT(STAT_SMPoolMisses);
+		UpdateStats();
+		return nullptr;
+	}
+
+	MoveInstance(Instance, Context ? Context : GetTransientPackage(), Context, false);
+
+	Stats.Hits++;
+	Stats.ObjectsRecycled += Entry->ObjectsPerInstance;
+	INC_DWORD_STAT(STAT_SMPoolHits);
+	INC_DWORD_STAT_BY(STAT_SMPoolObjectsRecycled, Entry->ObjectsPerInstance);
+	UpdateStats();
+
+	// Match the order of a new instance where references initialize before their owner.
+	TArray<USMInstance*> References = Instance->GetAllReferencedInstances(true);
+	for (int32 Idx = References.Num() - 1; Idx >= 0; --Idx)
+	{
+		References[Idx]->OnStateMachineInitialized();
+	}
+	Instance->OnStateMachineInitialized();
+
+	return Instance;
+}
+
+bool USMInstancePool::Release(USMInstance* Instance)
+{
+	if (!IsValid(Instance) || Instance->IsPooled())
+	{
+		return false;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMInstancePool::Release"), STAT_SMInstancePool_Release, STATGROUP_LogicDriver);
+
+	if (!Instance->IsInitialized() || Instance->IsTemplate() || Instance->GetReferenceOwner() || Instance->GetComponentOwner())
+	{
+		LD_LOG_WARNING(TEXT("Could not release state machine instance %s to the pool. Only initialized instances not owned by a component or another state machine can be pooled."), *Instance->GetName());
+		Stats.Rejected++;
+		return false;
+	}
+
+	FSMInstancePoolEntry& Entry = PooledInstances.FindOrAdd(GetArchetype(Instance->GetClass(), Instance->GetInstanceTemplate()));
+	if (Entry.Instances.Num() >= MaxPooledPerArchetype)
+	{
+		Stats.Rejected++;
+		return false;
+	}
+
+	Instance->ResetToInitialState();
+	MoveInstance(Instance, this, nullptr, true);
+
+	Entry.ObjectsPerInstance = CountObjects(Instance);
+	Entry.Instances.Add(Instance);
+
+	Stats.Released++;
+	UpdateStats();
+
+	return true;
+}
+
+int32 USMInstancePool::Prewarm(UClass* StateMachineClass, UObject* Context, int32 Count, USMInstance* Template)
+{
+	if (!StateMachineClass || !StateMachineClass->IsChildOf<USMInstance>() || (Template && Template->GetClass() != StateMachineClass))
+	{
+		return 0;
+	}
+
+	int32 NumAdded = 0;
+	for (int32 Idx = 0; Idx < Count; ++Idx)
+	{
+		USMInstance* Instance = NewObject<USMInstance>(Context ? Context : GetTransientPackage(), StateMachineClass, NAME_None, RF_NoFlags, Template);
+		Instance->InstanceTemplate = Template;
+		Instance->Initialize(Context);
+
+		if (!Release(Instance))
+		{
+			break;
+		}
+
+		NumAdded++;
+	}
+
+	return NumAdded;
+}
+
+void USMInstancePool::Empty()
+{
+	for (auto& KeyVal : PooledInstances)
+	{
+		for (USMInstance* Instance : KeyVal.Value.Instances)
+		{
+			if (Instance)
+			{
+				Instance->bIsPooled = false;
+			}
+		}
+	}
+
+	PooledInstances.Empty();
+	UpdateStats();
+}
+
+int32 USMInstancePool::GetNumPooled(UClass* StateMachineClass, USMInstance* Template) const
+{
+	const FSMInstancePoolEntry* Entry = PooledInstances.Find(GetArchetype(StateMachineClass, Template));
+	return Entry ? Entry->Instances.Num() : 0;
+}
+
+void USMInstancePool::ResetStats()
+{
+	Stats = FSMInstancePoolStats();
+	UpdateStats();
+}
+
+UObject* USMInstancePool::GetArchetype(UClass* StateMachineClass, USMInstance* Template)
+{
+	if (Template)
+	{
+		return Template;
+	}
+
+	return StateMachineClass ? StateMachineClass->GetDefaultObject() : nullptr;
+}
+
+void USMInstancePool::MoveInstance(USMInstance* Instance, UObject* NewOuter, UObject* Context, bool bPooled)
+{
+	const ERenameFlags RenameFlags = REN_DontCreateRedirectors | REN_ForceNoResetLoaders | REN_DoNotDirty | REN_NonTransactional;
+
+	TArray<USMInstance*> Instances = Instance->GetAllReferencedInstances(true);
+	Instances.Insert(Instance, 0);
+
+	// References share the outer of the instance owning them.
+	UObject* OldOuter = Instance->GetOuter();
+
+	for (USMInstance* InstanceToMove : Instances)
+	{
+		if (InstanceToMove->GetOuter() == OldOuter && OldOuter != NewOuter)
+		{
+			FName NewName = InstanceToMove->GetFName();
+			if (StaticFindObjectFast(nullptr, NewOuter, NewName))
+			{
+				NewName = MakeUniqueObjectName(NewOuter, InstanceToMove->GetClass());
+			}
+
+			InstanceToMove->Rename(*NewName.ToString(), NewOuter, RenameFlags);
+		}
+
+		InstanceToMove->SetContext(Context);
+		InstanceToMove->bIsPooled = bPooled;
+	}
+}
+
+int32 USMInstancePool::CountObjects(USMInstance* Instance)
+{
+	int32 NumObjects = 1 + Instance->GetAllReferencedInstances(true).Num();
+
+	TArray<FSMNode_Base*> Nodes = Instance->GetRootStateMachine().GetAllNodes(true);
+	Nodes.Add(&Instance->GetRootStateMachine());
+	for (const FSMNode_Base* Node : Nodes)
+	{
+		// Node instances created on demand are only counted once they exist.
+		if (Node->GetNodeInstanceIfCreated())
+		{
+			NumObjects += 1 + Node->GetStackInstances().Num();
+		}
+	}
+
+	return NumObjects;
+}
+
+void USMInstancePool::UpdateStats()
+{
+	Stats.NumPooled = 0;
+	Stats.NumPooledObjects = 0;
+	for (const auto& KeyVal : PooledInstances)
+	{
+		Stats.NumPooled += KeyVal.Value.Instances.Num();
+		Stats.NumPooledObjects += KeyVal.Value.Instances.Num() * KeyVal.Value.ObjectsPerInstance;
+	}
+
+	SET_DWORD_STAT(STAT_SMPooledInstances, Stats.NumPooled);
+	SET_DWORD_STAT(STAT_SMPooledObjects, Stats.NumPooledObjects);
+	SET_FLOAT_STAT(STAT_SMPoolHitRate, Stats.GetHitRate() * 100.f);
+}
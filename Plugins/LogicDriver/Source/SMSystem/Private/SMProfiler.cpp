@@ -0,0 +1,369 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+
+#include "SMProfiler.h"
+#include "SMInstance.h"
+#include "SMNode_Base.h"
+#include "SMLogging.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Trace Events"), STAT_SMTraceEvents, STATGROUP_LogicDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Trace Events Dropped"), STAT_SMTraceEventsDropped, STATGROUP_LogicDriver);
+
+TAtomic<bool> FSMProfiler::bIsTracing(false);
+
+static FSMProfiler* GlobalProfiler = nullptr;
+
+static const TCHAR* TraceEventNames[] = { TEXT("Begin"), TEXT("Update"), TEXT("End"), TEXT("Evaluate"), TEXT("Taken") };
+static_assert(UE_ARRAY_COUNT(TraceEventNames) == (int32)ESMTraceEventType::Max, "Trace event names out of date.");
+
+static FAutoConsoleCommand TraceStartCommand(
+	TEXT("LogicDriver.Trace.Start"),
+	TEXT("Start tracing state machine nodes. Optional argument: ring buffer size in events."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FSMProfiler::Get().StartTrace(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 65536);
+	}));
+
+static FAutoConsoleCommand TraceStopCommand(
+	TEXT("LogicDriver.Trace.Stop"),
+	TEXT("Stop tracing state machine nodes. Recorded data is kept until the next trace."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FSMProfiler::Get().StopTrace();
+	}));
+
+static FAutoConsoleCommand TraceDumpCommand(
+	TEXT("LogicDriver.Trace.Dump"),
+	TEXT("Log the most expensive nodes of each traced state machine class. Optional argument: nodes per class."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FSMProfiler& Profiler = FSMProfiler::Get();
+		Profiler.Flush();
+		Profiler.DumpHotLists(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10);
+	}));
+
+static FAutoConsoleCommand TraceExportCommand(
+	TEXT("LogicDriver.Trace.Export"),
+	TEXT("Export traced node timings to CSV. Optional argument: file path, defaults to the profiling directory."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString FilePath = Args.Num() > 0 ? Args[0] :
+			FPaths::Combine(FPaths::ProfilingDir(), TEXT("LogicDriver"), FString::Printf(TEXT("Trace-%s.csv"), *FDateTime::Now().ToString()));
+
+		FSMProfiler& Profiler = FSMProfiler::Get();
+		Profiler.Flush();
+		if (Profiler.ExportCSV(FilePath))
+		{
+			LD_LOG_INFO(TEXT("Exported state machine trace to %s."), *FilePath);
+		}
+	}));
+
+void FSMTraceScope::Finish()
+{
+	FSMTraceEvent Event;
+	Event.Instance = Node->GetOwningInstance();
+	Event.InstanceClass = Node->GetOwningInstance() ? Node->GetOwningInstance()->GetClass() : nullptr;
+	Event.NodeGuid = Node->GetGuid();
+	Event.StartCycles = StartCycles;
+	Event.DurationCycles = (uint32)FMath::Min<uint64>(FPlatformTime::Cycles64() - StartCycles, MAX_uint32);
+	Event.Type = Type;
+	Event.bResult = Result && *Result;
+
+	FSMProfiler::Get().Record(Event);
+}
+
+FSMProfiler::FSMProfiler() : FTickableGameObject(), NumSlots(0), WriteIndex(0), ReadIndex(0), NumDroppedEvents(0),
+                             TraceStartCycles(0)
+{
+}
+
+FSMProfiler::~FSMProfiler()
+{
+	bIsTracing = false;
+}
+
+FSMProfiler& FSMProfiler::Get()
+{
+	if (!GlobalProfiler)
+	{
+		GlobalProfiler = new FSMProfiler();
+	}
+
+	return *GlobalProfiler;
+}
+
+void FSMProfiler::Shutdown()
+{
+	if (GlobalProfiler)
+	{
+		delete GlobalProfiler;
+		GlobalProfiler = nullptr;
+	}
+}
+
+void FSMProfiler::StartTrace(int32 BufferSize)
+{
+	check(IsInGameThread());
+
+	bIsTracing = false;
+
+	const uint64 NewNumSlots = FMath::RoundUpToPowerOfTwo(FMath::Max(BufferSize, 1024));
+	if (NewNumSlots != NumSlots)
+	{
+		Slots = MakeUnique<FSlot[]>(NewNumSlots);
+		NumSlots = NewNumSlots;
+	}
+
+	for (uint64 Idx = 0; Idx < NumSlots; ++Idx)
+	{
+		Slots[Idx].Sequence = 0;
+	}
+
+	WriteIndex = 0;
+	ReadIndex = 0;
+	Reset();
+
+	TraceStartCycles = FPlatformTime::Cycles64();
+	bIsTracing = true;
+
+	LD_LOG_INFO(TEXT("State machine tracing started with a buffer of %d events."), (int32)NumSlots);
+}
+
+void FSMProfiler::StopTrace()
+{
+	if (!bIsTracing)
+	{
+		return;
+	}
+
+	bIsTracing = false;
+	Flush();
+
+	LD_LOG_INFO(TEXT("State machine tracing stopped. %d classes traced, %d events dropped."), ClassStats.Num(), (int32)NumDroppedEvents);
+}
+
+void FSMProfiler::Record(const FSMTraceEvent& Event)
+{
+	if (NumSlots == 0)
+	{
+		return;
+	}
+
+	const uint64 Index = WriteIndex++;
+	FSlot& Slot = Slots[Index & (NumSlots - 1)];
+
+	// Claim the slot so a reader can detect the overwrite. The exchange has acquire semantics so the event writes below
+	// can't be reordered before it. If another writer a full lap behind still owns the slot this event is dropped, the
+	// reader sees the sequence never reach this index.
+	if (Slot.Sequence.Exchange(WritingSequence) == WritingSequence)
+	{
+		return;
+	}
+
+	Slot.Event = Event;
+
+	// Release the event, the store can't be reordered before the writes above.
+	Slot.Sequence.Store(Index + 1);
+}
+
+void FSMProfiler::Flush()
+{
+	if (NumSlots == 0)
+	{
+		return;
+	}
+
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMProfiler::Flush"), STAT_SMProfiler_Flush, STATGROUP_LogicDriver);
+
+	const uint64 EndIndex = WriteIndex.Load();
+	uint64 Index = ReadIndex;
+
+	// Writers lapped the reader, the oldest events are gone.
+	if (EndIndex - Index > NumSlots)
+	{
+		const uint64 NumLost = EndIndex - NumSlots - Index;
+		NumDroppedEvents += NumLost;
+		INC_DWORD_STAT_BY(STAT_SMTraceEventsDropped, NumLost);
+		Index = EndIndex - NumSlots;
+	}
+
+	for (; Index < EndIndex; ++Index)
+	{
+		const FSlot& Slot = Slots[Index & (NumSlots - 1)];
+
+		// Either still being written or already overwritten by a newer event.
+		if (Slot.Sequence.Load() != Index + 1)
+		{
+			NumDroppedEvents++;
+			INC_DWORD_STAT(STAT_SMTraceEventsDropped);
+			continue;
+		}
+
+		const FSMTraceEvent Event = Slot.Event;
+
+		// The copy above must complete before the sequence is checked again, otherwise a writer which started during
+		// the copy may go unnoticed.
+		FPlatformMisc::MemoryBarrier();
+		if (Slot.Sequence.Load() != Index + 1)
+		{
+			NumDroppedEvents++;
+			INC_DWORD_STAT(STAT_SMTraceEventsDropped);
+			continue;
+		}
+
+		Aggregate(Event);
+	}
+
+	INC_DWORD_STAT_BY(STAT_SMTraceEvents, EndIndex - ReadIndex);
+	ReadIndex = EndIndex;
+}
+
+void FSMProfiler::Reset()
+{
+	ClassStats.Reset();
+	TakenTransitions.Reset();
+	NumDroppedEvents = 0;
+}
+
+void FSMProfiler::Aggregate(const FSMTraceEvent& Event)
+{
+	FClassStats& Class = ClassStats.FindOrAdd(Event.InstanceClass);
+
+	FSMTraceNodeStats* NodeStats = Class.Nodes.Find(Event.NodeGuid);
+	if (!NodeStats)
+	{
+		NodeStats = &Class.Nodes.Add(Event.NodeGuid);
+		NodeStats->NodeGuid = Event.NodeGuid;
+
+		// Names are only resolved the first time a node is seen.
+		const FSMNode_Base* Node = Event.Instance.IsValid() ? Event.Instance->GetNodeByGuid(Event.NodeGuid) : nullptr;
+		NodeStats->NodeName = Node ? Node->GetNodeName() : Event.NodeGuid.ToString();
+	}
+
+	const int32 TypeIndex = (int32)Event.Type;
+	NodeStats->Counts[TypeIndex]++;
+	NodeStats->Cycles[TypeIndex] += Event.DurationCycles;
+	NodeStats->MaxCycles[TypeIndex] = FMath::Max(NodeStats->MaxCycles[TypeIndex], Event.DurationCycles);
+	NodeStats->TotalCycles += Event.DurationCycles;
+
+	if (Event.Type == ESMTraceEventType::TransitionEvaluated && Event.bResult)
+	{
+		NodeStats->NumPassed++;
+	}
+	else if (Event.Type == ESMTraceEventType::TransitionTaken && TakenTransitions.Num() < MaxTakenTransitions)
+	{
+		FSMTraceTakenTransition& Taken = TakenTransitions.AddDefaulted_GetRef();
+		Taken.InstanceClass = Event.InstanceClass;
+		Taken.NodeGuid = Event.NodeGuid;
+		Taken.Timestamp = FPlatformTime::ToSeconds64(Event.StartCycles - TraceStartCycles);
+	}
+}
+
+TArray<FSMTraceNodeStats> FSMProfiler::GetHotList(const UClass* InstanceClass, int32 MaxNodes) const
+{
+	TArray<FSMTraceNodeStats> HotList;
+	if (const FClassStats* Class = ClassStats.Find(InstanceClass))
+	{
+		Class->Nodes.GenerateValueArray(HotList);
+		HotList.Sort([](const FSMTraceNodeStats& A, const FSMTraceNodeStats& B)
+		{
+			return A.TotalCycles > B.TotalCycles;
+		});
+
+		if (MaxNodes >= 0 && HotList.Num() > MaxNodes)
+		{
+			HotList.SetNum(MaxNodes);
+		}
+	}
+
+	return HotList;
+}
+
+TArray<const UClass*> FSMProfiler::GetTracedClasses() const
+{
+	TArray<const UClass*> Classes;
+	ClassStats.GetKeys(Classes);
+	return Classes;
+}
+
+static FString GetTracedClassName(const UClass* Class)
+{
+	return Class ? Class->GetName() : TEXT("None");
+}
+
+bool FSMProfiler::ExportCSV(const FString& FilePath) const
+{
+	FString Csv = TEXT("Class,Node,Guid,Event,Count,TotalMs,AvgUs,MaxUs,Passed\n");
+	for (const UClass* Class : GetTracedClasses())
+	{
+		const FString ClassName = GetTracedClassName(Class);
+		for (const FSMTraceNodeStats& NodeStats : GetHotList(Class))
+		{
+			for (int32 TypeIndex = 0; TypeIndex < (int32)ESMTraceEventType::Max; ++TypeIndex)
+			{
+				const int32 Count = NodeStats.Counts[TypeIndex];
+				if (Count == 0)
+				{
+					continue;
+				}
+
+				const double TotalSeconds = FPlatformTime::ToSeconds64(NodeStats.Cycles[TypeIndex]);
+				Csv += FString::Printf(TEXT("%s,\"%s\",%s,%s,%d,%.4f,%.3f,%.3f,%d\n"), *ClassName,
+					*NodeStats.NodeName.Replace(TEXT("\""), TEXT("\"\"")), *NodeStats.NodeGuid.ToString(), TraceEventNames[TypeIndex], Count,
+					TotalSeconds * 1000.0, TotalSeconds * 1000000.0 / Count, FPlatformTime::ToSeconds64(NodeStats.MaxCycles[TypeIndex]) * 1000000.0,
+					TypeIndex == (int32)ESMTraceEventType::TransitionEvaluated ? NodeStats.NumPassed : 0);
+			}
+		}
+	}
+
+	FString TransitionsCsv = TEXT("Time,Class,Node,Guid\n");
+	for (const FSMTraceTakenTransition& Taken : TakenTransitions)
+	{
+		const FSMTraceNodeStats* NodeStats = nullptr;
+		if (const FClassStats* Class = ClassStats.Find(Taken.InstanceClass))
+		{
+			NodeStats = Class->Nodes.Find(Taken.NodeGuid);
+		}
+
+		TransitionsCsv += FString::Printf(TEXT("%.6f,%s,\"%s\",%s\n"), Taken.Timestamp, *GetTracedClassName(Taken.InstanceClass),
+			NodeStats ? *NodeStats->NodeName.Replace(TEXT("\""), TEXT("\"\"")) : TEXT(""), *Taken.NodeGuid.ToString());
+	}
+
+	const FString TransitionsPath = FPaths::Combine(FPaths::GetPath(FilePath), FPaths::GetBaseFilename(FilePath) + TEXT("_Transitions.csv"));
+	if (!FFileHelper::SaveStringToFile(Csv, *FilePath) || !FFileHelper::SaveStringToFile(TransitionsCsv, *TransitionsPath))
+	{
+		LD_LOG_ERROR(TEXT("Could not export state machine trace to %s."), *FilePath);
+		return false;
+	}
+
+	return true;
+}
+
+void FSMProfiler::DumpHotLists(int32 MaxNodes) const
+{
+	for (const UClass* Class : GetTracedClasses())
+	{
+		LD_LOG_INFO(TEXT("State machine trace: %s"), *GetTracedClassName(Class));
+		for (const FSMTraceNodeStats& NodeStats : GetHotList(Class, MaxNodes))
+		{
+			const int32 NumEvaluations = NodeStats.Counts[(int32)ESMTraceEventType::TransitionEvaluated];
+			LD_LOG_INFO(TEXT("  %.3fms %s (begin %d, update %d, end %d, evaluated %d, passed %d, taken %d)"),
+				FPlatformTime::ToMilliseconds64(NodeStats.TotalCycles), *NodeStats.NodeName,
+				NodeStats.Counts[(int32)ESMTraceEventType::StateBegin], NodeStats.Counts[(int32)ESMTraceEventType::StateUpdate],
+				NodeStats.Counts[(int32)ESMTraceEventType::StateEnd], NumEvaluations, NodeStats.NumPassed,
+				NodeStats.Counts[(int32)ESMTraceEventType::TransitionTaken]);
+		}
+	}
+}
+
+void FSMProfiler::Tick(float DeltaTime)
+{
+	Flush();
+}
+
+TStatId FSMProfiler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FSMProfiler, STATGROUP_Tickables);
+}
@@ -21,6 +21,7 @@ USMStateMachineComponent::USMStateMachineComponent(class FObjectInitializer cons
 	NetworkStateConfiguration = SM_ClientAndServer;
 	TransitionResetTimeSeconds = 2.f;
 	bReplicateStatesOnLoad = true;
+	ReplicatedStatesBaselineInterval = 32;
 	bTakeTransitionsFromServerOnly = false;
 	bDiscardTransitionsBeforeInitialize = false;
 	bIncludeSimulatedProxies = false;
@@ -70,11 +71,15 @@ void USMStateMachineComponent::BeginPlay()
 void USMStateMachineComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 	FActorComponentTickFunction* ThisTickFunction)
 {
-	if (R_Instance && CanTickForEnvironment())
+	// Dormant instances are updated by the dormancy manager until they wake.
+	if (R_Instance && !R_Instance->IsDormant() && CanTickForEnvironment())
 	{
 		DECLARE_SCOPE_CYCLE_COUNTER(TEXT("SMStateMachineComponent::Tick"), STAT_SMStateMachineComponent_Tick, STATGROUP_LogicDriver);
 		R_Instance->Tick(DeltaTime);
 	}
+
+	// Everything the instance took this frame goes out in one call.
+	FlushOutgoingTransactions();
 	
 	if (IsRegistered())
 	{
@@ -530,11 +535,53 @@ void USMStateMachineComponent::ProcessTransaction(const TArray<FSMNetworkedTrans
 {
 	if (HasAuthority())
 	{
-		SendTransactionsToClients(Transactions);
+		FSMPackedTransactions PackedTransactions;
+		PackTransactions(Transactions, PackedTransactions, [this](const FSMPackedTransactions& FullTransactions)
+		{
+			SendTransactionsToClients(FullTransactions);
+		});
+		SendTransactionsToClients(PackedTransactions);
 		return;
 	}
 
-	SERVER_ProcessTransaction(Transactions);
+	// A full payload is sent now rather than dropping the oldest transactions of this frame.
+	PackTransactions(Transactions, OutgoingTransactions, [this](const FSMPackedTransactions& FullTransactions)
+	{
+		SERVER_ProcessTransaction(FullTransactions);
+	});
+
+	// Without a component tick there is no end of frame to wait for.
+	if (!IsComponentTickEnabled())
+	{
+		FlushOutgoingTransactions();
+	}
+}
+
+void USMStateMachineComponent::PackTransactions(const TArray<FSMNetworkedTransaction>& Transactions, FSMPackedTransactions& OutPackedTransactions,
+	TFunctionRef<void(const FSMPackedTransactions&)> Flush) const
+{
+	if (!R_Instance)
+	{
+		return;
+	}
+
+	for (const FSMNetworkedTransaction& Transaction : Transactions)
+	{
+		FSMPackedTransaction PackedTransaction;
+		if (R_Instance->PackTransaction(Transaction, PackedTransaction))
+		{
+			OutPackedTransactions.AddOrFlush(PackedTransaction, Flush);
+		}
+	}
+}
+
+void USMStateMachineComponent::FlushOutgoingTransactions()
+{
+	if (OutgoingTransactions.Num() > 0)
+	{
+		SERVER_ProcessTransaction(OutgoingTransactions);
+		OutgoingTransactions.Empty();
+	}
 }
 
 bool USMStateMachineComponent::ShouldReplicateStates() const
@@ -542,6 +589,11 @@ bool USMStateMachineComponent::ShouldReplicateStates() const
 	return bReplicateStatesOnLoad;
 }
 
+int32 USMStateMachineComponent::GetReplicatedStatesBaselineInterval() const
+{
+	return ReplicatedStatesBaselineInterval;
+}
+
 #if WITH_EDITOR
 
 void USMStateMachineComponent::InitInstanceTemplate()
@@ -682,6 +734,7 @@ void USMStateMachineComponent::DoStop()
 void USMStateMachineComponent::DoShutdown()
 {
 	PendingTransactions.Empty();
+	OutgoingTransactions.Empty();
 	
 	if (!R_Instance)
 	{
@@ -691,7 +744,7 @@ void USMStateMachineComponent::DoShutdown()
 	R_Instance->Shutdown();
 }
 
-void USMStateMachineComponent::DoProcessTransactions(const TArray<FSMNetworkedTransaction>& Transactions)
+void USMStateMachineComponent::DoProcessTransactions(const FSMPackedTransactions& Transactions)
 {
 	if(!R_Instance)
 	{
@@ -703,88 +756,77 @@ void USMStateMachineComponent::DoProcessTransactions(const TArray<FSMNetworkedTr
 		return;
 	}
 
-	const TMap<FGuid, FSMTransition*>& TransitionMap = R_Instance->GetTransitionMap();
-	const TMap<FGuid, FSMState_Base*>& StateMap = R_Instance->GetStateMap();
-	
 	FDateTime CurrentTime = FDateTime::UtcNow();
-	for (const FSMNetworkedTransaction& NetworkedTransaction : Transactions)
+	for (int32 Idx = 0; Idx < Transactions.Num(); ++Idx)
 	{
-		if (FSMStateMachine* OwningStateMachine = (FSMStateMachine*)StateMap.FindRef(NetworkedTransaction.StateMachineGuid))
+		const FSMPackedTransaction& PackedTransaction = Transactions[Idx];
+
+		FSMState_Base* OwningState = R_Instance->GetStateByIndex(PackedTransaction.StateMachineIndex);
+		if (OwningState == nullptr || !OwningState->IsStateMachine())
+		{
+			continue;
+		}
+
+		FSMStateMachine* OwningStateMachine = (FSMStateMachine*)OwningState;
+		if (PackedTransaction.bIsTransition)
 		{
-			if (NetworkedTransaction.IsTransition())
+			// Signal the FSM to take the transition.
+			// TODO: See about refactoring out previous transaction checks from the FSM to the component, similar to state transactions.
+			if (FSMTransition* Transition = R_Instance->GetTransitionByIndex(PackedTransaction.NodeIndex))
 			{
-				// Signal the FSM to take the transition.
-				// TODO: See about refactoring out previous transaction checks from the FSM to the component, similar to state transactions.
-				if (FSMTransition* Transition = (FSMTransition*)TransitionMap.FindRef(NetworkedTransaction.BaseGuid))
+				FSMNetworkedTransaction NetworkedTransaction(OwningStateMachine->GetGuid(), Transition->GetGuid(), ESMTransactionType::SM_Transition);
+				NetworkedTransaction.TransactionGuid = FGuid(PackedTransaction.TransactionId, 0, 0, 0);
+				NetworkedTransaction.Timestamp = FDateTime(PackedTransaction.TimestampTicks);
+				
+				if (OwningStateMachine->ProcessTransition(Transition, &NetworkedTransaction, 0.f, &CurrentTime))
 				{
-					if (OwningStateMachine->ProcessTransition(Transition, &NetworkedTransaction, 0.f, &CurrentTime))
-					{
-						OwningStateMachine->ProcessStates(0.f);
-					}
+					OwningStateMachine->ProcessStates(0.f);
 				}
 			}
-			else if (NetworkedTransaction.IsState())
+		}
+		else
+		{
+			// State networked transactions just switch it from active to not active.
+			FSMTransactionHistory& PreviousTransactions = OwningStateMachine->GetPreviousTransactions();
+			if (!PreviousTransactions.Contains(PackedTransaction.TransactionId))
 			{
-				// State networked transactions just switch it from active to not active.
-				TMap<FGuid, FSMNetworkedTransaction>& PreviousTransactions = OwningStateMachine->GetPreviousTransactions();
-				if (!PreviousTransactions.Contains(NetworkedTransaction.TransactionGuid))
+				if (FSMState_Base* State = R_Instance->GetStateByIndex(PackedTransaction.NodeIndex))
 				{
-					if (FSMState_Base* State = (FSMState_Base*)StateMap.FindRef(NetworkedTransaction.BaseGuid))
+					if (PackedTransaction.bIsActive)
 					{
-						if (NetworkedTransaction.bIsActive)
-						{
-							OwningStateMachine->AddActiveState(State);
-						}
-						else
-						{
-							OwningStateMachine->RemoveActiveState(State);
-						}
-
-						PreviousTransactions.Add(NetworkedTransaction.TransactionGuid, NetworkedTransaction);
+						OwningStateMachine->AddActiveState(State);
 					}
+					else
+					{
+						OwningStateMachine->RemoveActiveState(State);
+					}
+
+					PreviousTransactions.Add(PackedTransaction.TransactionId, CurrentTime);
 				}
 			}
-			
-			OwningStateMachine->CleanupPreviousTransactions(CurrentTime, TransitionResetTimeSeconds);
 		}
+		
+		OwningStateMachine->CleanupPreviousTransactions(CurrentTime, TransitionResetTimeSeconds);
 	}
 }
 
-void USMStateMachineComponent::SendTransactionsToClients(const TArray<FSMNetworkedTransaction>& Transactions)
+void USMStateMachineComponent::SendTransactionsToClients(const FSMPackedTransactions& Transactions)
 {
 	const FDateTime CurrentTime = FDateTime::UtcNow();
 	RemoveExpiredTransactions(CurrentTime);
 
-	// Record the current time. Const cast necessary -- SERVER_ call args must be const, but we want to record the time stamp for the server only.
-	for (FSMNetworkedTransaction& Transaction : const_cast<TArray<FSMNetworkedTransaction>&>(Transactions))
+	// Record the current time for the server only, the ring relies on transactions being added in time order.
+	for (int32 Idx = 0; Idx < Transactions.Num(); ++Idx)
 	{
-		Transaction.Timestamp = CurrentTime;
+		FSMPackedTransaction Transaction = Transactions[Idx];
+		Transaction.TimestampTicks = CurrentTime.GetTicks();
+		R_NetworkedTransactions.Add(Transaction);
 	}
-	
-	R_NetworkedTransactions.Append(Transactions);
 }
 
 void USMStateMachineComponent::RemoveExpiredTransactions(const FDateTime& CurrentTime)
 {
-	const FTimespan Seconds = FTimespan::FromSeconds((double)TransitionResetTimeSeconds);
-
-	int32 RemoveThroughIndex = -1;
-	for (int32 Idx = R_NetworkedTransactions.Num() - 1; Idx >= 0; --Idx)
-	{
-		const FSMNetworkedTransaction& Transaction = R_NetworkedTransactions[Idx];
-		FDateTime ExpirationDate = Transaction.Timestamp + Seconds;
-
-		if (ExpirationDate <= CurrentTime)
-		{
-			RemoveThroughIndex = Idx;
-			break;
-		}
-	}
-
-	if (RemoveThroughIndex >= 0)
-	{
-		R_NetworkedTransactions.RemoveAt(0, RemoveThroughIndex + 1);
-	}
+	R_NetworkedTransactions.RemoveExpired(CurrentTime, FTimespan::FromSeconds((double)TransitionResetTimeSeconds));
 }
 
 bool USMStateMachineComponent::SERVER_Initialize_Validate(UObject* Context)
@@ -837,13 +879,13 @@ void USMStateMachineComponent::SERVER_Shutdown_Implementation()
 	DoShutdown();
 }
 
-bool USMStateMachineComponent::SERVER_ProcessTransaction_Validate(const TArray<FSMNetworkedTransaction>& Transactions)
+bool USMStateMachineComponent::SERVER_ProcessTransaction_Validate(const FSMPackedTransactions& Transactions)
 {
 	// Don't notify if there wasn't at least one new transaction.
 	return Transactions.Num() > 0;
 }
 
-void USMStateMachineComponent::SERVER_ProcessTransaction_Implementation(const TArray<FSMNetworkedTransaction>& Transactions)
+void USMStateMachineComponent::SERVER_ProcessTransaction_Implementation(const FSMPackedTransactions& Transactions)
 {
 	SendTransactionsToClients(Transactions);
 	DoProcessTransactions(Transactions);
@@ -863,11 +905,7 @@ void USMStateMachineComponent::REP_OnInstanceLoaded()
 
 		if (bReplicateStatesOnLoad)
 		{
-			const TArray<FGuid>& States = R_Instance->GetReplicatedStates();
-			if (States.Num() > 0)
-			{
-				R_Instance->LoadFromMultipleStates(States);
-			}
+			R_Instance->LoadFromReplicatedStates();
 		}
 		
 		// It's possible the state machine has already started on the server. The start variable is replicated so we know to start it here.
@@ -1,6 +1,9 @@
 // Copyright Recursoft LLC 2019-2020. All Rights Reserved.
 #include "ISMSystemModule.h"
 #include "SMLogging.h"
+#include "SMInstancePool.h"
+#include "SMDormancyManager.h"
+#include "SMProfiler.h"
 
 DEFINE_LOG_CATEGORY(LogLogicDriver);
 
@@ -24,4 +27,7 @@ void FSMSystemModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	USMInstancePool::ShutdownPool();
+	FSMDormancyManager::Shutdown();
+	FSMProfiler::Shutdown();
 }
@@ -1,6 +1,7 @@
 // Copyright Recursoft LLC 2019-2020. All Rights Reserved.
 
 #include "SMUtils.h"
+#include "SMInstancePool.h"
 #include "Blueprints/SMBlueprintGeneratedClass.h"
 #include "Engine/World.h"
 #include "SMLogging.h"
@@ -8,17 +9,17 @@
 
 USMInstance* USMBlueprintUtils::CreateStateMachineInstance(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context)
 {
-	return CreateStateMachineInstanceInternal(StateMachineClass, Context, nullptr);
+	return CreateStateMachineInstanceInternal(StateMachineClass, Context, nullptr, true);
 }
 
 USMInstance* USMBlueprintUtils::CreateStateMachineInstanceFromTemplate(TSubclassOf<USMInstance> StateMachineClass,
 	UObject* Context, USMInstance* Template)
 {
-	return CreateStateMachineInstanceInternal(StateMachineClass, Context, Template);
+	return CreateStateMachineInstanceInternal(StateMachineClass, Context, Template, true);
 }
 
 USMInstance* USMBlueprintUtils::CreateStateMachineInstanceInternal(TSubclassOf<USMInstance> StateMachineClass,
-	UObject* Context, USMInstance* Template)
+	UObject* Context, USMInstance* Template, bool bAllowPooling)
 {
 	if (StateMachineClass.Get() == nullptr)
 	{
@@ -32,12 +33,39 @@ USMInstance* USMBlueprintUtils::CreateStateMachineInstanceInternal(TSubclassOf<U
 		return nullptr;
 	}
 
+	// The pool only exists once an instance has been released to it.
+	USMInstancePool* Pool = bAllowPooling ? USMInstancePool::Get(false) : nullptr;
+	if (Pool)
+	{
+		if (USMInstance* PooledInstance = Pool->Acquire(StateMachineClass, Context, Template))
+		{
+			return PooledInstance;
+		}
+	}
+
 	USMInstance* Instance = NewObject<USMInstance>(Context, StateMachineClass, NAME_None, RF_NoFlags, Template);
+	Instance->InstanceTemplate = Template;
 	Instance->Initialize(Context);
 
 	return Instance;
 }
 
+bool USMBlueprintUtils::ReleaseStateMachineInstance(USMInstance* Instance)
+{
+	return USMInstancePool::Get()->Release(Instance);
+}
+
+int32 USMBlueprintUtils::PrewarmStateMachineInstances(TSubclassOf<USMInstance> StateMachineClass, UObject* Context, int32 Count, USMInstance* Template)
+{
+	return USMInstancePool::Get()->Prewarm(StateMachineClass, Context, Count, Template);
+}
+
+FSMInstancePoolStats USMBlueprintUtils::GetInstancePoolStats()
+{
+	const USMInstancePool* Pool = USMInstancePool::Get(false);
+	return Pool ? Pool->GetStats() : FSMInstancePoolStats();
+}
+
 bool USMUtils::GenerateStateMachine(UObject* Instance, FSMStateMachine& StateMachineOut,
 	const TSet<FStructProperty*>& RunTimeProperties, bool bDryRun)
 {
@@ -136,8 +164,8 @@ bool USMUtils::GenerateStateMachine(UObject* Instance, FSMStateMachine& StateMac
 				int32& CurrentInstances = CurrentGeneration.InstancesGenerating.FindOrAdd(StateMachineClassReference);
 				CurrentInstances++;
 
-				// Instantiate template.
-				USMInstance* ReferencedInstance = USMBlueprintUtils::CreateStateMachineInstanceFromTemplate(StateMachineClassReference, SMInstance->GetContext(), TemplateInstance);
+				// Instantiate template. References are always constructed, a pooled instance would initialize before it is registered with this generation.
+				USMInstance* ReferencedInstance = USMBlueprintUtils::CreateStateMachineInstanceInternal(StateMachineClassReference, SMInstance->GetContext(), TemplateInstance, false);
 				if (ReferencedInstance == nullptr)
 				{
 					LD_LOG_ERROR(TEXT("Could not create reference %s for use within state machine %s from package %s."), *StateMachineClassReference->GetName(), *StateMachineOut.GetNodeName(), *Instance->GetName());
@@ -416,6 +444,54 @@ UObject* USMUtils::FindTemplateFromInstance(USMInstance* Instance, const FName&
 	return nullptr;
 }
 
+void USMUtils::ResetObjectToArchetype(UObject* Object, const UObject* Archetype)
+{
+	if (!Object)
+	{
+		return;
+	}
+
+	if (!Archetype)
+	{
+		Archetype = Object->GetClass()->GetDefaultObject();
+	}
+
+	if (!Object->GetClass()->IsChildOf(Archetype->GetClass()))
+	{
+		LD_LOG_WARNING(TEXT("Could not reset %s to archetype %s. The classes are not compatible."), *Object->GetName(), *Archetype->GetName());
+		return;
+	}
+
+	for (TFieldIterator<FProperty> It(Archetype->GetClass(), EFieldIteratorFlags::IncludeSuper); It; ++It)
+	{
+		FProperty* Property = *It;
+
+		// Native members hold run-time data managed by the owning class.
+		const UClass* OwnerClass = Property->GetOwnerClass();
+		if (!OwnerClass || OwnerClass->HasAnyClassFlags(CLASS_Native))
+		{
+			continue;
+		}
+
+		// Instanced objects belong to the object being reset and can't be shared with the archetype.
+		if (Property->HasAnyPropertyFlags(CPF_InstancedReference | CPF_ContainsInstancedReference))
+		{
+			continue;
+		}
+
+		// Compiled nodes are linked at initialization and must be preserved.
+		if (FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+		{
+			if (StructProperty->Struct->IsChildOf(FSMNode_Base::StaticStruct()))
+			{
+				continue;
+			}
+		}
+
+		Property->CopyCompleteValue_InContainer(Object, Archetype);
+	}
+}
+
 bool USMUtils::TryGetAllReferenceTemplatesFromInstance(USMInstance* Instance, TSet<USMInstance*>& TemplatesOut, bool bIncludeNested)
 {
 	for (UObject* Template : Instance->ReferenceTemplates)
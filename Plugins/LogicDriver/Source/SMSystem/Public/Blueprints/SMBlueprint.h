@@ -35,6 +35,16 @@ public:
 
 	UPROPERTY(AssetRegistrySearchable)
 	int32 AssetVersion;
+
+#if WITH_EDITORONLY_DATA
+	/** Hash of the root state machine graph as children see it. Children are only recompiled when this changes. */
+	UPROPERTY()
+	uint32 InheritedGraphFingerprint;
+
+	/** State machine node guids mapped to their fingerprint from the last full compile. */
+	UPROPERTY(Transient)
+	TMap<FGuid, uint32> NodeFingerprints;
+#endif
 };
 
 
@@ -68,4 +68,5 @@ class SMSYSTEM_API ISMStateMachineNetworkedInterface
 public:
 	virtual void ProcessTransaction(const TArray<FSMNetworkedTransaction>& Transactions);
 	virtual bool ShouldReplicateStates() const;
+	virtual int32 GetReplicatedStatesBaselineInterval() const;
 };
\ No newline at end of file
@@ -53,6 +53,125 @@ public:
 
 	bool IsTransition() const { return (ESMTransactionType)TransactionType == ESMTransactionType::SM_Transition; }
 	bool IsState() const { return (ESMTransactionType)TransactionType == ESMTransactionType::SM_State; }
+
+	/** Transactions are identified by the first 32 bits of the transaction guid. Only the id is sent over the network. */
+	uint32 GetTransactionId() const { return TransactionGuid.A; }
+};
+
+/** A networked transaction using node indices of the owning instance instead of guids. */
+USTRUCT()
+struct SMSYSTEM_API FSMPackedTransaction
+{
+	GENERATED_USTRUCT_BODY()
+
+	FSMPackedTransaction() : StateMachineIndex(INDEX_NONE), NodeIndex(INDEX_NONE), TransactionId(0), TimestampTicks(0), bIsTransition(true), bIsActive(false) {}
+
+	/** Index of the owning state machine in the instance's indexed states. */
+	int32 StateMachineIndex;
+
+	/** Index of the transition or state in the instance's indexed transitions or states. */
+	int32 NodeIndex;
+
+	uint32 TransactionId;
+
+	/** FDateTime ticks. Sent relative to the oldest transaction in milliseconds. */
+	int64 TimestampTicks;
+
+	uint8 bIsTransition: 1;
+	uint8 bIsActive: 1;
+};
+
+/**
+ * Transactions packed into a single payload. Stored as a bounded ring buffer so the oldest transactions
+ * are dropped once full and expired transactions are removed from the front without shifting.
+ */
+USTRUCT()
+struct SMSYSTEM_API FSMPackedTransactions
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Most transactions stored and the most accepted from the network. */
+	static constexpr int32 MaxTransactions = 128;
+
+	FSMPackedTransactions() : Head(0), Count(0), Revision(0) {}
+
+	/** Add a transaction, dropping the oldest if full. Transactions should be added in time order. */
+	void Add(const FSMPackedTransaction& Transaction);
+
+	/** Add a transaction, passing the payload to Flush and emptying it first if full so nothing is dropped. */
+	void AddOrFlush(const FSMPackedTransaction& Transaction, TFunctionRef<void(const FSMPackedTransactions&)> Flush);
+
+	/** Add all transactions of another payload. */
+	void Append(const FSMPackedTransactions& Other);
+
+	/** Remove transactions older than the timeout from the front. */
+	void RemoveExpired(const FDateTime& CurrentTime, const FTimespan& Timeout);
+
+	void Empty();
+
+	int32 Num() const { return Count; }
+	bool IsFull() const { return Count == MaxTransactions; }
+
+	/** Transaction by age, 0 is the oldest. */
+	const FSMPackedTransaction& operator[](int32 Index) const
+	{
+		check(Index >= 0 && Index < Count);
+		return Transactions[(Head + Index) % MaxTransactions];
+	}
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	/** Changes are detected by revision so the ring doesn't have to be compared. */
+	bool Identical(const FSMPackedTransactions* Other, uint32 PortFlags) const { return Other && Revision == Other->Revision; }
+
+private:
+	TArray<FSMPackedTransaction> Transactions;
+	int32 Head;
+	int32 Count;
+	uint32 Revision;
+};
+
+template<>
+struct TStructOpsTypeTraits<FSMPackedTransactions> : public TStructOpsTypeTraitsBase2<FSMPackedTransactions>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdentical = true,
+	};
+};
+
+/**
+ * Ids of recently processed transactions. A ring buffer in time order so expiry only looks at the front.
+ * It grows instead of dropping ids, a forgotten id still in the replicated window would be processed again.
+ */
+struct SMSYSTEM_API FSMTransactionHistory
+{
+	FSMTransactionHistory() : Head(0), Count(0) {}
+
+	bool Contains(uint32 TransactionId) const { return Ids.Contains(TransactionId); }
+
+	/** Record a transaction, growing if full. */
+	void Add(uint32 TransactionId, const FDateTime& Time);
+
+	/** Remove transactions recorded before the timeout. */
+	void RemoveExpired(const FDateTime& CurrentTime, const FTimespan& Timeout);
+
+	void Empty();
+
+	int32 Num() const { return Count; }
+
+private:
+	struct FEntry
+	{
+		uint32 TransactionId;
+		FDateTime Time;
+	};
+
+	TArray<FEntry> Entries;
+	TSet<uint32> Ids;
+	int32 Head;
+	int32 Count;
 };
 
 /**
@@ -143,6 +262,21 @@ public:
 	/** Create the node instance if a node instance class is set. */
 	void CreateNodeInstance();
 	void CreateStackInstances();
+
+	/** Create the node instance now if its creation was deferred until the node was needed. */
+	FORCEINLINE void EnsureNodeInstance() const
+	{
+		if (bNodeInstanceDeferred)
+		{
+			const_cast<FSMNode_Base*>(this)->CreateNodeInstance();
+		}
+	}
+
+	/**
+	 * Clear run-time data so the node can be started again without being initialized again.
+	 * Graph bindings are kept and node instances have their variables reset to their templates.
+	 */
+	virtual void ResetRuntimeData();
 	
 	/** Calls CheckNodeInstanceCompatible. */
 	void SetNodeInstanceClass(UClass* NewNodeInstanceClass);
@@ -150,11 +284,20 @@ public:
 	/** Derived nodes should overload and check for the correct type. */
 	virtual bool IsNodeInstanceClassCompatible(UClass* NewNodeInstanceClass) const;
 	
-	/** Return the current node instance. Only valid after initialization and may be nullptr. */
-	virtual USMNodeInstance* GetNodeInstance() const { return NodeInstance; }
+	/** Return the current node instance. Only valid after initialization and may be nullptr. Creates a deferred node instance. */
+	virtual USMNodeInstance* GetNodeInstance() const { EnsureNodeInstance(); return NodeInstance; }
+
+	/** Return the node instance only if it has been created. */
+	USMNodeInstance* GetNodeInstanceIfCreated() const { return NodeInstance; }
+
+	/**
+	 * The node instance if created, otherwise the template or class defaults it will be created from.
+	 * Lets deferred nodes read their defaults without being instantiated.
+	 */
+	virtual const USMNodeInstance* GetNodeInstanceDefaults() const;
 	
-	/** Returns the current stack instances. */
-	const TArray<USMNodeInstance*>& GetStackInstances() const { return StackNodeInstances; }
+	/** Returns the current stack instances. Creates deferred stack instances. */
+	const TArray<USMNodeInstance*>& GetStackInstances() const { EnsureNodeInstance(); return StackNodeInstances; }
 	
 	/** Returns a specific state from the stack. */
 	USMNodeInstance* GetNodeInStack(int32 Index) const;
@@ -258,4 +401,7 @@ protected:
 	bool bInitialized;
 
 	bool bIsActive;
+
+	/** The owning instance creates node instances on demand and this node's instance hasn't been needed yet. */
+	bool bNodeInstanceDeferred;
 };
\ No newline at end of file
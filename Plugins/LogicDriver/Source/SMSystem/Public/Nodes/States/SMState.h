@@ -71,6 +71,7 @@ public:
 	// FSMNode_Base
 	virtual void Initialize(UObject* Instance) override;
 	virtual void Reset() override;
+	virtual void ResetRuntimeData() override;
 	virtual bool IsNodeInstanceClassCompatible(UClass* NewNodeInstanceClass) const override;
 	virtual UClass* GetDefaultNodeInstanceClass() const override;
 	virtual void ExecuteInitializeNodes() override;
@@ -60,6 +60,7 @@ public:
 	// FSMState_Base
 	virtual void Initialize(UObject* Instance) override;
 	virtual void Reset() override;
+	virtual void ResetRuntimeData() override;
 	virtual bool StartState() override;
 	virtual bool UpdateState(float DeltaSeconds) override;
 	virtual bool EndState(float DeltaSeconds, const FSMTransition* TransitionToTake = nullptr) override;
@@ -73,6 +74,7 @@ public:
 	virtual bool IsStateMachine() const override { return true; }
 	virtual bool IsNodeInstanceClassCompatible(UClass* NewNodeInstanceClass) const override;
 	virtual USMNodeInstance* GetNodeInstance() const override;
+	virtual const USMNodeInstance* GetNodeInstanceDefaults() const override;
 	virtual UClass* GetDefaultNodeInstanceClass() const override;
 	virtual FSMNode_Base* GetOwnerNode() const override;
 	// ~FSMState_Base
@@ -190,7 +192,7 @@ public:
 	bool IsNetworked() const { return AllActiveTransactions != nullptr; }
 
 	/** Accessor for retrieving any previous transactions. */
-	TMap<FGuid, FSMNetworkedTransaction>& GetPreviousTransactions() { return PreviousTransactions; }
+	FSMTransactionHistory& GetPreviousTransactions() { return PreviousTransactions; }
 	
 	/**
 	 * Forcibly add an active state.
@@ -215,15 +217,18 @@ protected:
 	 * @param FromState: The state we are switching from. If not null it will be removed from the active list if bStayActiveOnStateChange is false.
 	 */
 	void SetCurrentState(FSMState_Base* ToState, FSMState_Base* FromState);
+
+	/** Change ActiveStates, keeping the active state lists of the owning instance and any instances referencing it current. */
+	void AddToActiveStates(FSMState_Base* State);
+	void RemoveFromActiveStates(FSMState_Base* State);
 	
 protected:
 	TArray<FSMState_Base*> States;
 	TArray<FSMTransition*> Transitions;
 	TArray<FSMNetworkedTransaction>* AllActiveTransactions;
 
-	/* The transaction ID mapped to the transaction. */
-	UPROPERTY(Transient)
-	TMap<FGuid, FSMNetworkedTransaction> PreviousTransactions;
+	/* Ids of transactions already processed. */
+	FSMTransactionHistory PreviousTransactions;
 
 	/** The default root entry point. */
 	TSet<FSMState_Base*> EntryStates;
@@ -28,6 +28,9 @@ struct SMSYSTEM_API FSMExposedFunctionHandler
 	/** Execute the function. */
 	void Execute(void* Parms = nullptr) const;
 
+	/** If a graph function was found during initialization. */
+	bool IsBound() const { return bInitialized; }
+
 private:
 	UPROPERTY()
 	UFunction* Function;
@@ -0,0 +1,47 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+
+class USMInstance;
+
+/**
+ * Single tick for all dormant state machine instances. Dormant instances don't tick themselves, instead the manager
+ * advances their time and checks their wake conditions (wake timer and watched properties) in one loop.
+ */
+class SMSYSTEM_API FSMDormancyManager : public FTickableGameObject
+{
+public:
+	FSMDormancyManager();
+
+	/** The global manager. Created on first use. */
+	static FSMDormancyManager& Get();
+
+	/** Destroy the global manager. Any instances still dormant are woken. */
+	static void Shutdown();
+
+	void AddInstance(USMInstance* Instance);
+	void RemoveInstance(USMInstance* Instance);
+
+	/** Advance all dormant instances, waking those which have met a wake condition. */
+	void TickDormantInstances(float DeltaTime);
+
+	int32 GetNumDormantInstances() const { return DormantInstances.Num(); }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableInEditor() const override { return false; }
+	virtual bool IsTickableWhenPaused() const override { return false; }
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	// ~FTickableGameObject
+
+private:
+	/** Dense list of dormant instances. Each instance stores its own index for removal. */
+	TArray<USMInstance*> DormantInstances;
+
+	/** The manager ticks once for every world, only the first tick of a frame is used. */
+	uint64 LastTickFrame;
+};
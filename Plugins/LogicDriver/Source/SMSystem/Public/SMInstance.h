@@ -3,6 +3,7 @@
 
 #include "Tickable.h"
 #include "Net/UnrealNetwork.h"
+#include "Engine/NetSerialization.h"
 #include "SMStateMachine.h"
 #include "SMStateMachineInstance.h"
 #include "SMTransitionInstance.h"
@@ -19,6 +20,79 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnStateMachineTransitionTakenSigna
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnStateMachineStateChangedSignature, class USMInstance*, Instance, struct FSMStateInfo, NewState, struct FSMStateInfo, PreviousState);
 
 
+/** A replicated active state. Only the index into the instance's flattened state map is sent. */
+USTRUCT()
+struct SMSYSTEM_API FSMReplicatedActiveState : public FFastArraySerializerItem
+{
+	GENERATED_USTRUCT_BODY()
+
+	FSMReplicatedActiveState() : StateIndex(INDEX_NONE) {}
+	explicit FSMReplicatedActiveState(int32 InStateIndex) : StateIndex(InStateIndex) {}
+
+	UPROPERTY()
+	int32 StateIndex;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSMReplicatedActiveState> : public TStructOpsTypeTraitsBase2<FSMReplicatedActiveState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * Active states replicated as a fast array so only states which were added or removed are sent.
+ * The fast array keeps its own per connection base state, so late joiners and lost packets still receive every state.
+ * Every BaselineInterval changes all states are marked dirty and sent again as a full baseline.
+ */
+USTRUCT()
+struct SMSYSTEM_API FSMReplicatedActiveStates : public FFastArraySerializer
+{
+	GENERATED_USTRUCT_BODY()
+
+	FSMReplicatedActiveStates() : ChangesSinceBaseline(0) {}
+
+	/**
+	 * Sync with the current active state indices, marking only the differences dirty.
+	 * @param ActiveStateIndices Unique indices of all active states.
+	 * @param BaselineInterval Number of changes before all states are sent again. 0 to disable.
+	 * @return The number of states added or removed.
+	 */
+	int32 Update(const TArray<int32>& ActiveStateIndices, int32 BaselineInterval);
+
+	/** Clear all states. */
+	void Reset();
+
+	/** All replicated state indices. */
+	void GetStateIndices(TArray<int32>& OutStateIndices) const;
+
+	int32 Num() const { return Items.Num(); }
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FSMReplicatedActiveState, FSMReplicatedActiveStates>(Items, DeltaParms, *this);
+	}
+
+private:
+	UPROPERTY()
+	TArray<FSMReplicatedActiveState> Items;
+
+	int32 ChangesSinceBaseline;
+};
+
+template<>
+struct TStructOpsTypeTraits<FSMReplicatedActiveStates> : public TStructOpsTypeTraitsBase2<FSMReplicatedActiveStates>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
 USTRUCT()
 struct FSMDebugStateMachine
 {
@@ -72,6 +146,35 @@ struct FSMDebugStateMachine
 #endif
 };
 
+/**
+ * A property a dormant instance watches for changes. Values are compared by hash when the property type supports it,
+ * otherwise by their exported text.
+ */
+struct SMSYSTEM_API FSMWatchedProperty
+{
+	FSMWatchedProperty() : Property(nullptr), ValueHash(0) {}
+	FSMWatchedProperty(UObject* InObject, FProperty* InProperty) : Object(InObject), Property(InProperty), ValueHash(0) {}
+
+	/** Record the current value. */
+	void Capture();
+
+	/** If the value differs from the last capture. True if the object is no longer valid. */
+	bool HasChanged() const;
+
+	bool Matches(const UObject* InObject, const FName& PropertyName) const
+	{
+		return Object.Get() == InObject && Property && Property->GetFName() == PropertyName;
+	}
+
+private:
+	bool ReadValue(uint32& OutHash, FString& OutText) const;
+
+	TWeakObjectPtr<UObject> Object;
+	FProperty* Property;
+	uint32 ValueHash;
+	FString ValueText;
+};
+
 /**
  * The base class all blueprint state machines inherit from. The compiled state machine is accessible through GetRootStateMachine().
  */
@@ -82,6 +185,10 @@ class SMSYSTEM_API USMInstance : public UObject, public FTickableGameObject, pub
 
 public:
 	friend class USMStateMachineComponent;
+	friend class USMBlueprintUtils;
+	friend class USMInstancePool;
+	friend class FSMDormancyManager;
+	friend struct FSMStateMachine;
 	
 	USMInstance();
 	// FTickableGameObject
@@ -147,6 +254,74 @@ public:
 	void StartWithNewContext(UObject* Context);
 	// ~USMStateMachineInterface
 
+	/**
+	 * Stop the state machine and return it to the state it was in after initialization without constructing the graph again.
+	 * Active states, loaded states and transaction history are cleared, event bindings are removed and Blueprint variables
+	 * of this instance, its node instances and references are reset to their templates.
+	 *
+	 * @return False if the instance isn't initialized.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool ResetToInitialState();
+
+	/** The template this instance was created from. Null if created from the class defaults. */
+	USMInstance* GetInstanceTemplate() const { return InstanceTemplate; }
+
+	/** If this instance is currently held by the instance pool. */
+	bool IsPooled() const { return bIsPooled; }
+
+	/**
+	 * Put the instance to sleep. A dormant instance doesn't tick or evaluate transitions until it is woken by a transition event,
+	 * a watched property changing, the wake timer expiring, a manual Update or WakeUp. Time spent dormant is applied to the
+	 * active states on the first update after waking.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void GoDormant();
+
+	/** Wake a dormant instance so it resumes ticking. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void WakeUp();
+
+	UFUNCTION(BlueprintPure, Category = "Logic Driver|State Machine Instances")
+	bool IsDormant() const { return bIsDormant; }
+
+	/** Allow the instance to go dormant automatically once updates pass without a state change. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void SetCanGoDormant(bool bValue);
+
+	UFUNCTION(BlueprintPure, Category = "Logic Driver|State Machine Instances")
+	bool CanGoDormant() const { return bCanGoDormant; }
+
+	/** Create node instances when first needed instead of during Initialize. Takes effect the next time the instance is initialized. */
+	void SetCreateNodeInstancesOnDemand(bool bValue) { bCreateNodeInstancesOnDemand = bValue; }
+	bool ShouldCreateNodeInstancesOnDemand() const { return bCreateNodeInstancesOnDemand; }
+
+	/**
+	 * Wake the instance when a property changes while dormant. Watch the properties transitions out of idle states depend on.
+	 *
+	 * @param Object The object owning the property, such as the context.
+	 * @param PropertyName The name of a property of the object's class.
+	 * @return False if the property could not be found.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool AddWatchedProperty(UObject* Object, FName PropertyName);
+
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void RemoveWatchedProperty(UObject* Object, FName PropertyName);
+
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void ClearWatchedProperties();
+
+	/**
+	 * Wake the instance once this many seconds of state machine time have passed. Used for transitions depending on time in state.
+	 * A value of zero or less clears the timer.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	void SetWakeTimer(float Seconds);
+
+	/** Advance a dormant instance by a frame and wake it if a wake condition is met. Returns true if the instance woke. */
+	bool UpdateDormant(float DeltaSeconds);
+
 	/**
 	 * Signals to the owning state machine to process transition evaluation.
 	 * This is similar to calling Update on the owner root state machine, however state update logic (Tick) won't execute.
@@ -174,6 +349,32 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
 	void LoadFromMultipleStates(const TArray<FGuid>& FromGuids);
 
+	/**
+	 * Write a compact binary snapshot of all active states and their time in state.
+	 * States are written by their index in the flattened state map instead of by guid, so the snapshot
+	 * can only be loaded into an instance of the same state machine class.
+	 * @param OutSnapshot The snapshot bytes.
+	 * @param bIncludeNodeInstanceProperties Also write all node instance properties marked SaveGame.
+	 * @return True if the snapshot was written.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool SaveSnapshot(TArray<uint8>& OutSnapshot, bool bIncludeNodeInstanceProperties = false) const;
+
+	/**
+	 * Restore a snapshot written by SaveSnapshot(). Must be called before Start, the same as LoadFromMultipleStates().
+	 * Time in state is applied once the states are started.
+	 * @param Snapshot The snapshot bytes.
+	 * @return False if the snapshot is malformed or was written from a different state machine.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
+	bool LoadFromSnapshot(const TArray<uint8>& Snapshot);
+
+	/** Write a snapshot to any archive. See SaveSnapshot(). */
+	bool WriteSnapshot(FArchive& Ar, bool bIncludeNodeInstanceProperties = false) const;
+
+	/** Read a snapshot from any archive. See LoadFromSnapshot(). */
+	bool ReadSnapshot(FArchive& Ar);
+
 //#pragma region Node Locator Helpers
 	/**
 	 * Return the current active state name, or an empty string.
@@ -230,6 +431,13 @@ public:
 
 	/** Recursively retrieve all active states. */
 	TArray<FSMState_Base*> GetAllActiveStates() const;
+
+	/**
+	 * All active states including nested state machines and references without searching or allocating.
+	 * The list is maintained as states start and end. The order is not guaranteed. Unlike GetAllActiveStates(),
+	 * temporary initial states loaded before the instance starts are not included.
+	 */
+	const TArray<FSMState_Base*>& GetActiveStatesView() const { return ActiveStateList; }
 	
 	/**
 	 * Recursively retrieve the guid of all current states. Useful if saving the current state of a state machine.
@@ -393,7 +601,26 @@ public:
 	/** Get all mapped PathGuids to transitions. */
 	const TMap<FGuid, FSMTransition*>& GetTransitionMap() const { return GuidTransitionMap; }
 
-	const TArray<FGuid>& GetReplicatedStates() const { return R_ActiveStates; }
+	/** The guids of the replicated active states. Prefer LoadFromReplicatedStates() which doesn't need guids. */
+	TArray<FGuid> GetReplicatedStates() const;
+
+	/** The replicated active states. */
+	const FSMReplicatedActiveStates& GetReplicatedActiveStates() const { return R_ActiveStates; }
+
+	/** Set the temporary initial states from the replicated active states. Used when a client instance is loaded. */
+	void LoadFromReplicatedStates();
+
+	/** Indices of all active states in the flattened state map. Same states as GetAllActiveStateGuids(). */
+	void GetAllActiveStateIndices(TArray<int32>& OutStateIndices) const;
+
+	/** Retrieve a state by its index in the flattened state map. */
+	FSMState_Base* GetStateByIndex(int32 Index) const { return IndexedStates.IsValidIndex(Index) ? IndexedStates[Index] : nullptr; }
+
+	/** Retrieve a transition by its index in the flattened transition map. */
+	FSMTransition* GetTransitionByIndex(int32 Index) const { return IndexedTransitions.IsValidIndex(Index) ? IndexedTransitions[Index] : nullptr; }
+
+	/** Convert a transaction to node indices for sending over the network. Returns false if the nodes aren't mapped. */
+	bool PackTransaction(const FSMNetworkedTransaction& Transaction, FSMPackedTransaction& OutPackedTransaction) const;
 
 	/** Retrieve all state instances. These can be States, State Machines, and Conduits. */
 	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Instances")
@@ -547,6 +774,22 @@ protected:
 	 * of all instances built to prevent stack overflow in the event of state machine references that self reference. */
 	void BuildStateMachineMap(FSMStateMachine* StateMachine, TSet<USMInstance*>& InstancesMapped);
 
+	/** Give a mapped state the next snapshot index. */
+	void AddIndexedState(FSMState_Base* State);
+
+	/** Called by state machines as their active states change, including nested state machines and references. */
+	void AddToActiveStateList(FSMState_Base* State);
+	void RemoveFromActiveStateList(FSMState_Base* State);
+
+	/** The active state list, or when nothing is active any temporary initial states found by searching. */
+	const TArray<FSMState_Base*>& GetActiveStatesOrInitial(TArray<FSMState_Base*>& InitialStates) const;
+
+	/** Set a state from the flattened state map as a temporary initial state of its parent. */
+	void LoadFromStateIndex(int32 StateIndex);
+
+	/** Restore the time in state of states loaded from a snapshot. Called after the root state machine has started. */
+	void ApplyPendingSnapshotTimes();
+
 	/** Logs a warning if not initialized. */
 	bool CheckIsInitialized() const;
 
@@ -580,6 +823,65 @@ protected:
 	
 	/** Map of all StateMachine Path Guids */
 	TSet<FGuid> StateMachineGuids;
+
+	/** All states of GuidStateMap in the order they were mapped. The order is deterministic for a class which makes the index usable in snapshots. */
+	TArray<FSMState_Base*> IndexedStates;
+
+	/** State -> index in IndexedStates. Reference root state machines share the index of the state machine node referencing them. */
+	TMap<const FSMState_Base*, int32> StateIndexMap;
+
+	/** All transitions of GuidTransitionMap in the order they were mapped. */
+	TArray<FSMTransition*> IndexedTransitions;
+
+	/** Transition -> index in IndexedTransitions. */
+	TMap<const FSMTransition*, int32> TransitionIndexMap;
+
+	/** Hash of all indexed state guids used to validate snapshots. */
+	uint32 StateLayoutHash;
+
+	/** Dense list of every active state across all nesting levels and references. */
+	TArray<FSMState_Base*> ActiveStateList;
+
+	/** State -> index in ActiveStateList for swap removal. */
+	TMap<const FSMState_Base*, int32> ActiveStateListIndices;
+
+	/** Time in state restored from a snapshot, applied once the states start. */
+	TArray<TPair<int32, float>> PendingSnapshotTimes;
+
+	/** The template passed to NewObject, needed to reset the instance since the archetype isn't otherwise recorded. */
+	UPROPERTY(Transient)
+	USMInstance* InstanceTemplate;
+
+	/** Set while the instance is held by the instance pool. Pooled instances don't tick. */
+	bool bIsPooled;
+
+	/** Properties which wake the instance when changed. */
+	TArray<FSMWatchedProperty> WatchedProperties;
+
+	/** Seconds left until the instance should be awake. Less than zero if no timer is set. */
+	float WakeTimeRemaining;
+
+	/** Index in the dormancy manager or INDEX_NONE when awake. */
+	int32 DormantIndex;
+
+	/** Consecutive updates without a state change. */
+	int32 IdleUpdates;
+
+	/** The frame the dormancy manager woke this instance. The delta of that frame was already applied by the manager. */
+	uint64 DormantWakeFrame;
+
+	/** The frame an update put this instance to sleep. The delta of that frame was already applied by the update. */
+	uint64 DormantSleepFrame;
+
+	bool bIsDormant;
+
+	/** A state change or event occurred during the current update, preventing dormancy. */
+	bool bHadActivityThisUpdate;
+
+	/** If this instance is included in the awake instance stat. */
+	bool bCountedAwake;
+
+	void UpdateDormancyStats();
 	
 	/** Networked transactions that are currently being executed. Only valid for one update cycle and only used if there is a server object. */
 	UPROPERTY(Transient)
@@ -593,9 +895,9 @@ protected:
 	UPROPERTY(Replicated, Transient, meta = (DisplayName=Context))
 	UObject* R_StateMachineContext;
 
-	/** Replicated active state guids. */
+	/** Replicated active state indices. */
 	UPROPERTY(Replicated, Transient)
-	TArray<FGuid> R_ActiveStates;
+	FSMReplicatedActiveStates R_ActiveStates;
 	
 	/** If this instance is owned by another instance making this a reference. */
 	UPROPERTY()
@@ -612,6 +914,26 @@ protected:
 	/** Should this instance stop itself once an end state has been reached. An Update call is required for this to occur. */
 	UPROPERTY(EditAnywhere, Category = "State Machine Instance")
 	bool bStopOnEndState = false;
+
+	/**
+	 * Allow the instance to go dormant once updates pass without a state change. A dormant instance stops ticking and doesn't
+	 * evaluate transitions until woken by a transition event, a watched property changing, the wake timer or a manual update.
+	 * Only enable this when transitions out of idle states are driven by events, watched properties or time in state.
+	 */
+	UPROPERTY(EditAnywhere, Category = "State Machine Instance|Dormancy")
+	bool bCanGoDormant = false;
+
+	/** Consecutive updates without a state change before the instance goes dormant. */
+	UPROPERTY(EditAnywhere, Category = "State Machine Instance|Dormancy", meta = (EditCondition = "bCanGoDormant", ClampMin = "1"))
+	int32 IdleUpdatesBeforeDormant = 1;
+
+	/**
+	 * Create node instances the first time a node becomes active, runs a graph or has its instance requested, instead of
+	 * creating every node instance during Initialize. Reduces initialize time and memory of large state machines where most
+	 * nodes are rarely entered. Until then a node reads its defaults from its shared template.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "State Machine Instance|Performance")
+	bool bCreateNodeInstancesOnDemand = false;
 	
 	/** Should this instance tick. By default it will update the state machine. */
 	UPROPERTY(EditAnywhere, Category = "State Machine Instance|Tick")
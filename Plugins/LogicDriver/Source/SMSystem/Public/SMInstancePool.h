@@ -0,0 +1,140 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "SMInstancePool.generated.h"
+
+class USMInstance;
+
+/** Released instances sharing the same archetype. */
+USTRUCT()
+struct FSMInstancePoolEntry
+{
+	GENERATED_BODY()
+
+	FSMInstancePoolEntry() : ObjectsPerInstance(0) {}
+
+	/** Instances reset to their initial state and ready to be handed out. */
+	UPROPERTY()
+	TArray<USMInstance*> Instances;
+
+	/** UObjects kept alive by a single pooled instance: the instance, its node instances and references. */
+	int32 ObjectsPerInstance;
+};
+
+/** Lifetime counters of the instance pool. */
+USTRUCT(BlueprintType)
+struct SMSYSTEM_API FSMInstancePoolStats
+{
+	GENERATED_BODY()
+
+	FSMInstancePoolStats() : Hits(0), Misses(0), Released(0), Rejected(0), ObjectsRecycled(0), NumPooled(0), NumPooledObjects(0) {}
+
+	/** Instances handed out from the pool. */
+	UPROPERTY(BlueprintReadOnly, Category = "Logic Driver|Instance Pool")
+	int32 Hits;
+
+	/** Instance requests that had to construct a new instance. */
+	UPROPERTY(BlueprintReadOnly, Category = "Logic Driver|Instance Pool")
+	int32 Misses;
+
+	/** Instances returned to the pool. */
+	UPROPERTY(BlueprintReadOnly, Category = "Logic Driver|Instance Pool")
+	int32 Released;
+
+	/** Instances which couldn't be pooled. */
+	UPROPERTY(BlueprintReadOnly, Category = "Logic Driver|Instance Pool")
+	int32 Rejected;
+
+	/** UObjects that didn't have to be constructed because of pool hits. */
+	UPROPERTY(BlueprintReadOnly, Category = "Logic Driver|Instance Pool")
+	int32 ObjectsRecycled;
+
+	/** Instances currently pooled. */
+	UPROPERTY(BlueprintReadOnly, Category = "Logic Driver|Instance Pool")
+	int32 NumPooled;
+
+	/** UObjects currently kept alive by the pool. */
+	UPROPERTY(BlueprintReadOnly, Category = "Logic Driver|Instance Pool")
+	int32 NumPooledObjects;
+
+	/** Hits / requests in the range of 0 - 1. */
+	float GetHitRate() const
+	{
+		const int32 Requests = Hits + Misses;
+		return Requests > 0 ? (float)Hits / (float)Requests : 0.f;
+	}
+};
+
+/**
+ * Recycles state machine instances so the graph, node instances and references don't have to be constructed again.
+ * Instances are pooled by their archetype, which is the template they were created from or the class default object.
+ *
+ * Pooling is opt-in, only instances given back through Release() are reused. Once anything has been pooled
+ * USMBlueprintUtils::CreateStateMachineInstance will hand out pooled instances before constructing new ones.
+ * Node instances are recycled along with the instance owning them.
+ */
+UCLASS(Transient)
+class SMSYSTEM_API USMInstancePool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	USMInstancePool();
+
+	/**
+	 * The global instance pool.
+	 * @param bCreateIfMissing Create the pool if nothing has been pooled yet.
+	 */
+	static USMInstancePool* Get(bool bCreateIfMissing = true);
+
+	/** Remove the global pool, leaving all pooled instances to garbage collection. */
+	static void ShutdownPool();
+
+	/**
+	 * Take an instance out of the pool. The instance is moved into the context and remains initialized.
+	 * @return A pooled instance or nullptr if none of this class and template are pooled.
+	 */
+	USMInstance* Acquire(UClass* StateMachineClass, UObject* Context, USMInstance* Template = nullptr);
+
+	/**
+	 * Reset an instance to its initial state and keep it for reuse. The instance shouldn't be used by the caller afterwards.
+	 * References and instances owned by a state machine component can't be released.
+	 *
+	 * @return False if the instance was not pooled.
+	 */
+	bool Release(USMInstance* Instance);
+
+	/** Construct and pool instances ahead of time. Returns the number of instances added to the pool. */
+	int32 Prewarm(UClass* StateMachineClass, UObject* Context, int32 Count, USMInstance* Template = nullptr);
+
+	/** Remove all pooled instances leaving them to garbage collection. */
+	void Empty();
+
+	/** Number of pooled instances of a class and template. */
+	int32 GetNumPooled(UClass* StateMachineClass, USMInstance* Template = nullptr) const;
+
+	const FSMInstancePoolStats& GetStats() const { return Stats; }
+	void ResetStats();
+
+	/** Maximum instances kept for a single archetype. Instances released past this are left to garbage collection. */
+	int32 MaxPooledPerArchetype;
+
+protected:
+	static UObject* GetArchetype(UClass* StateMachineClass, USMInstance* Template);
+
+	/** Rename the instance and its references into a new outer and context. */
+	static void MoveInstance(USMInstance* Instance, UObject* NewOuter, UObject* Context, bool bPooled);
+
+	/** Count the instance, node instances and references. */
+	static int32 CountObjects(USMInstance* Instance);
+
+	void UpdateStats();
+
+protected:
+	UPROPERTY()
+	TMap<UObject*, FSMInstancePoolEntry> PooledInstances;
+
+	FSMInstancePoolStats Stats;
+};
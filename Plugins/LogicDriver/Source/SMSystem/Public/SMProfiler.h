@@ -0,0 +1,214 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Templates/Atomic.h"
+#include "UObject/WeakObjectPtr.h"
+
+/** Node tracing is compiled out of shipping builds unless a target defines this. */
+#ifndef LOGICDRIVER_TRACE_ENABLED
+	#define LOGICDRIVER_TRACE_ENABLED !UE_BUILD_SHIPPING
+#endif
+
+struct FSMNode_Base;
+class USMInstance;
+
+enum class ESMTraceEventType : uint8
+{
+	StateBegin,
+	StateUpdate,
+	StateEnd,
+	TransitionEvaluated,
+	TransitionTaken,
+	Max
+};
+
+/** A single timed node event. Kept small and trivially copyable since it's written to the trace buffer from the update loop. */
+struct FSMTraceEvent
+{
+	TWeakObjectPtr<USMInstance> Instance;
+	const UClass* InstanceClass;
+	FGuid NodeGuid;
+	uint64 StartCycles;
+	uint32 DurationCycles;
+	ESMTraceEventType Type;
+	/** Transition evaluations only: if the transition passed. */
+	bool bResult;
+};
+
+/** Aggregated timings of one node. State machine durations include their nested states. */
+struct SMSYSTEM_API FSMTraceNodeStats
+{
+	FSMTraceNodeStats() : TotalCycles(0), NumPassed(0)
+	{
+		FMemory::Memzero(Counts);
+		FMemory::Memzero(Cycles);
+		FMemory::Memzero(MaxCycles);
+	}
+
+	FString NodeName;
+	FGuid NodeGuid;
+
+	int32 Counts[(int32)ESMTraceEventType::Max];
+	uint64 Cycles[(int32)ESMTraceEventType::Max];
+	uint32 MaxCycles[(int32)ESMTraceEventType::Max];
+
+	/** All event cycles, used to sort the hot list. */
+	uint64 TotalCycles;
+
+	/** Transition evaluations which passed. */
+	int32 NumPassed;
+};
+
+/** A transition taken while tracing. */
+struct FSMTraceTakenTransition
+{
+	const UClass* InstanceClass;
+	FGuid NodeGuid;
+	/** Seconds since tracing started. */
+	double Timestamp;
+};
+
+/**
+ * Opt-in per node tracing of state begin, update and end, transition evaluations and taken transitions.
+ *
+ * Nodes write events to a fixed size ring buffer which is drained once a frame and aggregated into per class hot lists.
+ * Writers reserve a slot with an atomic index and publish the event with a per slot sequence number (a seqlock). The drain
+ * copies the event and only keeps it if the sequence was unchanged around the copy, so events which were still being
+ * written or were overwritten are counted as dropped rather than read torn. A writer which laps another writer still
+ * filling the same slot drops its own event. When tracing is not running a node only pays for a single branch.
+ *
+ * Console commands:
+ *   LogicDriver.Trace.Start [BufferSize]
+ *   LogicDriver.Trace.Stop
+ *   LogicDriver.Trace.Dump [NumNodes]  Log the hottest nodes of each class.
+ *   LogicDriver.Trace.Export [Path]    Write the hot lists and taken transitions to CSV. Defaults to the profiling directory.
+ */
+class SMSYSTEM_API FSMProfiler : public FTickableGameObject
+{
+public:
+	FSMProfiler();
+	virtual ~FSMProfiler();
+
+	static FSMProfiler& Get();
+	static void Shutdown();
+
+	/** If events are being recorded. Checked by every traced node. */
+	static FORCEINLINE bool IsTracing() { return bIsTracing.Load(EMemoryOrder::Relaxed); }
+
+	/**
+	 * Begin recording from the game thread. Previously aggregated data is cleared. The buffer may be reallocated, so this
+	 * must not be called while state machines are updating on other threads.
+	 * @param BufferSize Events which can be recorded between drains, rounded up to a power of two.
+	 */
+	void StartTrace(int32 BufferSize = 65536);
+	void StopTrace();
+
+	/** Write an event to the ring buffer. Safe to call from any thread. */
+	void Record(const FSMTraceEvent& Event);
+
+	/** Move all recorded events into the aggregated stats. Must only be called from one thread at a time. */
+	void Flush();
+
+	/** Discard all aggregated data. */
+	void Reset();
+
+	/** The nodes of a state machine class sorted by total time, most expensive first. */
+	TArray<FSMTraceNodeStats> GetHotList(const UClass* InstanceClass, int32 MaxNodes = -1) const;
+
+	/** All traced state machine classes. */
+	TArray<const UClass*> GetTracedClasses() const;
+
+	const TArray<FSMTraceTakenTransition>& GetTakenTransitions() const { return TakenTransitions; }
+
+	/** Events overwritten before they could be drained. */
+	int64 GetNumDroppedEvents() const { return NumDroppedEvents; }
+
+	/** Write the hot lists to a CSV file and the taken transitions to a second file with a _Transitions suffix. */
+	bool ExportCSV(const FString& FilePath) const;
+
+	/** Log the hottest nodes of every traced class. */
+	void DumpHotLists(int32 MaxNodes = 10) const;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return IsTracing(); }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	// ~FTickableGameObject
+
+private:
+	struct FSlot
+	{
+		FSMTraceEvent Event;
+		/** Write index + 1 once the event is complete, WritingSequence while a writer owns the slot, 0 if never written. */
+		TAtomic<uint64> Sequence;
+	};
+
+	struct FClassStats
+	{
+		TMap<FGuid, FSMTraceNodeStats> Nodes;
+	};
+
+	void Aggregate(const FSMTraceEvent& Event);
+
+	/** Marks a slot a writer is currently filling. */
+	static constexpr uint64 WritingSequence = MAX_uint64;
+
+	static TAtomic<bool> bIsTracing;
+
+	TUniquePtr<FSlot[]> Slots;
+	uint64 NumSlots;
+	TAtomic<uint64> WriteIndex;
+	uint64 ReadIndex;
+	int64 NumDroppedEvents;
+
+	uint64 TraceStartCycles;
+
+	TMap<const UClass*, FClassStats> ClassStats;
+	TArray<FSMTraceTakenTransition> TakenTransitions;
+
+	/** Taken transitions kept for export. Further transitions are still aggregated. */
+	static constexpr int32 MaxTakenTransitions = 100000;
+};
+
+/** Times a node event for the duration of the scope when tracing. */
+struct SMSYSTEM_API FSMTraceScope
+{
+	FORCEINLINE FSMTraceScope(const FSMNode_Base* InNode, ESMTraceEventType InType, const bool* InResult = nullptr)
+	{
+		Node = FSMProfiler::IsTracing() ? InNode : nullptr;
+		if (Node)
+		{
+			Type = InType;
+			Result = InResult;
+			StartCycles = FPlatformTime::Cycles64();
+		}
+	}
+
+	FORCEINLINE ~FSMTraceScope()
+	{
+		if (Node)
+		{
+			Finish();
+		}
+	}
+
+private:
+	void Finish();
+
+	const FSMNode_Base* Node;
+	const bool* Result;
+	uint64 StartCycles;
+	ESMTraceEventType Type;
+};
+
+#if LOGICDRIVER_TRACE_ENABLED
+	#define SM_TRACE_SCOPE(Node, Type) FSMTraceScope ANONYMOUS_VARIABLE(SMTraceScope)(Node, Type)
+	#define SM_TRACE_SCOPE_RESULT(Node, Type, Result) FSMTraceScope ANONYMOUS_VARIABLE(SMTraceScope)(Node, Type, Result)
+#else
+	#define SM_TRACE_SCOPE(Node, Type)
+	#define SM_TRACE_SCOPE_RESULT(Node, Type, Result)
+#endif
@@ -74,6 +74,9 @@ public:
 
 	/** Should the instance replicate states. */
 	virtual bool ShouldReplicateStates() const override;
+
+	/** Number of state changes before all active states are replicated again. */
+	virtual int32 GetReplicatedStatesBaselineInterval() const override;
 	// ~ISMStateMachineNetworkedInstance
 
 	/** If this is a networked environment. */
@@ -168,8 +171,15 @@ protected:
 	virtual void DoStop();
 	virtual void DoShutdown();
 
-	virtual void DoProcessTransactions(const TArray<FSMNetworkedTransaction>& Transactions);
-	void SendTransactionsToClients(const TArray<FSMNetworkedTransaction>& Transactions);
+	virtual void DoProcessTransactions(const FSMPackedTransactions& Transactions);
+	void SendTransactionsToClients(const FSMPackedTransactions& Transactions);
+
+	/** Convert transactions from the instance to node indices. Full payloads are passed to Flush before more are added. */
+	void PackTransactions(const TArray<FSMNetworkedTransaction>& Transactions, FSMPackedTransactions& OutPackedTransactions,
+		TFunctionRef<void(const FSMPackedTransactions&)> Flush) const;
+
+	/** Send all transactions queued this frame to the server in one call. */
+	void FlushOutgoingTransactions();
 
 	/* Removes all replicated transitions that have expired. */
 	void RemoveExpiredTransactions(const FDateTime& CurrentTime);
@@ -197,7 +207,7 @@ protected:
 
 	/** Signal the server of changing transitions. */
 	UFUNCTION(Server, Reliable, WithValidation)
-	void SERVER_ProcessTransaction(const TArray<FSMNetworkedTransaction>& Transactions);
+	void SERVER_ProcessTransaction(const FSMPackedTransactions& Transactions);
 
 	/** When the StateMachineInstance is loaded from the server. */
 	UFUNCTION()
@@ -269,6 +279,13 @@ public:
 	 */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "Network", meta = (EditCondition = "bReplicates"))
 	bool bReplicateStatesOnLoad;
+
+	/**
+	 * Only added and removed states are replicated. After this many changes all active states are sent again as a baseline,
+	 * which corrects clients that changed their states locally. Set to 0 to only send changes.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, AdvancedDisplay, Category = "Network", meta = (EditCondition = "bReplicateStatesOnLoad", ClampMin = "0"))
+	int32 ReplicatedStatesBaselineInterval;
 	
 	/**
 	 * When true, if the client receives transitions before the state machine has initialized it will discard them.
@@ -300,11 +317,15 @@ public:
 protected:
 	/** Transactions which the server has replicated. Generally transitions. */
 	UPROPERTY(Transient, ReplicatedUsing = REP_NetworkedTransactions)
-	TArray<FSMNetworkedTransaction> R_NetworkedTransactions;
+	FSMPackedTransactions R_NetworkedTransactions;
 
 	/** Transitions which couldn't be processed yet. */
 	UPROPERTY(Transient)
-	TArray<FSMNetworkedTransaction> PendingTransactions;
+	FSMPackedTransactions PendingTransactions;
+
+	/** Transactions taken locally this frame waiting to be sent to the server. */
+	UPROPERTY(Transient)
+	FSMPackedTransactions OutgoingTransactions;
 	
 	/** The actual state machine instance. */
 	UPROPERTY(Transient, ReplicatedUsing = REP_OnInstanceLoaded, meta=(DisplayName = Instance))
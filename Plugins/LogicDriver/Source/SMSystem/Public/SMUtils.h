@@ -4,6 +4,7 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "SMInstance.h"
+#include "SMInstancePool.h"
 #include "SMUtils.generated.h"
 
 
@@ -24,8 +25,29 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Logic Driver|State Machine Utilities")
 	static USMInstance* CreateStateMachineInstanceFromTemplate(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, USMInstance* Template);
 
+	/**
+	 * Reset an instance to its initial state and return it to the instance pool. Later calls to create an instance
+	 * of the same class and template will reuse it instead of constructing a new one. The instance should not be used after releasing.
+	 * Instances owned by a component or another state machine can't be released.
+	 *
+	 * @return True if the instance was pooled.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Utilities")
+	static bool ReleaseStateMachineInstance(USMInstance* Instance);
+
+	/** Construct instances ahead of time and add them to the instance pool. Returns the number of instances pooled. */
+	UFUNCTION(BlueprintCallable, Category = "Logic Driver|State Machine Utilities")
+	static int32 PrewarmStateMachineInstances(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, int32 Count, USMInstance* Template = nullptr);
+
+	/** Hit and object counts of the instance pool. */
+	UFUNCTION(BlueprintPure, Category = "Logic Driver|State Machine Utilities")
+	static FSMInstancePoolStats GetInstancePoolStats();
+
 private:
-	static USMInstance* CreateStateMachineInstanceInternal(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, USMInstance* Template);
+	/** @param bAllowPooling Reuse a pooled instance if available. Only top level instances are pooled, references are always constructed. */
+	static USMInstance* CreateStateMachineInstanceInternal(TSubclassOf<class USMInstance> StateMachineClass, UObject* Context, USMInstance* Template, bool bAllowPooling);
+
+	friend class USMUtils;
 };
 
 /**
@@ -64,6 +86,14 @@ public:
 	/** Search up parents for a default sub objects for a template. */
 	static UObject* FindTemplateFromInstance(USMInstance* Instance, const FName& TemplateName);
 
+	/**
+	 * Copy the values of all Blueprint declared variables from an archetype. Native members and run-time node structs are left alone.
+	 *
+	 * @param Object The object to reset.
+	 * @param Archetype The template the object was created from. Uses the class default object if null.
+	 */
+	static void ResetObjectToArchetype(UObject* Object, const UObject* Archetype = nullptr);
+
 	/** Find all reference templates from an instance. Nested children shouldn't be found after a compile or during run-time! */
 	static bool TryGetAllReferenceTemplatesFromInstance(USMInstance* Instance, TSet<USMInstance*>& TemplatesOut, bool bIncludeNested = false);
 
@@ -84,7 +84,8 @@ bool FSMKismetCompiler::GetBlueprintTypesForClass(UClass* ParentClass, UClass*&
 
 FSMKismetCompilerContext::FSMKismetCompilerContext(UBlueprint* InBlueprint,
 	FCompilerResultsLog& InMessageLog, const FKismetCompilerOptions& InCompilerOptions) :
-	FKismetCompilerContext(InBlueprint, InMessageLog, InCompilerOptions), NewSMBlueprintClass(nullptr)
+	FKismetCompilerContext(InBlueprint, InMessageLog, InCompilerOptions), NewSMBlueprintClass(nullptr), bInheritedGraphChanged(true),
+	CompiledGraphFingerprint(0), NumFingerprintedNodes(0), NumChangedNodes(0)
 {
 	if (InBlueprint->HasAnyFlags(RF_NeedPostLoad))
 	{
@@ -102,9 +103,35 @@ FSMKismetCompilerContext::FSMKismetCompilerContext(UBlueprint* InBlueprint,
 	bBlueprintIsDerived = CastChecked<USMBlueprint>(InBlueprint)->FindOldestParentBlueprint() != nullptr;
 }
 
+FSMKismetCompilerContext::~FSMKismetCompilerContext()
+{
+	if (PhaseTimings.Num() == 0)
+	{
+		return;
+	}
+
+	double TotalTime = 0.0;
+	FString Phases;
+	for (const TPair<const TCHAR*, double>& Phase : PhaseTimings)
+	{
+		TotalTime += Phase.Value;
+		Phases += FString::Printf(TEXT(" %s: %.2fms"), Phase.Key, Phase.Value * 1000.0);
+	}
+
+	UE_LOG(LogLogicDriverEditor, Log, TEXT("%s compile of %s took %.2fms in timed phases. %d of %d nodes changed, inherited graph %s.%s"),
+		CompileOptions.CompileType == EKismetCompileType::SkeletonOnly ? TEXT("Skeleton") : TEXT("Full"), *GetNameSafe(Blueprint),
+		TotalTime * 1000.0, NumChangedNodes, NumFingerprintedNodes, bInheritedGraphChanged ? TEXT("changed") : TEXT("unchanged"), *Phases);
+}
+
 void FSMKismetCompilerContext::MergeUbergraphPagesIn(UEdGraph* Ubergraph)
 {
-	Super::MergeUbergraphPagesIn(Ubergraph);
+	const auto RunPhase = [this](const TCHAR* PhaseName, TFunctionRef<void()> Phase)
+	{
+		FScopedPhaseTimer PhaseTimer(*this, PhaseName);
+		Phase();
+	};
+
+	RunPhase(TEXT("MergeUbergraphPages"), [&]() { Super::MergeUbergraphPagesIn(Ubergraph); });
 
 	// Make sure we expand any split pins here before we process state machine nodes.
 	for (TArray<UEdGraphNode*>::TIterator NodeIt(ConsolidatedEventGraph->Nodes); NodeIt; ++NodeIt)
@@ -139,14 +166,14 @@ void FSMKismetCompilerContext::MergeUbergraphPagesIn(UEdGraph* Ubergraph)
 	NewSMBlueprintClass->SetRootGuid(RootStateMachineNode->GetNodeGuid());
 
 	USMGraph* RootStateMachineGraph = RootStateMachine->GetStateMachineGraph();
-	ValidateAllNodes(RootStateMachineGraph);
-	PreProcessStateMachineNodes(RootStateMachineGraph);
-	PreProcessRuntimeReferences(RootStateMachineGraph);
-	ExpandParentNodes(RootStateMachineGraph);
-	ProcessStateMachineGraph(RootStateMachineGraph);
-	ProcessPropertyNodes();
-	ProcessRuntimeContainers();
-	ProcessRuntimeReferences();
+	RunPhase(TEXT("ValidateAllNodes"), [&]() { ValidateAllNodes(RootStateMachineGraph); });
+	RunPhase(TEXT("PreProcessStateMachineNodes"), [&]() { PreProcessStateMachineNodes(RootStateMachineGraph); });
+	RunPhase(TEXT("PreProcessRuntimeReferences"), [&]() { PreProcessRuntimeReferences(RootStateMachineGraph); });
+	RunPhase(TEXT("ExpandParentNodes"), [&]() { ExpandParentNodes(RootStateMachineGraph); });
+	RunPhase(TEXT("ProcessStateMachineGraph"), [&]() { ProcessStateMachineGraph(RootStateMachineGraph); });
+	RunPhase(TEXT("ProcessPropertyNodes"), [&]() { ProcessPropertyNodes(); });
+	RunPhase(TEXT("ProcessRuntimeContainers"), [&]() { ProcessRuntimeContainers(); });
+	RunPhase(TEXT("ProcessRuntimeReferences"), [&]() { ProcessRuntimeReferences(); });
 }
 
 void FSMKismetCompilerContext::SpawnNewClass(const FString& NewClassName)
@@ -177,6 +204,7 @@ void FSMKismetCompilerContext::CleanAndSanitizeClass(UBlueprintGeneratedClass* C
 	// Fixes #151. CommandLet can cause a crash during BP modify.
 	if (CompileOptions.CompileType != EKismetCompileType::BytecodeOnly)
 	{
+		FScopedPhaseTimer PhaseTimer(*this, TEXT("RecompileChildren"));
 		RecompileChildren();
 	}
 	
@@ -186,6 +214,8 @@ void FSMKismetCompilerContext::CleanAndSanitizeClass(UBlueprintGeneratedClass* C
 
 void FSMKismetCompilerContext::CopyTermDefaultsToDefaultObject(UObject* DefaultObject)
 {
+	FScopedPhaseTimer PhaseTimer(*this, TEXT("CopyTermDefaultsToDefaultObject"));
+	
 	Super::CopyTermDefaultsToDefaultObject(DefaultObject);
 
 	USMInstance* DefaultInstance = CastChecked<USMInstance>(DefaultObject);
@@ -419,6 +449,8 @@ void FSMKismetCompilerContext::PreCompile()
 			Node->PreCompile(*this);
 		}
 	}
+
+	UpdateGraphFingerprints();
 }
 
 void FSMKismetCompilerContext::PostCompile()
@@ -434,6 +466,15 @@ void FSMKismetCompilerContext::PostCompile()
 			Node->PostCompileValidate(MessageLog);
 		}
 	}
+
+	// Only a successful full compile becomes the new baseline. After a failed compile children stay marked until the
+	// errors are fixed and the blueprint compiles.
+	USMBlueprint* SMBlueprint = GetSMBlueprint();
+	if (SMBlueprint && CompiledGraphFingerprint != 0 && CompileOptions.CompileType == EKismetCompileType::Full && MessageLog.NumErrors == 0)
+	{
+		SMBlueprint->InheritedGraphFingerprint = CompiledGraphFingerprint;
+		SMBlueprint->NodeFingerprints = MoveTemp(CompiledNodeFingerprints);
+	}
 }
 
 USMGraphK2Node_StateMachineNode* FSMKismetCompilerContext::GetRootStateMachineNode() const
@@ -1776,6 +1817,13 @@ void FSMKismetCompilerContext::RecompileChildren()
 	}
 	
 	FSMBlueprintEditorUtils::MarkBlueprintAsModified(Blueprint);
+
+	// Children only clone the state machine graph. Event graph, variable and function edits are handled by a normal skeleton recompile.
+	if (!bInheritedGraphChanged)
+	{
+		return;
+	}
+	
 	if (Blueprint->SkeletonGeneratedClass && !Blueprint->HasAnyFlags(RF_NeedLoad | RF_NeedPostLoad))
 	{
 		TArray<UClass*> ChildClasses;
@@ -1830,4 +1878,190 @@ void FSMKismetCompilerContext::RecompileChildren()
 	}
 }
 
+void FSMKismetCompilerContext::UpdateGraphFingerprints()
+{
+	USMBlueprint* SMBlueprint = GetSMBlueprint();
+	USMGraph* Graph = FSMBlueprintEditorUtils::GetRootStateMachineGraph(Blueprint);
+	if (!SMBlueprint || !Graph)
+	{
+		return;
+	}
+
+	FScopedPhaseTimer PhaseTimer(*this, TEXT("Fingerprint"));
+	
+	TMap<FGuid, uint32> NodeFingerprints;
+	const uint32 GraphFingerprint = CalculateGraphFingerprint(Graph, NodeFingerprints);
+
+	NumFingerprintedNodes = NodeFingerprints.Num();
+	NumChangedNodes = 0;
+	for (const TPair<FGuid, uint32>& NodeFingerprint : NodeFingerprints)
+	{
+		const uint32* PreviousFingerprint = SMBlueprint->NodeFingerprints.Find(NodeFingerprint.Key);
+		if (!PreviousFingerprint || *PreviousFingerprint != NodeFingerprint.Value)
+		{
+			NumChangedNodes++;
+		}
+	}
+
+	// Zero is a blueprint which hasn't been fully compiled since fingerprinting was added.
+	bInheritedGraphChanged = SMBlueprint->InheritedGraphFingerprint == 0 || SMBlueprint->InheritedGraphFingerprint != GraphFingerprint;
+
+	// Stored in PostCompile. Skeleton and failed compiles compare against the last successful full compile so children
+	// stay marked until the edit is fully compiled.
+	CompiledGraphFingerprint = GraphFingerprint;
+	CompiledNodeFingerprints = MoveTemp(NodeFingerprints);
+}
+
+static uint32 HashString(const FString& String)
+{
+	// Fingerprints are saved so they can't use name indices or pointers.
+	return FCrc::StrCrc32(*String);
+}
+
+static uint32 HashObjectProperties(const UObject* Object, uint32 Hash)
+{
+	static const FName CollectedLogsName(TEXT("CollectedLogs"));
+	
+	Hash = HashCombine(Hash, HashString(Object->GetClass()->GetPathName()));
+	for (TFieldIterator<FProperty> It(Object->GetClass()); It; ++It)
+	{
+		const FProperty* Property = *It;
+
+		// Position, comments and messages from the last compile don't change the compiled result.
+		if (Property->HasAnyPropertyFlags(CPF_Transient) || Property->GetOwnerClass() == UEdGraphNode::StaticClass() ||
+			Property->GetFName() == CollectedLogsName)
+		{
+			continue;
+		}
+
+		for (int32 Idx = 0; Idx < Property->ArrayDim; ++Idx)
+		{
+			FString Value;
+			Property->ExportTextItem(Value, Property->ContainerPtrToValuePtr<void>(Object, Idx), nullptr, const_cast<UObject*>(Object), PPF_None);
+			Hash = HashCombine(Hash, HashString(Value));
+		}
+	}
+
+	return Hash;
+}
+
+/** Hash node templates and any other instanced objects. Graphs and their nodes are hashed separately. */
+static uint32 HashSubObjects(const UObject* Outer, uint32 Hash)
+{
+	TArray<UObject*> SubObjects;
+	GetObjectsWithOuter(Outer, SubObjects, false);
+
+	// Creation order isn't stable between sessions.
+	SubObjects.Sort([](const UObject& A, const UObject& B)
+	{
+		return A.GetName() < B.GetName();
+	});
+	
+	for (const UObject* SubObject : SubObjects)
+	{
+		if (SubObject->IsPendingKill() || SubObject->HasAnyFlags(RF_Transient) || SubObject->IsA<UEdGraph>() || SubObject->IsA<UEdGraphNode>())
+		{
+			continue;
+		}
+
+		Hash = HashCombine(Hash, HashString(SubObject->GetName()));
+		Hash = HashObjectProperties(SubObject, Hash);
+		Hash = HashSubObjects(SubObject, Hash);
+	}
+
+	return Hash;
+}
+
+static uint32 HashGraphNode(const UEdGraphNode* Node)
+{
+	uint32 Hash = GetTypeHash(Node->NodeGuid);
+	Hash = HashCombine(Hash, GetTypeHash((uint8)Node->IsNodeEnabled()));
+	Hash = HashObjectProperties(Node, Hash);
+
+	for (const UEdGraphPin* Pin : Node->Pins)
+	{
+		Hash = HashCombine(Hash, HashString(Pin->PinName.ToString()));
+		Hash = HashCombine(Hash, HashString(Pin->PinType.PinCategory.ToString()));
+		Hash = HashCombine(Hash, HashString(Pin->PinType.PinSubCategory.ToString()));
+		Hash = HashCombine(Hash, HashString(GetPathNameSafe(Pin->PinType.PinSubCategoryObject.Get())));
+		Hash = HashCombine(Hash, GetTypeHash((uint8)Pin->PinType.ContainerType));
+		Hash = HashCombine(Hash, GetTypeHash((uint8)Pin->PinType.bIsReference));
+		Hash = HashCombine(Hash, HashString(Pin->DefaultValue));
+		Hash = HashCombine(Hash, HashString(GetPathNameSafe(Pin->DefaultObject)));
+		Hash = HashCombine(Hash, HashString(Pin->DefaultTextValue.ToString()));
+
+		for (const UEdGraphPin* LinkedPin : Pin->LinkedTo)
+		{
+			if (const UEdGraphNode* LinkedNode = LinkedPin->GetOwningNodeUnchecked())
+			{
+				Hash = HashCombine(Hash, GetTypeHash(LinkedNode->NodeGuid));
+			}
+			Hash = HashCombine(Hash, HashString(LinkedPin->PinName.ToString()));
+		}
+	}
+
+	if (const USMGraphNode_Base* StateMachineNode = Cast<USMGraphNode_Base>(Node))
+	{
+		Hash = HashSubObjects(StateMachineNode, Hash);
+
+		// Parent and reference graphs are compiled into this blueprint so their changes are inherited too.
+		if (const USMGraphNode_StateMachineParentNode* ParentNode = Cast<USMGraphNode_StateMachineParentNode>(Node))
+		{
+			if (const USMBlueprint* ParentBlueprint = Cast<USMBlueprint>(UBlueprint::GetBlueprintFromClass(ParentNode->ParentClass)))
+			{
+				Hash = HashCombine(Hash, ParentBlueprint->InheritedGraphFingerprint);
+			}
+		}
+		else if (const USMGraphNode_StateMachineStateNode* StateMachineStateNode = Cast<USMGraphNode_StateMachineStateNode>(Node))
+		{
+			if (const USMBlueprint* ReferencedBlueprint = StateMachineStateNode->GetStateMachineReference())
+			{
+				Hash = HashCombine(Hash, ReferencedBlueprint->InheritedGraphFingerprint);
+			}
+		}
+	}
+
+	return Hash;
+}
+
+uint32 FSMKismetCompilerContext::CalculateGraphFingerprint(USMGraph* StateMachineGraph, TMap<FGuid, uint32>& OutNodeFingerprints)
+{
+	OutNodeFingerprints.Reset();
+	if (!StateMachineGraph)
+	{
+		return 0;
+	}
+
+	TArray<UEdGraphNode*> Nodes;
+	FSMBlueprintEditorUtils::GetAllNodesOfClassNested<UEdGraphNode>(StateMachineGraph, Nodes);
+
+	for (const UEdGraphNode* Node : Nodes)
+	{
+		// Nodes in state, transition and property graphs belong to the state machine node owning the graph.
+		const USMGraphNode_Base* OwningNode = Cast<USMGraphNode_Base>(Node);
+		for (const UObject* Outer = Node->GetOuter(); !OwningNode && Outer; Outer = Outer->GetOuter())
+		{
+			OwningNode = Cast<USMGraphNode_Base>(Outer);
+		}
+
+		// Anything outside of a state machine node, such as the entry node, uses an empty guid.
+		uint32& NodeFingerprint = OutNodeFingerprints.FindOrAdd(OwningNode ? OwningNode->NodeGuid : FGuid());
+		NodeFingerprint = HashCombine(NodeFingerprint, HashGraphNode(Node));
+	}
+
+	OutNodeFingerprints.KeySort([](const FGuid& A, const FGuid& B)
+	{
+		return A < B;
+	});
+
+	uint32 GraphFingerprint = 0;
+	for (const TPair<FGuid, uint32>& NodeFingerprint : OutNodeFingerprints)
+	{
+		GraphFingerprint = HashCombine(GraphFingerprint, HashCombine(GetTypeHash(NodeFingerprint.Key), NodeFingerprint.Value));
+	}
+
+	// Zero is reserved for blueprints which haven't been fingerprinted.
+	return GraphFingerprint != 0 ? GraphFingerprint : 1;
+}
+
 #undef LOCTEXT_NAMESPACE
@@ -65,6 +65,18 @@ class FSMKismetCompilerContext : public FKismetCompilerContext
 public:
 	FSMKismetCompilerContext(UBlueprint* InBlueprint,
 		FCompilerResultsLog& InMessageLog, const FKismetCompilerOptions& InCompilerOptions);
+	virtual ~FSMKismetCompilerContext();
+
+	/**
+	 * Hash everything under a state machine graph which affects the compiled result. Node positions, comments and compiler
+	 * messages are ignored. Parent and reference nodes include the fingerprint of the blueprint they use.
+	 *
+	 * @param StateMachineGraph The root state machine graph.
+	 * @param OutNodeFingerprints State machine node guids mapped to the hash of the node and everything it owns.
+	 *
+	 * @return The combined hash of all nodes.
+	 */
+	static SMSYSTEMEDITOR_API uint32 CalculateGraphFingerprint(USMGraph* StateMachineGraph, TMap<FGuid, uint32>& OutNodeFingerprints);
 
 protected:
 	// FKismetCompilerContext interface
@@ -156,6 +168,31 @@ public:
 protected:
 	/* Looks for derived blueprints with parent calls and marks the blueprints dirty. */
 	void RecompileChildren();
+
+	/**
+	 * Fingerprint the root state machine graph and record which nodes changed since the last successful full compile.
+	 * The blueprint's fingerprints are only updated in PostCompile once the compile succeeded.
+	 */
+	void UpdateGraphFingerprints();
+
+	/** Records the duration of a compile phase for the summary logged once compiling is finished. */
+	struct FScopedPhaseTimer
+	{
+		FScopedPhaseTimer(FSMKismetCompilerContext& InContext, const TCHAR* InPhaseName) : Context(InContext), PhaseName(InPhaseName),
+			StartTime(FPlatformTime::Seconds())
+		{
+		}
+
+		~FScopedPhaseTimer()
+		{
+			Context.PhaseTimings.Emplace(PhaseName, FPlatformTime::Seconds() - StartTime);
+		}
+
+	private:
+		FSMKismetCompilerContext& Context;
+		const TCHAR* PhaseName;
+		double StartTime;
+	};
 	
 protected:
 	friend class USMGraphNode_Base;
@@ -183,4 +220,18 @@ protected:
 	 * Current derived behavior allows child graphs to replace parent graphs.
 	 */
 	bool bBlueprintIsDerived;
+
+	/** If the graph children inherit has changed since the last full compile. Unchanged graphs don't recompile children. */
+	bool bInheritedGraphChanged;
+
+	/** Fingerprints calculated in PreCompile, saved to the blueprint if the compile succeeds. */
+	uint32 CompiledGraphFingerprint;
+	TMap<FGuid, uint32> CompiledNodeFingerprints;
+
+	/** State machine nodes fingerprinted and how many of them changed since the last full compile. */
+	int32 NumFingerprintedNodes;
+	int32 NumChangedNodes;
+
+	/** Phase name and duration in seconds, in the order run. */
+	TArray<TPair<const TCHAR*, double>> PhaseTimings;
 };
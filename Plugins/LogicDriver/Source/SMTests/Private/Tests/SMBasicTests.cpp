@@ -18,6 +18,15 @@
 #include "Graph/Nodes/SMGraphNode_TransitionEdge.h"
 #include "Graph/Nodes/SMGraphNode_StateMachineStateNode.h"
 #include "Graph/Nodes/SMGraphNode_ConduitNode.h"
+#include "SMInstancePool.h"
+#include "SMDormancyManager.h"
+#include "SMStateMachineComponent.h"
+#include "SMProfiler.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+#include "Async/Async.h"
+#include "SMUtils.h"
 
 
 #if WITH_DEV_AUTOMATION_TESTS
@@ -430,6 +439,659 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStateNodeSingleTickTest, "SMTests.SingleTick",
 	return NewAsset.DeleteAsset(this);
 }
 
+/**
+ * Released instances should be reset to their initial state and handed back out instead of being constructed again.
+ * Also logs the time to construct instances compared to acquiring them from the pool.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstancePoolTest, "SMTests.InstancePool", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FInstancePoolTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	// A -> [A -> B] -> C
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+	USMGraphNode_StateMachineStateNode* NestedFSM = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 2, &LastStatePin, nullptr);
+	LastStatePin = NestedFSM->GetOutputPin();
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	UClass* StateMachineClass = NewBP->GetGeneratedClass();
+
+	USMInstancePool* Pool = USMInstancePool::Get();
+	Pool->Empty();
+	Pool->ResetStats();
+
+	USMInstance* StateMachineInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+	const FGuid InitialStateGuid = StateMachineInstance->GetRootStateMachine().GetInitialStates()[0]->GetGuid();
+	const USMNodeInstance* RootNodeInstance = StateMachineInstance->GetRootStateMachine().GetNodeInstance();
+
+	TestHelpers::RunAllStateMachinesToCompletion(this, StateMachineInstance, &StateMachineInstance->GetRootStateMachine(), 2);
+	TestTrue("State machine running", StateMachineInstance->IsActive());
+	TestTrue("Moved past the initial state", StateMachineInstance->GetRootStateMachine().GetSingleActiveState()->GetGuid() != InitialStateGuid);
+
+	// Release resets the instance.
+	TestTrue("Instance released", USMBlueprintUtils::ReleaseStateMachineInstance(StateMachineInstance));
+	TestTrue("Instance pooled", StateMachineInstance->IsPooled());
+	TestFalse("Pooled instance can't tick", StateMachineInstance->IsTickable());
+	TestFalse("Pooled instance stopped", StateMachineInstance->IsActive());
+	TestFalse("Pooled instance not started", StateMachineInstance->HasStarted());
+	TestFalse("Events unbound", StateMachineInstance->OnStateMachineStateChangedEvent.IsBound());
+	TestNull("Pooled instance has no context", StateMachineInstance->GetContext());
+	TestTrue("Pooled instance outered to pool", StateMachineInstance->GetOuter() == Pool);
+	TestEqual("Pool count", Pool->GetNumPooled(StateMachineClass), 1);
+	TestFalse("Instance can't be released twice", Pool->Release(StateMachineInstance));
+
+	// The same instance is handed out with a fresh run.
+	USMTestContext* NewContext = NewObject<USMTestContext>();
+	USMInstance* PooledInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewContext);
+	TestTrue("Instance reused", PooledInstance == StateMachineInstance);
+	TestTrue("Node instance reused", PooledInstance->GetRootStateMachine().GetNodeInstance() == RootNodeInstance);
+	TestTrue("Context set", PooledInstance->GetContext() == NewContext);
+	TestTrue("Outered to context", PooledInstance->GetOuter() == NewContext);
+	TestFalse("Instance no longer pooled", PooledInstance->IsPooled());
+	TestEqual("Pool hit", Pool->GetStats().Hits, 1);
+	TestTrue("Objects recycled", Pool->GetStats().ObjectsRecycled > 1);
+
+	PooledInstance->Start();
+	TestEqual("Starts from the initial state", PooledInstance->GetRootStateMachine().GetSingleActiveState()->GetGuid(), InitialStateGuid);
+	TestTrue("Pooled instance runs to completion", TestHelpers::RunAllStateMachinesToCompletion(this, PooledInstance, &PooledInstance->GetRootStateMachine()) > 0);
+	TestTrue("Pooled instance in end state", PooledInstance->IsInEndState());
+
+	// Nothing left to hand out.
+	USMInstance* NewInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+	TestTrue("New instance constructed", NewInstance != PooledInstance);
+	TestEqual("Pool miss", Pool->GetStats().Misses, 1);
+	TestEqual("Hit rate", Pool->GetStats().GetHitRate(), 0.5f);
+
+	TestEqual("Prewarmed", USMBlueprintUtils::PrewarmStateMachineInstances(StateMachineClass, NewObject<USMTestContext>(), 4), 4);
+	TestEqual("Pool count after prewarm", Pool->GetNumPooled(StateMachineClass), 4);
+
+	// Construction compared to the pool.
+	{
+		const int32 Iterations = 200;
+		Pool->Empty();
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			USMBlueprintUtils::CreateStateMachineInstance(StateMachineClass, NewContext);
+		}
+		const double ConstructSeconds = FPlatformTime::Seconds() - StartTime;
+
+		USMBlueprintUtils::ReleaseStateMachineInstance(USMBlueprintUtils::CreateStateMachineInstance(StateMachineClass, NewContext));
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			USMBlueprintUtils::ReleaseStateMachineInstance(USMBlueprintUtils::CreateStateMachineInstance(StateMachineClass, NewContext));
+		}
+		const double PooledSeconds = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("Create x%d: constructed %.3fms, pooled %.3fms, hit rate %.2f"), Iterations,
+			ConstructSeconds * 1000.0, PooledSeconds * 1000.0, Pool->GetStats().GetHitRate()));
+	}
+
+	Pool->Empty();
+	Pool->ResetStats();
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * A pooled class used as a reference inside another state machine. References are always constructed during generation,
+ * only top level instances come from the pool.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInstancePoolReferenceTest, "SMTests.InstancePoolReference", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FInstancePoolReferenceTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	// A -> [Reference: A -> B] -> C
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+	USMGraphNode_StateMachineStateNode* NestedFSM = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 2, &LastStatePin, nullptr);
+	LastStatePin = NestedFSM->GetOutputPin();
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+
+	FString ReferencedAssetName = "PoolRef_0";
+	USMBlueprint* ReferencedBP = FSMBlueprintEditorUtils::ConvertStateMachineToReference(NestedFSM, false, &ReferencedAssetName, nullptr);
+	TestNotNull("Referenced blueprint created", ReferencedBP);
+	if (ReferencedBP == nullptr)
+	{
+		return NewAsset.DeleteAsset(this);
+	}
+
+	FString ReferencedPath = ReferencedBP->GetPathName();
+	FAssetHandler ReferencedAsset(ReferencedBP->GetName(), USMBlueprint::StaticClass(), NewObject<USMBlueprintFactory>(), &ReferencedPath);
+	ReferencedAsset.Object = ReferencedBP;
+	ReferencedAsset.Package = FAssetData(ReferencedBP).GetPackage();
+
+	FKismetEditorUtilities::CompileBlueprint(ReferencedBP);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	UClass* ReferencedClass = ReferencedBP->GetGeneratedClass();
+
+	USMInstancePool* Pool = USMInstancePool::Get();
+	Pool->Empty();
+	Pool->ResetStats();
+
+	// Pool the referenced class as a top level state machine.
+	TestEqual("Referenced class prewarmed", USMBlueprintUtils::PrewarmStateMachineInstances(ReferencedClass, NewObject<USMTestContext>(), 2), 2);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* StateMachineInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+
+	TArray<USMInstance*> References = StateMachineInstance->GetAllReferencedInstances();
+	TestEqual("One reference", References.Num(), 1);
+	if (References.Num() == 1)
+	{
+		USMInstance* Reference = References[0];
+		TestFalse("Reference not pooled", Reference->IsPooled());
+		TestTrue("Reference initialized", Reference->IsInitialized());
+		TestTrue("Reference owned by the state machine", Reference->GetReferenceOwner() == StateMachineInstance);
+		TestTrue("Reference uses the owner's context", Reference->GetContext() == Context);
+	}
+
+	TestEqual("Pooled references untouched", Pool->GetNumPooled(ReferencedClass), 2);
+	TestEqual("No pool hits from references", Pool->GetStats().Hits, 0);
+	TestEqual("Only the top level instance missed", Pool->GetStats().Misses, 1);
+
+	StateMachineInstance->Start();
+	TestTrue("State machine runs to completion", TestHelpers::RunAllStateMachinesToCompletion(this, StateMachineInstance, &StateMachineInstance->GetRootStateMachine()) > 0);
+	TestTrue("State machine in end state", StateMachineInstance->IsInEndState());
+
+	// The referenced class is still handed out at the top level.
+	USMInstance* TopLevelInstance = USMBlueprintUtils::CreateStateMachineInstance(ReferencedClass, Context);
+	TestTrue("Top level instance pooled", TopLevelInstance && Pool->GetStats().Hits == 1);
+	TestEqual("Pooled count after acquiring", Pool->GetNumPooled(ReferencedClass), 1);
+
+	// An owner released with its reference keeps it when handed out again.
+	TestTrue("Owner released", USMBlueprintUtils::ReleaseStateMachineInstance(StateMachineInstance));
+	USMInstance* PooledOwner = USMBlueprintUtils::CreateStateMachineInstance(NewBP->GetGeneratedClass(), NewObject<USMTestContext>());
+	TestTrue("Owner reused", PooledOwner == StateMachineInstance);
+	TestTrue("Reference reused with the owner", PooledOwner->GetAllReferencedInstances() == References);
+	TestEqual("Pooled references still untouched", Pool->GetNumPooled(ReferencedClass), 1);
+
+	PooledOwner->Start();
+	TestTrue("Reused owner runs to completion", TestHelpers::RunAllStateMachinesToCompletion(this, PooledOwner, &PooledOwner->GetRootStateMachine()) > 0);
+
+	Pool->Empty();
+	Pool->ResetStats();
+
+	ReferencedAsset.DeleteAsset(this);
+	return NewAsset.DeleteAsset(this);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDormantStateMachineTest, "SMTests.DormantStateMachine", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FDormantStateMachineTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 4;
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	FSMDormancyManager& DormancyManager = FSMDormancyManager::Get();
+
+	USMTestContext* PollingContext = NewObject<USMTestContext>();
+	USMTestContext* DormantContext = NewObject<USMTestContext>();
+	PollingContext->bCanTransition = false;
+	DormantContext->bCanTransition = false;
+
+	USMInstance* PollingInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, PollingContext);
+	USMInstance* DormantInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, DormantContext);
+	DormantInstance->SetCanGoDormant(true);
+	TestTrue("Watched property added", DormantInstance->AddWatchedProperty(DormantContext, GET_MEMBER_NAME_CHECKED(USMTestContext, bCanTransition)));
+	TestFalse("Missing property can't be watched", DormantInstance->AddWatchedProperty(DormantContext, TEXT("NotAProperty")));
+
+	PollingInstance->Start();
+	DormantInstance->Start();
+
+	// Mimic a frame: the dormancy manager ticks once, then every tickable instance.
+	auto SimulateFrame = [&]()
+	{
+		++GFrameCounter;
+		DormancyManager.TickDormantInstances(1.f);
+		for (USMInstance* Instance : { PollingInstance, DormantInstance })
+		{
+			if (Instance->IsTickable())
+			{
+				Instance->Tick(1.f);
+			}
+		}
+	};
+
+	auto VerifyMatching = [&](const FString& When)
+	{
+		FSMState_Base* PollingState = PollingInstance->GetRootStateMachine().GetSingleActiveState();
+		FSMState_Base* DormantState = DormantInstance->GetRootStateMachine().GetSingleActiveState();
+		if (!PollingState || !DormantState)
+		{
+			TestTrue(FString::Printf(TEXT("Both instances active %s"), *When), PollingState == DormantState);
+			return;
+		}
+		TestEqual(FString::Printf(TEXT("Active state %s"), *When), DormantState->GetGuid(), PollingState->GetGuid());
+		TestEqual(FString::Printf(TEXT("Time in state %s"), *When), DormantState->TimeInState, PollingState->TimeInState);
+		TestEqual(FString::Printf(TEXT("States entered %s"), *When), DormantContext->GetEntryInt(), PollingContext->GetEntryInt());
+		TestTrue(FString::Printf(TEXT("In end state %s"), *When), DormantInstance->IsInEndState() == PollingInstance->IsInEndState());
+	};
+
+	// Idle instances go dormant and stop ticking.
+	for (int32 Frame = 0; Frame < 3; ++Frame)
+	{
+		SimulateFrame();
+	}
+	TestTrue("Idle instance dormant", DormantInstance->IsDormant());
+	TestFalse("Dormant instance not tickable", DormantInstance->IsTickable());
+	TestFalse("Polling instance never dormant", PollingInstance->IsDormant());
+	TestEqual("Manager tracks the dormant instance", DormancyManager.GetNumDormantInstances(), 1);
+
+	// Changing the watched property wakes the instance which then behaves the same as the polling instance.
+	PollingContext->bCanTransition = true;
+	DormantContext->bCanTransition = true;
+	for (int32 Frame = 0; Frame < TotalStates && !PollingInstance->IsInEndState(); ++Frame)
+	{
+		SimulateFrame();
+		VerifyMatching(FString::Printf(TEXT("frame %d"), Frame));
+		TestFalse("Awake while transitioning", DormantInstance->IsDormant());
+	}
+	TestTrue("Polling instance in end state", PollingInstance->IsInEndState());
+	TestTrue("Dormant instance in end state", DormantInstance->IsInEndState());
+
+	// Wake timer.
+	DormantInstance->Stop();
+	DormantContext->bCanTransition = false;
+	DormantInstance->Start();
+	DormantInstance->GoDormant();
+	TestTrue("Manually dormant", DormantInstance->IsDormant());
+	DormantInstance->SetWakeTimer(2.f);
+	DormancyManager.TickDormantInstances(1.f);
+	TestTrue("Dormant before timer expires", DormantInstance->IsDormant());
+	DormancyManager.TickDormantInstances(1.f);
+	TestFalse("Timer wakes the instance", DormantInstance->IsDormant());
+
+	// Manual wake and update. Automatic dormancy is disabled so the update doesn't put the instance back to sleep.
+	DormantInstance->SetCanGoDormant(false);
+	DormantInstance->GoDormant();
+	DormantInstance->WakeUp();
+	TestFalse("Manual wake", DormantInstance->IsDormant());
+	DormantInstance->GoDormant();
+	DormantInstance->Update(0.f);
+	TestFalse("Update wakes", DormantInstance->IsDormant());
+
+	// Stopped instances never stay dormant.
+	DormantInstance->GoDormant();
+	DormantInstance->Stop();
+	TestFalse("Stop wakes", DormantInstance->IsDormant());
+	TestEqual("Manager empty", DormancyManager.GetNumDormantInstances(), 0);
+
+	// Component owned instances are ticked by their component, which runs before the dormancy manager.
+	{
+		USMTestContext* PollingComponentContext = NewObject<USMTestContext>();
+		USMTestContext* DormantComponentContext = NewObject<USMTestContext>();
+		PollingComponentContext->bCanTransition = false;
+		DormantComponentContext->bCanTransition = false;
+
+		USMStateMachineComponent* PollingComponent = NewObject<USMStateMachineComponent>(GetTransientPackage());
+		USMStateMachineComponent* DormantComponent = NewObject<USMStateMachineComponent>(GetTransientPackage());
+		PollingComponent->StateMachineClass = NewBP->GeneratedClass;
+		DormantComponent->StateMachineClass = NewBP->GeneratedClass;
+		PollingComponent->Initialize(PollingComponentContext);
+		DormantComponent->Initialize(DormantComponentContext);
+
+		USMInstance* PollingComponentInstance = PollingComponent->GetInstance();
+		USMInstance* DormantComponentInstance = DormantComponent->GetInstance();
+		if (TestNotNull("Polling component instance", PollingComponentInstance) && TestNotNull("Dormant component instance", DormantComponentInstance))
+		{
+			DormantComponentInstance->SetCanGoDormant(true);
+			DormantComponentInstance->AddWatchedProperty(DormantComponentContext, GET_MEMBER_NAME_CHECKED(USMTestContext, bCanTransition));
+
+			PollingComponent->Start();
+			DormantComponent->Start();
+
+			auto SimulateComponentFrame = [&]()
+			{
+				++GFrameCounter;
+				PollingComponent->TickComponent(1.f, LEVELTICK_All, nullptr);
+				DormantComponent->TickComponent(1.f, LEVELTICK_All, nullptr);
+				DormancyManager.TickDormantInstances(1.f);
+			};
+
+			auto GetTimeInState = [](USMInstance* Instance)
+			{
+				FSMState_Base* State = Instance->GetRootStateMachine().GetSingleActiveState();
+				return State ? State->TimeInState : -1.f;
+			};
+
+			for (int32 Frame = 0; Frame < 3; ++Frame)
+			{
+				SimulateComponentFrame();
+			}
+			TestTrue("Idle component instance dormant", DormantComponentInstance->IsDormant());
+
+			// The component leaves the dormant instance alone instead of waking and updating it every frame.
+			const float DormantTimeInState = GetTimeInState(DormantComponentInstance);
+			for (int32 Frame = 0; Frame < 5; ++Frame)
+			{
+				SimulateComponentFrame();
+			}
+			TestTrue("Component instance stays dormant", DormantComponentInstance->IsDormant());
+			TestEqual("Dormant component instance not updated", GetTimeInState(DormantComponentInstance), DormantTimeInState);
+
+			// Woken by the manager at the end of a frame, the next component tick applies every frame exactly once.
+			DormantComponentInstance->SetWakeTimer(1.f);
+			SimulateComponentFrame();
+			TestFalse("Timer wakes the component instance", DormantComponentInstance->IsDormant());
+			SimulateComponentFrame();
+			TestEqual("Component instance time in state after waking", GetTimeInState(DormantComponentInstance), GetTimeInState(PollingComponentInstance));
+
+			// Both still reach the end state once transitions are allowed.
+			PollingComponentContext->bCanTransition = true;
+			DormantComponentContext->bCanTransition = true;
+			for (int32 Frame = 0; Frame < TotalStates * 2 && !(PollingComponentInstance->IsInEndState() && DormantComponentInstance->IsInEndState()); ++Frame)
+			{
+				SimulateComponentFrame();
+			}
+			TestTrue("Polling component instance in end state", PollingComponentInstance->IsInEndState());
+			TestTrue("Dormant component instance in end state", DormantComponentInstance->IsInEndState());
+			TestEqual("Component states entered", DormantComponentContext->GetEntryInt(), PollingComponentContext->GetEntryInt());
+		}
+
+		PollingComponent->Shutdown();
+		DormantComponent->Shutdown();
+		TestEqual("Manager empty after components", DormancyManager.GetNumDormantInstances(), 0);
+	}
+
+	return NewAsset.DeleteAsset(this);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNodeTraceTest, "SMTests.NodeTrace", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FNodeTraceTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 4;
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	FSMProfiler& Profiler = FSMProfiler::Get();
+	Profiler.StopTrace();
+	Profiler.Reset();
+
+	// Nothing is recorded until tracing starts.
+	{
+		USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+		TestHelpers::RunAllStateMachinesToCompletion(this, Instance, &Instance->GetRootStateMachine());
+		Profiler.Flush();
+		TestEqual("No classes traced", Profiler.GetTracedClasses().Num(), 0);
+	}
+
+	Profiler.StartTrace();
+	TestTrue("Tracing", FSMProfiler::IsTracing());
+
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+	TestHelpers::RunAllStateMachinesToCompletion(this, Instance, &Instance->GetRootStateMachine());
+
+	Profiler.StopTrace();
+	TestFalse("Not tracing", FSMProfiler::IsTracing());
+	TestEqual("No events dropped", Profiler.GetNumDroppedEvents(), (int64)0);
+
+	const TArray<FSMTraceNodeStats> HotList = Profiler.GetHotList(Instance->GetClass());
+	TestTrue("Nodes traced", HotList.Num() > 0);
+
+	int32 StatesBegun = 0;
+	int32 TransitionsEvaluated = 0;
+	int32 TransitionsTaken = 0;
+	for (int32 Idx = 0; Idx < HotList.Num(); ++Idx)
+	{
+		const FSMTraceNodeStats& NodeStats = HotList[Idx];
+		if (const FSMNode_Base* Node = Instance->GetNodeByGuid(NodeStats.NodeGuid))
+		{
+			TestEqual("Node name resolved", NodeStats.NodeName, Node->GetNodeName());
+		}
+		if (Idx > 0)
+		{
+			TestTrue("Hot list sorted", HotList[Idx - 1].TotalCycles >= NodeStats.TotalCycles);
+		}
+
+		StatesBegun += NodeStats.Counts[(int32)ESMTraceEventType::StateBegin];
+		TransitionsEvaluated += NodeStats.Counts[(int32)ESMTraceEventType::TransitionEvaluated];
+		TransitionsTaken += NodeStats.Counts[(int32)ESMTraceEventType::TransitionTaken];
+	}
+
+	TestTrue("Every state begun", StatesBegun >= TotalStates);
+	TestTrue("Transitions evaluated", TransitionsEvaluated >= TotalStates - 1);
+	TestEqual("Transitions taken", TransitionsTaken, TotalStates - 1);
+	TestEqual("Taken transitions logged", Profiler.GetTakenTransitions().Num(), TotalStates - 1);
+	for (int32 Idx = 1; Idx < Profiler.GetTakenTransitions().Num(); ++Idx)
+	{
+		TestTrue("Taken transitions in order", Profiler.GetTakenTransitions()[Idx].Timestamp >= Profiler.GetTakenTransitions()[Idx - 1].Timestamp);
+	}
+
+	const FString CsvPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("LogicDriverTrace.csv"));
+	TestTrue("Exported", Profiler.ExportCSV(CsvPath));
+
+	TArray<FString> CsvLines;
+	FFileHelper::LoadFileToStringArray(CsvLines, *CsvPath);
+	TestTrue("CSV has rows", CsvLines.Num() > 1);
+
+	IFileManager::Get().Delete(*CsvPath);
+	IFileManager::Get().Delete(*FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("LogicDriverTrace_Transitions.csv")));
+	Profiler.Reset();
+
+	return NewAsset.DeleteAsset(this);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNodeTraceConcurrentTest, "SMTests.NodeTraceConcurrent", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FNodeTraceConcurrentTest::RunTest(const FString& Parameters)
+{
+	FSMProfiler& Profiler = FSMProfiler::Get();
+	Profiler.StopTrace();
+
+	// Small enough that writers lap the reader and each other.
+	Profiler.StartTrace(1024);
+
+	const int32 NumWriters = 4;
+	const int32 EventsPerWriter = 200000;
+	const UClass* TracedClass = USMTestContext::StaticClass();
+
+	// Every writer uses its own node and duration, a torn read would mix them and show up in the node totals.
+	TArray<TFuture<void>> Writers;
+	for (int32 WriterIdx = 0; WriterIdx < NumWriters; ++WriterIdx)
+	{
+		Writers.Add(Async(EAsyncExecution::Thread, [&Profiler, TracedClass, WriterIdx, EventsPerWriter]()
+		{
+			FSMTraceEvent Event;
+			Event.InstanceClass = TracedClass;
+			Event.NodeGuid = FGuid(WriterIdx + 1, WriterIdx + 1, WriterIdx + 1, WriterIdx + 1);
+			Event.StartCycles = WriterIdx + 1;
+			Event.DurationCycles = WriterIdx + 1;
+			Event.Type = ESMTraceEventType::StateUpdate;
+			Event.bResult = false;
+
+			for (int32 Idx = 0; Idx < EventsPerWriter; ++Idx)
+			{
+				Profiler.Record(Event);
+			}
+		}));
+	}
+
+	for (TFuture<void>& Writer : Writers)
+	{
+		while (!Writer.IsReady())
+		{
+			Profiler.Flush();
+		}
+	}
+
+	Profiler.StopTrace();
+
+	int64 NumAggregated = 0;
+	for (const FSMTraceNodeStats& NodeStats : Profiler.GetHotList(TracedClass))
+	{
+		const int32 Count = NodeStats.Counts[(int32)ESMTraceEventType::StateUpdate];
+		const uint32 Duration = NodeStats.NodeGuid.A;
+		TestTrue("Node is a writer", Duration >= 1 && Duration <= (uint32)NumWriters);
+		TestEqual("Guid not torn", NodeStats.NodeGuid, FGuid(Duration, Duration, Duration, Duration));
+		TestEqual("Durations not torn", NodeStats.Cycles[(int32)ESMTraceEventType::StateUpdate], (uint64)Count * Duration);
+		TestEqual("Max duration not torn", NodeStats.MaxCycles[(int32)ESMTraceEventType::StateUpdate], Duration);
+		NumAggregated += Count;
+	}
+
+	AddInfo(FString::Printf(TEXT("Aggregated %lld of %d events, %lld dropped."), NumAggregated, NumWriters * EventsPerWriter,
+		Profiler.GetNumDroppedEvents()));
+	TestTrue("Events aggregated", NumAggregated > 0);
+	TestEqual("Every event aggregated or dropped", NumAggregated + Profiler.GetNumDroppedEvents(), (int64)NumWriters * EventsPerWriter);
+
+	Profiler.Reset();
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOnDemandNodeInstancesTest, "SMTests.OnDemandNodeInstances", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FOnDemandNodeInstancesTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 4;
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* UpFrontContext = NewObject<USMTestContext>();
+	USMTestContext* OnDemandContext = NewObject<USMTestContext>();
+	UpFrontContext->bCanTransition = false;
+	OnDemandContext->bCanTransition = false;
+
+	USMInstance* UpFrontInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, UpFrontContext);
+
+	USMInstance* DefaultObject = NewBP->GetGeneratedClass()->GetDefaultObject<USMInstance>();
+	DefaultObject->SetCreateNodeInstancesOnDemand(true);
+	USMInstance* OnDemandInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, OnDemandContext);
+	DefaultObject->SetCreateNodeInstancesOnDemand(false);
+
+	auto CountCreatedNodeInstances = [](USMInstance* Instance)
+	{
+		int32 NumCreated = 0;
+		for (const auto& KeyVal : Instance->GetStateMap())
+		{
+			NumCreated += KeyVal.Value->GetNodeInstanceIfCreated() ? 1 : 0;
+		}
+		for (const auto& KeyVal : Instance->GetTransitionMap())
+		{
+			NumCreated += KeyVal.Value->GetNodeInstanceIfCreated() ? 1 : 0;
+		}
+		return NumCreated;
+	};
+
+	const int32 NumNodes = UpFrontInstance->GetStateMap().Num() + UpFrontInstance->GetTransitionMap().Num();
+	TestEqual("Every node instance created up front", CountCreatedNodeInstances(UpFrontInstance), NumNodes);
+	TestEqual("No node instances created on initialize", CountCreatedNodeInstances(OnDemandInstance), 0);
+
+	UpFrontInstance->Start();
+	OnDemandInstance->Start();
+
+	FSMState_Base* ActiveState = OnDemandInstance->GetRootStateMachine().GetSingleActiveState();
+	TestNotNull("On demand instance active", ActiveState);
+	if (!ActiveState)
+	{
+		return false;
+	}
+
+	TestNotNull("Active state instance created", ActiveState->GetNodeInstanceIfCreated());
+	const int32 NumCreatedAfterStart = CountCreatedNodeInstances(OnDemandInstance);
+	TestTrue("Only reached nodes created", NumCreatedAfterStart > 0 && NumCreatedAfterStart < NumNodes);
+
+	// Defaults are readable without creating the instance and requesting it creates it.
+	FSMState_Base* UnreachedState = nullptr;
+	for (const auto& KeyVal : OnDemandInstance->GetStateMap())
+	{
+		if (!KeyVal.Value->GetNodeInstanceIfCreated() && !KeyVal.Value->IsStateMachine())
+		{
+			UnreachedState = KeyVal.Value;
+			break;
+		}
+	}
+	TestNotNull("Unreached state found", UnreachedState);
+	if (UnreachedState)
+	{
+		TestNotNull("Defaults available", UnreachedState->GetNodeInstanceDefaults());
+		TestNull("Reading defaults doesn't create the instance", UnreachedState->GetNodeInstanceIfCreated());
+		TestNotNull("Instance created when requested", UnreachedState->GetNodeInstance());
+		TestTrue("Requested instance kept", UnreachedState->GetNodeInstanceIfCreated() == UnreachedState->GetNodeInstance());
+	}
+
+	// Both run the same.
+	UpFrontContext->bCanTransition = true;
+	OnDemandContext->bCanTransition = true;
+	for (int32 Update = 0; Update < TotalStates * 2 && !UpFrontInstance->IsInEndState(); ++Update)
+	{
+		UpFrontInstance->Update(1.f);
+		OnDemandInstance->Update(1.f);
+	}
+
+	TestTrue("Up front instance in end state", UpFrontInstance->IsInEndState());
+	TestTrue("On demand instance in end state", OnDemandInstance->IsInEndState());
+	TestEqual("Same states entered", OnDemandContext->GetEntryInt(), UpFrontContext->GetEntryInt());
+	TestEqual("Same states ended", OnDemandContext->GetEndInt(), UpFrontContext->GetEndInt());
+	TestEqual("Every node reached", CountCreatedNodeInstances(OnDemandInstance), NumNodes);
+
+	UpFrontInstance->Stop();
+	OnDemandInstance->Stop();
+
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
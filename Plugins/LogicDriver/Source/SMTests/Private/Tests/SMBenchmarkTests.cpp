@@ -0,0 +1,467 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "Blueprints/SMBlueprint.h"
+#include "SMTestHelpers.h"
+#include "SMBlueprintFactory.h"
+#include "Utilities/SMBlueprintEditorUtils.h"
+#include "SMTestContext.h"
+#include "SMUtils.h"
+#include "SMInstancePool.h"
+#include "SMConduitInstance.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Graph/SMGraph.h"
+#include "Graph/SMConduitGraph.h"
+#include "Graph/SMTransitionGraph.h"
+#include "Graph/Nodes/SMGraphK2Node_StateMachineNode.h"
+#include "Graph/Nodes/SMGraphNode_StateNode.h"
+#include "Graph/Nodes/SMGraphNode_StateMachineEntryNode.h"
+#include "Graph/Nodes/SMGraphNode_TransitionEdge.h"
+#include "Graph/Nodes/SMGraphNode_StateMachineStateNode.h"
+#include "Graph/Nodes/SMGraphNode_ConduitNode.h"
+#include "Graph/Nodes/RootNodes/SMGraphK2Node_TransitionResultNode.h"
+#include "Graph/Nodes/RootNodes/SMGraphK2Node_ConduitResultNode.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectHash.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#if PLATFORM_DESKTOP
+
+/**
+ * Benchmarks build a synthetic state machine, then measure it at 1, 100 and 1000 instances.
+ * Transitions are left unable to pass while updating so every update evaluates the same graph.
+ *
+ * Results are logged and written as JSON to Saved/Automation/LogicDriver/Benchmarks/<Graph>-<Timestamp>.json.
+ * Timings are wall clock and should only be compared between runs on the same machine and build configuration.
+ */
+namespace SMBenchmark
+{
+	static const int32 InstanceCounts[] = { 1, 100, 1000 };
+	static const int32 UpdatesPerRun = 10;
+	static const float UpdateDeltaSeconds = 1.f / 60.f;
+
+	/** Serialized size of an instance, its node instances and its references. */
+	static int64 CountInstanceBytes(USMInstance* Instance)
+	{
+		TArray<USMInstance*> Instances = Instance->GetAllReferencedInstances(true);
+		Instances.Add(Instance);
+
+		TArray<UObject*> Objects;
+		for (USMInstance* CountedInstance : Instances)
+		{
+			Objects.Add(CountedInstance);
+			GetObjectsWithOuter(CountedInstance, Objects, true);
+		}
+
+		int64 Bytes = 0;
+		for (UObject* Object : Objects)
+		{
+			FArchiveCountMem CountMem(Object);
+			Bytes += CountMem.GetMax();
+		}
+
+		return Bytes;
+	}
+
+	/** Add the environment to a result and write it to the benchmark directory. */
+	static void WriteResults(FAutomationTestBase* Test, const FString& GraphName, const TSharedPtr<FJsonObject>& Result)
+	{
+		Result->SetStringField(TEXT("Graph"), GraphName);
+		Result->SetStringField(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+		Result->SetStringField(TEXT("Engine"), FEngineVersion::Current().ToString());
+		Result->SetStringField(TEXT("Configuration"), LexToString(FApp::GetBuildConfiguration()));
+		Result->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+
+		FString Json;
+		const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+		FJsonSerializer::Serialize(Result.ToSharedRef(), Writer);
+
+		const FString FilePath = FPaths::Combine(FPaths::AutomationDir(), TEXT("LogicDriver"), TEXT("Benchmarks"),
+			FString::Printf(TEXT("%s-%s.json"), *GraphName, *FDateTime::Now().ToString()));
+		Test->TestTrue("Benchmark results written", FFileHelper::SaveStringToFile(Json, *FilePath));
+		Test->AddInfo(FString::Printf(TEXT("Benchmark results: %s"), *FPaths::ConvertRelativePathToFull(FilePath)));
+	}
+
+	/**
+	 * Compile and measure a state machine blueprint.
+	 *
+	 * @param WarmupUpdates Updates run with transitions allowed before measuring. Used to activate parallel states.
+	 * @param bCreateNodeInstancesOnDemand Measure with node instances created on first use.
+	 */
+	static bool RunBenchmark(FAutomationTestBase* Test, USMBlueprint* Blueprint, const FString& GraphName, int32 WarmupUpdates = 0,
+		bool bCreateNodeInstancesOnDemand = false)
+	{
+		FKismetEditorUtilities::CompileBlueprint(Blueprint);
+		UClass* StateMachineClass = Blueprint->GetGeneratedClass();
+		StateMachineClass->GetDefaultObject<USMInstance>()->SetCreateNodeInstancesOnDemand(bCreateNodeInstancesOnDemand);
+
+		// Measure construction, not recycling.
+		if (USMInstancePool* Pool = USMInstancePool::Get(false))
+		{
+			Pool->Empty();
+		}
+
+		TArray<TSharedPtr<FJsonValue>> Runs;
+		for (const int32 NumInstances : InstanceCounts)
+		{
+			USMTestContext* Context = NewObject<USMTestContext>();
+			Context->bCanTransition = WarmupUpdates > 0;
+
+			TArray<USMInstance*> Instances;
+			Instances.Reserve(NumInstances);
+
+			const int32 ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+			const uint64 MemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Idx = 0; Idx < NumInstances; ++Idx)
+			{
+				Instances.Add(USMBlueprintUtils::CreateStateMachineInstance(StateMachineClass, Context));
+			}
+			const double InitializeSeconds = FPlatformTime::Seconds() - StartTime;
+
+			const int32 ObjectsCreated = GUObjectArray.GetObjectArrayNumMinusAvailable() - ObjectsBefore;
+			const int64 MemoryGrowth = (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)MemoryBefore;
+
+			StartTime = FPlatformTime::Seconds();
+			for (USMInstance* Instance : Instances)
+			{
+				Instance->Start();
+			}
+			const double StartSeconds = FPlatformTime::Seconds() - StartTime;
+
+			for (int32 Update = 0; Update < WarmupUpdates; ++Update)
+			{
+				for (USMInstance* Instance : Instances)
+				{
+					Instance->Update(UpdateDeltaSeconds);
+				}
+			}
+			Context->bCanTransition = false;
+
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Update = 0; Update < UpdatesPerRun; ++Update)
+			{
+				for (USMInstance* Instance : Instances)
+				{
+					Instance->Update(UpdateDeltaSeconds);
+				}
+			}
+			const double UpdateSeconds = FPlatformTime::Seconds() - StartTime;
+
+			const int32 ActiveStates = Instances[0]->GetAllActiveStateGuidsCopy().Num();
+			const int64 InstanceBytes = CountInstanceBytes(Instances[0]);
+
+			for (USMInstance* Instance : Instances)
+			{
+				Instance->Stop();
+			}
+
+			const double InitializeUsPerInstance = InitializeSeconds * 1000000.0 / NumInstances;
+			const double UpdateUsPerInstance = UpdateSeconds * 1000000.0 / (NumInstances * UpdatesPerRun);
+			const double ObjectsPerInstance = (double)ObjectsCreated / NumInstances;
+
+			TSharedPtr<FJsonObject> Run = MakeShared<FJsonObject>();
+			Run->SetNumberField(TEXT("Instances"), NumInstances);
+			Run->SetNumberField(TEXT("InitializeMs"), InitializeSeconds * 1000.0);
+			Run->SetNumberField(TEXT("InitializeUsPerInstance"), InitializeUsPerInstance);
+			Run->SetNumberField(TEXT("StartUsPerInstance"), StartSeconds * 1000000.0 / NumInstances);
+			Run->SetNumberField(TEXT("UpdateUsPerInstance"), UpdateUsPerInstance);
+			Run->SetNumberField(TEXT("ActiveStates"), ActiveStates);
+			Run->SetNumberField(TEXT("ObjectsPerInstance"), ObjectsPerInstance);
+			Run->SetNumberField(TEXT("BytesPerInstance"), InstanceBytes);
+			Run->SetNumberField(TEXT("ProcessBytesPerInstance"), (double)MemoryGrowth / NumInstances);
+			Runs.Add(MakeShared<FJsonValueObject>(Run));
+
+			Test->AddInfo(FString::Printf(TEXT("%s x%d: initialize %.2fus, update %.2fus, %.1f objects, %lld bytes per instance. %d active states."),
+				*GraphName, NumInstances, InitializeUsPerInstance, UpdateUsPerInstance, ObjectsPerInstance, InstanceBytes, ActiveStates));
+
+			Test->TestTrue("Instance measured while active", ActiveStates > 0);
+		}
+
+		TSharedPtr<FJsonObject> Result = MakeShared<FJsonObject>();
+		Result->SetBoolField(TEXT("NodeInstancesOnDemand"), bCreateNodeInstancesOnDemand);
+		Result->SetNumberField(TEXT("UpdatesPerRun"), UpdatesPerRun);
+		Result->SetArrayField(TEXT("Runs"), Runs);
+		WriteResults(Test, GraphName, Result);
+
+		return true;
+	}
+}
+
+/**
+ * A single state with many outgoing transitions evaluated every update.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBenchmarkWideTest, "SMTests.Benchmark.Wide", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+	bool FBenchmarkWideTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+
+	TArray<UEdGraphPin*> FromPins { LastStatePin };
+	TestHelpers::BuildBranchingStateMachine(this, StateMachineGraph, 1, 64, false, &FromPins);
+
+	SMBenchmark::RunBenchmark(this, NewBP, TEXT("Wide"));
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * State machines nested inside each other, each level with a transition out of the nested state machine.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBenchmarkDeepNestedTest, "SMTests.Benchmark.DeepNested", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+	bool FBenchmarkDeepNestedTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 Depth = 8;
+	for (int32 Level = 0; Level < Depth; ++Level)
+	{
+		// The nested state machine is the initial state of its parent so every level is active after start.
+		USMGraphNode_StateMachineStateNode* NestedNode = TestHelpers::CreateNewNode<USMGraphNode_StateMachineStateNode>(this, StateMachineGraph,
+			StateMachineGraph->GetEntryNode()->GetOutputPin());
+
+		UEdGraphPin* ExitPin = NestedNode->GetOutputPin();
+		TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &ExitPin);
+
+		StateMachineGraph = CastChecked<USMGraph>(NestedNode->GetBoundGraph());
+	}
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 2, &LastStatePin);
+
+	SMBenchmark::RunBenchmark(this, NewBP, TEXT("DeepNested"));
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * A state leading to many conduits configured as transitions. Each update evaluates the transition into the conduit,
+ * the conduit and the conduit's outgoing transition.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBenchmarkConduitsTest, "SMTests.Benchmark.Conduits", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+	bool FBenchmarkConduitsTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+
+	TArray<UEdGraphPin*> FromPins { LastStatePin };
+	TestHelpers::BuildBranchingStateMachine(this, StateMachineGraph, 1, 32, false, &FromPins);
+
+	for (UEdGraphPin* FromPin : FromPins)
+	{
+		USMGraphNode_StateNodeBase* StateNode = CastChecked<USMGraphNode_StateNodeBase>(FromPin->GetOwningNode());
+
+		// Always enter the conduit so it's evaluated on every update.
+		USMGraphNode_TransitionEdge* TransitionToConduit = CastChecked<USMGraphNode_TransitionEdge>(StateNode->GetInputPin()->LinkedTo[0]->GetOwningNode());
+		USMTransitionGraph* TransitionGraph = TransitionToConduit->GetTransitionGraph();
+		TransitionGraph->ResultNode->BreakAllNodeLinks();
+		TransitionGraph->GetSchema()->TrySetDefaultValue(*TransitionGraph->ResultNode->GetTransitionEvaluationPin(), "True");
+
+		USMGraphNode_ConduitNode* ConduitNode = FSMBlueprintEditorUtils::ConvertNodeTo<USMGraphNode_ConduitNode>(StateNode);
+		ConduitNode->GetNodeTemplateAs<USMConduitInstance>()->bEvalWithTransitions = true;
+		CastChecked<USMConduitGraph>(ConduitNode->GetBoundGraph())->ResultNode->GetInputPin()->DefaultValue = "True";
+
+		UEdGraphPin* ConduitPin = ConduitNode->GetOutputPin();
+		TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &ConduitPin);
+	}
+
+	SMBenchmark::RunBenchmark(this, NewBP, TEXT("Conduits"));
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Parallel entry states each branching into parallel states which stay active.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBenchmarkParallelTest, "SMTests.Benchmark.Parallel", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+	bool FBenchmarkParallelTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	TestHelpers::BuildBranchingStateMachine(this, StateMachineGraph, 2, 6, true, nullptr, true);
+
+	// One update with transitions allowed activates the second row.
+	SMBenchmark::RunBenchmark(this, NewBP, TEXT("Parallel"), 1);
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * The wide graph with node instances created up front and on demand. Only the active state and its transitions are needed.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBenchmarkOnDemandNodeInstancesTest, "SMTests.Benchmark.OnDemandNodeInstances", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+	bool FBenchmarkOnDemandNodeInstancesTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+
+	TArray<UEdGraphPin*> FromPins { LastStatePin };
+	TestHelpers::BuildBranchingStateMachine(this, StateMachineGraph, 1, 64, false, &FromPins);
+
+	SMBenchmark::RunBenchmark(this, NewBP, TEXT("WideUpFront"));
+	SMBenchmark::RunBenchmark(this, NewBP, TEXT("WideOnDemand"), 0, true);
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Active state queries on deep nested parallel state machines. Compares searching every nested state machine against
+ * the maintained active state list, both for the states and their guids.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBenchmarkActiveStateQueriesTest, "SMTests.Benchmark.ActiveStateQueries", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+	bool FBenchmarkActiveStateQueriesTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 Depth = 8;
+	for (int32 Level = 0; Level < Depth; ++Level)
+	{
+		USMGraphNode_StateMachineStateNode* NestedNode = TestHelpers::CreateNewNode<USMGraphNode_StateMachineStateNode>(this, StateMachineGraph,
+			StateMachineGraph->GetEntryNode()->GetOutputPin());
+
+		UEdGraphPin* ExitPin = NestedNode->GetOutputPin();
+		TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &ExitPin);
+
+		StateMachineGraph = CastChecked<USMGraph>(NestedNode->GetBoundGraph());
+	}
+
+	// The deepest level runs parallel states.
+	TestHelpers::BuildBranchingStateMachine(this, StateMachineGraph, 1, 8, true, nullptr, true);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	Instance->Start();
+	Instance->Update(SMBenchmark::UpdateDeltaSeconds);
+
+	const int32 NumActiveStates = Instance->GetActiveStatesView().Num();
+	TestTrue("Nested states active", NumActiveStates > Depth);
+	TestEqual("Active states match search", TestHelpers::ArrayContentsInArray(Instance->GetActiveStatesView(),
+		Instance->GetRootStateMachine().GetAllNestedActiveStates()), NumActiveStates);
+
+	const int32 Iterations = 100000;
+	int32 Found = 0;
+
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Found += Instance->GetRootStateMachine().GetAllNestedActiveStates().Num();
+	}
+	const double SearchSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Found += Instance->GetActiveStatesView().Num();
+	}
+	const double ViewSeconds = FPlatformTime::Seconds() - StartTime;
+
+	TArray<FGuid> Guids;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Guids.Reset();
+		for (FSMState_Base* State : Instance->GetRootStateMachine().GetAllNestedActiveStates())
+		{
+			Guids.AddUnique(State->GetGuid());
+		}
+	}
+	const double SearchGuidSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < Iterations; ++Idx)
+	{
+		Instance->GetAllActiveStateGuids(Guids);
+	}
+	const double ListGuidSeconds = FPlatformTime::Seconds() - StartTime;
+
+	Instance->Stop();
+	TestEqual("Every query found the active states", Found, NumActiveStates * Iterations * 2);
+
+	const double ToNs = 1000000000.0 / Iterations;
+	AddInfo(FString::Printf(TEXT("Active state queries x%d (%d active states, depth %d): search %.1fns, view %.1fns, search guids %.1fns, list guids %.1fns"),
+		Iterations, NumActiveStates, Depth, SearchSeconds * ToNs, ViewSeconds * ToNs, SearchGuidSeconds * ToNs, ListGuidSeconds * ToNs));
+
+	TSharedPtr<FJsonObject> Result = MakeShared<FJsonObject>();
+	Result->SetNumberField(TEXT("Iterations"), Iterations);
+	Result->SetNumberField(TEXT("ActiveStates"), NumActiveStates);
+	Result->SetNumberField(TEXT("SearchNs"), SearchSeconds * ToNs);
+	Result->SetNumberField(TEXT("ViewNs"), ViewSeconds * ToNs);
+	Result->SetNumberField(TEXT("SearchGuidsNs"), SearchGuidSeconds * ToNs);
+	Result->SetNumberField(TEXT("ListGuidsNs"), ListGuidSeconds * ToNs);
+	SMBenchmark::WriteResults(this, TEXT("ActiveStateQueries"), Result);
+
+	return NewAsset.DeleteAsset(this);
+}
+
+#endif
+
+#endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
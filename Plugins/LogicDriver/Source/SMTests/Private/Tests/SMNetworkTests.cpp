@@ -0,0 +1,376 @@
+// Copyright Recursoft LLC 2019-2020. All Rights Reserved.
+#include "Blueprints/SMBlueprint.h"
+#include "SMTestHelpers.h"
+#include "Utilities/SMBlueprintEditorUtils.h"
+#include "SMTestContext.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Graph/SMGraph.h"
+#include "Graph/Nodes/SMGraphK2Node_StateMachineNode.h"
+#include "Graph/Nodes/SMGraphNode_TransitionEdge.h"
+#include "Graph/Nodes/SMGraphNode_StateMachineStateNode.h"
+#include "Graph/Nodes/Helpers/SMGraphK2Node_StateReadNodes.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/CoreNet.h"
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#if PLATFORM_DESKTOP
+
+/** Serializes fast array items with their native NetSerialize, which is what the rep layout does for FSMReplicatedActiveState. */
+class FReplicatedActiveStatesSerializeCB : public INetSerializeCB
+{
+public:
+	virtual void NetSerializeStruct(FNetDeltaSerializeInfo& Params) override
+	{
+		FBitArchive& Ar = Params.Reader ? static_cast<FBitArchive&>(*Params.Reader) : static_cast<FBitArchive&>(*Params.Writer);
+		bool bHasUnmapped = false;
+		NetSerializeStruct(CastChecked<UScriptStruct>(Params.Struct), Ar, Params.Map, Params.Data, bHasUnmapped);
+	}
+
+	PRAGMA_DISABLE_DEPRECATION_WARNINGS
+	virtual void NetSerializeStruct(UScriptStruct* Struct, FBitArchive& Ar, UPackageMap* Map, void* Data, bool& bHasUnmapped) override
+	{
+		bool bSuccess = true;
+		Struct->GetCppStructOps()->NetSerialize(Ar, Map, bSuccess, Data);
+	}
+	PRAGMA_ENABLE_DEPRECATION_WARNINGS
+
+	virtual void GatherGuidReferencesForFastArray(FFastArrayDeltaSerializeParams& Params) override {}
+	virtual bool MoveGuidToUnmappedForFastArray(FFastArrayDeltaSerializeParams& Params) override { return false; }
+	virtual void UpdateUnmappedGuidsForFastArray(FFastArrayDeltaSerializeParams& Params) override {}
+	virtual bool NetDeltaSerializeForFastArray(FFastArrayDeltaSerializeParams& Params) override { return false; }
+};
+
+/**
+ * Write a fast array delta of the active states against the base state last sent to a connection.
+ * @param InOutBaseState The connection's base state, null for a connection which hasn't received anything. Updated when something is sent.
+ * @return The bytes written, 0 if nothing changed.
+ */
+static int32 NetDeltaSerializeActiveStates(FSMReplicatedActiveStates& ActiveStates, TSharedPtr<INetDeltaBaseState>& InOutBaseState)
+{
+	FReplicatedActiveStatesSerializeCB SerializeCB;
+	FNetBitWriter Writer(nullptr, 8 * 1024 * 8);
+	TSharedPtr<INetDeltaBaseState> NewState;
+
+	FNetDeltaSerializeInfo Parms;
+	Parms.Writer = &Writer;
+	Parms.OldState = InOutBaseState.Get();
+	Parms.NewState = &NewState;
+	Parms.Struct = FSMReplicatedActiveStates::StaticStruct();
+	Parms.NetSerializeCB = &SerializeCB;
+
+	if (!ActiveStates.NetDeltaSerialize(Parms))
+	{
+		return 0;
+	}
+
+	InOutBaseState = NewState;
+	return (int32)FMath::DivideAndRoundUp(Writer.GetNumBits(), (int64)8);
+}
+
+/**
+ * Replicated active states should only send changed states. Measures the bytes the fast array delta actually writes per transition on a
+ * deep nested state machine against serializing every active state guid.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FReplicatedActiveStatesTest, "SMTests.ReplicatedActiveStates", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FReplicatedActiveStatesTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	// Each level is a nested state machine followed by a state which waits for it to complete.
+	const int32 Depth = 5;
+	UEdGraphPin* LastPin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastPin);
+	for (int32 Level = 0; Level < Depth; ++Level)
+	{
+		UEdGraphPin* NestedPin = nullptr;
+		USMGraphNode_StateMachineStateNode* NestedStateMachineNode = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 3, &LastPin, &NestedPin);
+
+		LastPin = NestedStateMachineNode->GetOutputPin();
+		TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastPin);
+		USMGraphNode_TransitionEdge* TransitionFromNestedStateMachine = CastChecked<USMGraphNode_TransitionEdge>(NestedStateMachineNode->GetOutputPin()->LinkedTo[0]->GetOwningNode());
+		TestHelpers::OverrideTransitionResultLogic<USMGraphK2Node_StateMachineReadNode_InEndState>(this, TransitionFromNestedStateMachine);
+
+		StateMachineGraph = Cast<USMGraph>(NestedStateMachineNode->GetBoundGraph());
+		LastPin = NestedPin;
+	}
+
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMStateMachineTestComponent* ServerComponent = NewObject<USMStateMachineTestComponent>(GetTransientPackage());
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* StateMachineInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	StateMachineInstance->SetServerInstance(ServerComponent);
+	StateMachineInstance->Start();
+
+	int32 Transitions = 0;
+	int32 MaxActiveStates = 0;
+	int64 DeltaBytes = 0;
+	int64 GuidBytes = 0;
+
+	// Connected from the start, the initial states aren't counted.
+	TSharedPtr<INetDeltaBaseState> ConnectionBaseState;
+	{
+		FSMReplicatedActiveStates ActiveStates = StateMachineInstance->GetReplicatedActiveStates();
+		TestTrue("Initial states sent", NetDeltaSerializeActiveStates(ActiveStates, ConnectionBaseState) > 0);
+		TestEqual("Nothing sent without a change", NetDeltaSerializeActiveStates(ActiveStates, ConnectionBaseState), 0);
+	}
+
+	TArray<FGuid> PreviousGuids = StateMachineInstance->GetAllActiveStateGuidsCopy();
+	const int32 MaxIterations = 1000;
+	for (int32 Iteration = 0; Iteration < MaxIterations && !StateMachineInstance->GetRootStateMachine().IsInEndState(); ++Iteration)
+	{
+		StateMachineInstance->Update(1.f);
+
+		TArray<FGuid> ActiveGuids = StateMachineInstance->GetAllActiveStateGuidsCopy();
+		if (ActiveGuids == PreviousGuids)
+		{
+			continue;
+		}
+
+		const TArray<FGuid> ReplicatedGuids = StateMachineInstance->GetReplicatedStates();
+		TestEqual("Replicated states match active states", TestHelpers::ArrayContentsInArray(ReplicatedGuids, ActiveGuids), ActiveGuids.Num());
+		TestEqual("No extra replicated states", ReplicatedGuids.Num(), ActiveGuids.Num());
+
+		{
+			FNetBitWriter GuidWriter(nullptr, 8 * 1024 * 8);
+			GuidWriter << ActiveGuids;
+			GuidBytes += FMath::DivideAndRoundUp(GuidWriter.GetNumBits(), (int64)8);
+		}
+
+		FSMReplicatedActiveStates ActiveStates = StateMachineInstance->GetReplicatedActiveStates();
+		const int32 ChangeBytes = NetDeltaSerializeActiveStates(ActiveStates, ConnectionBaseState);
+		TestTrue("Change sent", ChangeBytes > 0);
+		DeltaBytes += ChangeBytes;
+
+		MaxActiveStates = FMath::Max(MaxActiveStates, ActiveGuids.Num());
+		Transitions++;
+
+		PreviousGuids = MoveTemp(ActiveGuids);
+	}
+
+	TestTrue("State machine reached end state", StateMachineInstance->GetRootStateMachine().IsInEndState());
+	TestTrue("Transitions taken", Transitions > 0);
+	TestTrue("Deep nested states active", MaxActiveStates > Depth);
+	TestTrue("Deltas smaller than guids", DeltaBytes < GuidBytes);
+
+	AddInfo(FString::Printf(TEXT("Replicated bytes per transition over %d transitions (max %d active states): guids %.1f, deltas %.1f"),
+		Transitions, MaxActiveStates, (double)GuidBytes / FMath::Max(Transitions, 1), (double)DeltaBytes / FMath::Max(Transitions, 1)));
+
+	// Only differences are sent to a connection, a connection without a base state (late joiner) receives every state.
+	{
+		FSMReplicatedActiveStates ActiveStates;
+		TSharedPtr<INetDeltaBaseState> BaseState;
+
+		TArray<int32> Indices = { 0, 1, 2, 3 };
+		TestEqual("Initial states changed", ActiveStates.Update(Indices, 0), 4);
+		const int32 InitialBytes = NetDeltaSerializeActiveStates(ActiveStates, BaseState);
+
+		Indices[3] = 4;
+		TestEqual("One state replaced", ActiveStates.Update(Indices, 0), 2);
+		const int32 ChangeBytes = NetDeltaSerializeActiveStates(ActiveStates, BaseState);
+		TestTrue("Change smaller than initial", ChangeBytes > 0 && ChangeBytes < InitialBytes);
+
+		TestEqual("No change", ActiveStates.Update(Indices, 0), 0);
+		TestEqual("Nothing sent", NetDeltaSerializeActiveStates(ActiveStates, BaseState), 0);
+
+		TSharedPtr<INetDeltaBaseState> LateJoinerBaseState;
+		TestTrue("Late joiner receives every state", NetDeltaSerializeActiveStates(ActiveStates, LateJoinerBaseState) > ChangeBytes);
+
+		TArray<int32> ReplicatedIndices;
+		ActiveStates.GetStateIndices(ReplicatedIndices);
+		TestEqual("Indices replicated", TestHelpers::ArrayContentsInArray(ReplicatedIndices, Indices), Indices.Num());
+	}
+
+	// Every BaselineInterval changes all states are sent again, then only differences until the next baseline.
+	{
+		const int32 BaselineInterval = 3;
+		FSMReplicatedActiveStates ActiveStates;
+		TSharedPtr<INetDeltaBaseState> BaseState;
+
+		TArray<int32> Indices = { 0, 1, 2, 3 };
+		ActiveStates.Update(Indices, BaselineInterval);
+		NetDeltaSerializeActiveStates(ActiveStates, BaseState);
+
+		Indices[3] = 4;
+		ActiveStates.Update(Indices, BaselineInterval);
+		const int32 ChangeBytes = NetDeltaSerializeActiveStates(ActiveStates, BaseState);
+
+		TestEqual("No change doesn't count towards the baseline", ActiveStates.Update(Indices, BaselineInterval), 0);
+		TestEqual("Nothing sent before the baseline", NetDeltaSerializeActiveStates(ActiveStates, BaseState), 0);
+
+		Indices[3] = 5;
+		ActiveStates.Update(Indices, BaselineInterval);
+		const int32 BaselineBytes = NetDeltaSerializeActiveStates(ActiveStates, BaseState);
+		TestTrue("Baseline sends every state", BaselineBytes > ChangeBytes);
+
+		Indices[3] = 6;
+		ActiveStates.Update(Indices, BaselineInterval);
+		TestTrue("Only differences sent after the baseline", NetDeltaSerializeActiveStates(ActiveStates, BaseState) < BaselineBytes);
+
+		TArray<int32> ReplicatedIndices;
+		ActiveStates.GetStateIndices(ReplicatedIndices);
+		TestEqual("Indices replicated after the baseline", TestHelpers::ArrayContentsInArray(ReplicatedIndices, Indices), Indices.Num());
+	}
+
+	return NewAsset.DeleteAsset(this);
+}
+
+/**
+ * Packed transactions should survive a network round trip with millisecond timestamps, flush instead of dropping when full and expire from the front.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPackedNetworkTransactionsTest, "SMTests.PackedNetworkTransactions", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FPackedNetworkTransactionsTest::RunTest(const FString& Parameters)
+{
+	const FDateTime StartTime = FDateTime::UtcNow();
+
+	FSMPackedTransactions Transactions;
+	for (int32 Idx = 0; Idx < 10; ++Idx)
+	{
+		FSMPackedTransaction Transaction;
+		Transaction.StateMachineIndex = Idx % 3;
+		Transaction.NodeIndex = Idx * 100;
+		Transaction.TransactionId = FGuid::NewGuid().A;
+		Transaction.TimestampTicks = (StartTime + FTimespan::FromMilliseconds(Idx * 250)).GetTicks();
+		Transaction.bIsTransition = Idx % 2 == 0;
+		Transaction.bIsActive = Idx % 4 == 1;
+		Transactions.Add(Transaction);
+	}
+
+	TArray<uint8> Bytes;
+	{
+		FMemoryWriter Writer(Bytes);
+		bool bSuccess = false;
+		Transactions.NetSerialize(Writer, nullptr, bSuccess);
+		TestTrue("Packed transactions written", bSuccess);
+	}
+
+	AddInfo(FString::Printf(TEXT("%d transactions packed into %d bytes, %d bytes as guids."), Transactions.Num(), Bytes.Num(),
+		Transactions.Num() * (int32)(sizeof(FGuid) * 3 + sizeof(FDateTime))));
+
+	FSMPackedTransactions ReadTransactions;
+	{
+		FMemoryReader Reader(Bytes);
+		bool bSuccess = false;
+		ReadTransactions.NetSerialize(Reader, nullptr, bSuccess);
+		TestTrue("Packed transactions read", bSuccess);
+	}
+
+	if (!TestEqual("Transactions read", ReadTransactions.Num(), Transactions.Num()))
+	{
+		return false;
+	}
+
+	for (int32 Idx = 0; Idx < Transactions.Num(); ++Idx)
+	{
+		TestEqual("State machine index", ReadTransactions[Idx].StateMachineIndex, Transactions[Idx].StateMachineIndex);
+		TestEqual("Node index", ReadTransactions[Idx].NodeIndex, Transactions[Idx].NodeIndex);
+		TestTrue("Transaction id", ReadTransactions[Idx].TransactionId == Transactions[Idx].TransactionId);
+		TestTrue("Timestamp within a millisecond", FMath::Abs(ReadTransactions[Idx].TimestampTicks - Transactions[Idx].TimestampTicks) < ETimespan::TicksPerMillisecond);
+		TestTrue("Is transition", ReadTransactions[Idx].bIsTransition == Transactions[Idx].bIsTransition);
+		TestTrue("Is active", ReadTransactions[Idx].bIsActive == Transactions[Idx].bIsActive);
+	}
+
+	// Expire from the front.
+	Transactions.RemoveExpired(StartTime + FTimespan::FromSeconds(2.0), FTimespan::FromSeconds(1.0));
+	TestEqual("Expired transactions removed", Transactions.Num(), 5);
+	TestEqual("Oldest remaining", Transactions[0].NodeIndex, 500);
+
+	// Drop the oldest when full.
+	for (int32 Idx = 0; Idx < FSMPackedTransactions::MaxTransactions; ++Idx)
+	{
+		FSMPackedTransaction Transaction;
+		Transaction.NodeIndex = 1000 + Idx;
+		Transaction.TimestampTicks = (StartTime + FTimespan::FromSeconds(5.0)).GetTicks();
+		Transactions.Add(Transaction);
+	}
+	TestEqual("Ring bounded", Transactions.Num(), FSMPackedTransactions::MaxTransactions);
+	TestEqual("Oldest dropped", Transactions[0].NodeIndex, 1000);
+
+	// More transactions in a frame than fit in one payload are flushed in order without dropping any.
+	{
+		const int32 FrameTransactions = FSMPackedTransactions::MaxTransactions * 2 + 44;
+		TArray<int32> FlushedNodeIndices;
+		int32 NumFlushes = 0;
+		auto Flush = [&](const FSMPackedTransactions& FullTransactions)
+		{
+			TestTrue("Only full payloads flushed", FullTransactions.IsFull());
+			for (int32 Idx = 0; Idx < FullTransactions.Num(); ++Idx)
+			{
+				FlushedNodeIndices.Add(FullTransactions[Idx].NodeIndex);
+			}
+			NumFlushes++;
+		};
+
+		FSMPackedTransactions FrameOutgoing;
+		for (int32 Idx = 0; Idx < FrameTransactions; ++Idx)
+		{
+			FSMPackedTransaction Transaction;
+			Transaction.NodeIndex = Idx;
+			Transaction.TimestampTicks = StartTime.GetTicks();
+			FrameOutgoing.AddOrFlush(Transaction, Flush);
+		}
+		Flush(FrameOutgoing);
+
+		TestEqual("Full payloads flushed", NumFlushes, 3);
+		if (TestEqual("No transactions dropped", FlushedNodeIndices.Num(), FrameTransactions))
+		{
+			for (int32 Idx = 0; Idx < FrameTransactions; ++Idx)
+			{
+				if (FlushedNodeIndices[Idx] != Idx)
+				{
+					AddError(FString::Printf(TEXT("Transaction %d flushed out of order."), Idx));
+					break;
+				}
+			}
+		}
+	}
+
+	// Transaction history.
+	FSMTransactionHistory History;
+	History.Add(1, StartTime);
+	History.Add(2, StartTime + FTimespan::FromSeconds(1.0));
+	History.Add(3, StartTime + FTimespan::FromSeconds(2.0));
+	History.RemoveExpired(StartTime + FTimespan::FromSeconds(2.5), FTimespan::FromSeconds(1.0));
+	TestFalse("Expired id removed", History.Contains(1));
+	TestFalse("Expired id removed", History.Contains(2));
+	TestTrue("Recent id kept", History.Contains(3));
+
+	// The history grows past the replicated window rather than forgetting ids which could be replayed.
+	const int32 NumHistoryIds = FSMPackedTransactions::MaxTransactions * 2 + 44;
+	for (uint32 Id = 100; Id < 100 + (uint32)NumHistoryIds; ++Id)
+	{
+		History.Add(Id, StartTime + FTimespan::FromSeconds(3.0 + Id * 0.001));
+	}
+	TestEqual("History grown", History.Num(), NumHistoryIds + 1);
+	TestTrue("Oldest id kept", History.Contains(3));
+	TestTrue("First id kept", History.Contains(100));
+	TestTrue("Newest id kept", History.Contains(100 + NumHistoryIds - 1));
+
+	// Expiry after growing still walks the ring in time order.
+	History.RemoveExpired(StartTime + FTimespan::FromSeconds(3.5005), FTimespan::FromSeconds(0.3));
+	TestFalse("Expired id removed after growing", History.Contains(3));
+	TestFalse("Expired id removed after growing", History.Contains(200));
+	TestTrue("Recent id kept after growing", History.Contains(201));
+	TestEqual("History after expiry", History.Num(), NumHistoryIds - 101);
+
+	return true;
+}
+
+#endif
+
+#endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include "Graph/Nodes/SMGraphNode_ConduitNode.h"
 #include "Graph/Nodes/Helpers/SMGraphK2Node_StateReadNodes.h"
 #include "Graph/Nodes/RootNodes/SMGraphK2Node_TransitionEnteredNode.h"
+#include "Compilers/SMKismetCompiler.h"
 
 
 #if WITH_DEV_AUTOMATION_TESTS
@@ -382,6 +383,93 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStateMachineParentTest, "SMTests.StateMachineP
 	return true;
 }
 
+/**
+ * Verify the inherited graph fingerprint only changes when the compiled state machine changes, and children with parent
+ * calls are only marked for recompile when it does.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStateMachineCompileFingerprintTest, "SMTests.CompileFingerprint", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FStateMachineCompileFingerprintTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 3, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	const uint32 Fingerprint = NewBP->InheritedGraphFingerprint;
+	TestTrue("Fingerprint set on compile", Fingerprint != 0);
+	TestTrue("State machine nodes fingerprinted", NewBP->NodeFingerprints.Num() > 0);
+
+	TMap<FGuid, uint32> NodeFingerprints;
+	TestTrue("Fingerprint matches the graph", FSMKismetCompilerContext::CalculateGraphFingerprint(StateMachineGraph, NodeFingerprints) == Fingerprint);
+
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+	TestTrue("Fingerprint stable when recompiled", NewBP->InheritedGraphFingerprint == Fingerprint);
+
+	// Moving a node doesn't change the compiled state machine.
+	LastStatePin->GetOwningNode()->NodePosX += 256;
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+	TestTrue("Fingerprint ignores node position", NewBP->InheritedGraphFingerprint == Fingerprint);
+
+	// A child calling the parent graph.
+	FAssetHandler ChildAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, ChildAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* ChildBP = ChildAsset.GetObjectAs<USMBlueprint>();
+	ChildBP->ParentClass = NewBP->GetGeneratedClass();
+	USMGraph* ChildStateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(ChildBP)->GetStateMachineGraph();
+
+	UEdGraphPin* LastChildStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, ChildStateMachineGraph, 1, &LastChildStatePin);
+	if (!ChildAsset.SaveAsset(this))
+	{
+		return false;
+	}
+
+	USMGraphNode_StateMachineParentNode* ParentNode = TestHelpers::CreateNewNode<USMGraphNode_StateMachineParentNode>(this, ChildStateMachineGraph, LastChildStatePin);
+	TestNotNull("Parent node created", ParentNode);
+	FKismetEditorUtilities::CompileBlueprint(ChildBP);
+
+	const uint32 ChildFingerprint = ChildBP->InheritedGraphFingerprint;
+	TestTrue("Child fingerprint set on compile", ChildFingerprint != 0);
+	TestTrue("Child compiled", ChildBP->Status == BS_UpToDate);
+
+	// Recompiling an unchanged parent skips the children.
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+	TestTrue("Parent fingerprint unchanged", NewBP->InheritedGraphFingerprint == Fingerprint);
+	TestTrue("Child not marked when the parent is unchanged", ChildBP->Status == BS_UpToDate);
+
+	LastStatePin->GetOwningNode()->NodePosY += 256;
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+	TestTrue("Child not marked when a parent node is moved", ChildBP->Status == BS_UpToDate);
+
+	// Changing the parent graph marks the children.
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+	TestTrue("Fingerprint changed when a state is added", NewBP->InheritedGraphFingerprint != Fingerprint);
+	TestTrue("Child marked when the parent changed", ChildBP->Status == BS_Dirty);
+
+	// The child inlines the parent graph so its own fingerprint follows the parent.
+	FKismetEditorUtilities::CompileBlueprint(ChildBP);
+	TestTrue("Child compiled after the parent changed", ChildBP->Status == BS_UpToDate);
+	TestTrue("Child fingerprint includes the parent", ChildBP->InheritedGraphFingerprint != ChildFingerprint);
+
+	ChildAsset.DeleteAsset(this);
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
@@ -14,6 +14,8 @@
 #include "Graph/Nodes/SMGraphNode_StateMachineStateNode.h"
 #include "Graph/Nodes/SMGraphNode_ConduitNode.h"
 #include "Graph/Nodes/Helpers/SMGraphK2Node_StateReadNodes.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
 
 
 #if WITH_DEV_AUTOMATION_TESTS
@@ -335,6 +337,8 @@ bool TestSaveStateMachineState(FAutomationTestBase* Test, bool bCreateReferences
 		Test->TestNull("Active nested state null after stop", ActiveNestedState);
 
 		TArray<FGuid> SavedStateGuids;
+		TArray<uint8> SavedSnapshot;
+		float SavedActiveStateTime = 0.f;
 
 		const int32 StatesNotHit = 5;
 		// Re-instantiate and abort sooner.
@@ -355,6 +359,10 @@ bool TestSaveStateMachineState(FAutomationTestBase* Test, bool bCreateReferences
 			// Top level, nested_1 (exited already) nested_2, nested_2_1 (exited already), nested_2_2
 			NewStateMachineInstance->GetAllActiveStateGuids(SavedStateGuids);
 
+			// Same states in snapshot form.
+			SavedActiveStateTime = SavedActiveState->GetActiveTime();
+			Test->TestTrue("Snapshot saved", NewStateMachineInstance->SaveSnapshot(SavedSnapshot));
+
 			// One state machine is inactive so the states restored depend on if the current state is reused. Reusing states increases count of second nested state machine.
 			// First nested state machine is replaced with a reference to second nested state machine when using references.
 			int32 ExpectedStates = 3;
@@ -457,6 +465,29 @@ bool TestSaveStateMachineState(FAutomationTestBase* Test, bool bCreateReferences
 			Test->TestNotEqual("Nested state shouldn't equal initial state", SavedActiveState, NewStateMachineInstance->GetRootStateMachine().GetSingleInitialState());
 		}
 
+		// Re-instantiate and restore all states from the snapshot.
+		{
+			USMTestContext* NewContext = NewObject<USMTestContext>();
+			USMInstance* NewStateMachineInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(Test, NewBP, NewContext);
+
+			SavedActiveState = NewStateMachineInstance->FindStateByGuid(SavedActiveState->GetGuid());
+			Test->TestNotNull("Active state found by guid", SavedActiveState);
+
+			Test->TestTrue("Snapshot loaded", NewStateMachineInstance->LoadFromSnapshot(SavedSnapshot));
+			Test->TestTrue("Initial top level state should be state machine", NewStateMachineInstance->GetRootStateMachine().GetSingleInitialState()->IsStateMachine());
+
+			NewStateMachineInstance->Start();
+			Test->TestTrue("State Machine should have started", NewStateMachineInstance->IsActive());
+			Test->TestEqual("The first state to start should be equal to the previous saved active state", NewStateMachineInstance->GetSingleNestedActiveState(), SavedActiveState);
+			Test->TestEqual("Time in state restored", SavedActiveState->GetActiveTime(), SavedActiveStateTime);
+
+			int32 Match = TestHelpers::ArrayContentsInArray(NewStateMachineInstance->GetAllActiveStateGuidsCopy(), SavedStateGuids);
+			Test->TestEqual("Restored snapshot states match saved guids", Match, SavedStateGuids.Num());
+
+			StatesHit = TestHelpers::RunAllStateMachinesToCompletion(Test, NewStateMachineInstance, &NewStateMachineInstance->GetRootStateMachine(), -1, -1);
+			Test->TestEqual("Correct number of states hit", StatesHit, StatesNotHit);
+		}
+
 		// One last test checking incrementing every state, saving, and reloading.
 		{
 			for (int32 i = 0; i < TotalStatesHit; ++i)
@@ -486,6 +517,114 @@ bool TestSaveStateMachineState(FAutomationTestBase* Test, bool bCreateReferences
 	return NewAsset.DeleteAsset(Test);
 }
 
+/**
+ * Snapshots must be rejected by a different state machine and must survive a round trip through an archive.
+ * Also logs the time to save and restore snapshots compared to guids.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSaveStateMachineSnapshotTest, "SMTests.SaveRestoreStateMachineSnapshot", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FSaveStateMachineSnapshotTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	const int32 TotalStates = 100;
+	UEdGraphPin* LastStatePin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, TotalStates, &LastStatePin);
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* StateMachineInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+	StateMachineInstance->Start();
+	TestHelpers::RunAllStateMachinesToCompletion(this, StateMachineInstance, &StateMachineInstance->GetRootStateMachine(), TotalStates / 2, -1);
+	StateMachineInstance->Update(1.5f);
+
+	FSMState_Base* ActiveState = StateMachineInstance->GetSingleNestedActiveState();
+	TestNotNull("Active state", ActiveState);
+	const float ActiveTime = ActiveState->GetActiveTime();
+
+	// Round trip through an archive.
+	TArray<uint8> Snapshot;
+	{
+		FMemoryWriter Writer(Snapshot);
+		TestTrue("Snapshot written", StateMachineInstance->WriteSnapshot(Writer));
+	}
+	{
+		USMInstance* LoadedInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+		FMemoryReader Reader(Snapshot);
+		TestTrue("Snapshot read", LoadedInstance->ReadSnapshot(Reader));
+		LoadedInstance->Start();
+		TestEqual("Active state restored", LoadedInstance->GetSingleNestedActiveState()->GetGuid(), ActiveState->GetGuid());
+		TestEqual("Time in state restored", LoadedInstance->GetSingleNestedActiveState()->GetActiveTime(), ActiveTime);
+	}
+
+	// Malformed and mismatched snapshots are rejected.
+	{
+		USMInstance* LoadedInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+
+		AddExpectedError("The data is not a state machine snapshot", EAutomationExpectedErrorFlags::Contains, 1);
+		TArray<uint8> Garbage;
+		Garbage.Init(0xFF, 16);
+		TestFalse("Garbage rejected", LoadedInstance->LoadFromSnapshot(Garbage));
+
+		AddExpectedError("The data is malformed", EAutomationExpectedErrorFlags::Contains, 1);
+		TArray<uint8> Truncated(Snapshot.GetData(), Snapshot.Num() - 2);
+		TestFalse("Truncated snapshot rejected", LoadedInstance->LoadFromSnapshot(Truncated));
+	}
+	{
+		FAssetHandler OtherAsset;
+		if (!TestHelpers::TryCreateNewStateMachineAsset(this, OtherAsset, false))
+		{
+			return false;
+		}
+		USMBlueprint* OtherBP = OtherAsset.GetObjectAs<USMBlueprint>();
+		UEdGraphPin* OtherLastStatePin = nullptr;
+		TestHelpers::BuildLinearStateMachine(this, FSMBlueprintEditorUtils::GetRootStateMachineNode(OtherBP)->GetStateMachineGraph(), TotalStates, &OtherLastStatePin);
+		FKismetEditorUtilities::CompileBlueprint(OtherBP);
+
+		AddExpectedError("It was saved from a different state machine", EAutomationExpectedErrorFlags::Contains, 1);
+		USMInstance* OtherInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, OtherBP, NewObject<USMTestContext>());
+		TestFalse("Snapshot from other state machine rejected", OtherInstance->LoadFromSnapshot(Snapshot));
+
+		OtherAsset.DeleteAsset(this);
+	}
+
+	// Throughput compared to guids.
+	{
+		const int32 Iterations = 10000;
+		USMInstance* LoadedInstance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, NewObject<USMTestContext>());
+
+		double StartTime = FPlatformTime::Seconds();
+		TArray<FGuid> Guids;
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			StateMachineInstance->GetAllActiveStateGuids(Guids);
+			LoadedInstance->LoadFromMultipleStates(Guids);
+		}
+		const double GuidSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			StateMachineInstance->SaveSnapshot(Snapshot);
+			LoadedInstance->LoadFromSnapshot(Snapshot);
+		}
+		const double SnapshotSeconds = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("Save/restore x%d: guids %.3fms (%d bytes), snapshot %.3fms (%d bytes)"), Iterations,
+			GuidSeconds * 1000.0, Guids.Num() * (int32)sizeof(FGuid), SnapshotSeconds * 1000.0, Snapshot.Num()));
+	}
+
+	return NewAsset.DeleteAsset(this);
+}
+
 /**
  * Save and restore the state of a hierarchical state machine, then do it again with bReuseCurrentState.
  */
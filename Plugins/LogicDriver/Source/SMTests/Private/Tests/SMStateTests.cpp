@@ -669,6 +669,98 @@ IMPLEMENT_SIMPLE_AUTOMATION_TEST(FParallelStatesTest, "SMTests.ParallelStates",
 	return NewAsset.DeleteAsset(this);
 }
 
+/**
+ * The maintained active state list must match searching every nested state machine and reference as states start and end.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FActiveStateListTest, "SMTests.ActiveStateList", EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+	bool FActiveStateListTest::RunTest(const FString& Parameters)
+{
+	FAssetHandler NewAsset;
+	if (!TestHelpers::TryCreateNewStateMachineAsset(this, NewAsset, false))
+	{
+		return false;
+	}
+
+	USMBlueprint* NewBP = NewAsset.GetObjectAs<USMBlueprint>();
+	USMGraph* StateMachineGraph = FSMBlueprintEditorUtils::GetRootStateMachineNode(NewBP)->GetStateMachineGraph();
+
+	// Each level is a nested state machine followed by a state which waits for it to complete.
+	const int32 Depth = 3;
+	UEdGraphPin* LastPin = nullptr;
+	TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastPin);
+
+	USMGraphNode_StateMachineStateNode* DeepestStateMachineNode = nullptr;
+	for (int32 Level = 0; Level < Depth; ++Level)
+	{
+		UEdGraphPin* NestedPin = nullptr;
+		USMGraphNode_StateMachineStateNode* NestedStateMachineNode = TestHelpers::BuildNestedStateMachine(this, StateMachineGraph, 3, &LastPin, &NestedPin);
+
+		LastPin = NestedStateMachineNode->GetOutputPin();
+		TestHelpers::BuildLinearStateMachine(this, StateMachineGraph, 1, &LastPin);
+		USMGraphNode_TransitionEdge* TransitionFromNestedStateMachine = CastChecked<USMGraphNode_TransitionEdge>(NestedStateMachineNode->GetOutputPin()->LinkedTo[0]->GetOwningNode());
+		TestHelpers::OverrideTransitionResultLogic<USMGraphK2Node_StateMachineReadNode_InEndState>(this, TransitionFromNestedStateMachine);
+
+		StateMachineGraph = Cast<USMGraph>(NestedStateMachineNode->GetBoundGraph());
+		LastPin = NestedPin;
+		DeepestStateMachineNode = NestedStateMachineNode;
+	}
+
+	// The deepest level runs as a reference so its states reach the owning instance through the instance referencing it.
+	FString AssetName = "ActiveStateListRef";
+	USMBlueprint* ReferencedBP = FSMBlueprintEditorUtils::ConvertStateMachineToReference(DeepestStateMachineNode, false, &AssetName, nullptr);
+	TestNotNull("New referenced blueprint created", ReferencedBP);
+	if (!ReferencedBP)
+	{
+		return false;
+	}
+	FKismetEditorUtilities::CompileBlueprint(ReferencedBP);
+
+	FString ReferencedPath = ReferencedBP->GetPathName();
+	FAssetHandler ReferencedAsset(ReferencedBP->GetName(), USMBlueprint::StaticClass(), NewObject<USMBlueprintFactory>(), &ReferencedPath);
+	ReferencedAsset.Object = ReferencedBP;
+	ReferencedAsset.Package = FAssetData(ReferencedBP).GetPackage();
+
+	FKismetEditorUtilities::CompileBlueprint(NewBP);
+
+	USMTestContext* Context = NewObject<USMTestContext>();
+	USMInstance* Instance = TestHelpers::CreateNewStateMachineInstanceFromBP(this, NewBP, Context);
+
+	auto TestMatchesSearch = [&](const TCHAR* When)
+	{
+		const TArray<FSMState_Base*> SearchedStates = Instance->GetRootStateMachine().GetAllNestedActiveStates();
+		const TArray<FSMState_Base*>& ActiveStates = Instance->GetActiveStatesView();
+		TestEqual(FString::Printf(TEXT("Active state count matches search %s"), When), ActiveStates.Num(), SearchedStates.Num());
+		TestEqual(FString::Printf(TEXT("Active states match search %s"), When), TestHelpers::ArrayContentsInArray(ActiveStates, SearchedStates), SearchedStates.Num());
+	};
+
+	Instance->Start();
+	TestTrue("Nested states active", Instance->GetActiveStatesView().Num() > Depth);
+	TestMatchesSearch(TEXT("after start"));
+
+	int32 MaxActiveStates = 0;
+	const int32 MaxIterations = 1000;
+	for (int32 Iteration = 0; Iteration < MaxIterations && !Instance->GetRootStateMachine().IsInEndState(); ++Iteration)
+	{
+		Instance->Update(1.f);
+		TestMatchesSearch(TEXT("during update"));
+		MaxActiveStates = FMath::Max(MaxActiveStates, Instance->GetActiveStatesView().Num());
+	}
+
+	TestTrue("State machine reached end state", Instance->GetRootStateMachine().IsInEndState());
+	TestTrue("Referenced states included", MaxActiveStates > Depth);
+
+	Instance->Stop();
+	TestMatchesSearch(TEXT("after stop"));
+
+	TestTrue("Instance reset", Instance->ResetToInitialState());
+	TestEqual("No active states after reset", Instance->GetActiveStatesView().Num(), 0);
+
+	ReferencedAsset.DeleteAsset(this);
+	return NewAsset.DeleteAsset(this);
+}
+
 #endif
 
 #endif //WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
@@ -33,6 +33,7 @@ public class SMSystemTests : ModuleRules
                 "BlueprintGraph",
                 "KismetCompiler",
                 "SlateCore",
+                "Json",
                 "SMSystem",
                 "SMSystemEditor",
                 "SMExtendedRuntime",
@@ -1,5 +1,6 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 #include "OpenVRExpansionFunctionLibrary.h"
+#include "OpenVRRenderModelCache.h"
 //#include "EngineMinimal.h"
 #include "Engine/Engine.h"
 #include "CoreMinimal.h"
@@ -985,153 +986,43 @@ UTexture2D * UOpenVRExpansionFunctionLibrary::GetVRDeviceModelAndTexture(UObject
 		RenderModelNameOut = FString(ANSI_TO_TCHAR(RenderModelName));
 	}
 
-	//uint32_t numComponents = VRRenderModels->GetComponentCount("vr_controller_vive_1_5");
-	//UE_LOG(OpenVRExpansionFunctionLibraryLog, Warning, TEXT("NumComponents: %i"), (int32)numComponents);
-	// if numComponents > 0 load each, otherwise load the main one only
+	// Converted models are cached by name and shared between devices, the conversion itself runs on the thread pool
+	FOpenVRRenderModelCache& RenderModelCache = FOpenVRRenderModelCache::Get();
+	FOpenVRRenderModelDataPtr RenderModelData = RenderModelCache.FindRenderModel(RenderModelNameOut);
 
-	vr::RenderModel_t *RenderModel = NULL;
-
-	//VRRenderModels->LoadRenderModel()
-	vr::EVRRenderModelError ModelErrorCode = VRRenderModels->LoadRenderModel_Async(RenderModelName, &RenderModel);
-	
-	if (ModelErrorCode != vr::EVRRenderModelError::VRRenderModelError_None)
+	if (!RenderModelData.IsValid())
 	{
-		if (ModelErrorCode != vr::EVRRenderModelError::VRRenderModelError_Loading)
+		if (!RenderModelCache.ConsumeLoadFailure(RenderModelNameOut))
 		{
-			UE_LOG(OpenVRExpansionFunctionLibraryLog, Warning, TEXT("Couldn't Load Model!!"));
-			Result = EAsyncBlueprintResultSwitch::OnFailure;
+			RenderModelCache.LoadRenderModel(RenderModelNameOut, FOnOpenVRRenderModelLoaded());
+			RenderModelData = RenderModelCache.FindRenderModel(RenderModelNameOut);
 		}
-		else
-			Result = EAsyncBlueprintResultSwitch::AsyncLoading;
-
-		return nullptr;
-	}
-
-	if (!RenderModel)
-	{
-		UE_LOG(OpenVRExpansionFunctionLibraryLog, Warning, TEXT("Couldn't Load Model!!"));
-		Result = EAsyncBlueprintResultSwitch::OnFailure;
-		return nullptr;
-	}
-
-	vr::TextureID_t texID = RenderModel->diffuseTextureId;
-	vr::RenderModel_TextureMap_t * texture = NULL;
-	UTexture2D* OutTexture = nullptr;
-
-	if (texID != vr::INVALID_TEXTURE_ID)
-	{
-		//UTexture2DDynamic * OutTexture = nullptr;
-		vr::EVRRenderModelError TextureErrorCode = VRRenderModels->LoadTexture_Async(texID, &texture);
 
-		if (TextureErrorCode != vr::EVRRenderModelError::VRRenderModelError_None)
+		if (!RenderModelData.IsValid())
 		{
-			if (TextureErrorCode != vr::EVRRenderModelError::VRRenderModelError_Loading)
+			if (RenderModelCache.IsLoading(RenderModelNameOut))
 			{
-				UE_LOG(OpenVRExpansionFunctionLibraryLog, Warning, TEXT("Couldn't Load Texture!!"));
-				Result = EAsyncBlueprintResultSwitch::OnFailure;
+				Result = EAsyncBlueprintResultSwitch::AsyncLoading;
 			}
 			else
-				Result = EAsyncBlueprintResultSwitch::AsyncLoading;
-
-			return nullptr;
-		}
+			{
+				RenderModelCache.ConsumeLoadFailure(RenderModelNameOut);
+				UE_LOG(OpenVRExpansionFunctionLibraryLog, Warning, TEXT("Couldn't Load Model!!"));
+				Result = EAsyncBlueprintResultSwitch::OnFailure;
+			}
 
-		if (!texture)
-		{
-			UE_LOG(OpenVRExpansionFunctionLibraryLog, Warning, TEXT("Couldn't Load Texture!!"));
-			Result = EAsyncBlueprintResultSwitch::OnFailure;
 			return nullptr;
 		}
 	}
 
 	if (ProceduralMeshComponentsToFill.Num() > 0)
 	{
-		TArray<FVector> vertices;
-		TArray<int32> triangles;
-		TArray<FVector> normals;
-		TArray<FVector2D> UV0;
-		TArray<FColor> vertexColors;
-		TArray<FProcMeshTangent> tangents;
-		
-		vr::HmdVector3_t vPosition;
-		vr::HmdVector3_t vNormal;
-
-		vertices.Reserve(RenderModel->unVertexCount);
-		normals.Reserve(RenderModel->unVertexCount);
-		UV0.Reserve(RenderModel->unVertexCount);
-	
-		for (uint32_t i = 0; i < RenderModel->unVertexCount; ++i)
-		{
-			vPosition = RenderModel->rVertexData[i].vPosition;
-			// OpenVR y+ Up, +x Right, -z Going away
-			// UE4 z+ up, +y right, +x forward
-
-			vertices.Add(FVector(-vPosition.v[2], vPosition.v[0], vPosition.v[1]));
-
-			vNormal = RenderModel->rVertexData[i].vNormal;
-
-			normals.Add(FVector(-vNormal.v[2], vNormal.v[0], vNormal.v[1]));
-
-			UV0.Add(FVector2D(RenderModel->rVertexData[i].rfTextureCoord[0], RenderModel->rVertexData[i].rfTextureCoord[1]));
-		}
-
-		triangles.Reserve(RenderModel->unTriangleCount);
-		for (uint32_t i = 0; i < RenderModel->unTriangleCount * 3; i += 3)
-		{
-			triangles.Add(RenderModel->rIndexData[i]);
-			triangles.Add(RenderModel->rIndexData[i + 1]);
-			triangles.Add(RenderModel->rIndexData[i + 2]);
-		}
-
 		float scale = UHeadMountedDisplayFunctionLibrary::GetWorldToMetersScale(WorldContextObject);
-		for (int i = 0; i < ProceduralMeshComponentsToFill.Num(); ++i)
-		{
-			ProceduralMeshComponentsToFill[i]->ClearAllMeshSections();
-			ProceduralMeshComponentsToFill[i]->CreateMeshSection(0, vertices, triangles, normals, UV0, vertexColors, tangents, bCreateCollision);
-			ProceduralMeshComponentsToFill[i]->SetMeshSectionVisible(0, true);
-			ProceduralMeshComponentsToFill[i]->SetWorldScale3D(FVector(scale, scale, scale));
-		}
-	}
-
-	if (texture != nullptr)
-	{
-		uint32 Width = texture->unWidth;
-		uint32 Height = texture->unHeight;
-
-
-		//OutTexture = UTexture2DDynamic::Create(Width, Height, PF_R8G8B8A8);
-		OutTexture = UTexture2D::CreateTransient(Width, Height, PF_R8G8B8A8);
-
-
-		//FTexture2DDynamicResource * TexResource = static_cast<FTexture2DDynamicResource*>(OutTexture->Resource);
-		//FTexture2DRHIParamRef TextureRHI = TexResource->GetTexture2DRHI();
-
-		//uint32 DestStride = 0;
-		//uint8* MipData = reinterpret_cast<uint8*>(RHILockTexture2D(TextureRHI, 0, RLM_WriteOnly, DestStride, false, false));
-
-		uint8* MipData = (uint8*)OutTexture->PlatformData->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
-		FMemory::Memcpy(MipData, (void*)texture->rubTextureMapData, Height * Width * 4);
-		OutTexture->PlatformData->Mips[0].BulkData.Unlock();
-		//RHIUnlockTexture2D(TextureRHI, 0, false, false);
-
-
-		//Setting some Parameters for the Texture and finally returning it
-		OutTexture->PlatformData->SetNumSlices(1);
-		OutTexture->NeverStream = true;
-		OutTexture->UpdateResource();
-
-		/*if (bReturnRawTexture)
-		{
-			OutRawTexture.AddUninitialized(Height * Width * 4);
-			FMemory::Memcpy(OutRawTexture.GetData(), (void*)texture->rubTextureMapData, Height * Width * 4);
-		}*/
-
-		Result = EAsyncBlueprintResultSwitch::OnSuccess;
-		VRRenderModels->FreeTexture(texture);
+		FOpenVRRenderModelConverter::FillProceduralMeshes(*RenderModelData, ProceduralMeshComponentsToFill, bCreateCollision, scale);
 	}
 
-	VRRenderModels->FreeRenderModel(RenderModel);
-	return OutTexture;
+	Result = EAsyncBlueprintResultSwitch::OnSuccess;
+	return RenderModelCache.GetTexture(*RenderModelData);
 #endif
 }
 
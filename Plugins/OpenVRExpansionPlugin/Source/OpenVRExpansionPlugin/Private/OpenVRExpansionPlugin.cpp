@@ -2,6 +2,7 @@
 
 #include "OpenVRExpansionPlugin.h"
 #include "OpenVRExpansionFunctionLibrary.h"
+#include "OpenVRRenderModelCache.h"
 
 #define LOCTEXT_NAMESPACE "FVRExpansionPluginModule"
 
@@ -15,6 +16,7 @@ void FOpenVRExpansionPluginModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FOpenVRRenderModelCache::Shutdown();
 //	UnloadOpenVRModule();
 }
 
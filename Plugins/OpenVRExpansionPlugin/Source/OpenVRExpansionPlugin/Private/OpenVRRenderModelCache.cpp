@@ -0,0 +1,374 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "OpenVRRenderModelCache.h"
+#include "Engine/Texture2D.h"
+#include "ProceduralMeshComponent.h"
+#include "Async/Async.h"
+
+DEFINE_LOG_CATEGORY(OpenVRRenderModelCacheLog);
+
+TUniquePtr<FOpenVRRenderModelCache> FOpenVRRenderModelCache::Instance;
+
+#if STEAMVR_SUPPORTED_PLATFORM
+// Forwards to the SteamVR render models interface
+class FSteamVRRenderModelSource : public IOpenVRRenderModelSource
+{
+public:
+	explicit FSteamVRRenderModelSource(vr::IVRRenderModels* InVRRenderModels) : VRRenderModels(InVRRenderModels)
+	{}
+
+	virtual vr::EVRRenderModelError LoadRenderModel_Async(const char* RenderModelName, vr::RenderModel_t** OutRenderModel) override
+	{
+		return VRRenderModels->LoadRenderModel_Async(RenderModelName, OutRenderModel);
+	}
+
+	virtual vr::EVRRenderModelError LoadTexture_Async(vr::TextureID_t TextureId, vr::RenderModel_TextureMap_t** OutTexture) override
+	{
+		return VRRenderModels->LoadTexture_Async(TextureId, OutTexture);
+	}
+
+	virtual void FreeRenderModel(vr::RenderModel_t* RenderModel) override
+	{
+		VRRenderModels->FreeRenderModel(RenderModel);
+	}
+
+	virtual void FreeTexture(vr::RenderModel_TextureMap_t* Texture) override
+	{
+		VRRenderModels->FreeTexture(Texture);
+	}
+
+	vr::IVRRenderModels* VRRenderModels;
+};
+#endif
+
+#if STEAMVR_SUPPORTED_PLATFORM
+void FOpenVRRenderModelConverter::ConvertGeometry(const vr::RenderModel_Vertex_t* VertexData, uint32 VertexCount, const uint16* IndexData, uint32 TriangleCount, FOpenVRRenderModelData& OutData)
+{
+	OutData.Vertices.Reset(VertexCount);
+	OutData.Normals.Reset(VertexCount);
+	OutData.UV0.Reset(VertexCount);
+
+	for (uint32 i = 0; i < VertexCount; ++i)
+	{
+		const vr::HmdVector3_t& vPosition = VertexData[i].vPosition;
+		const vr::HmdVector3_t& vNormal = VertexData[i].vNormal;
+
+		// OpenVR y+ Up, +x Right, -z Going away
+		// UE4 z+ up, +y right, +x forward
+		OutData.Vertices.Add(FVector(-vPosition.v[2], vPosition.v[0], vPosition.v[1]));
+		OutData.Normals.Add(FVector(-vNormal.v[2], vNormal.v[0], vNormal.v[1]));
+		OutData.UV0.Add(FVector2D(VertexData[i].rfTextureCoord[0], VertexData[i].rfTextureCoord[1]));
+	}
+
+	OutData.Triangles.Reset(TriangleCount * 3);
+	for (uint32 i = 0; i < TriangleCount * 3; ++i)
+	{
+		OutData.Triangles.Add(IndexData[i]);
+	}
+}
+
+void FOpenVRRenderModelConverter::ConvertTexture(const uint8* TextureMapData, uint16 Width, uint16 Height, FOpenVRRenderModelData& OutData)
+{
+	OutData.TextureWidth = Width;
+	OutData.TextureHeight = Height;
+	OutData.TextureData.SetNumUninitialized(Width * Height * 4);
+	FMemory::Memcpy(OutData.TextureData.GetData(), TextureMapData, OutData.TextureData.Num());
+}
+#endif
+
+void FOpenVRRenderModelConverter::FillProceduralMeshes(const FOpenVRRenderModelData& Data, const TArray<UProceduralMeshComponent*>& ProceduralMeshComponentsToFill, bool bCreateCollision, float WorldToMetersScale)
+{
+	const TArray<FColor> VertexColors;
+	const TArray<FProcMeshTangent> Tangents;
+
+	for (UProceduralMeshComponent* ProceduralMeshComponent : ProceduralMeshComponentsToFill)
+	{
+		if (!ProceduralMeshComponent)
+			continue;
+
+		ProceduralMeshComponent->ClearAllMeshSections();
+		ProceduralMeshComponent->CreateMeshSection(0, Data.Vertices, Data.Triangles, Data.Normals, Data.UV0, VertexColors, Tangents, bCreateCollision);
+		ProceduralMeshComponent->SetMeshSectionVisible(0, true);
+		ProceduralMeshComponent->SetWorldScale3D(FVector(WorldToMetersScale));
+	}
+}
+
+UTexture2D* FOpenVRRenderModelConverter::CreateTexture(const FOpenVRRenderModelData& Data)
+{
+	check(IsInGameThread());
+
+	if (!Data.HasTexture())
+		return nullptr;
+
+	UTexture2D* OutTexture = UTexture2D::CreateTransient(Data.TextureWidth, Data.TextureHeight, PF_R8G8B8A8);
+	if (!OutTexture)
+		return nullptr;
+
+	uint8* MipData = (uint8*)OutTexture->PlatformData->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
+	FMemory::Memcpy(MipData, Data.TextureData.GetData(), Data.TextureData.Num());
+	OutTexture->PlatformData->Mips[0].BulkData.Unlock();
+
+	OutTexture->PlatformData->SetNumSlices(1);
+	OutTexture->NeverStream = true;
+	OutTexture->UpdateResource();
+
+	return OutTexture;
+}
+
+FOpenVRRenderModelCache& FOpenVRRenderModelCache::Get()
+{
+	if (!Instance.IsValid())
+	{
+		Instance = MakeUnique<FOpenVRRenderModelCache>();
+	}
+
+	return *Instance;
+}
+
+void FOpenVRRenderModelCache::Shutdown()
+{
+	Instance.Reset();
+}
+
+FOpenVRRenderModelCache::~FOpenVRRenderModelCache()
+{
+	for (TPair<FString, TUniquePtr<FPendingLoad>>& PendingLoad : PendingLoads)
+	{
+		ReleasePendingLoad(*PendingLoad.Value);
+	}
+}
+
+void FOpenVRRenderModelCache::LoadRenderModel(const FString& RenderModelName, FOnOpenVRRenderModelLoaded OnLoaded)
+{
+	check(IsInGameThread());
+
+	if (FOpenVRRenderModelDataPtr* RenderModel = RenderModels.Find(RenderModelName))
+	{
+		OnLoaded.ExecuteIfBound(*RenderModel);
+		return;
+	}
+
+	if (TUniquePtr<FPendingLoad>* ExistingLoad = PendingLoads.Find(RenderModelName))
+	{
+		if (OnLoaded.IsBound())
+		{
+			(*ExistingLoad)->Callbacks.Add(OnLoaded);
+		}
+		return;
+	}
+
+	FailedRenderModels.Remove(RenderModelName);
+
+	TUniquePtr<FPendingLoad> NewLoad = MakeUnique<FPendingLoad>();
+	if (OnLoaded.IsBound())
+	{
+		NewLoad->Callbacks.Add(OnLoaded);
+	}
+
+	// Poll right away, SteamVR may already have the model loaded
+	if (!UpdatePendingLoad(RenderModelName, *NewLoad))
+	{
+		ReleasePendingLoad(*NewLoad);
+		FailedRenderModels.Add(RenderModelName);
+		OnLoaded.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	PendingLoads.Add(RenderModelName, MoveTemp(NewLoad));
+}
+
+FOpenVRRenderModelDataPtr FOpenVRRenderModelCache::FindRenderModel(const FString& RenderModelName) const
+{
+	const FOpenVRRenderModelDataPtr* RenderModel = RenderModels.Find(RenderModelName);
+	return RenderModel ? *RenderModel : nullptr;
+}
+
+bool FOpenVRRenderModelCache::IsLoading(const FString& RenderModelName) const
+{
+	return PendingLoads.Contains(RenderModelName);
+}
+
+bool FOpenVRRenderModelCache::ConsumeLoadFailure(const FString& RenderModelName)
+{
+	return FailedRenderModels.Remove(RenderModelName) > 0;
+}
+
+UTexture2D* FOpenVRRenderModelCache::GetTexture(const FOpenVRRenderModelData& Data)
+{
+	check(IsInGameThread());
+
+	if (UTexture2D** ExistingTexture = Textures.Find(Data.RenderModelName))
+	{
+		return *ExistingTexture;
+	}
+
+	UTexture2D* NewTexture = FOpenVRRenderModelConverter::CreateTexture(Data);
+	if (NewTexture)
+	{
+		Textures.Add(Data.RenderModelName, NewTexture);
+	}
+
+	return NewTexture;
+}
+
+void FOpenVRRenderModelCache::Empty()
+{
+	RenderModels.Empty();
+	Textures.Empty();
+	FailedRenderModels.Empty();
+}
+
+#if STEAMVR_SUPPORTED_PLATFORM
+void FOpenVRRenderModelCache::SetRenderModelSource(TSharedPtr<IOpenVRRenderModelSource> NewRenderModelSource)
+{
+	check(PendingLoads.Num() == 0);
+	RenderModelSource = NewRenderModelSource;
+}
+
+IOpenVRRenderModelSource* FOpenVRRenderModelCache::GetRenderModelSource() const
+{
+	if (RenderModelSource.IsValid())
+		return RenderModelSource.Get();
+
+	// The interface pointer changes if SteamVR is restarted, so it is looked up on every use
+	static FSteamVRRenderModelSource SteamVRRenderModelSource(nullptr);
+	SteamVRRenderModelSource.VRRenderModels = vr::VRRenderModels();
+	return SteamVRRenderModelSource.VRRenderModels ? &SteamVRRenderModelSource : nullptr;
+}
+#endif
+
+void FOpenVRRenderModelCache::Tick(float DeltaTime)
+{
+	// Gather the finished loads first, the callbacks are free to start new ones
+	TArray<TPair<FOpenVRRenderModelDataPtr, TArray<FOnOpenVRRenderModelLoaded>>> FinishedLoads;
+
+	for (auto It = PendingLoads.CreateIterator(); It; ++It)
+	{
+		FPendingLoad& Load = *It.Value();
+
+		if (!UpdatePendingLoad(It.Key(), Load))
+		{
+			ReleasePendingLoad(Load);
+			FailedRenderModels.Add(It.Key());
+			FinishedLoads.Emplace(nullptr, MoveTemp(Load.Callbacks));
+			It.RemoveCurrent();
+			continue;
+		}
+
+		if (Load.Conversion.IsValid() && Load.Conversion.IsReady())
+		{
+			FOpenVRRenderModelDataPtr RenderModel = Load.Conversion.Get();
+			ReleasePendingLoad(Load);
+			RenderModels.Add(It.Key(), RenderModel);
+			FinishedLoads.Emplace(RenderModel, MoveTemp(Load.Callbacks));
+			It.RemoveCurrent();
+		}
+	}
+
+	for (TPair<FOpenVRRenderModelDataPtr, TArray<FOnOpenVRRenderModelLoaded>>& FinishedLoad : FinishedLoads)
+	{
+		for (FOnOpenVRRenderModelLoaded& Callback : FinishedLoad.Value)
+		{
+			Callback.ExecuteIfBound(FinishedLoad.Key);
+		}
+	}
+}
+
+TStatId FOpenVRRenderModelCache::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FOpenVRRenderModelCache, STATGROUP_Tickables);
+}
+
+void FOpenVRRenderModelCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObjects(Textures);
+}
+
+bool FOpenVRRenderModelCache::UpdatePendingLoad(const FString& RenderModelName, FPendingLoad& Load)
+{
+#if !STEAMVR_SUPPORTED_PLATFORM
+	UE_LOG(OpenVRRenderModelCacheLog, Warning, TEXT("Not SteamVR Supported Platform!!"));
+	return false;
+#else
+
+	// Already converting
+	if (Load.Conversion.IsValid())
+		return true;
+
+	IOpenVRRenderModelSource* VRRenderModels = GetRenderModelSource();
+	if (!VRRenderModels)
+	{
+		UE_LOG(OpenVRRenderModelCacheLog, Warning, TEXT("Render Models Errored"));
+		return false;
+	}
+
+	if (!Load.RenderModel)
+	{
+		vr::EVRRenderModelError ModelErrorCode = VRRenderModels->LoadRenderModel_Async(TCHAR_TO_ANSI(*RenderModelName), &Load.RenderModel);
+		if (ModelErrorCode == vr::EVRRenderModelError::VRRenderModelError_Loading)
+			return true;
+
+		if (ModelErrorCode != vr::EVRRenderModelError::VRRenderModelError_None || !Load.RenderModel)
+		{
+			UE_LOG(OpenVRRenderModelCacheLog, Warning, TEXT("Couldn't Load Model %s!!"), *RenderModelName);
+			Load.RenderModel = nullptr;
+			return false;
+		}
+	}
+
+	if (!Load.Texture && Load.RenderModel->diffuseTextureId != vr::INVALID_TEXTURE_ID)
+	{
+		vr::EVRRenderModelError TextureErrorCode = VRRenderModels->LoadTexture_Async(Load.RenderModel->diffuseTextureId, &Load.Texture);
+		if (TextureErrorCode == vr::EVRRenderModelError::VRRenderModelError_Loading)
+			return true;
+
+		if (TextureErrorCode != vr::EVRRenderModelError::VRRenderModelError_None || !Load.Texture)
+		{
+			UE_LOG(OpenVRRenderModelCacheLog, Warning, TEXT("Couldn't Load Texture for %s!!"), *RenderModelName);
+			Load.Texture = nullptr;
+			return false;
+		}
+	}
+
+	// Both buffers are owned by SteamVR until freed, which only happens after the conversion is done
+	const vr::RenderModel_t* RenderModel = Load.RenderModel;
+	const vr::RenderModel_TextureMap_t* Texture = Load.Texture;
+	Load.Conversion = Async(EAsyncExecution::ThreadPool, [RenderModelName, RenderModel, Texture]() -> FOpenVRRenderModelDataPtr
+	{
+		TSharedRef<FOpenVRRenderModelData, ESPMode::ThreadSafe> Data = MakeShared<FOpenVRRenderModelData, ESPMode::ThreadSafe>();
+		Data->RenderModelName = RenderModelName;
+		FOpenVRRenderModelConverter::ConvertGeometry(RenderModel->rVertexData, RenderModel->unVertexCount, RenderModel->rIndexData, RenderModel->unTriangleCount, *Data);
+
+		if (Texture)
+		{
+			FOpenVRRenderModelConverter::ConvertTexture(Texture->rubTextureMapData, Texture->unWidth, Texture->unHeight, *Data);
+		}
+
+		return Data;
+	});
+
+	return true;
+#endif
+}
+
+void FOpenVRRenderModelCache::ReleasePendingLoad(FPendingLoad& Load)
+{
+	if (Load.Conversion.IsValid())
+	{
+		Load.Conversion.Wait();
+	}
+
+#if STEAMVR_SUPPORTED_PLATFORM
+	IOpenVRRenderModelSource* VRRenderModels = GetRenderModelSource();
+	if (VRRenderModels)
+	{
+		if (Load.Texture)
+			VRRenderModels->FreeTexture(Load.Texture);
+
+		if (Load.RenderModel)
+			VRRenderModels->FreeRenderModel(Load.RenderModel);
+	}
+
+	Load.RenderModel = nullptr;
+	Load.Texture = nullptr;
+#endif
+}
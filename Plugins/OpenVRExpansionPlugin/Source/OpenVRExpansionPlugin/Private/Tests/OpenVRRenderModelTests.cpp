@@ -0,0 +1,316 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "OpenVRRenderModelCache.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && STEAMVR_SUPPORTED_PLATFORM
+
+namespace OpenVRRenderModelTests
+{
+	/**
+	* A hand built OpenVR render model, a quad with every vertex on a different axis and a 2x2 texture
+	*/
+	struct FTestRenderModel
+	{
+		vr::RenderModel_Vertex_t Vertices[4];
+		uint16 Indices[6];
+		uint8 TextureData[2 * 2 * 4];
+
+		vr::RenderModel_t RenderModel;
+		vr::RenderModel_TextureMap_t Texture;
+
+		FTestRenderModel()
+		{
+			for (int32 i = 0; i < 4; ++i)
+			{
+				Vertices[i].vPosition.v[0] = 1.0f + i;
+				Vertices[i].vPosition.v[1] = 10.0f + i;
+				Vertices[i].vPosition.v[2] = 100.0f + i;
+				Vertices[i].vNormal.v[0] = i == 1 ? 1.0f : 0.0f;
+				Vertices[i].vNormal.v[1] = i == 2 ? 1.0f : 0.0f;
+				Vertices[i].vNormal.v[2] = i == 3 || i == 0 ? -1.0f : 0.0f;
+				Vertices[i].rfTextureCoord[0] = (i & 1) ? 1.0f : 0.0f;
+				Vertices[i].rfTextureCoord[1] = (i & 2) ? 1.0f : 0.0f;
+			}
+
+			const uint16 QuadIndices[6] = { 0, 1, 2, 2, 1, 3 };
+			FMemory::Memcpy(Indices, QuadIndices, sizeof(Indices));
+
+			for (int32 i = 0; i < UE_ARRAY_COUNT(TextureData); ++i)
+			{
+				TextureData[i] = (uint8)(i * 13);
+			}
+
+			RenderModel.rVertexData = Vertices;
+			RenderModel.unVertexCount = 4;
+			RenderModel.rIndexData = Indices;
+			RenderModel.unTriangleCount = 2;
+			RenderModel.diffuseTextureId = 7;
+
+			Texture.unWidth = 2;
+			Texture.unHeight = 2;
+			Texture.rubTextureMapData = TextureData;
+		}
+	};
+
+	/**
+	* Answers the cache with the test model after a number of polls, like SteamVR while it loads from disk
+	*/
+	class FTestRenderModelSource : public IOpenVRRenderModelSource
+	{
+	public:
+		FTestRenderModelSource() :
+			NumLoadingPolls(0),
+			bFailModel(false),
+			bFailTexture(false),
+			NumModelPolls(0),
+			NumTexturePolls(0),
+			NumModelsFreed(0),
+			NumTexturesFreed(0)
+		{}
+
+		virtual vr::EVRRenderModelError LoadRenderModel_Async(const char* RenderModelName, vr::RenderModel_t** OutRenderModel) override
+		{
+			if (bFailModel)
+				return vr::EVRRenderModelError::VRRenderModelError_InvalidModel;
+
+			if (NumModelPolls++ < NumLoadingPolls)
+				return vr::EVRRenderModelError::VRRenderModelError_Loading;
+
+			*OutRenderModel = &Model.RenderModel;
+			return vr::EVRRenderModelError::VRRenderModelError_None;
+		}
+
+		virtual vr::EVRRenderModelError LoadTexture_Async(vr::TextureID_t TextureId, vr::RenderModel_TextureMap_t** OutTexture) override
+		{
+			if (bFailTexture || TextureId != Model.RenderModel.diffuseTextureId)
+				return vr::EVRRenderModelError::VRRenderModelError_InvalidTexture;
+
+			if (NumTexturePolls++ < NumLoadingPolls)
+				return vr::EVRRenderModelError::VRRenderModelError_Loading;
+
+			*OutTexture = &Model.Texture;
+			return vr::EVRRenderModelError::VRRenderModelError_None;
+		}
+
+		virtual void FreeRenderModel(vr::RenderModel_t* RenderModel) override
+		{
+			NumModelsFreed++;
+		}
+
+		virtual void FreeTexture(vr::RenderModel_TextureMap_t* Texture) override
+		{
+			NumTexturesFreed++;
+		}
+
+		FTestRenderModel Model;
+
+		// Polls of each buffer answered with VRRenderModelError_Loading before it is returned
+		int32 NumLoadingPolls;
+		bool bFailModel;
+		bool bFailTexture;
+
+		int32 NumModelPolls;
+		int32 NumTexturePolls;
+		int32 NumModelsFreed;
+		int32 NumTexturesFreed;
+	};
+
+	// Records what a load callback received
+	struct FLoadResult
+	{
+		FLoadResult() : NumCalls(0)
+		{}
+
+		void OnLoaded(FOpenVRRenderModelDataPtr InData)
+		{
+			NumCalls++;
+			Data = InData;
+		}
+
+		int32 NumCalls;
+		FOpenVRRenderModelDataPtr Data;
+	};
+
+	// Ticks the cache until the model is no longer loading, the conversion runs on the thread pool
+	static bool TickUntilLoaded(FOpenVRRenderModelCache& Cache, const FString& RenderModelName)
+	{
+		const double TimeoutTime = FPlatformTime::Seconds() + 10.0;
+		while (Cache.IsLoading(RenderModelName) && FPlatformTime::Seconds() < TimeoutTime)
+		{
+			Cache.Tick(0.0f);
+			FPlatformProcess::Sleep(0.001f);
+		}
+		return !Cache.IsLoading(RenderModelName);
+	}
+}
+
+/**
+* Converts the hand built model and checks the OpenVR to UE4 axis swap, the index buffer and the texture copy
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOpenVRRenderModelConvertTest, "OpenVRExpansionPlugin.RenderModelCache.Convert", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FOpenVRRenderModelConvertTest::RunTest(const FString& Parameters)
+{
+	using namespace OpenVRRenderModelTests;
+
+	FTestRenderModel Model;
+	FOpenVRRenderModelData Data;
+	FOpenVRRenderModelConverter::ConvertGeometry(Model.RenderModel.rVertexData, Model.RenderModel.unVertexCount, Model.RenderModel.rIndexData, Model.RenderModel.unTriangleCount, Data);
+	FOpenVRRenderModelConverter::ConvertTexture(Model.Texture.rubTextureMapData, Model.Texture.unWidth, Model.Texture.unHeight, Data);
+
+	if (!TestEqual(TEXT("Vertex count"), Data.Vertices.Num(), 4) || !TestEqual(TEXT("Normal count"), Data.Normals.Num(), 4) || !TestEqual(TEXT("UV count"), Data.UV0.Num(), 4))
+		return false;
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		const vr::RenderModel_Vertex_t& Vertex = Model.Vertices[i];
+
+		// OpenVR -z forward becomes x, x right becomes y and y up becomes z
+		TestEqual(FString::Printf(TEXT("Vertex %d"), i), Data.Vertices[i], FVector(-Vertex.vPosition.v[2], Vertex.vPosition.v[0], Vertex.vPosition.v[1]));
+		TestEqual(FString::Printf(TEXT("Normal %d"), i), Data.Normals[i], FVector(-Vertex.vNormal.v[2], Vertex.vNormal.v[0], Vertex.vNormal.v[1]));
+		TestTrue(FString::Printf(TEXT("UV %d"), i), Data.UV0[i].Equals(FVector2D(Vertex.rfTextureCoord[0], Vertex.rfTextureCoord[1])));
+	}
+
+	// A forward normal ends up on +x, up on +z
+	TestEqual(TEXT("Forward normal"), Data.Normals[0], FVector(1.0f, 0.0f, 0.0f));
+	TestEqual(TEXT("Up normal"), Data.Normals[2], FVector(0.0f, 0.0f, 1.0f));
+
+	if (TestEqual(TEXT("Index count"), Data.Triangles.Num(), (int32)Model.RenderModel.unTriangleCount * 3))
+	{
+		for (int32 i = 0; i < Data.Triangles.Num(); ++i)
+		{
+			TestEqual(FString::Printf(TEXT("Index %d"), i), Data.Triangles[i], (int32)Model.Indices[i]);
+		}
+	}
+
+	TestTrue(TEXT("Has texture"), Data.HasTexture());
+	TestEqual(TEXT("Texture width"), Data.TextureWidth, 2);
+	TestEqual(TEXT("Texture height"), Data.TextureHeight, 2);
+	if (TestEqual(TEXT("Texture size"), Data.TextureData.Num(), (int32)sizeof(Model.TextureData)))
+	{
+		TestTrue(TEXT("Texture copied"), FMemory::Memcmp(Data.TextureData.GetData(), Model.TextureData, sizeof(Model.TextureData)) == 0);
+	}
+
+	// Converting again replaces the previous data instead of appending to it
+	FOpenVRRenderModelConverter::ConvertGeometry(Model.RenderModel.rVertexData, Model.RenderModel.unVertexCount, Model.RenderModel.rIndexData, Model.RenderModel.unTriangleCount, Data);
+	TestEqual(TEXT("Vertex count after converting again"), Data.Vertices.Num(), 4);
+	TestEqual(TEXT("Index count after converting again"), Data.Triangles.Num(), 6);
+
+	return true;
+}
+
+/**
+* Requests the same model twice while it loads, both callbacks must share one load and one converted model
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOpenVRRenderModelSharedLoadTest, "OpenVRExpansionPlugin.RenderModelCache.SharedLoad", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FOpenVRRenderModelSharedLoadTest::RunTest(const FString& Parameters)
+{
+	using namespace OpenVRRenderModelTests;
+
+	TSharedPtr<FTestRenderModelSource> Source = MakeShared<FTestRenderModelSource>();
+	Source->NumLoadingPolls = 2;
+
+	FOpenVRRenderModelCache Cache;
+	Cache.SetRenderModelSource(Source);
+
+	const FString RenderModelName = TEXT("test_controller");
+	FLoadResult FirstResult;
+	FLoadResult SecondResult;
+	Cache.LoadRenderModel(RenderModelName, FOnOpenVRRenderModelLoaded::CreateRaw(&FirstResult, &FLoadResult::OnLoaded));
+	Cache.LoadRenderModel(RenderModelName, FOnOpenVRRenderModelLoaded::CreateRaw(&SecondResult, &FLoadResult::OnLoaded));
+
+	TestTrue(TEXT("Loading"), Cache.IsLoading(RenderModelName));
+	TestEqual(TEXT("The second request doesn't poll"), Source->NumModelPolls, 1);
+	TestEqual(TEXT("No callback while loading"), FirstResult.NumCalls + SecondResult.NumCalls, 0);
+
+	TestTrue(TEXT("Loaded"), TickUntilLoaded(Cache, RenderModelName));
+	TestEqual(TEXT("First callback called once"), FirstResult.NumCalls, 1);
+	TestEqual(TEXT("Second callback called once"), SecondResult.NumCalls, 1);
+	TestTrue(TEXT("Model converted"), FirstResult.Data.IsValid());
+	TestTrue(TEXT("Callbacks share the model"), FirstResult.Data == SecondResult.Data);
+	TestTrue(TEXT("Model cached"), Cache.FindRenderModel(RenderModelName) == FirstResult.Data);
+	TestFalse(TEXT("No failure recorded"), Cache.ConsumeLoadFailure(RenderModelName));
+
+	// One load, so each OpenVR buffer is polled past its loading polls once and freed once
+	TestEqual(TEXT("Model polls"), Source->NumModelPolls, Source->NumLoadingPolls + 1);
+	TestEqual(TEXT("Texture polls"), Source->NumTexturePolls, Source->NumLoadingPolls + 1);
+	TestEqual(TEXT("Model freed"), Source->NumModelsFreed, 1);
+	TestEqual(TEXT("Texture freed"), Source->NumTexturesFreed, 1);
+
+	if (FirstResult.Data.IsValid())
+	{
+		TestEqual(TEXT("Model name"), FirstResult.Data->RenderModelName, RenderModelName);
+		TestEqual(TEXT("Model vertices"), FirstResult.Data->Vertices.Num(), 4);
+		TestTrue(TEXT("Model texture"), FirstResult.Data->HasTexture());
+	}
+
+	// Cached models are handed out right away without touching OpenVR
+	FLoadResult CachedResult;
+	Cache.LoadRenderModel(RenderModelName, FOnOpenVRRenderModelLoaded::CreateRaw(&CachedResult, &FLoadResult::OnLoaded));
+	TestEqual(TEXT("Cached callback called right away"), CachedResult.NumCalls, 1);
+	TestTrue(TEXT("Cached callback shares the model"), CachedResult.Data == FirstResult.Data);
+	TestEqual(TEXT("Cached load doesn't poll"), Source->NumModelPolls, Source->NumLoadingPolls + 1);
+
+	return true;
+}
+
+/**
+* Fails the model and texture loads, the callbacks must receive null and the failure must be reported once and then retried
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOpenVRRenderModelLoadFailureTest, "OpenVRExpansionPlugin.RenderModelCache.LoadFailure", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FOpenVRRenderModelLoadFailureTest::RunTest(const FString& Parameters)
+{
+	using namespace OpenVRRenderModelTests;
+
+	TSharedPtr<FTestRenderModelSource> Source = MakeShared<FTestRenderModelSource>();
+
+	FOpenVRRenderModelCache Cache;
+	Cache.SetRenderModelSource(Source);
+
+	const FString RenderModelName = TEXT("test_controller");
+
+	// A model error fails right away
+	Source->bFailModel = true;
+	FLoadResult ImmediateResult;
+	Cache.LoadRenderModel(RenderModelName, FOnOpenVRRenderModelLoaded::CreateRaw(&ImmediateResult, &FLoadResult::OnLoaded));
+	TestEqual(TEXT("Failed callback called right away"), ImmediateResult.NumCalls, 1);
+	TestFalse(TEXT("Failed callback gets no model"), ImmediateResult.Data.IsValid());
+	TestFalse(TEXT("Not loading after the failure"), Cache.IsLoading(RenderModelName));
+	TestTrue(TEXT("Failure reported"), Cache.ConsumeLoadFailure(RenderModelName));
+	TestFalse(TEXT("Failure reported once"), Cache.ConsumeLoadFailure(RenderModelName));
+
+	// A texture error after the model loaded fails every waiting callback and frees the model
+	Source->bFailModel = false;
+	Source->bFailTexture = true;
+	Source->NumLoadingPolls = 1;
+	FLoadResult FirstResult;
+	FLoadResult SecondResult;
+	Cache.LoadRenderModel(RenderModelName, FOnOpenVRRenderModelLoaded::CreateRaw(&FirstResult, &FLoadResult::OnLoaded));
+	Cache.LoadRenderModel(RenderModelName, FOnOpenVRRenderModelLoaded::CreateRaw(&SecondResult, &FLoadResult::OnLoaded));
+	TestTrue(TEXT("Loading"), Cache.IsLoading(RenderModelName));
+
+	TestTrue(TEXT("Load finished"), TickUntilLoaded(Cache, RenderModelName));
+	TestEqual(TEXT("First callback called once"), FirstResult.NumCalls, 1);
+	TestEqual(TEXT("Second callback called once"), SecondResult.NumCalls, 1);
+	TestFalse(TEXT("First callback gets no model"), FirstResult.Data.IsValid());
+	TestFalse(TEXT("Second callback gets no model"), SecondResult.Data.IsValid());
+	TestFalse(TEXT("Nothing cached"), Cache.FindRenderModel(RenderModelName).IsValid());
+	TestEqual(TEXT("Loaded model freed"), Source->NumModelsFreed, 1);
+	TestEqual(TEXT("No texture to free"), Source->NumTexturesFreed, 0);
+	TestTrue(TEXT("Texture failure reported"), Cache.ConsumeLoadFailure(RenderModelName));
+
+	// Once the failure is consumed a new request loads again
+	Source->bFailTexture = false;
+	FLoadResult RetryResult;
+	Cache.LoadRenderModel(RenderModelName, FOnOpenVRRenderModelLoaded::CreateRaw(&RetryResult, &FLoadResult::OnLoaded));
+	TestTrue(TEXT("Retry loaded"), TickUntilLoaded(Cache, RenderModelName));
+	TestEqual(TEXT("Retry callback called once"), RetryResult.NumCalls, 1);
+	TestTrue(TEXT("Retry gets the model"), RetryResult.Data.IsValid());
+	TestFalse(TEXT("No failure after the retry"), Cache.ConsumeLoadFailure(RenderModelName));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
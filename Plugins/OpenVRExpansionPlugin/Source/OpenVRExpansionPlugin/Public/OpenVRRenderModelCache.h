@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "UObject/GCObject.h"
+#include "Async/Future.h"
+#include "OpenVRExpansionFunctionLibrary.h"
+
+class UTexture2D;
+class UProceduralMeshComponent;
+
+DECLARE_LOG_CATEGORY_EXTERN(OpenVRRenderModelCacheLog, Log, All);
+
+// A render model converted to UE4 conventions, shared by every device using the model
+struct OPENVREXPANSIONPLUGIN_API FOpenVRRenderModelData
+{
+	FOpenVRRenderModelData() : TextureWidth(0), TextureHeight(0)
+	{}
+
+	FString RenderModelName;
+
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector> Normals;
+	TArray<FVector2D> UV0;
+
+	// RGBA8 diffuse texture, empty if the model doesn't have one
+	int32 TextureWidth;
+	int32 TextureHeight;
+	TArray<uint8> TextureData;
+
+	bool HasTexture() const { return TextureData.Num() > 0; }
+};
+
+typedef TSharedPtr<const FOpenVRRenderModelData, ESPMode::ThreadSafe> FOpenVRRenderModelDataPtr;
+
+// Executed on the game thread when a render model load finishes, the data is null if the load failed
+DECLARE_DELEGATE_OneParam(FOnOpenVRRenderModelLoaded, FOpenVRRenderModelDataPtr);
+
+/**
+* Converts OpenVR render model buffers to UE4 mesh and texture data.
+* Only works on the buffers themselves so it can run on any thread and be fed canned data without a headset.
+*/
+struct OPENVREXPANSIONPLUGIN_API FOpenVRRenderModelConverter
+{
+#if STEAMVR_SUPPORTED_PLATFORM
+	// Converts the vertices and indices from OpenVR's y+ up, x+ right, z- forward to UE4's z+ up, y+ right, x+ forward
+	static void ConvertGeometry(const vr::RenderModel_Vertex_t* VertexData, uint32 VertexCount, const uint16* IndexData, uint32 TriangleCount, FOpenVRRenderModelData& OutData);
+
+	// Copies the RGBA8 texture map
+	static void ConvertTexture(const uint8* TextureMapData, uint16 Width, uint16 Height, FOpenVRRenderModelData& OutData);
+#endif
+
+	// Fills the first section of each procedural mesh with the model, OpenVR models are in meters
+	static void FillProceduralMeshes(const FOpenVRRenderModelData& Data, const TArray<UProceduralMeshComponent*>& ProceduralMeshComponentsToFill, bool bCreateCollision, float WorldToMetersScale);
+
+	// Creates a transient texture from the model texture, game thread only
+	static UTexture2D* CreateTexture(const FOpenVRRenderModelData& Data);
+};
+
+#if STEAMVR_SUPPORTED_PLATFORM
+/**
+* The OpenVR render model calls made by the cache, forwarded to SteamVR by default.
+* Can be replaced to feed the cache canned models without a headset.
+*/
+class OPENVREXPANSIONPLUGIN_API IOpenVRRenderModelSource
+{
+public:
+	virtual ~IOpenVRRenderModelSource() {}
+
+	virtual vr::EVRRenderModelError LoadRenderModel_Async(const char* RenderModelName, vr::RenderModel_t** OutRenderModel) = 0;
+	virtual vr::EVRRenderModelError LoadTexture_Async(vr::TextureID_t TextureId, vr::RenderModel_TextureMap_t** OutTexture) = 0;
+	virtual void FreeRenderModel(vr::RenderModel_t* RenderModel) = 0;
+	virtual void FreeTexture(vr::RenderModel_TextureMap_t* Texture) = 0;
+};
+#endif
+
+/**
+* Loads SteamVR render models without blocking the game thread.
+* The OpenVR async loads are polled every frame, the buffers are converted on the thread pool,
+* and the results are cached by render model name so identical devices share the converted data and texture.
+*/
+class OPENVREXPANSIONPLUGIN_API FOpenVRRenderModelCache : public FTickableGameObject, public FGCObject
+{
+public:
+	static FOpenVRRenderModelCache& Get();
+	static void Shutdown();
+
+	virtual ~FOpenVRRenderModelCache();
+
+	// Starts loading a render model if it isn't already cached or loading, OnLoaded is executed right away if it is cached
+	void LoadRenderModel(const FString& RenderModelName, FOnOpenVRRenderModelLoaded OnLoaded);
+
+	// Returns the converted render model, null if it isn't loaded yet
+	FOpenVRRenderModelDataPtr FindRenderModel(const FString& RenderModelName) const;
+
+	bool IsLoading(const FString& RenderModelName) const;
+
+	// Returns whether the last load of the render model failed, and forgets the failure so it can be retried
+	bool ConsumeLoadFailure(const FString& RenderModelName);
+
+	// Returns the texture of a render model, created the first time it is requested and shared afterwards
+	UTexture2D* GetTexture(const FOpenVRRenderModelData& Data);
+
+	// Releases every cached render model and texture
+	void Empty();
+
+#if STEAMVR_SUPPORTED_PLATFORM
+	// Replaces the OpenVR calls, null goes back to SteamVR. Must not be changed while loads are pending
+	void SetRenderModelSource(TSharedPtr<IOpenVRRenderModelSource> NewRenderModelSource);
+#endif
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return PendingLoads.Num() > 0; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	// ~FTickableGameObject
+
+	// FGCObject
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FOpenVRRenderModelCache"); }
+	// ~FGCObject
+
+private:
+	struct FPendingLoad
+	{
+#if STEAMVR_SUPPORTED_PLATFORM
+		vr::RenderModel_t* RenderModel = nullptr;
+		vr::RenderModel_TextureMap_t* Texture = nullptr;
+#endif
+		TFuture<FOpenVRRenderModelDataPtr> Conversion;
+		TArray<FOnOpenVRRenderModelLoaded> Callbacks;
+	};
+
+	// Polls the OpenVR loads and starts the conversion once they are done, returns false if a load failed
+	bool UpdatePendingLoad(const FString& RenderModelName, FPendingLoad& Load);
+
+	// Frees the OpenVR buffers of a load, waiting for its conversion first
+	void ReleasePendingLoad(FPendingLoad& Load);
+
+#if STEAMVR_SUPPORTED_PLATFORM
+	// The replaced OpenVR calls if set, otherwise SteamVR's, null if SteamVR isn't running
+	IOpenVRRenderModelSource* GetRenderModelSource() const;
+
+	TSharedPtr<IOpenVRRenderModelSource> RenderModelSource;
+#endif
+
+	TMap<FString, TUniquePtr<FPendingLoad>> PendingLoads;
+	TMap<FString, FOpenVRRenderModelDataPtr> RenderModels;
+	TMap<FString, UTexture2D*> Textures;
+	TSet<FString> FailedRenderModels;
+
+	static TUniquePtr<FOpenVRRenderModelCache> Instance;
+};
@@ -7,6 +7,8 @@
 #include "Engine/ObjectLibrary.h"
 
 #include "AssetToolsModule.h"
+#include "AssetRegistryModule.h"
+#include "Misc/ScopedSlowTask.h"
 
 #include "Engine/Blueprint.h"
 #include "Engine/TextureRenderTarget.h"
@@ -15,6 +17,8 @@ DEFINE_LOG_CATEGORY(LogProductivityToolsFixNaming);
 
 #define LOCTEXT_NAMESPACE "FProductivityToolsModule"
 
+TMap<FName, FString> FFixNaming::ClassPrefixCache = TMap<FName, FString>();
+
 void FFixNaming::FixNaming(TArray<FAssetData> SelectedAssets, TArray<FString> SelectedPaths)
 {
 	SelectedAssets.Append(FTools::GetAssetsFromPaths(SelectedPaths));
@@ -30,8 +34,27 @@ void FFixNaming::FixNaming(TArray<FAssetData> SelectedAssets)
 {
 	TArray<FAssetRenameData> RenameDatas = TArray<FAssetRenameData>();
 
-	for (FAssetData AssetData : SelectedAssets)
+	// The settings may have changed since the last fix naming
+	ClassPrefixCache.Reset();
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	// Object paths already used in the folders of the selected assets, including the new names given so far
+	TSet<FName> UsedObjectPaths;
+	TSet<FName> ExploredPackagePaths;
+
+	// Assets can be selected directly and through their folder
+	TSet<FName> FixedObjectPaths;
+
+	for (const FAssetData& AssetData : SelectedAssets)
 	{
+		bool bAlreadyFixed = false;
+		FixedObjectPaths.Add(AssetData.ObjectPath, &bAlreadyFixed);
+		if (bAlreadyFixed)
+		{
+			continue;
+		}
+
 		// Retrieve the package path of each selected asset
 		const FString PackagePath = FPackageName::GetLongPackagePath(AssetData.ToSoftObjectPath().GetAssetPathName().ToString());
 		
@@ -40,7 +63,7 @@ void FFixNaming::FixNaming(TArray<FAssetData> SelectedAssets)
 		bool bExistingPrefix = false;
 
 		// Find the corresponding prefix in the project settings to add to the asset name 
-		FString Prefix = GetPrefix(AssetData.GetAsset());
+		FString Prefix = GetPrefix(AssetData);
 		
 		// If a prefix was found in the project settings for this asset class
 		if (Prefix != "")
@@ -105,7 +128,7 @@ void FFixNaming::FixNaming(TArray<FAssetData> SelectedAssets)
 		}
 
 		// Find a suitable suffix if any
-		FString Suffix = GetSuffix(AssetData.GetAsset());
+		FString Suffix = GetSuffix(AssetData);
 
 		// If we did find a suffix
 		if (Suffix != "")
@@ -122,64 +145,111 @@ void FFixNaming::FixNaming(TArray<FAssetData> SelectedAssets)
 		// If a new name has been defined for the asset
 		if (bRename)
 		{
+			// Retrieve the assets already in this folder the first time it is found
+			bool bPackagePathExplored = false;
+			ExploredPackagePaths.Add(AssetData.PackagePath, &bPackagePathExplored);
+			if (!bPackagePathExplored)
+			{
+				TArray<FAssetData> AssetsInPath;
+				AssetRegistry.GetAssetsByPath(AssetData.PackagePath, AssetsInPath);
+				for (const FAssetData& AssetInPath : AssetsInPath)
+				{
+					UsedObjectPaths.Add(AssetInPath.ObjectPath);
+				}
+			}
+
+			// Skip the renaming if another asset already uses this name, the rename would fail anyway
+			const FString NewObjectPath = PackagePath / NewName + "." + NewName;
+			bool bNameUsed = false;
+			UsedObjectPaths.Add(FName(*NewObjectPath), &bNameUsed);
+			if (bNameUsed)
+			{
+				UE_LOG(LogProductivityToolsFixNaming, Warning, TEXT("Cannot rename %s to %s, the name is already used"), *AssetData.AssetName.ToString(), *NewName);
+				continue;
+			}
+
 			// Add this asset to the array of assets to rename
-			FAssetRenameData RenameData = FAssetRenameData(AssetData.GetAsset(), PackagePath, NewName);
+			FAssetRenameData RenameData = FAssetRenameData(AssetData.ToSoftObjectPath(), FSoftObjectPath(NewObjectPath));
 			RenameDatas.Add(RenameData);
 		}
 	}
 
 	// Rename all the assets we changed the name
-	FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
-	AssetToolsModule.Get().RenameAssets(RenameDatas);
+	RenameAssetsInBatches(RenameDatas);
 }
 
-FString FFixNaming::GetPrefix(UObject* Asset)
+void FFixNaming::RenameAssetsInBatches(const TArray<FAssetRenameData>& RenameDatas)
 {
-	FString ClassName = Asset->GetClass()->GetName();
-	FString Prefix;
-	// For each specified prefix in the project settings
-	for (FClassNameToPrefix ClassNameToPrefix : SETTINGS->Prefixes)
+	if (RenameDatas.Num() == 0)
+	{
+		return;
+	}
+
+	FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
+
+	const int32 BatchSize = FMath::Max(SETTINGS->RenameBatchSize, 1);
+
+	// For the progress bar
+	FScopedSlowTask RenameTask(RenameDatas.Num(), LOCTEXT("FixNamingRenameText", "Renaming assets"));
+	RenameTask.MakeDialog(true);
+
+	int32 RenamedAssets = 0;
+	while (RenamedAssets < RenameDatas.Num())
 	{
-		// If we found the correponding class name
-		if (ClassName == ClassNameToPrefix.ClassName)
+		if (RenameTask.ShouldCancel())
 		{
-			// set the prefix to the correponding one
-			Prefix = ClassNameToPrefix.Prefix;
+			UE_LOG(LogProductivityToolsFixNaming, Log, TEXT("Fix naming cancelled after renaming %d of %d assets"), RenamedAssets, RenameDatas.Num());
 			break;
 		}
+
+		const int32 BatchNum = FMath::Min(BatchSize, RenameDatas.Num() - RenamedAssets);
+		RenameTask.EnterProgressFrame(BatchNum, FText::Format(LOCTEXT("FixNamingRenameProgressText", "Renaming assets {0} / {1}"),
+			FText::AsNumber(RenamedAssets + BatchNum), FText::AsNumber(RenameDatas.Num())));
+
+		// Only the assets of this batch are loaded by the rename
+		TArray<FAssetRenameData> Batch(RenameDatas.GetData() + RenamedAssets, BatchNum);
+		AssetToolsModule.Get().RenameAssets(Batch);
+
+		RenamedAssets += BatchNum;
 	}
+}
 
+FString FFixNaming::GetPrefix(const FAssetData& AssetData)
+{
 	// Check if this asset actually need a special prefix (Blueprint Interface, ...)
-	FString PrimarySpecialPrefix = CheckSpecialPrefixes(Asset);
+	FString PrimarySpecialPrefix = CheckSpecialPrefixes(AssetData);
 	
 	// Use the Special Prefix in priority
 	if (PrimarySpecialPrefix != "")
 	{
 		return PrimarySpecialPrefix;
 	}
-	else 
+
+	// The other prefixes only depend on the class
+	if (const FString* CachedPrefix = ClassPrefixCache.Find(AssetData.AssetClass))
 	{
-		// Else use the prefix found before
-		if (Prefix != "")
-		{
-			return Prefix;
-		}
-		else 
-		{
-			// Else use the other Special Prefix if any
-			FString SecondarySpecialPrefix = CheckClassGroupPrefixes(Asset);
-			if (SecondarySpecialPrefix != "")
-			{
-				return SecondarySpecialPrefix;
-			}
-			// If no prefixes were found
-			else
-			{
-				UE_LOG(LogTemp, Warning, TEXT("Class name %s not defined for fix naming"), *ClassName);
-				return "";
-			}
-		}
-	}	
+		return *CachedPrefix;
+	}
+
+	FString ClassName = AssetData.AssetClass.ToString();
+
+	// Use the prefix specified for this class name
+	FString Prefix = GetPrefixByClassName(ClassName);
+
+	// Else use the other Special Prefix if any
+	if (Prefix == "")
+	{
+		Prefix = CheckClassGroupPrefixes(ClassName);
+	}
+
+	// If no prefixes were found
+	if (Prefix == "")
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Class name %s not defined for fix naming"), *ClassName);
+	}
+
+	ClassPrefixCache.Add(AssetData.AssetClass, Prefix);
+	return Prefix;
 }
 
 FString FFixNaming::GetPrefixByClassName(FString ClassName)
@@ -194,15 +264,15 @@ FString FFixNaming::GetPrefixByClassName(FString ClassName)
 	return "";
 }
 
-FString FFixNaming::CheckSpecialPrefixes(UObject* Asset)
+FString FFixNaming::CheckSpecialPrefixes(const FAssetData& AssetData)
 {
-	FString ClassName = Asset->GetClass()->GetName();
 	FString SpecialPrefix = "";
 	// Check special cases for Blueprints
-	if (ClassName == "Blueprint")
+	if (AssetData.AssetClass == UBlueprint::StaticClass()->GetFName())
 	{
-		// if the asset is a Blueprint Interface
-		if (((UBlueprint*)Asset)->BlueprintType == EBlueprintType::BPTYPE_Interface)
+		// if the asset is a Blueprint Interface, the blueprint type is saved in the asset registry
+		FString BlueprintType;
+		if (AssetData.GetTagValue(GET_MEMBER_NAME_CHECKED(UBlueprint, BlueprintType), BlueprintType) && BlueprintType == TEXT("BPTYPE_Interface"))
 		{
 			SpecialPrefix = GetPrefixByClassName("BlueprintInterface");
 		}	
@@ -210,10 +280,8 @@ FString FFixNaming::CheckSpecialPrefixes(UObject* Asset)
 	return SpecialPrefix;
 }
 
-FString FFixNaming::CheckClassGroupPrefixes(UObject* Asset)
+FString FFixNaming::CheckClassGroupPrefixes(FString ClassName)
 {
-	FString ClassName = Asset->GetClass()->GetName();
-
 	// For each specified class group prefix in project settings
 	for (FClassGroupToPrefix ClassGroupToPrefix : SETTINGS->PrefixesGroup)
 	{
@@ -227,20 +295,31 @@ FString FFixNaming::CheckClassGroupPrefixes(UObject* Asset)
 	return "";
 }
 
-FString FFixNaming::GetSuffix(UObject* Asset)
+FString FFixNaming::GetSuffix(const FAssetData& AssetData)
 {
-	FString ClassName = Asset->GetClass()->GetName();
 	FString Suffix = "";
 
 	// Check Suffixes for Textures
-	// Try to cast the Asset to a UTexture
-	UTexture* Texture = Cast<UTexture>(Asset);
+	// Native classes are found without loading the asset
+	UClass* AssetClass = AssetData.GetClass();
 
 	// If the Asset is a Texture
-	if (Texture != NULL)
+	if (AssetClass != NULL && AssetClass->IsChildOf(UTexture::StaticClass()))
 	{
+		// The compression settings are saved in the asset registry, only load the texture if they are missing
+		FString CompressionSettings;
+		bool bNormalmap = false;
+		if (AssetData.GetTagValue(GET_MEMBER_NAME_CHECKED(UTexture, CompressionSettings), CompressionSettings))
+		{
+			bNormalmap = CompressionSettings == TEXT("TC_Normalmap");
+		}
+		else if (UTexture* Texture = Cast<UTexture>(AssetData.GetAsset()))
+		{
+			bNormalmap = Texture->CompressionSettings == TextureCompressionSettings::TC_Normalmap;
+		}
+
 		// If the Asset use Normalmap compression setting
-		if (Texture->CompressionSettings == TextureCompressionSettings::TC_Normalmap)
+		if (bNormalmap)
 		{
 			// It is most likely a Normal texture
 			Suffix = "_N";
@@ -2,9 +2,12 @@
 
 #include "OptimizeTextureSize.h"
 #include "ProductivityToolsSettings.h"
+#include "TextureUsageIndex.h"
 #include "Tools.h"
 
 #include "ScopedTransaction.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopedSlowTask.h"
 
 DEFINE_LOG_CATEGORY(LogProductivityToolsOptimizeTextureSize);
 
@@ -29,78 +32,83 @@ void FOptimizeTextureSize::OptimizeTextureSize(TArray<FAssetData> SelectedAssets
 
 	LODBiasesMap = TMap<UTexture*, int32>();
 
+	// Each selected texture only once
 	TArray<UTexture*> SelectedTextures = TArray<UTexture*>();
+	TArray<FName> SelectedTexturePackages = TArray<FName>();
+	TSet<FName> AddedTexturePackages;
 	for (FAssetData SelectedAsset : SelectedAssets)
 	{
-		SelectedTextures.Add((UTexture*)SelectedAsset.GetAsset());
+		bool bAlreadyAdded = false;
+		AddedTexturePackages.Add(SelectedAsset.PackageName, &bAlreadyAdded);
+
+		UTexture* Texture = Cast<UTexture>(SelectedAsset.GetAsset());
+		if (Texture && !bAlreadyAdded)
+		{
+			SelectedTextures.Add(Texture);
+			SelectedTexturePackages.Add(SelectedAsset.PackageName);
+		}
 	}
 
-	// Retrieve all static meshes in Content folder
-	TArray<FAssetData> StaticMeshesData = FTools::GetAssetsFromPath("/Game", UStaticMesh::StaticClass());
+	// For the progress bar
+	FScopedSlowTask FindMeshesTask(SelectedTextures.Num(), LOCTEXT("FindingMeshesUsingTexturesText", "Finding the meshes using the textures"));
+	FindMeshesTask.MakeDialog();
 
-	for (FAssetData StaticMeshData : StaticMeshesData)
+	// Retrieve the static meshes using each texture from the index instead of loading every mesh in the Content folder
+	TArray<TArray<FTextureMeshUsage>> TextureMeshes = TArray<TArray<FTextureMeshUsage>>();
+	TextureMeshes.SetNum(SelectedTextures.Num());
+	for (int32 Index = 0; Index < SelectedTextures.Num(); Index++)
 	{
-		UStaticMesh* StaticMesh = (UStaticMesh*)(StaticMeshData.GetAsset());
+		FindMeshesTask.EnterProgressFrame();
+		TextureMeshes[Index] = FTextureUsageIndex::GetMeshesUsingTexture(SelectedTexturePackages[Index]);
+	}
+
+	FTextureUsageIndex::Save();
 
-		// Retrieve an approximative size of the mesh
-		FVector MeshSize = StaticMesh->GetBounds().BoxExtent * 2.0f;
+	// The smallest LOD bias found for each texture, INDEX_NONE if no mesh uses it
+	TArray<int32> NewLODBiases = TArray<int32>();
+	NewLODBiases.Init(INDEX_NONE, SelectedTextures.Num());
 
-		// Retrieve all textures used by materials in this mesh
-		TArray<UTexture*> Textures = GetUsedTextures(StaticMesh);
+	ParallelFor(SelectedTextures.Num(), [&SelectedTextures, &TextureMeshes, &NewLODBiases](int32 Index)
+	{
+		UTexture* Texture = SelectedTextures[Index];
+		FIntPoint TextureResolution = FIntPoint((int32)Texture->GetSurfaceWidth(), (int32)Texture->GetSurfaceHeight());
 
-		// Check if the static mesh is not small enough to reduce its texture size
-		if (SETTINGS->bReduceSizeForSmallObjectsOnly
-			&& MeshSize.X > SETTINGS->MaximumSizeForSmallObjects.X  && MeshSize.Y > SETTINGS->MaximumSizeForSmallObjects.Y && MeshSize.Z > SETTINGS->MaximumSizeForSmallObjects.Z)
+		for (const FTextureMeshUsage& MeshUsage : TextureMeshes[Index])
 		{
-			// If the mesh is too large, keep the textures as they are
-			for (UTexture* Texture : Textures)
+			const FVector& MeshSize = MeshUsage.MeshSize;
+
+			// Check if the static mesh is not small enough to reduce its texture size
+			int32 NewLODBias;
+			if (SETTINGS->bReduceSizeForSmallObjectsOnly
+				&& MeshSize.X > SETTINGS->MaximumSizeForSmallObjects.X && MeshSize.Y > SETTINGS->MaximumSizeForSmallObjects.Y && MeshSize.Z > SETTINGS->MaximumSizeForSmallObjects.Z)
 			{
-				if (SelectedTextures.Contains(Texture))
-				{
-					SaveLODBias(Texture, Texture->LODBias);
-				}
+				// If the mesh is too large, keep the texture as it is
+				NewLODBias = Texture->LODBias;
 			}
-					
-			continue;
-		}
-
-		for (UTexture* Texture : Textures) 
-		{
-			if (SelectedTextures.Contains(Texture))
+			else
 			{
-				FIntPoint TextureResolution = FIntPoint((int32)Texture->GetSurfaceWidth(), (int32)Texture->GetSurfaceHeight());
-
-				// Calculate the new LOD bias for each texture
-				int32 NewLODBias = CalculateNewLODBias(MeshSize, TextureResolution);
+				// Calculate the new LOD bias for the texture used by this mesh
+				NewLODBias = CalculateNewLODBias(MeshSize, TextureResolution);
+			}
 
-				// Save the LOD Bias for this texture to compare with other LOD biases found (if the texture is used by several meshes)
-				SaveLODBias(Texture, NewLODBias);
-			}	
+			// If the texture is used by several meshes, keep the smallest LOD bias
+			if (NewLODBiases[Index] == INDEX_NONE || NewLODBias < NewLODBiases[Index])
+			{
+				NewLODBiases[Index] = NewLODBias;
+			}
 		}
-	}
-
-	// Finally update texture assets with their corresponding LOD bias
-	UpdateLODBiases();
-}
-
-TArray<UTexture*> FOptimizeTextureSize::GetUsedTextures(UStaticMesh* StaticMesh)
-{
-	TArray<UTexture*> UsedTextures = TArray<UTexture*>();
+	});
 
-	// For all materials used by this static mesh
-	for (FStaticMaterial StaticMaterial : StaticMesh->StaticMaterials)
+	for (int32 Index = 0; Index < SelectedTextures.Num(); Index++)
 	{
-		TArray<UTexture*> MaterialTextures;
-
-		if (StaticMaterial.MaterialInterface->IsValidLowLevel())
+		if (NewLODBiases[Index] != INDEX_NONE)
 		{
-			// Retrieve all textures used by each material
-			StaticMaterial.MaterialInterface->GetUsedTextures(MaterialTextures, EMaterialQualityLevel::Num, true, ERHIFeatureLevel::Num, true);
+			SaveLODBias(SelectedTextures[Index], NewLODBiases[Index]);
 		}
-		UsedTextures.Append(MaterialTextures);
 	}
 
-	return UsedTextures;
+	// Finally update texture assets with their corresponding LOD bias
+	UpdateLODBiases();
 }
 
 int32 FOptimizeTextureSize::CalculateNewLODBias(FVector MeshSize, FIntPoint TextureResolution)
@@ -22,8 +22,17 @@ TWeakPtr<SGraphEditor> FOrganizeBlueprint::GraphEditor = nullptr;
 
 UEdGraph* FOrganizeBlueprint::CurrentGraph = nullptr;
 
-TArray<FNodeInfos> FOrganizeBlueprint::NodesInfos = TArray<FNodeInfos>();
-TArray<FPinInfos> FOrganizeBlueprint::PinsInfos = TArray<FPinInfos>();
+TIndirectArray<FNodeInfos> FOrganizeBlueprint::NodesInfos = TIndirectArray<FNodeInfos>();
+TIndirectArray<FPinInfos> FOrganizeBlueprint::PinsInfos = TIndirectArray<FPinInfos>();
+
+TMap<UEdGraphNode*, FNodeInfos*> FOrganizeBlueprint::NodeInfosMap = TMap<UEdGraphNode*, FNodeInfos*>();
+TMap<UEdGraphPin*, FPinInfos*> FOrganizeBlueprint::PinInfosMap = TMap<UEdGraphPin*, FPinInfos*>();
+TMap<const UEdGraphNode*, FVector2D> FOrganizeBlueprint::NodeSizes = TMap<const UEdGraphNode*, FVector2D>();
+
+FNodeSpatialGrid FOrganizeBlueprint::NodeGrid = FNodeSpatialGrid();
+
+// Most nodes are a bit smaller than a cell, so a node is usually in 1 to 4 cells
+static const float NodeGridCellSize = 256.f;
 
 TArray<FPinPair> FOrganizeBlueprint::PinPairsStraightened = TArray<FPinPair>();
 
@@ -33,14 +42,23 @@ TArray<UEdGraphNode*> FOrganizeBlueprint::DiscoveredNodes = TArray<UEdGraphNode*
 TMap<UEdGraphPin*, TSharedPtr<SGraphPin>> FOrganizeBlueprint::PinMap = TMap<UEdGraphPin*, TSharedPtr<SGraphPin>>();
 TMap<UEdGraphNode*, TSharedPtr<SGraphNode>> FOrganizeBlueprint::NodeMap = TMap<UEdGraphNode*, TSharedPtr<SGraphNode>>();
 
+TSharedPtr<FCustomNodeFactory> FCustomNodeFactory::Instance = MakeShareable(new FCustomNodeFactory());
+UEdGraphNode* FCustomNodeFactory::LastNode = nullptr;
+
+UEdGraphPin* FCustomPinFactory::LastPin = nullptr;
+
 void FOrganizeBlueprint::OrganizeBlueprint(UBlueprint* Blueprint)
 {
 	// Create a transaction (in order to make it possible to undo/redo the organization)
 	const FScopedTransaction Transaction(LOCTEXT("OrganizeBlueprintAction", "Organize Blueprint"));
 
 	// Empty the saved position and size of nodes and pins
-	NodesInfos = TArray<FNodeInfos>();
-	PinsInfos = TArray<FPinInfos>();
+	NodesInfos.Empty();
+	PinsInfos.Empty();
+	NodeInfosMap.Empty();
+	PinInfosMap.Empty();
+	NodeSizes.Empty();
+	NodeGrid.Reset();
 	PinPairsStraightened = TArray<FPinPair>();
 
 	// Retrieve the blueprint editor for this blueprint
@@ -58,14 +76,15 @@ void FOrganizeBlueprint::OrganizeBlueprint(UBlueprint* Blueprint)
 	// Retrieve all the nodes of the graph to use later
 	GraphNodes = CurrentGraph->Nodes;
 
-	// Prevent NodesInfos and PinsInfos arrays to reallocate memory by providing enough memory (keep enough place for all nodes and pins in the graph)
-	// This way, these arrays won't change addresses and pointers to this array will stay valid even when new elements are added to the array	
-	NodesInfos.Empty(GraphNodes.Num() * 2);
+	// Reserve enough place for all nodes and pins in the graph (new reroute nodes will grow the arrays)
+	NodesInfos.Reserve(GraphNodes.Num());
+	NodeInfosMap.Reserve(GraphNodes.Num());
 	int32 PinCount = 0;
 	for (UEdGraphNode* GraphNode : GraphNodes) {
 		PinCount += GraphNode->Pins.Num();
 	}
-	PinsInfos.Empty(PinCount * 2);
+	PinsInfos.Reserve(PinCount);
+	PinInfosMap.Reserve(PinCount);
 		
 	// Retrieve event nodes and begin function nodes
 	// They will be the start for the node's recursive discovery
@@ -88,6 +107,9 @@ void FOrganizeBlueprint::OrganizeBlueprint(UBlueprint* Blueprint)
 	// Open the graph in editor (the only way I found to retrieve the widget SGraphEditor used to retrieve node sizes)
 	GraphEditor = BlueprintEditor->OpenGraphAndBringToFront(CurrentGraph);
 
+	// Add the nodes to the grid once the graph editor can give their size
+	NodeGrid.Build(GraphNodes, NodeGridCellSize);
+
 	// For each event node and function begin node in the graph
 	for (UEdGraphNode* Node : StartingNodes)
 	{
@@ -124,6 +146,10 @@ void FOrganizeBlueprint::OrganizeBlueprint(UBlueprint* Blueprint)
 		DiscoverNodes(Node, /*bCreateRerouteNodes=*/ false);
 	}
 
+	// The node widgets and the graph editor may not be valid anymore in the next organization
+	NodeSizes.Empty();
+	NodeGrid.Reset();
+
 	FBlueprintEditorUtils::MarkBlueprintAsModified(Blueprint);	
 }
 
@@ -731,14 +757,18 @@ TArray<UEdGraphNode*> FOrganizeBlueprint::GetOverlappingNodes(FNodeInfos* Previo
 	return GetOverlappingNodesWithLine(LineStart, LineEnd, NodesToExclude);
 }
 
-TArray<UEdGraphNode*> FOrganizeBlueprint::GetOverlappingNodesWithLine(FVector LineStart, FVector LineEnd, TArray<UEdGraphNode*> NodesToExclude)
+TArray<UEdGraphNode*> FOrganizeBlueprint::GetOverlappingNodesWithLine(FVector LineStart, FVector LineEnd, const TArray<UEdGraphNode*>& NodesToExclude)
 {
 	TArray<UEdGraphNode*> OverlappingNodes = TArray<UEdGraphNode*>();
 
 	FVector StartToEnd = LineEnd - LineStart;
 
-	// For each node in the graph
-	for (UEdGraphNode* Node : GraphNodes)
+	// Only the nodes in the grid cells crossed by the line can overlap it
+	TArray<UEdGraphNode*> NearbyNodes;
+	NodeGrid.QueryLine(FVector2D(LineStart), FVector2D(LineEnd), NearbyNodes);
+
+	// For each node near the line
+	for (UEdGraphNode* Node : NearbyNodes)
 	{
 		if (UK2Node_Knot* RerouteNode = Cast<UK2Node_Knot>(Node))
 		{
@@ -828,9 +858,18 @@ bool FOrganizeBlueprint::MoveNodes(TArray<UEdGraphNode*>& NodesToMove)
 		}
 
 		FNodeInfos* NodeInfos = RetrieveNodeInfos(Node);
-		
+
+		// Only nodes overlapping this node on the Y axis and overlapping or too close on the X axis can be moved
+		// The grid does not contain comments and returns the nodes in the same order as the graph nodes
+		TArray<UEdGraphNode*> NearbyNodes;
+		NodeGrid.QueryBox(
+			FVector2D(NodeInfos->Pos.X - SETTINGS->NodesMinDistance, NodeInfos->Pos.Y),
+			FVector2D(NodeInfos->PosMax.X + SETTINGS->NodesMinDistance, NodeInfos->PosMax.Y),
+			NearbyNodes
+		);
+
 		// Compare it to each other node
-		for (UEdGraphNode* Node2 : NodesToMove)
+		for (UEdGraphNode* Node2 : NearbyNodes)
 		{
 			if (UEdGraphNode_Comment* CommentNode = Cast<UEdGraphNode_Comment>(Node2))
 			{
@@ -1328,11 +1367,16 @@ void FOrganizeBlueprint::HandleRemoving(FRemoveNodeHelper& RemoveHelper)
 
 FVector2D FOrganizeBlueprint::GetNodeSize(const SGraphEditor& graphEditor, const UEdGraphNode* Node)
 {
+	if (const FVector2D* CachedSize = NodeSizes.Find(Node))
+	{
+		return *CachedSize;
+	}
+
 	FSlateRect Rect;
 	if (graphEditor.GetBoundsForNode(Node, Rect, 0.f))
 	{
 		// Retrieve the size using the graph editor widget
-		return FVector2D(Rect.Right - Rect.Left, Rect.Bottom - Rect.Top);
+		return NodeSizes.Add(Node, FVector2D(Rect.Right - Rect.Left, Rect.Bottom - Rect.Top));
 	}
 	// NodeWidth and NodeHeight are only useful when the node is resizable
 	return FVector2D(Node->NodeWidth, Node->NodeHeight);
@@ -1340,67 +1384,63 @@ FVector2D FOrganizeBlueprint::GetNodeSize(const SGraphEditor& graphEditor, const
 
 FNodeInfos* FOrganizeBlueprint::RetrieveNodeInfos(UEdGraphNode* Node)
 {
-	for (int32 i = 0; i < NodesInfos.Num(); i++)
+	if (FNodeInfos** ExistingNodeInfos = NodeInfosMap.Find(Node))
 	{
-		if (NodesInfos[i].Node == Node)
-		{
-			// if we already created infos for this node, retrieve them
-			NodesInfos[i].UpdatePos();
-			return &NodesInfos[i];
-		}
+		// if we already created infos for this node, retrieve them
+		(*ExistingNodeInfos)->UpdatePos();
+		return *ExistingNodeInfos;
 	}
 	// else, create new infos for this node
-	NodesInfos.Add(FNodeInfos(Node));
-	return &NodesInfos.Last();
+	FNodeInfos* NodeInfos = new FNodeInfos(Node);
+	NodesInfos.Add(NodeInfos);
+	NodeInfosMap.Add(Node, NodeInfos);
+	return NodeInfos;
 }
 
 FNodeInfos* FOrganizeBlueprint::RetrieveNodeInfos(UEdGraphNode* Node, UEdGraphPin* Pin)
 {
-	for (int32 i = 0; i < NodesInfos.Num(); i++)
+	if (FNodeInfos** ExistingNodeInfos = NodeInfosMap.Find(Node))
 	{
-		if (NodesInfos[i].Node == Node)
-		{
-			// if we already created infos for this node, retrieve them
-			NodesInfos[i].UpdatePos();
-			AttachPin(&NodesInfos[i], Pin);
-			return &NodesInfos[i];
-		}
+		// if we already created infos for this node, retrieve them
+		(*ExistingNodeInfos)->UpdatePos();
+		AttachPin(*ExistingNodeInfos, Pin);
+		return *ExistingNodeInfos;
 	}
 	// else, create new infos for this node
-	NodesInfos.Add(FNodeInfos(Node, Pin));
-	return &NodesInfos.Last();
+	FNodeInfos* NodeInfos = new FNodeInfos(Node, Pin);
+	NodesInfos.Add(NodeInfos);
+	NodeInfosMap.Add(Node, NodeInfos);
+	return NodeInfos;
 }
 
 FPinInfos* FOrganizeBlueprint::RetrievePinInfos(UEdGraphPin* Pin)
 {
 	//return RetrievePinInfos(Pin, NodeMap[Pin->GetOwningNode()]);
 
-	for (int32 i = 0; i < PinsInfos.Num(); i++)
+	if (FPinInfos** ExistingPinInfos = PinInfosMap.Find(Pin))
 	{
-		if (PinsInfos[i].Pin == Pin)
-		{
-			// if we already created infos for this pin, retrieve them
-			return &PinsInfos[i];
-		}
+		// if we already created infos for this pin, retrieve them
+		return *ExistingPinInfos;
 	}
 	// else, create new infos for this pin
-	PinsInfos.Add(FPinInfos(Pin));
-	return &PinsInfos.Last();
+	FPinInfos* PinInfos = new FPinInfos(Pin);
+	PinsInfos.Add(PinInfos);
+	PinInfosMap.Add(Pin, PinInfos);
+	return PinInfos;
 }
 
 FPinInfos* FOrganizeBlueprint::RetrievePinInfos(UEdGraphPin* Pin, TSharedPtr<SGraphNode> NodeWidget)
 {
-	for (int32 i = 0; i < PinsInfos.Num(); i++)
+	if (FPinInfos** ExistingPinInfos = PinInfosMap.Find(Pin))
 	{
-		if (PinsInfos[i].Pin == Pin)
-		{
-			// if we already created infos for this node, retrieve them
-			return &PinsInfos[i];
-		}
+		// if we already created infos for this node, retrieve them
+		return *ExistingPinInfos;
 	}
 	// else, create new infos for this pin using specified node widget
-	PinsInfos.Add(FPinInfos(Pin, NodeWidget));
-	return &PinsInfos.Last();
+	FPinInfos* PinInfos = new FPinInfos(Pin, NodeWidget);
+	PinsInfos.Add(PinInfos);
+	PinInfosMap.Add(Pin, PinInfos);
+	return PinInfos;
 }
 
 void FOrganizeBlueprint::AttachPin(FNodeInfos* NodeInfos, UEdGraphPin* Pin)
@@ -1512,7 +1552,9 @@ void FNodeInfos::UpdatePos()
 	Node->NodePosX = Pos.X;
 	Node->NodePosY = Pos.Y;
 	PosMax = FVector2D(Pos.X + Size.X, Pos.Y + Size.Y);
-	
+
+	// Keep the node box in the grid up to date for the overlapping checks
+	FOrganizeBlueprint::NodeGrid.UpdateNode(Node, Pos, PosMax);
 }
 
 
@@ -1562,6 +1604,177 @@ FPinPair::FPinPair(UEdGraphPin* Pin1, UEdGraphPin* Pin2)
 	this->Pin2 = Pin2;
 }
 
+void FNodeSpatialGrid::Build(const TArray<UEdGraphNode*>& Nodes, float InCellSize)
+{
+	Reset();
+	CellSize = InCellSize;
+
+	Entries.Reserve(Nodes.Num());
+	EntryIndices.Reserve(Nodes.Num());
+
+	for (UEdGraphNode* Node : Nodes)
+	{
+		// Comments are never moved nor considered as overlapping, and they would fill a lot of cells
+		if (Node == nullptr || Node->IsA<UEdGraphNode_Comment>())
+		{
+			continue;
+		}
+
+		FVector2D Min = FVector2D(Node->NodePosX, Node->NodePosY);
+		FVector2D Max = Min + FOrganizeBlueprint::GetNodeSize(*FOrganizeBlueprint::GraphEditor.Pin().Get(), Node);
+
+		AddNode(Node, Min, Max);
+	}
+}
+
+void FNodeSpatialGrid::Reset()
+{
+	Entries.Empty();
+	EntryIndices.Empty();
+	Cells.Empty();
+}
+
+void FNodeSpatialGrid::AddNode(UEdGraphNode* Node, const FVector2D& Min, const FVector2D& Max)
+{
+	int32 EntryIndex = Entries.Add({ Node, GetCell(Min), GetCell(Max) });
+	EntryIndices.Add(Node, EntryIndex);
+	AddToCells(EntryIndex);
+}
+
+void FNodeSpatialGrid::UpdateNode(UEdGraphNode* Node, const FVector2D& Min, const FVector2D& Max)
+{
+	const int32* EntryIndex = EntryIndices.Find(Node);
+	if (EntryIndex == nullptr)
+	{
+		return;
+	}
+
+	FGridEntry& Entry = Entries[*EntryIndex];
+	FIntPoint CellMin = GetCell(Min);
+	FIntPoint CellMax = GetCell(Max);
+
+	// Most moves are small and keep the node in the same cells
+	if (CellMin != Entry.CellMin || CellMax != Entry.CellMax)
+	{
+		RemoveFromCells(*EntryIndex);
+		Entry.CellMin = CellMin;
+		Entry.CellMax = CellMax;
+		AddToCells(*EntryIndex);
+	}
+}
+
+void FNodeSpatialGrid::QueryBox(const FVector2D& Min, const FVector2D& Max, TArray<UEdGraphNode*>& OutNodes) const
+{
+	FIntPoint CellMin = GetCell(Min);
+	FIntPoint CellMax = GetCell(Max);
+
+	TArray<int32> FoundEntries;
+	for (int32 CellX = CellMin.X; CellX <= CellMax.X; CellX++)
+	{
+		GatherCells(CellX, CellMin.Y, CellMax.Y, FoundEntries);
+	}
+
+	ResolveEntries(FoundEntries, OutNodes);
+}
+
+void FNodeSpatialGrid::QueryLine(const FVector2D& LineStart, const FVector2D& LineEnd, TArray<UEdGraphNode*>& OutNodes) const
+{
+	const FVector2D& Left = LineStart.X <= LineEnd.X ? LineStart : LineEnd;
+	const FVector2D& Right = LineStart.X <= LineEnd.X ? LineEnd : LineStart;
+
+	int32 MinCellX = GetCell(Left).X;
+	int32 MaxCellX = GetCell(Right).X;
+
+	TArray<int32> FoundEntries;
+	for (int32 CellX = MinCellX; CellX <= MaxCellX; CellX++)
+	{
+		float MinY = FMath::Min(Left.Y, Right.Y);
+		float MaxY = FMath::Max(Left.Y, Right.Y);
+
+		// Only keep the part of the line inside this column of cells
+		if (Right.X > Left.X)
+		{
+			float ColumnMinX = FMath::Max(CellX * CellSize, Left.X);
+			float ColumnMaxX = FMath::Min((CellX + 1) * CellSize, Right.X);
+			float Slope = (Right.Y - Left.Y) / (Right.X - Left.X);
+			float ColumnStartY = Left.Y + (ColumnMinX - Left.X) * Slope;
+			float ColumnEndY = Left.Y + (ColumnMaxX - Left.X) * Slope;
+			MinY = FMath::Min(ColumnStartY, ColumnEndY);
+			MaxY = FMath::Max(ColumnStartY, ColumnEndY);
+		}
+
+		// Add a unit on each side in case of rounding errors at the border of a cell
+		GatherCells(CellX, FMath::FloorToInt((MinY - 1.f) / CellSize), FMath::FloorToInt((MaxY + 1.f) / CellSize), FoundEntries);
+	}
+
+	ResolveEntries(FoundEntries, OutNodes);
+}
+
+FIntPoint FNodeSpatialGrid::GetCell(const FVector2D& Position) const
+{
+	return FIntPoint(FMath::FloorToInt(Position.X / CellSize), FMath::FloorToInt(Position.Y / CellSize));
+}
+
+void FNodeSpatialGrid::AddToCells(int32 EntryIndex)
+{
+	const FGridEntry& Entry = Entries[EntryIndex];
+	for (int32 CellX = Entry.CellMin.X; CellX <= Entry.CellMax.X; CellX++)
+	{
+		for (int32 CellY = Entry.CellMin.Y; CellY <= Entry.CellMax.Y; CellY++)
+		{
+			Cells.FindOrAdd(FIntPoint(CellX, CellY)).Add(EntryIndex);
+		}
+	}
+}
+
+void FNodeSpatialGrid::RemoveFromCells(int32 EntryIndex)
+{
+	const FGridEntry& Entry = Entries[EntryIndex];
+	for (int32 CellX = Entry.CellMin.X; CellX <= Entry.CellMax.X; CellX++)
+	{
+		for (int32 CellY = Entry.CellMin.Y; CellY <= Entry.CellMax.Y; CellY++)
+		{
+			FIntPoint Cell = FIntPoint(CellX, CellY);
+			if (TArray<int32>* CellEntries = Cells.Find(Cell))
+			{
+				CellEntries->RemoveSingleSwap(EntryIndex, /*bAllowShrinking=*/ false);
+				if (CellEntries->Num() == 0)
+				{
+					Cells.Remove(Cell);
+				}
+			}
+		}
+	}
+}
+
+void FNodeSpatialGrid::GatherCells(int32 CellX, int32 MinCellY, int32 MaxCellY, TArray<int32>& OutEntries) const
+{
+	for (int32 CellY = MinCellY; CellY <= MaxCellY; CellY++)
+	{
+		if (const TArray<int32>* CellEntries = Cells.Find(FIntPoint(CellX, CellY)))
+		{
+			OutEntries.Append(*CellEntries);
+		}
+	}
+}
+
+void FNodeSpatialGrid::ResolveEntries(TArray<int32>& FoundEntries, TArray<UEdGraphNode*>& OutNodes) const
+{
+	// Entries are added in the order of the nodes, sorting them keeps the same order as iterating on all the nodes
+	FoundEntries.Sort();
+
+	int32 PreviousEntryIndex = INDEX_NONE;
+	for (int32 EntryIndex : FoundEntries)
+	{
+		// A node in several cells is found once per cell
+		if (EntryIndex != PreviousEntryIndex)
+		{
+			OutNodes.Add(Entries[EntryIndex].Node);
+			PreviousEntryIndex = EntryIndex;
+		}
+	}
+}
+
 FRemoveNodeHelper::FRemoveNodeHelper()
 {
 	this->NodesToRemove = TArray<UEdGraphNode*>();
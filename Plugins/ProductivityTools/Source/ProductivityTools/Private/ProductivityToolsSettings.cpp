@@ -34,6 +34,7 @@ void UProductivityToolsSettings::Reset()
 	// FIX NAMING
 	ExistingPrefixMode = EExistingPrefixMode::LEAVE_UNCHANGED;
 	bEnableSuffixes = false;
+	RenameBatchSize = 50;
 
 	// DEFAULT SUB FOLDERS TO CREATE FOR "CREATE PACKAGE"
 	SubFoldersToCreate = TArray<FString>();
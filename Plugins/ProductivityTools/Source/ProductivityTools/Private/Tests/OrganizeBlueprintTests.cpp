@@ -0,0 +1,242 @@
+// Copyright (c) 2019 Isara Technologies. All Rights Reserved.
+
+#include "OrganizeBlueprint.h"
+
+#include "EdGraph/EdGraph.h"
+#include "EdGraph/EdGraphNode.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace OrganizeBlueprintTests
+{
+	/** A node of the synthetic graph and its box */
+	struct FTestNode
+	{
+		UEdGraphNode* Node;
+		FVector2D Min;
+		FVector2D Max;
+	};
+
+	/**
+	* Lay out nodes in rows and columns like a large event graph, with random sizes and offsets so that boxes cross cell borders
+	*
+	* @param	Graph			The graph owning the nodes
+	* @param	NumColumns		The number of nodes in a row
+	* @param	NumRows			The number of rows
+	* @param	Stream			The random stream used for the sizes and offsets
+	* @param	OutNodes		The created nodes, in graph order
+	*/
+	void BuildSyntheticGraph(UEdGraph* Graph, int32 NumColumns, int32 NumRows, FRandomStream& Stream, TArray<FTestNode>& OutNodes)
+	{
+		for (int32 Row = 0; Row < NumRows; Row++)
+		{
+			for (int32 Column = 0; Column < NumColumns; Column++)
+			{
+				UEdGraphNode* Node = NewObject<UEdGraphNode>(Graph);
+				Node->NodePosX = Column * 400 + Stream.RandRange(-60, 60);
+				Node->NodePosY = Row * 250 + Stream.RandRange(-40, 40);
+				Graph->AddNode(Node, false, false);
+
+				FVector2D Min = FVector2D(Node->NodePosX, Node->NodePosY);
+				FVector2D Size = FVector2D(Stream.FRandRange(120.f, 320.f), Stream.FRandRange(60.f, 200.f));
+				OutNodes.Add({ Node, Min, Min + Size });
+			}
+		}
+	}
+
+	/** The boxes of the specified nodes overlapping the line, tested the same way as FOrganizeBlueprint::GetOverlappingNodesWithLine */
+	void FilterOverlappingLine(const TArray<const FTestNode*>& Candidates, const FVector& LineStart, const FVector& LineEnd, TArray<UEdGraphNode*>& OutNodes)
+	{
+		FVector StartToEnd = LineEnd - LineStart;
+		for (const FTestNode* TestNode : Candidates)
+		{
+			FBox NodeBox = FBox(FVector(TestNode->Min, 0.f), FVector(TestNode->Max, 0.f));
+			if (FMath::LineBoxIntersection(NodeBox, LineStart, LineEnd, StartToEnd))
+			{
+				OutNodes.Add(TestNode->Node);
+			}
+		}
+	}
+}
+
+/**
+* Compare the spatial grid with the scan over every graph node it replaced, on a synthetic graph of 5000 nodes
+* Queries are made the way organizing a graph makes them: a line per wire and a box per moved node
+* Both must find the same nodes in the same order, the timings are reported
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOrganizeBlueprintGridBenchmarkTest, "ProductivityTools.OrganizeBlueprint.GridBenchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FOrganizeBlueprintGridBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace OrganizeBlueprintTests;
+
+	const int32 NumColumns = 100;
+	const int32 NumRows = 50;
+	const int32 NumQueries = 5000;
+	const float NodesMinDistance = 100.f;
+	const float CellSize = 256.f;
+
+	FRandomStream Stream(4242);
+
+	UEdGraph* Graph = NewObject<UEdGraph>(GetTransientPackage());
+	TArray<FTestNode> Nodes;
+	BuildSyntheticGraph(Graph, NumColumns, NumRows, Stream, Nodes);
+
+	TMap<UEdGraphNode*, const FTestNode*> NodesByObject;
+	for (const FTestNode& TestNode : Nodes)
+	{
+		NodesByObject.Add(TestNode.Node, &TestNode);
+	}
+
+	double StartTime = FPlatformTime::Seconds();
+	FNodeSpatialGrid Grid;
+	for (const FTestNode& TestNode : Nodes)
+	{
+		Grid.AddNode(TestNode.Node, TestNode.Min, TestNode.Max);
+	}
+	double BuildTime = FPlatformTime::Seconds() - StartTime;
+
+	// Wires mostly go from a node to one of the following columns, a few rows up or down
+	TArray<TPair<FVector, FVector>> Lines;
+	for (int32 Idx = 0; Idx < NumQueries; Idx++)
+	{
+		const FTestNode& From = Nodes[Stream.RandHelper(Nodes.Num())];
+		FVector LineStart = FVector(From.Max.X, Stream.FRandRange(From.Min.Y, From.Max.Y), 0.f);
+		FVector LineEnd = LineStart + FVector(Stream.FRandRange(100.f, 1600.f), Stream.FRandRange(-750.f, 750.f), 0.f);
+		Lines.Add(TPair<FVector, FVector>(LineStart, LineEnd));
+	}
+
+	TArray<const FTestNode*> AllNodes;
+	for (const FTestNode& TestNode : Nodes)
+	{
+		AllNodes.Add(&TestNode);
+	}
+
+	// Lines, scanning every node
+	TArray<TArray<UEdGraphNode*>> ScanLineResults;
+	ScanLineResults.SetNum(NumQueries);
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < NumQueries; Idx++)
+	{
+		FilterOverlappingLine(AllNodes, Lines[Idx].Key, Lines[Idx].Value, ScanLineResults[Idx]);
+	}
+	double ScanLineTime = FPlatformTime::Seconds() - StartTime;
+
+	// Lines, only testing the nodes in the cells crossed by the line
+	TArray<TArray<UEdGraphNode*>> GridLineResults;
+	GridLineResults.SetNum(NumQueries);
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < NumQueries; Idx++)
+	{
+		TArray<UEdGraphNode*> NearbyNodes;
+		Grid.QueryLine(FVector2D(Lines[Idx].Key), FVector2D(Lines[Idx].Value), NearbyNodes);
+
+		TArray<const FTestNode*> Candidates;
+		Candidates.Reserve(NearbyNodes.Num());
+		for (UEdGraphNode* Node : NearbyNodes)
+		{
+			Candidates.Add(NodesByObject[Node]);
+		}
+		FilterOverlappingLine(Candidates, Lines[Idx].Key, Lines[Idx].Value, GridLineResults[Idx]);
+	}
+	double GridLineTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 NumLineMismatches = 0;
+	for (int32 Idx = 0; Idx < NumQueries; Idx++)
+	{
+		if (ScanLineResults[Idx] != GridLineResults[Idx])
+		{
+			NumLineMismatches++;
+		}
+	}
+	TestEqual(TEXT("Lines overlap the same nodes in the same order"), NumLineMismatches, 0);
+
+	// Boxes around each node expanded by the minimum distance, as when moving nodes apart, scanning every node
+	TArray<TArray<UEdGraphNode*>> ScanBoxResults;
+	ScanBoxResults.SetNum(Nodes.Num());
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < Nodes.Num(); Idx++)
+	{
+		FVector2D Min = FVector2D(Nodes[Idx].Min.X - NodesMinDistance, Nodes[Idx].Min.Y);
+		FVector2D Max = FVector2D(Nodes[Idx].Max.X + NodesMinDistance, Nodes[Idx].Max.Y);
+		for (const FTestNode& Other : Nodes)
+		{
+			if (Other.Max.X >= Min.X && Other.Min.X <= Max.X && Other.Max.Y >= Min.Y && Other.Min.Y <= Max.Y)
+			{
+				ScanBoxResults[Idx].Add(Other.Node);
+			}
+		}
+	}
+	double ScanBoxTime = FPlatformTime::Seconds() - StartTime;
+
+	// Boxes, only testing the nodes in the cells around the box
+	TArray<TArray<UEdGraphNode*>> GridBoxResults;
+	GridBoxResults.SetNum(Nodes.Num());
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < Nodes.Num(); Idx++)
+	{
+		FVector2D Min = FVector2D(Nodes[Idx].Min.X - NodesMinDistance, Nodes[Idx].Min.Y);
+		FVector2D Max = FVector2D(Nodes[Idx].Max.X + NodesMinDistance, Nodes[Idx].Max.Y);
+
+		TArray<UEdGraphNode*> NearbyNodes;
+		Grid.QueryBox(Min, Max, NearbyNodes);
+		for (UEdGraphNode* Node : NearbyNodes)
+		{
+			const FTestNode* Other = NodesByObject[Node];
+			if (Other->Max.X >= Min.X && Other->Min.X <= Max.X && Other->Max.Y >= Min.Y && Other->Min.Y <= Max.Y)
+			{
+				GridBoxResults[Idx].Add(Node);
+			}
+		}
+	}
+	double GridBoxTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 NumBoxMismatches = 0;
+	for (int32 Idx = 0; Idx < Nodes.Num(); Idx++)
+	{
+		if (ScanBoxResults[Idx] != GridBoxResults[Idx])
+		{
+			NumBoxMismatches++;
+		}
+	}
+	TestEqual(TEXT("Boxes overlap the same nodes in the same order"), NumBoxMismatches, 0);
+
+	// Moving every node keeps the grid up to date
+	for (FTestNode& TestNode : Nodes)
+	{
+		FVector2D Offset = FVector2D(Stream.FRandRange(-CellSize, CellSize), Stream.FRandRange(-CellSize, CellSize));
+		TestNode.Min += Offset;
+		TestNode.Max += Offset;
+		Grid.UpdateNode(TestNode.Node, TestNode.Min, TestNode.Max);
+	}
+
+	int32 NumMissingAfterMove = 0;
+	for (const FTestNode& TestNode : Nodes)
+	{
+		TArray<UEdGraphNode*> NearbyNodes;
+		Grid.QueryBox(TestNode.Min, TestNode.Max, NearbyNodes);
+		if (!NearbyNodes.Contains(TestNode.Node))
+		{
+			NumMissingAfterMove++;
+		}
+	}
+	TestEqual(TEXT("Moved nodes are found at their new position"), NumMissingAfterMove, 0);
+
+	AddInfo(FString::Printf(TEXT("%d nodes, grid built in %.2f ms"), Nodes.Num(), BuildTime * 1000.0));
+	AddInfo(FString::Printf(TEXT("%d lines: scan %.2f ms, grid %.2f ms, %.1fx faster"), NumQueries,
+		ScanLineTime * 1000.0, GridLineTime * 1000.0, ScanLineTime / FMath::Max(GridLineTime, SMALL_NUMBER)));
+	AddInfo(FString::Printf(TEXT("%d boxes: scan %.2f ms, grid %.2f ms, %.1fx faster"), Nodes.Num(),
+		ScanBoxTime * 1000.0, GridBoxTime * 1000.0, ScanBoxTime / FMath::Max(GridBoxTime, SMALL_NUMBER)));
+
+	TestTrue(TEXT("Grid line queries are faster than scanning every node"), GridLineTime < ScanLineTime);
+	TestTrue(TEXT("Grid box queries are faster than scanning every node"), GridBoxTime < ScanBoxTime);
+
+	Graph->MarkPendingKill();
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
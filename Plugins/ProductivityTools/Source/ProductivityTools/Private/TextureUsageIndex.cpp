@@ -0,0 +1,221 @@
+// Copyright (c) 2019 Isara Technologies. All Rights Reserved.
+
+#include "TextureUsageIndex.h"
+
+#include "Modules/ModuleManager.h"
+#include "AssetRegistryModule.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/MaterialInterface.h"
+#include "Materials/MaterialFunctionInterface.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY(LogProductivityToolsTextureUsageIndex);
+
+// Increase when the saved format changes to discard older files
+static const int32 TextureUsageIndexVersion = 1;
+
+TMap<FName, FTextureUsageIndex::FTextureUsage> FTextureUsageIndex::Entries = TMap<FName, FTextureUsageIndex::FTextureUsage>();
+bool FTextureUsageIndex::bLoaded = false;
+bool FTextureUsageIndex::bDirty = false;
+
+const TArray<FTextureMeshUsage>& FTextureUsageIndex::GetMeshesUsingTexture(FName TexturePackageName)
+{
+	Load();
+
+	FTextureUsage& Usage = Entries.FindOrAdd(TexturePackageName);
+
+	// Only rebuild the entry if one of the packages it went through changed
+	if (Usage.VisitedPackages.Num() == 0 || Usage.Signature != CalculateSignature(Usage.VisitedPackages))
+	{
+		BuildEntry(TexturePackageName, Usage);
+		bDirty = true;
+	}
+
+	return Usage.Meshes;
+}
+
+void FTextureUsageIndex::BuildEntry(FName TexturePackageName, FTextureUsage& OutUsage)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	OutUsage.VisitedPackages.Reset();
+	OutUsage.Meshes.Reset();
+
+	TSet<FName> VisitedPackages;
+	VisitedPackages.Add(TexturePackageName);
+	OutUsage.VisitedPackages.Add(TexturePackageName);
+
+	// Packages whose referencers still need to be explored
+	TArray<FName> PackagesToExplore;
+	PackagesToExplore.Add(TexturePackageName);
+
+	while (PackagesToExplore.Num() > 0)
+	{
+		TArray<FName> Referencers;
+		AssetRegistry.GetReferencers(PackagesToExplore.Pop(false), Referencers);
+
+		for (FName Referencer : Referencers)
+		{
+			bool bAlreadyVisited = false;
+			VisitedPackages.Add(Referencer, &bAlreadyVisited);
+			if (bAlreadyVisited)
+			{
+				continue;
+			}
+
+			TArray<FAssetData> ReferencerAssets;
+			AssetRegistry.GetAssetsByPackageName(Referencer, ReferencerAssets);
+
+			bool bIsUsingPackage = false;
+			for (const FAssetData& ReferencerAsset : ReferencerAssets)
+			{
+				UClass* ReferencerClass = ReferencerAsset.GetClass();
+				if (ReferencerClass == nullptr)
+				{
+					continue;
+				}
+
+				// Materials can use the texture through material functions and parent materials
+				if (ReferencerClass->IsChildOf(UMaterialInterface::StaticClass()) || ReferencerClass->IsChildOf(UMaterialFunctionInterface::StaticClass()))
+				{
+					PackagesToExplore.Add(Referencer);
+					bIsUsingPackage = true;
+				}
+				// Only the static meshes in the Content folder are used
+				else if (ReferencerClass->IsChildOf(UStaticMesh::StaticClass()) && ReferencerAsset.PackagePath.ToString().StartsWith(TEXT("/Game")))
+				{
+					FTextureMeshUsage MeshUsage;
+					MeshUsage.MeshObjectPath = ReferencerAsset.ObjectPath;
+					MeshUsage.MeshSize = GetMeshSize(ReferencerAsset);
+					OutUsage.Meshes.Add(MeshUsage);
+					bIsUsingPackage = true;
+				}
+			}
+
+			if (bIsUsingPackage)
+			{
+				OutUsage.VisitedPackages.Add(Referencer);
+			}
+		}
+	}
+
+	OutUsage.Signature = CalculateSignature(OutUsage.VisitedPackages);
+}
+
+uint32 FTextureUsageIndex::CalculateSignature(const TArray<FName>& Packages)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	uint32 Signature = 0;
+	for (FName Package : Packages)
+	{
+		// The package guid changes every time the package is saved
+		if (const FAssetPackageData* PackageData = AssetRegistry.GetAssetPackageData(Package))
+		{
+			Signature = HashCombine(Signature, GetTypeHash(PackageData->PackageGuid));
+		}
+		else
+		{
+			// The package was removed
+			Signature = HashCombine(Signature, GetTypeHash(Package));
+		}
+
+		// A new material or mesh using the package is only visible from its referencers
+		TArray<FName> Referencers;
+		AssetRegistry.GetReferencers(Package, Referencers);
+		Referencers.Sort(FNameLexicalLess());
+		for (FName Referencer : Referencers)
+		{
+			Signature = HashCombine(Signature, GetTypeHash(Referencer));
+		}
+	}
+
+	return Signature;
+}
+
+FVector FTextureUsageIndex::GetMeshSize(const FAssetData& MeshData)
+{
+	// The static mesh saves the size of its bounds as "XxYxZ"
+	FString ApproxSize;
+	if (MeshData.GetTagValue(TEXT("ApproxSize"), ApproxSize))
+	{
+		TArray<FString> Dimensions;
+		if (ApproxSize.ParseIntoArray(Dimensions, TEXT("x")) == 3)
+		{
+			return FVector(FCString::Atof(*Dimensions[0]), FCString::Atof(*Dimensions[1]), FCString::Atof(*Dimensions[2]));
+		}
+	}
+
+	// Assets saved before the tag existed have to be loaded
+	UE_LOG(LogProductivityToolsTextureUsageIndex, Verbose, TEXT("Loading %s to retrieve its bounds"), *MeshData.ObjectPath.ToString());
+	if (UStaticMesh* StaticMesh = Cast<UStaticMesh>(MeshData.GetAsset()))
+	{
+		return StaticMesh->GetBounds().BoxExtent * 2.0f;
+	}
+
+	return FVector::ZeroVector;
+}
+
+FString FTextureUsageIndex::GetIndexFilePath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("ProductivityTools") / TEXT("TextureUsageIndex.bin");
+}
+
+void FTextureUsageIndex::Load()
+{
+	if (bLoaded)
+	{
+		return;
+	}
+
+	bLoaded = true;
+
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *GetIndexFilePath(), FILEREAD_Silent))
+	{
+		return;
+	}
+
+	FMemoryReader Reader(Data);
+
+	int32 Version = 0;
+	Reader << Version;
+	if (Version != TextureUsageIndexVersion)
+	{
+		return;
+	}
+
+	Reader << Entries;
+	if (Reader.IsError())
+	{
+		UE_LOG(LogProductivityToolsTextureUsageIndex, Warning, TEXT("Discarding unreadable texture usage index %s"), *GetIndexFilePath());
+		Entries.Empty();
+	}
+}
+
+void FTextureUsageIndex::Save()
+{
+	if (!bDirty)
+	{
+		return;
+	}
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	int32 Version = TextureUsageIndexVersion;
+	Writer << Version;
+	Writer << Entries;
+
+	if (FFileHelper::SaveArrayToFile(Data, *GetIndexFilePath()))
+	{
+		bDirty = false;
+	}
+	else
+	{
+		UE_LOG(LogProductivityToolsTextureUsageIndex, Warning, TEXT("Unable to save the texture usage index to %s"), *GetIndexFilePath());
+	}
+}
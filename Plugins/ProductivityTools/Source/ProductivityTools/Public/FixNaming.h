@@ -7,8 +7,14 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogProductivityToolsFixNaming, Log, All);
 
+struct FAssetRenameData;
+
 class FFixNaming
 {
+private:
+	/** The prefix found for each class name, resolved once per class */
+	static TMap<FName, FString> ClassPrefixCache;
+
 public:
 	/**
 	* Function called by the Fix Naming button
@@ -37,10 +43,11 @@ public:
 
 	/**
 	* Retrieve the correponding prefix in the project settings
+	* Only the asset registry data is used, the asset is not loaded
 	*
-	* @param	Asset		The Asset it will retrieve the prefix for
+	* @param	AssetData		The Asset it will retrieve the prefix for
 	*/
-	static FString GetPrefix(UObject* Asset);
+	static FString GetPrefix(const FAssetData& AssetData);
 
 	/**
 	* Retrieve the correponding prefix in the project settings by class name
@@ -53,9 +60,9 @@ public:
 	* Check for special prefixes to use in priority to other prefixes
 	* Exemple : use prefix for "BlueprintInterface" instead of "Blueprint" even if Blueprint Interfaces are considered "Blueprint" classes
 	*
-	* @param	Asset		The Asset from which checking special prefixes
+	* @param	AssetData		The Asset from which checking special prefixes
 	*/
-	static FString CheckSpecialPrefixes(UObject* Asset);
+	static FString CheckSpecialPrefixes(const FAssetData& AssetData);
 
 	/**
 	* Check for class group prefixes to use if no other prefixes were found
@@ -63,17 +70,25 @@ public:
 	* This way, user can still override these group prefixes by defining more precise prefixes
 	* If an asset belongs to more than one class group, it will take the prefix of the first defined group
 	*
-	* @param	Asset		The Asset from which checking special prefixes
+	* @param	ClassName		The class name from which checking class group prefixes
 	*/
-	static FString CheckClassGroupPrefixes(UObject* Asset);
+	static FString CheckClassGroupPrefixes(FString ClassName);
 
 	/** 
 	* Retrieve the suitable suffix for the asset
+	* The asset is only loaded if the asset registry doesn't contain the needed data
 	* 
-	* @param	Asset		The Asset it will retrieve the suffix for
+	* @param	AssetData		The Asset it will retrieve the suffix for
 	*/
-	static FString GetSuffix(UObject* Asset);
+	static FString GetSuffix(const FAssetData& AssetData);
 
 	static bool IsPrefixSpecified(FString Prefix);
 
+	/**
+	* Rename the assets in batches with a progress bar, the renaming can be cancelled between each batch
+	*
+	* @param	RenameDatas		The assets to rename
+	*/
+	static void RenameAssetsInBatches(const TArray<FAssetRenameData>& RenameDatas);
+
 };
\ No newline at end of file
@@ -33,6 +33,7 @@ public:
 
 	/**
 	* Reduce LOD bias for the needed textures used by static meshes in the content browser
+	* The meshes using each texture come from the texture usage index so only those meshes are examined
 	*
 	* @param	SelectedAssets		The Selected Texture Assets in the content browser
 	*/
@@ -40,15 +41,6 @@ public:
 
 	
 
-	/**
-	* Retrieve the texture assets used by the specified static mesh
-	*
-	* @param	StaticMesh		The static mesh to retrieve the textures from
-	*
-	* @return	An array of textures used by materials in the static mesh
-	*/
-	static TArray<UTexture*> GetUsedTextures(UStaticMesh* StaticMesh);
-
 	/**
 	* Find a corresponding LOD bias using the mesh size and the texture resolution
 	* The return value can be offset in the settings
@@ -95,6 +95,94 @@ public:
 	}
 };
 
+/**
+* Uniform grid of node boxes, used to only test the nodes near a line or a box when looking for overlapping nodes
+* Nodes are identified by their index in the array the grid was built from so that queries return them in the same order as this array
+*/
+class FNodeSpatialGrid
+{
+public:
+	/**
+	* Empty the grid and add the specified nodes at their current position
+	*
+	* @param	Nodes			The nodes to add to the grid
+	* @param	InCellSize		The width and height of a cell
+	*/
+	void Build(const TArray<UEdGraphNode*>& Nodes, float InCellSize);
+
+	/** Remove all nodes from the grid */
+	void Reset();
+
+	/**
+	* Add a node to the grid
+	* Nodes must be added in the order queries should return them
+	*
+	* @param	Node		The node to add
+	* @param	Min			The top left corner of the node
+	* @param	Max			The bottom right corner of the node
+	*/
+	void AddNode(UEdGraphNode* Node, const FVector2D& Min, const FVector2D& Max);
+
+	/**
+	* Move the box of the specified node in the grid
+	* Nodes which were not added when building the grid are ignored
+	*
+	* @param	Node		The node which moved
+	* @param	Min			The top left corner of the node
+	* @param	Max			The bottom right corner of the node
+	*/
+	void UpdateNode(UEdGraphNode* Node, const FVector2D& Min, const FVector2D& Max);
+
+	/**
+	* Retrieve the nodes in the cells overlapped by the specified box
+	* The nodes are not tested against the box itself, only their cells are
+	*
+	* @param	Min				The top left corner of the box
+	* @param	Max				The bottom right corner of the box
+	* @param	OutNodes		The nodes found, in the order of the array the grid was built from
+	*/
+	void QueryBox(const FVector2D& Min, const FVector2D& Max, TArray<UEdGraphNode*>& OutNodes) const;
+
+	/**
+	* Retrieve the nodes in the cells crossed by a straight line between the two specified positions
+	* The nodes are not tested against the line itself, only their cells are
+	*
+	* @param	LineStart		The starting position of the line
+	* @param	LineEnd			The ending position of the line
+	* @param	OutNodes		The nodes found, in the order of the array the grid was built from
+	*/
+	void QueryLine(const FVector2D& LineStart, const FVector2D& LineEnd, TArray<UEdGraphNode*>& OutNodes) const;
+
+private:
+	/** A node in the grid and the cells it is in */
+	struct FGridEntry
+	{
+		UEdGraphNode* Node;
+		FIntPoint CellMin;
+		FIntPoint CellMax;
+	};
+
+	FIntPoint GetCell(const FVector2D& Position) const;
+
+	void AddToCells(int32 EntryIndex);
+	void RemoveFromCells(int32 EntryIndex);
+
+	/** Add the entries of the specified cells to the array, may add the same entry several times */
+	void GatherCells(int32 CellX, int32 MinCellY, int32 MaxCellY, TArray<int32>& OutEntries) const;
+
+	/** Sort the entries, remove duplicates and retrieve their nodes */
+	void ResolveEntries(TArray<int32>& FoundEntries, TArray<UEdGraphNode*>& OutNodes) const;
+
+	float CellSize = 256.f;
+
+	TArray<FGridEntry> Entries;
+
+	TMap<UEdGraphNode*, int32> EntryIndices;
+
+	/** The index of the entries in each cell which is not empty */
+	TMap<FIntPoint, TArray<int32>> Cells;
+};
+
 /** Class for containing nodes to remove and links to make after removing them */
 class FRemoveNodeHelper
 {
@@ -145,6 +233,7 @@ public:
 
 	/**
 	* Retrieve the size of the specified node in the graph
+	* Sizes found from the graph editor are cached until the next organization
 	*
 	* @param	GraphEditor			The graph editor widget in which the node is drawn
 	* @param	Node				The node to retrieve its size
@@ -214,7 +303,7 @@ public:
 	*
 	* @return	An array of nodes overlapping the line
 	*/
-	static TArray<UEdGraphNode*> GetOverlappingNodesWithLine(FVector LineStart, FVector LineEnd, TArray<UEdGraphNode*> NodesToExclude);
+	static TArray<UEdGraphNode*> GetOverlappingNodesWithLine(FVector LineStart, FVector LineEnd, const TArray<UEdGraphNode*>& NodesToExclude);
 	static TArray<UEdGraphNode*> GetOverlappingNodesWithLine(FVector LineStart, FVector LineEnd);
 
 	/**
@@ -351,11 +440,24 @@ public:
 	/** The current graph we are organizing */
 	static UEdGraph* CurrentGraph;
 
-	/** All the node infos currently created during this organization */
-	static TArray<FNodeInfos> NodesInfos;
+	/** All the node infos currently created during this organization
+	* Infos are allocated separately so that pointers to them stay valid when new infos are added */
+	static TIndirectArray<FNodeInfos> NodesInfos;
 
 	/** All the pin infos currently created during this organization */
-	static TArray<FPinInfos> PinsInfos;
+	static TIndirectArray<FPinInfos> PinsInfos;
+
+	/** The infos of each node in NodesInfos */
+	static TMap<UEdGraphNode*, FNodeInfos*> NodeInfosMap;
+
+	/** The infos of each pin in PinsInfos */
+	static TMap<UEdGraphPin*, FPinInfos*> PinInfosMap;
+
+	/** The size of the nodes already retrieved from the graph editor during this organization */
+	static TMap<const UEdGraphNode*, FVector2D> NodeSizes;
+
+	/** The boxes of the graph nodes (except comments), kept up to date when node infos change the position of a node */
+	static FNodeSpatialGrid NodeGrid;
 
 	/** All pin pairs that are connected by a straighten link */
 	static TArray<FPinPair> PinPairsStraightened;
@@ -495,9 +597,6 @@ private:
 	}
 };
 
-TSharedPtr<FCustomNodeFactory> FCustomNodeFactory::Instance = MakeShareable(new FCustomNodeFactory());
-UEdGraphNode* FCustomNodeFactory::LastNode = nullptr;
-
 /** The Class needed to retrieve the pins widgets */
 class FCustomPinFactory : public FGraphPanelPinFactory
 {
@@ -535,5 +634,3 @@ private:
 		return PinWidget;
 	}
 };
-
-UEdGraphPin* FCustomPinFactory::LastPin = nullptr;
\ No newline at end of file
@@ -131,6 +131,10 @@ public:
 	UPROPERTY(config, EditAnywhere, Category = FixNaming)
 	bool bEnableSuffixes;
 
+	/** The number of assets renamed at once when fix naming, the renaming can be cancelled between each batch */
+	UPROPERTY(config, EditAnywhere, Category = FixNaming, meta = (ClampMin = "1"))
+	int32 RenameBatchSize;
+
 	// ORGANIZE BLUEPRINT
 
 	/** The minimum distance between two blueprints nodes after they have been moved during the reorganization */
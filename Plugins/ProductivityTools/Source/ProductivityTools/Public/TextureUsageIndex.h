@@ -0,0 +1,98 @@
+// Copyright (c) 2019 Isara Technologies. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AssetData.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogProductivityToolsTextureUsageIndex, Log, All);
+
+/** A static mesh using a texture and its approximative size */
+struct FTextureMeshUsage
+{
+	FName MeshObjectPath;
+	FVector MeshSize;
+
+	friend FArchive& operator<<(FArchive& Ar, FTextureMeshUsage& Usage)
+	{
+		return Ar << Usage.MeshObjectPath << Usage.MeshSize;
+	}
+};
+
+/**
+* Index of the static meshes using each texture, built from asset registry referencers and the mesh bounds saved in the asset registry tags
+* Meshes are never loaded unless their bounds are missing from the asset registry
+* The index is saved in the project Saved folder and entries are only rebuilt when a package they went through has changed
+*/
+class FTextureUsageIndex
+{
+private:
+	/** Indexed usage of a single texture package */
+	struct FTextureUsage
+	{
+		/** Hash of the package guid and referencers of every package visited when building this entry */
+		uint32 Signature;
+
+		/** The texture, materials and meshes visited when building this entry */
+		TArray<FName> VisitedPackages;
+
+		TArray<FTextureMeshUsage> Meshes;
+
+		friend FArchive& operator<<(FArchive& Ar, FTextureUsage& Usage)
+		{
+			return Ar << Usage.Signature << Usage.VisitedPackages << Usage.Meshes;
+		}
+	};
+
+	static TMap<FName, FTextureUsage> Entries;
+
+	static bool bLoaded;
+	static bool bDirty;
+
+public:
+	/**
+	* Retrieve the static meshes in the Content folder which use the specified texture
+	* The entry of the texture is rebuilt if it is missing or out of date
+	*
+	* @param	TexturePackageName		The package of the texture
+	*
+	* @return	The meshes using the texture and their size
+	*/
+	static const TArray<FTextureMeshUsage>& GetMeshesUsingTexture(FName TexturePackageName);
+
+	/**
+	* Save the index if any entry was rebuilt since it was loaded
+	*/
+	static void Save();
+
+private:
+	/**
+	* Walk the referencers of the texture through materials and material functions up to the static meshes using them
+	*
+	* @param	TexturePackageName		The package of the texture
+	* @param	OutUsage				The entry to fill
+	*/
+	static void BuildEntry(FName TexturePackageName, FTextureUsage& OutUsage);
+
+	/**
+	* Calculate the signature of the specified packages from their package guid and referencers in the asset registry
+	*
+	* @param	Packages		The packages to hash
+	*
+	* @return	A hash which changes when one of the packages is saved or gains or loses a referencer
+	*/
+	static uint32 CalculateSignature(const TArray<FName>& Packages);
+
+	/**
+	* Read the approximative size of a mesh from its asset registry tags, loading the mesh only if the tag is missing
+	*
+	* @param	MeshData	The static mesh asset
+	*
+	* @return	The size of the mesh bounds
+	*/
+	static FVector GetMeshSize(const FAssetData& MeshData);
+
+	static FString GetIndexFilePath();
+
+	static void Load();
+};
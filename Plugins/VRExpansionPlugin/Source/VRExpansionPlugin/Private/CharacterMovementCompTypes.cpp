@@ -61,17 +61,41 @@ bool FSavedMove_VRBaseCharacter::CanCombineWith(const FSavedMovePtr& NewMove, AC
 	if (!ConditionalValues.RequestedVelocity.IsZero() || !nMove->ConditionalValues.RequestedVelocity.IsZero())
 		return false;
 
+	float CombineTolerance = KINDA_SMALL_NUMBER;
+	if (UVRBaseCharacterMovementComponent* MoveComp = Cast<UVRBaseCharacterMovementComponent>(Character->GetCharacterMovement()))
+	{
+		CombineTolerance = FMath::Max(MoveComp->VRMoveCombineTolerance, KINDA_SMALL_NUMBER);
+	}
+
 	// Hate this but we really can't combine if I am sending a new capsule height
-	if (!FMath::IsNearlyEqual(LFDiff.Z, nMove->LFDiff.Z))
+	// Changes smaller than the tolerance are just tracking noise though
+	if (!FMath::IsNearlyEqual(LFDiff.Z, nMove->LFDiff.Z, CombineTolerance))
 		return false;
 
-	if (!FVector2D(LFDiff.X, LFDiff.Y).IsZero() && !FVector2D(nMove->LFDiff.X, nMove->LFDiff.Y).IsZero() && !FVector::Coincident(LFDiff.GetSafeNormal2D(), nMove->LFDiff.GetSafeNormal2D(), AccelDotThresholdCombine))
+	if (!CanCombineVRDeltas(FVector2D(LFDiff), FVector2D(nMove->LFDiff), AccelDotThresholdCombine, CombineTolerance))
 		return false;
 
 	return FSavedMove_Character::CanCombineWith(NewMove, Character, MaxDelta);
 }
 
 
+bool FSavedMove_VRBaseCharacter::CanCombineVRDeltas(const FVector2D& OldDelta, const FVector2D& NewDelta, float DotThreshold, float Tolerance)
+{
+	const float OldSize = OldDelta.Size();
+	const float NewSize = NewDelta.Size();
+
+	// Tiny deltas have no meaningful direction, the sum is within tolerance of either path
+	if (OldSize <= Tolerance || NewSize <= Tolerance)
+		return true;
+
+	if (FVector2D::DotProduct(OldDelta / OldSize, NewDelta / NewSize) >= DotThreshold)
+		return true;
+
+	// Same general direction and the sideways part of the shorter delta is within tolerance
+	// The combined move applies the summed delta in a single step, so this is the most it can deviate from the original path
+	return FVector2D::DotProduct(OldDelta, NewDelta) > 0.0f && FMath::Abs(FVector2D::CrossProduct(OldDelta, NewDelta)) / FMath::Max(OldSize, NewSize) <= Tolerance;
+}
+
 bool FSavedMove_VRBaseCharacter::IsImportantMove(const FSavedMovePtr& LastAckedMove) const
 {
 	// Auto important if toggled climbing
@@ -312,6 +336,44 @@ void FVRCharacterNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Cha
 	}
 }
 
+void FVRCharacterNetworkMoveData::SerializeLFDiff(FArchive& Ar)
+{
+	// X/Y is the per frame HMD movement and Z is the capsule half height (or 0), packing them as a single
+	// NetQuantize100 vector makes the small X/Y values pay for the bit width of the half height.
+	// Send X/Y as a packed 2D delta and the half height as an optional packed int instead (same 1/100th precision).
+	const bool bIsSaving = Ar.IsSaving();
+
+	bool bHasDelta = bIsSaving ? (FMath::RoundToInt(LFDiff.X * 100.0f) != 0 || FMath::RoundToInt(LFDiff.Y * 100.0f) != 0) : false;
+	Ar.SerializeBits(&bHasDelta, 1);
+
+	if (bHasDelta)
+	{
+		FVector Delta = bIsSaving ? FVector(LFDiff.X, LFDiff.Y, 0.0f) : FVector::ZeroVector;
+		SerializePackedVector<100, 30>(Delta, Ar);
+		LFDiff.X = Delta.X;
+		LFDiff.Y = Delta.Y;
+	}
+	else if (!bIsSaving)
+	{
+		LFDiff.X = 0.0f;
+		LFDiff.Y = 0.0f;
+	}
+
+	uint32 HalfHeight = bIsSaving ? (uint32)FMath::Max(FMath::RoundToInt(LFDiff.Z * 100.0f), 0) : 0;
+	bool bHasHalfHeight = HalfHeight != 0;
+	Ar.SerializeBits(&bHasHalfHeight, 1);
+
+	if (bHasHalfHeight)
+	{
+		Ar.SerializeIntPacked(HalfHeight);
+	}
+
+	if (!bIsSaving)
+	{
+		LFDiff.Z = (float)HalfHeight / 100.0f;
+	}
+}
+
 bool FVRCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
 {
 	NetworkMoveType = MoveType;
@@ -412,7 +474,7 @@ bool FVRCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& Charact
 	ConditionalMoveReps.NetSerialize(Ar, PackageMap, bLocalSuccess);
 
 	//VRCapsuleLocation.NetSerialize(Ar, PackageMap, bLocalSuccess);
-	LFDiff.NetSerialize(Ar, PackageMap, bLocalSuccess);
+	SerializeLFDiff(Ar);
 	//Ar << VRCapsuleRotation;
 
 	return !Ar.IsError();
@@ -507,6 +507,10 @@ void UGripMotionControllerComponent::GetLifetimeReplicatedProps(TArray< class FL
 
 void UGripMotionControllerComponent::Server_SendControllerTransform_Implementation(FBPVRComponentPosRep NewTransform)
 {
+	// Resolve delta encoded updates, if their keyframe was lost then drop them like any other lost update
+	if (!ControllerTransformDecoder.Decode(NewTransform))
+		return;
+
 	// Store new transform and trigger OnRep_Function
 	ReplicatedControllerTransform = NewTransform;
 
@@ -3886,13 +3890,16 @@ void UGripMotionControllerComponent::UpdateTracking(float DeltaTime)
 					// Perf difference.
 					if (GetNetMode() == NM_Client/* && !IsTornOff()*/)
 					{
+						FBPVRComponentPosRep SendTransform = ReplicatedControllerTransform;
+						ControllerTransformEncoder.Encode(SendTransform);
+
 						AVRBaseCharacter* OwningChar = Cast<AVRBaseCharacter>(GetOwner());
 						if (OverrideSendTransform != nullptr && OwningChar != nullptr)
 						{
-							(OwningChar->* (OverrideSendTransform))(ReplicatedControllerTransform);
+							(OwningChar->* (OverrideSendTransform))(SendTransform);
 						}
 						else
-							Server_SendControllerTransform(ReplicatedControllerTransform);
+							Server_SendControllerTransform(SendTransform);
 					}
 				}
 			}
@@ -11,6 +11,12 @@ namespace VRPhysicsReplicationStatics
 	static bool bHasVRPhysicsReplication = false;
 }
 
+DECLARE_CYCLE_STAT(TEXT("VRPhysicsReplication Tick"), STAT_VRPhysicsReplicationTick, STATGROUP_VRPhysicsReplication);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("VRPhysicsReplication Buffered Objects"), STAT_VRPhysicsReplicationBuffered, STATGROUP_VRPhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("VRPhysicsReplication Corrections"), STAT_VRPhysicsReplicationCorrections, STATGROUP_VRPhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("VRPhysicsReplication Skipped Corrections"), STAT_VRPhysicsReplicationSkippedCorrections, STATGROUP_VRPhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("VRPhysicsReplication Extrapolated"), STAT_VRPhysicsReplicationExtrapolated, STATGROUP_VRPhysicsReplication);
+
 FPhysicsReplicationVR::FPhysicsReplicationVR(FPhysScene* PhysScene) :
 	FPhysicsReplication(PhysScene)
 {
@@ -36,6 +42,8 @@ bool FPhysicsReplicationVR::IsInitialized()
 
 void FPhysicsReplicationVR::OnTick(float DeltaSeconds, TMap<TWeakObjectPtr<UPrimitiveComponent>, FReplicatedPhysicsTarget>& ComponentsToTargets)
 {
+	float CurrentTimeSeconds = 0.0f;
+
 	// Skip all of the custom logic if we aren't the server
 	if (const UWorld* World = GetOwningWorld())
 	{
@@ -43,32 +51,25 @@ void FPhysicsReplicationVR::OnTick(float DeltaSeconds, TMap<TWeakObjectPtr<UPrim
 		{
 			return FPhysicsReplication::OnTick(DeltaSeconds, ComponentsToTargets);
 		}
+
+		CurrentTimeSeconds = World->GetTimeSeconds();
 	}
 
+	SCOPE_CYCLE_COUNTER(STAT_VRPhysicsReplicationTick);
+
 	const FRigidBodyErrorCorrection& PhysicErrorCorrection = UPhysicsSettings::Get()->PhysicErrorCorrection;
+	const UVRGlobalSettings& VRSettings = *GetDefault<UVRGlobalSettings>();
+	const bool bUseBuffer = VRSettings.bUsePhysicsReplicationBuffer;
 
-	// Get the ping between this PC & the server
-	const float LocalPing = 0.0f;//GetLocalPing();
-
-	/*float CurrentTimeSeconds = 0.0f;
+	// Get the ping between this PC & the server, we are always the server here
+	const float LocalPing = 0.0f;
 
-	if (UWorld* OwningWorld = GetOwningWorld())
-	{
-		CurrentTimeSeconds = OwningWorld->GetTimeSeconds();
-	}*/
+	// States are replayed this far behind their estimated send time
+	const float SampleTime = CurrentTimeSeconds - VRSettings.PhysicsReplicationRenderDelay;
 
 	for (auto Itr = ComponentsToTargets.CreateIterator(); Itr; ++Itr)
 	{
-
-		// Its been more than half a second since the last update, lets cease using the target as a failsafe
-		// Clients will never update with that much latency, and if they somehow are, then they are dropping so many
-		// packets that it will be useless to use their data anyway
-		/*if ((CurrentTimeSeconds - Itr.Value().ArrivedTimeSeconds) > 0.5f)
-		{
-			OnTargetRestored(Itr.Key().Get(), Itr.Value());
-			Itr.RemoveCurrent();
-		}
-		else */if (UPrimitiveComponent* PrimComp = Itr.Key().Get())
+		if (UPrimitiveComponent* PrimComp = Itr.Key().Get())
 		{
 			bool bRemoveItr = false;
 
@@ -76,40 +77,63 @@ void FPhysicsReplicationVR::OnTick(float DeltaSeconds, TMap<TWeakObjectPtr<UPrim
 			{
 				FReplicatedPhysicsTarget& PhysicsTarget = Itr.Value();
 				FRigidBodyState& UpdatedState = PhysicsTarget.TargetState;
-				bool bUpdated = false;
 				if (AActor* OwningActor = PrimComp->GetOwner())
 				{
-					// Removed as this is server sided
-					/*const ENetRole OwnerRole = OwningActor->GetLocalRole();
-					const bool bIsSimulated = OwnerRole == ROLE_SimulatedProxy;
-					const bool bIsReplicatedAutonomous = OwnerRole == ROLE_AutonomousProxy && PrimComp->bReplicatePhysicsToAutonomousProxy;
-					if (bIsSimulated || bIsReplicatedAutonomous)*/
-
-
 					// Deleted everything here, we will always be the server, I already filtered out clients to default logic
 					{
-						/*const*/ float OwnerPing = 0.0f;// GetOwnerPing(OwningActor, PhysicsTarget);
-
-						/*if (UPlayer* OwningPlayer = OwningActor->GetNetOwningPlayer())
-						{
-							if (APlayerController* PlayerController = OwningPlayer->GetPlayerController(nullptr))
-							{
-								if (APlayerState* PlayerState = PlayerController->PlayerState)
-								{
-									OwnerPing = PlayerState->ExactPing;
-								}
-							}
-						}*/
+						const float OwnerPing = GetOwningPlayerPing(OwningActor);
 
 						// Get the total ping - this approximates the time since the update was
 						// actually generated on the machine that is doing the authoritative sim.
 						// NOTE: We divide by 2 to approximate 1-way ping from 2-way ping.
-						const float PingSecondsOneWay = 0.0f;// (LocalPing + OwnerPing) * 0.5f * 0.001f;
-
+						const float PingSecondsOneWay = (LocalPing + OwnerPing) * 0.5f * 0.001f;
 
 						if (UpdatedState.Flags & ERigidBodyFlags::NeedsUpdate)
 						{
-							const bool bRestoredState = ApplyRigidBodyState(DeltaSeconds, BI, PhysicsTarget, PhysicErrorCorrection, PingSecondsOneWay);
+							bool bRestoredState = false;
+
+							if (bUseBuffer)
+							{
+								FVRPhysicsStateBuffer& StateBuffer = StateBuffers.FindOrAdd(Itr.Key());
+
+								if (PhysicsTarget.ArrivedTimeSeconds > StateBuffer.LastArrivedTimeSeconds)
+								{
+									StateBuffer.LastArrivedTimeSeconds = PhysicsTarget.ArrivedTimeSeconds;
+									StateBuffer.AddState(PhysicsTarget.ArrivedTimeSeconds - PingSecondsOneWay, UpdatedState, VRSettings.PhysicsReplicationBufferSize);
+								}
+
+								// Never extrapolate further than the owner could have moved it since sending
+								const float MaxExtrapolation = FMath::Min(VRSettings.PhysicsReplicationMaxExtrapolation, PingSecondsOneWay + VRSettings.PhysicsReplicationRenderDelay);
+
+								FRigidBodyState SampledState;
+								if (StateBuffer.Sample(SampleTime, MaxExtrapolation, SampledState))
+								{
+									INC_DWORD_STAT(STAT_VRPhysicsReplicationExtrapolated);
+								}
+
+								FRigidBodyErrorCorrection ScaledCorrection;
+								if (GetScaledErrorCorrection(BI, SampledState, PhysicErrorCorrection, VRSettings, ScaledCorrection))
+								{
+									INC_DWORD_STAT(STAT_VRPhysicsReplicationCorrections);
+
+									// Already compensated for the ping while sampling, apply the sampled state without extra extrapolation
+									const FRigidBodyState ReceivedState = UpdatedState;
+									UpdatedState = SampledState;
+									bRestoredState = ApplyRigidBodyState(DeltaSeconds, BI, PhysicsTarget, ScaledCorrection, 0.0f);
+									UpdatedState = ReceivedState;
+								}
+								else
+								{
+									INC_DWORD_STAT(STAT_VRPhysicsReplicationSkippedCorrections);
+
+									// Close enough, let go of it if the owner stopped sending updates a while ago
+									bRestoredState = (CurrentTimeSeconds - PhysicsTarget.ArrivedTimeSeconds) > (VRSettings.PhysicsReplicationRenderDelay + VRSettings.PhysicsReplicationMaxExtrapolation + PingSecondsOneWay);
+								}
+							}
+							else
+							{
+								bRestoredState = ApplyRigidBodyState(DeltaSeconds, BI, PhysicsTarget, PhysicErrorCorrection, PingSecondsOneWay);
+							}
 
 							// Need to update the component to match new position.
 							static const auto CVarSkipSkeletalRepOptimization = IConsoleManager::Get().FindConsoleVariable(TEXT("p.SkipSkeletalRepOptimization"));
@@ -130,16 +154,178 @@ void FPhysicsReplicationVR::OnTick(float DeltaSeconds, TMap<TWeakObjectPtr<UPrim
 
 			if (bRemoveItr)
 			{
+				StateBuffers.Remove(Itr.Key());
 				OnTargetRestored(Itr.Key().Get(), Itr.Value());
 				Itr.RemoveCurrent();
 			}
 		}
 	}
 
+	// Drop the history of anything that is no longer being replicated to
+	for (auto BufferItr = StateBuffers.CreateIterator(); BufferItr; ++BufferItr)
+	{
+		if (!BufferItr.Key().IsValid() || !ComponentsToTargets.Contains(BufferItr.Key()))
+		{
+			BufferItr.RemoveCurrent();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_VRPhysicsReplicationBuffered, StateBuffers.Num());
+
 	//GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, TEXT("Phys Rep Tick!"));
 	//FPhysicsReplication::OnTick(DeltaSeconds, ComponentsToTargets);
 }
 
+float FPhysicsReplicationVR::GetOwningPlayerPing(const AActor* OwningActor)
+{
+	if (OwningActor)
+	{
+		if (UPlayer* OwningPlayer = OwningActor->GetNetOwningPlayer())
+		{
+			if (APlayerController* PlayerController = OwningPlayer->GetPlayerController(nullptr))
+			{
+				if (PlayerController->IsLocalController())
+				{
+					return 0.0f;
+				}
+
+				if (APlayerState* PlayerState = PlayerController->PlayerState)
+				{
+					return PlayerState->ExactPing;
+				}
+			}
+		}
+	}
+
+	return 0.0f;
+}
+
+bool FPhysicsReplicationVR::GetScaledErrorCorrection(const FBodyInstance* BI, const FRigidBodyState& TargetState, const FRigidBodyErrorCorrection& BaseCorrection, const UVRGlobalSettings& VRSettings, FRigidBodyErrorCorrection& OutCorrection)
+{
+	FRigidBodyState CurrentState;
+	if (!BI->GetRigidBodyState(CurrentState))
+	{
+		OutCorrection = BaseCorrection;
+		return true;
+	}
+
+	return GetScaledErrorCorrection(CurrentState, TargetState, BaseCorrection, VRSettings, OutCorrection);
+}
+
+bool FPhysicsReplicationVR::GetScaledErrorCorrection(const FRigidBodyState& CurrentState, const FRigidBodyState& TargetState, const FRigidBodyErrorCorrection& BaseCorrection, const UVRGlobalSettings& VRSettings, FRigidBodyErrorCorrection& OutCorrection)
+{
+	OutCorrection = BaseCorrection;
+
+	const float PositionError = FVector::Dist(CurrentState.Position, TargetState.Position);
+	if (PositionError < VRSettings.PhysicsReplicationMinCorrectionError)
+	{
+		// Still correct rotation errors that are large enough to be noticed
+		const float AngleError = FMath::RadiansToDegrees(CurrentState.Quaternion.AngularDistance(TargetState.Quaternion));
+		if (AngleError < VRSettings.PhysicsReplicationMinCorrectionAngle)
+		{
+			return false;
+		}
+	}
+
+	const float Strength = FMath::GetMappedRangeValueClamped(
+		FVector2D(VRSettings.PhysicsReplicationMinCorrectionError, FMath::Max(VRSettings.PhysicsReplicationFullCorrectionError, VRSettings.PhysicsReplicationMinCorrectionError + KINDA_SMALL_NUMBER)),
+		FVector2D(VRSettings.PhysicsReplicationMinCorrectionStrength, 1.0f),
+		PositionError);
+
+	OutCorrection.PositionLerp *= Strength;
+	OutCorrection.AngleLerp *= Strength;
+	OutCorrection.LinearVelocityCoefficient *= Strength;
+	OutCorrection.AngularVelocityCoefficient *= Strength;
+	return true;
+}
+
+void FVRPhysicsStateBuffer::AddState(float Timestamp, const FRigidBodyState& State, int32 MaxStates)
+{
+	// Out of order arrival (clamped ping changes), keep the history sorted
+	int32 InsertIndex = States.Num();
+	while (InsertIndex > 0 && States[InsertIndex - 1].Timestamp > Timestamp)
+	{
+		--InsertIndex;
+	}
+
+	States.Insert({ Timestamp, State }, InsertIndex);
+
+	const int32 NumToRemove = States.Num() - FMath::Max(MaxStates, 2);
+	if (NumToRemove > 0)
+	{
+		States.RemoveAt(0, NumToRemove, false);
+	}
+}
+
+bool FVRPhysicsStateBuffer::Sample(float SampleTime, float MaxExtrapolation, FRigidBodyState& OutState) const
+{
+	if (States.Num() == 0)
+	{
+		return false;
+	}
+
+	const FVRBufferedPhysicsState& Newest = States.Last();
+	if (SampleTime >= Newest.Timestamp)
+	{
+		const float ExtrapolationTime = FMath::Min(SampleTime - Newest.Timestamp, FMath::Max(MaxExtrapolation, 0.0f));
+		ExtrapolateState(Newest.State, ExtrapolationTime, OutState);
+		return ExtrapolationTime > 0.0f;
+	}
+
+	if (SampleTime <= States[0].Timestamp)
+	{
+		OutState = States[0].State;
+		return false;
+	}
+
+	// Newest states are the most likely to be sampled, walk backwards
+	for (int32 i = States.Num() - 1; i > 0; --i)
+	{
+		const FVRBufferedPhysicsState& Older = States[i - 1];
+		if (Older.Timestamp <= SampleTime)
+		{
+			const FVRBufferedPhysicsState& Newer = States[i];
+			const float Span = Newer.Timestamp - Older.Timestamp;
+			const float Alpha = Span > KINDA_SMALL_NUMBER ? (SampleTime - Older.Timestamp) / Span : 1.0f;
+			InterpolateState(Older.State, Newer.State, Alpha, OutState);
+			return false;
+		}
+	}
+
+	OutState = Newest.State;
+	return false;
+}
+
+void FVRPhysicsStateBuffer::InterpolateState(const FRigidBodyState& From, const FRigidBodyState& To, float Alpha, FRigidBodyState& OutState)
+{
+	OutState.Position = FMath::Lerp(From.Position, To.Position, Alpha);
+	OutState.Quaternion = FQuat::Slerp(From.Quaternion, To.Quaternion, Alpha);
+	OutState.LinVel = FMath::Lerp(From.LinVel, To.LinVel, Alpha);
+	OutState.AngVel = FMath::Lerp(From.AngVel, To.AngVel, Alpha);
+	OutState.Flags = To.Flags;
+}
+
+void FVRPhysicsStateBuffer::ExtrapolateState(const FRigidBodyState& From, float Seconds, FRigidBodyState& OutState)
+{
+	OutState = From;
+
+	if (Seconds <= 0.0f || (From.Flags & ERigidBodyFlags::Sleeping) != 0)
+	{
+		return;
+	}
+
+	OutState.Position = From.Position + From.LinVel * Seconds;
+
+	// AngVel is in degrees per second
+	const FVector AngVelRad = FMath::DegreesToRadians(FVector(From.AngVel));
+	const float AngleDelta = AngVelRad.Size() * Seconds;
+	if (AngleDelta > KINDA_SMALL_NUMBER)
+	{
+		OutState.Quaternion = FQuat(AngVelRad.GetUnsafeNormal(), AngleDelta) * From.Quaternion;
+		OutState.Quaternion.Normalize();
+	}
+}
+
 #if PHYSICS_INTERFACE_PHYSX
 void FContactModifyCallbackVR::onContactModify(PxContactModifyPair* const pairs, PxU32 count)
 {
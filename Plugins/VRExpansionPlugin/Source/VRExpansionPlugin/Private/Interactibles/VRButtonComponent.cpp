@@ -1,6 +1,7 @@
 // Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
 
 #include "Interactibles/VRButtonComponent.h"
+#include "Interactibles/VRInteractibleTickSubsystem.h"
 #include "GameFramework/Character.h"
 
   //=============================================================================
@@ -71,12 +72,22 @@ void UVRButtonComponent::BeginPlay()
 	// Call the base class 
 	Super::BeginPlay();
 
+	// Hand our updates over to the batched interactible ticking
+	UVRInteractibleTickSubsystem::RegisterInteractible(this);
+
 	SetButtonToRestingPosition();
 
 	OnComponentBeginOverlap.AddUniqueDynamic(this, &UVRButtonComponent::OnOverlapBegin);
 	OnComponentEndOverlap.AddUniqueDynamic(this, &UVRButtonComponent::OnOverlapEnd);
 }
 
+void UVRButtonComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UVRInteractibleTickSubsystem::UnregisterInteractible(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void UVRButtonComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	// Call supers tick (though I don't think any of the base classes to this actually implement it)
@@ -134,7 +145,7 @@ void UVRButtonComponent::TickComponent(float DeltaTime, enum ELevelTick TickType
 		// Std precision tolerance should be fine
 		if (this->GetRelativeLocation().Equals(GetTargetRelativeLocation()))
 		{
-			this->SetComponentTickEnabled(false);
+			UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 
 			OnButtonEndInteraction.Broadcast(LocalLastInteractingActor.Get(), LocalLastInteractingComponent.Get());
 			ReceiveButtonEndInteraction(LocalLastInteractingActor.Get(), LocalLastInteractingComponent.Get());
@@ -289,7 +300,7 @@ void UVRButtonComponent::OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AAc
 		InitialComponentLoc = OriginalBaseTransform.InverseTransformPosition(this->GetComponentLocation());
 		bToggledThisTouch = false;
 
-		this->SetComponentTickEnabled(true);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, true);
 
 		if (LocalInteractingComponent != LocalLastInteractingComponent.Get())
 		{
@@ -345,7 +356,7 @@ void UVRButtonComponent::SetButtonToRestingPosition(bool bLerpToPosition)
 			this->SetRelativeLocation(InitialRelativeTransform.TransformPosition(SetAxisValue(NewDepth)), false);
 		}
 		else
-			this->SetComponentTickEnabled(true); // This will trigger the lerp to resting position
+			UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, true); // This will trigger the lerp to resting position
 
 	}break;
 	default:break;
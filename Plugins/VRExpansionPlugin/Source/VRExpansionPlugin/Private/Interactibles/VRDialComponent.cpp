@@ -1,6 +1,7 @@
 // Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
 
 #include "Interactibles/VRDialComponent.h"
+#include "Interactibles/VRInteractibleTickSubsystem.h"
 #include "Net/UnrealNetwork.h"
 
   //=============================================================================
@@ -87,11 +88,22 @@ void UVRDialComponent::BeginPlay()
 {
 	// Call the base class 
 	Super::BeginPlay();
+
+	// Hand our updates over to the batched interactible ticking
+	UVRInteractibleTickSubsystem::RegisterInteractible(this);
+
 	CalculateDialProgress();
 
 	bOriginalReplicatesMovement = bReplicateMovement;
 }
 
+void UVRDialComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UVRInteractibleTickSubsystem::UnregisterInteractible(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void UVRDialComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	if (bIsLerping)
@@ -111,7 +123,7 @@ void UVRDialComponent::TickComponent(float DeltaTime, enum ELevelTick TickType,
 
 		if (CurRotBackEnd == 0.f)
 		{
-			this->SetComponentTickEnabled(false);
+			UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 			bIsLerping = false;
 			OnDialFinishedLerping.Broadcast();
 			ReceiveDialFinishedLerping();
@@ -119,7 +131,7 @@ void UVRDialComponent::TickComponent(float DeltaTime, enum ELevelTick TickType,
 	}
 	else
 	{
-		this->SetComponentTickEnabled(false); 
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false); 
 	}
 }
 
@@ -258,10 +270,10 @@ void UVRDialComponent::OnGripRelease_Implementation(UGripMotionControllerCompone
 	if (bLerpBackOnRelease)
 	{
 		bIsLerping = true;
-		this->SetComponentTickEnabled(true);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, true);
 	}
 	else
-		this->SetComponentTickEnabled(false);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 
 	OnDropped.Broadcast(ReleasingController, GripInformation, bWasSocketed);
 }
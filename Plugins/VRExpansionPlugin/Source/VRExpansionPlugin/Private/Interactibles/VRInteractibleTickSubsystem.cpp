@@ -0,0 +1,350 @@
+// Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
+
+#include "Interactibles/VRInteractibleTickSubsystem.h"
+#include "Components/ActorComponent.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "VRGlobalSettings.h"
+
+DECLARE_CYCLE_STAT(TEXT("VRInteractibles TickActive"), STAT_VRInteractiblesTickActive, STATGROUP_VRInteractibles);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("VRInteractibles Registered"), STAT_VRInteractiblesRegistered, STATGROUP_VRInteractibles);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("VRInteractibles Active"), STAT_VRInteractiblesActive, STATGROUP_VRInteractibles);
+
+void FVRInteractibleBatchTickFunction::ExecuteTick(float DeltaTime, enum ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKill() && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Target->TickInteractibles(DeltaTime);
+	}
+}
+
+FString FVRInteractibleBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("VRInteractibleBatchTickFunction");
+}
+
+FName FVRInteractibleBatchTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXT("VRInteractibleBatchTick"));
+}
+
+void UVRInteractibleTickSubsystem::RegisterInteractible(UActorComponent* Interactible)
+{
+	if (!Interactible || !GetDefault<UVRGlobalSettings>()->bUseInteractibleTickSubsystem)
+		return;
+
+	UWorld* World = Interactible->GetWorld();
+	if (!World || !World->IsGameWorld())
+		return;
+
+	if (UVRInteractibleTickSubsystem* TickSubsystem = World->GetSubsystem<UVRInteractibleTickSubsystem>())
+	{
+		TickSubsystem->AddInteractible(Interactible);
+	}
+}
+
+void UVRInteractibleTickSubsystem::UnregisterInteractible(UActorComponent* Interactible)
+{
+	if (!Interactible)
+		return;
+
+	if (UWorld* World = Interactible->GetWorld())
+	{
+		if (UVRInteractibleTickSubsystem* TickSubsystem = World->GetSubsystem<UVRInteractibleTickSubsystem>())
+		{
+			TickSubsystem->RemoveInteractible(Interactible);
+		}
+	}
+}
+
+void UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(UActorComponent* Interactible, bool bEnabled)
+{
+	if (!Interactible)
+		return;
+
+	if (UWorld* World = Interactible->GetWorld())
+	{
+		UVRInteractibleTickSubsystem* TickSubsystem = World->GetSubsystem<UVRInteractibleTickSubsystem>();
+		if (TickSubsystem && TickSubsystem->IsInteractibleRegistered(Interactible))
+		{
+			TickSubsystem->SetInteractibleActive(Interactible, bEnabled);
+			return;
+		}
+	}
+
+	// Not batched, use the components own tick
+	Interactible->SetComponentTickEnabled(bEnabled);
+}
+
+bool UVRInteractibleTickSubsystem::AddInteractible(UActorComponent* Interactible)
+{
+	if (!Interactible || RegisteredInteractibles.Contains(Interactible))
+		return false;
+
+	RegisterBatchTickFunction();
+	RegisteredInteractibles.Add(Interactible, INDEX_NONE);
+
+	// If it was already ticking itself then take over its updates
+	if (Interactible->IsComponentTickEnabled())
+	{
+		Interactible->SetComponentTickEnabled(false);
+		SetInteractibleActive(Interactible, true);
+	}
+
+	UpdateStats();
+	return true;
+}
+
+bool UVRInteractibleTickSubsystem::RemoveInteractible(UActorComponent* Interactible)
+{
+	if (!Interactible || !RegisteredInteractibles.Contains(Interactible))
+		return false;
+
+	SetInteractibleActive(Interactible, false);
+	RegisteredInteractibles.Remove(Interactible);
+
+	UpdateStats();
+	return true;
+}
+
+void UVRInteractibleTickSubsystem::SetInteractibleActive(UActorComponent* Interactible, bool bActive)
+{
+	int32* ActiveIndex = RegisteredInteractibles.Find(Interactible);
+	if (!ActiveIndex)
+		return;
+
+	// Also when it is already active, a second grip adds another controller to its prerequisites
+	bPrerequisitesDirty = true;
+
+	if (bActive)
+	{
+		if (*ActiveIndex == INDEX_NONE)
+		{
+			*ActiveIndex = ActiveInteractibles.Add(Interactible);
+		}
+	}
+	else if (*ActiveIndex != INDEX_NONE)
+	{
+		const int32 RemovedIndex = *ActiveIndex;
+		*ActiveIndex = INDEX_NONE;
+
+		if (bIsTickingInteractibles)
+		{
+			// Can't shift the list while it is being looped, clear the slot and compact after the loop
+			ActiveInteractibles[RemovedIndex] = nullptr;
+			bNeedsCompaction = true;
+		}
+		else
+		{
+			ActiveInteractibles.RemoveAtSwap(RemovedIndex, 1, false);
+
+			// Fix up the index of the entry that was swapped into the removed slot
+			if (ActiveInteractibles.IsValidIndex(RemovedIndex))
+			{
+				if (int32* MovedIndex = RegisteredInteractibles.Find(ActiveInteractibles[RemovedIndex]))
+				{
+					*MovedIndex = RemovedIndex;
+				}
+			}
+		}
+	}
+
+	if (!bIsTickingInteractibles)
+	{
+		UpdateBatchTickFunction();
+	}
+
+	UpdateStats();
+}
+
+bool UVRInteractibleTickSubsystem::IsInteractibleRegistered(const UActorComponent* Interactible) const
+{
+	return RegisteredInteractibles.Contains(const_cast<UActorComponent*>(Interactible));
+}
+
+bool UVRInteractibleTickSubsystem::IsInteractibleActive(const UActorComponent* Interactible) const
+{
+	const int32* ActiveIndex = RegisteredInteractibles.Find(const_cast<UActorComponent*>(Interactible));
+	return ActiveIndex && *ActiveIndex != INDEX_NONE;
+}
+
+int32 UVRInteractibleTickSubsystem::GetNumRegisteredInteractibles() const
+{
+	return RegisteredInteractibles.Num();
+}
+
+int32 UVRInteractibleTickSubsystem::GetNumActiveInteractibles() const
+{
+	int32 NumActive = ActiveInteractibles.Num();
+
+	if (bNeedsCompaction)
+	{
+		for (const UActorComponent* Interactible : ActiveInteractibles)
+		{
+			if (!Interactible)
+				--NumActive;
+		}
+	}
+
+	return NumActive;
+}
+
+void UVRInteractibleTickSubsystem::Deinitialize()
+{
+	if (BatchTickFunction.IsTickFunctionRegistered())
+	{
+		BatchTickFunction.UnRegisterTickFunction();
+	}
+
+	RegisteredInteractibles.Empty();
+	ActiveInteractibles.Empty();
+	BatchPrerequisites.Empty();
+	bNeedsCompaction = false;
+	bPrerequisitesDirty = false;
+	UpdateStats();
+
+	Super::Deinitialize();
+}
+
+void UVRInteractibleTickSubsystem::RegisterBatchTickFunction()
+{
+	if (BatchTickFunction.IsTickFunctionRegistered())
+		return;
+
+	UWorld* World = GetWorld();
+	if (World && World->PersistentLevel)
+	{
+		BatchTickFunction.RegisterTickFunction(World->PersistentLevel);
+	}
+}
+
+void UVRInteractibleTickSubsystem::UpdateBatchTickFunction()
+{
+	if (!BatchTickFunction.IsTickFunctionRegistered())
+		return;
+
+	BatchTickFunction.SetTickFunctionEnable(GetNumActiveInteractibles() > 0);
+
+	if (!bPrerequisitesDirty)
+		return;
+
+	bPrerequisitesDirty = false;
+
+	// Gather the prerequisites of every active interactible, mostly the grip controllers that hold them
+	TArray<FTickPrerequisite> NewPrerequisites;
+	for (UActorComponent* Interactible : ActiveInteractibles)
+	{
+		if (!Interactible)
+			continue;
+
+		for (const FTickPrerequisite& Prerequisite : Interactible->PrimaryComponentTick.GetPrerequisites())
+		{
+			if (Prerequisite.PrerequisiteObject.IsValid() && Prerequisite.PrerequisiteTickFunction)
+			{
+				NewPrerequisites.AddUnique(Prerequisite);
+			}
+		}
+	}
+
+	for (const FTickPrerequisite& Prerequisite : BatchPrerequisites)
+	{
+		if (!NewPrerequisites.Contains(Prerequisite) && Prerequisite.PrerequisiteObject.IsValid())
+		{
+			BatchTickFunction.RemovePrerequisite(Prerequisite.PrerequisiteObject.Get(), *Prerequisite.PrerequisiteTickFunction);
+		}
+	}
+
+	for (const FTickPrerequisite& Prerequisite : NewPrerequisites)
+	{
+		if (!BatchPrerequisites.Contains(Prerequisite))
+		{
+			BatchTickFunction.AddPrerequisite(Prerequisite.PrerequisiteObject.Get(), *Prerequisite.PrerequisiteTickFunction);
+		}
+	}
+
+	BatchPrerequisites = MoveTemp(NewPrerequisites);
+}
+
+void UVRInteractibleTickSubsystem::TickInteractibles(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VRInteractiblesTickActive);
+
+	bIsTickingInteractibles = true;
+
+	// Anything activated during the loop is appended and will update next frame
+	const int32 NumToTick = ActiveInteractibles.Num();
+	for (int32 i = 0; i < NumToTick; ++i)
+	{
+		UActorComponent* Interactible = ActiveInteractibles[i];
+
+		if (!Interactible)
+		{
+			// Either removed during this loop or collected by the GC, in which case its registration is stale
+			bNeedsCompaction = true;
+			continue;
+		}
+
+		if (Interactible->IsPendingKill() || !Interactible->IsRegistered())
+		{
+			// Went away without un-registering
+			RegisteredInteractibles.Remove(Interactible);
+			ActiveInteractibles[i] = nullptr;
+			bNeedsCompaction = true;
+			continue;
+		}
+
+		// Match the per actor time dilation that the component tick would have received
+		float InteractibleDelta = DeltaTime;
+		if (AActor* Owner = Interactible->GetOwner())
+		{
+			InteractibleDelta *= Owner->CustomTimeDilation;
+		}
+
+		Interactible->TickComponent(InteractibleDelta, LEVELTICK_All, &Interactible->PrimaryComponentTick);
+	}
+
+	bIsTickingInteractibles = false;
+
+	if (bNeedsCompaction)
+	{
+		CompactActiveInteractibles();
+	}
+
+	// Interactibles that settled or picked up new controllers during the loop take effect from the next frame
+	UpdateBatchTickFunction();
+}
+
+void UVRInteractibleTickSubsystem::CompactActiveInteractibles()
+{
+	ActiveInteractibles.RemoveAll([](const UActorComponent* Interactible) { return Interactible == nullptr; });
+	PruneRegisteredInteractibles();
+
+	for (int32 i = 0; i < ActiveInteractibles.Num(); ++i)
+	{
+		if (int32* ActiveIndex = RegisteredInteractibles.Find(ActiveInteractibles[i]))
+		{
+			*ActiveIndex = i;
+		}
+	}
+
+	bNeedsCompaction = false;
+	UpdateStats();
+}
+
+void UVRInteractibleTickSubsystem::PruneRegisteredInteractibles()
+{
+	for (auto It = RegisteredInteractibles.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UVRInteractibleTickSubsystem::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_VRInteractiblesRegistered, RegisteredInteractibles.Num());
+	SET_DWORD_STAT(STAT_VRInteractiblesActive, GetNumActiveInteractibles());
+}
@@ -1,6 +1,7 @@
 // Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
 
 #include "Interactibles/VRLeverComponent.h"
+#include "Interactibles/VRInteractibleTickSubsystem.h"
 #include "Net/UnrealNetwork.h"
 
   //=============================================================================
@@ -115,11 +116,22 @@ void UVRLeverComponent::BeginPlay()
 {
 	// Call the base class 
 	Super::BeginPlay();
+
+	// Hand our updates over to the batched interactible ticking
+	UVRInteractibleTickSubsystem::RegisterInteractible(this);
+
 	ReCalculateCurrentAngle();
 
 	bOriginalReplicatesMovement = bReplicateMovement;
 }
 
+void UVRLeverComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UVRInteractibleTickSubsystem::UnregisterInteractible(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void UVRLeverComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	// Call supers tick (though I don't think any of the base classes to this actually implement it)
@@ -163,7 +175,7 @@ void UVRLeverComponent::TickComponent(float DeltaTime, enum ELevelTick TickType,
 
 			if (LerpedQuat.IsIdentity())
 			{
-				this->SetComponentTickEnabled(false);
+				UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 				bIsLerping = false;
 				bReplicateMovement = bOriginalReplicatesMovement;
 				this->SetRelativeRotation(InitialRelativeTransform.Rotator());
@@ -407,7 +419,7 @@ void UVRLeverComponent::OnGrip_Implementation(UGripMotionControllerComponent * G
 	bIsInFirstTick = true;
 	MomentumAtDrop = 0.0f;
 
-	this->SetComponentTickEnabled(true);
+	UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, true);
 
 	OnGripped.Broadcast(GrippingController, GripInformation);
 }
@@ -424,13 +436,13 @@ void UVRLeverComponent::OnGripRelease_Implementation(UGripMotionControllerCompon
 	if (LeverReturnTypeWhenReleased != EVRInteractibleLeverReturnType::Stay)
 	{		
 		bIsLerping = true;
-		this->SetComponentTickEnabled(true);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, true);
 		if (MovementReplicationSetting != EGripMovementReplicationSettings::ForceServerSideMovement)
 			bReplicateMovement = false;
 	}
 	else
 	{
-		this->SetComponentTickEnabled(false);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 		bReplicateMovement = bOriginalReplicatesMovement;
 	}
 
@@ -870,7 +882,7 @@ void UVRLeverComponent::LerpAxis(float CurrentAngle, float DeltaTime)
 		if (FMath::IsNearlyZero(MomentumAtDrop * DeltaTime, 0.1f))
 		{
 			MomentumAtDrop = 0.0f;
-			this->SetComponentTickEnabled(false);
+			UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 			bIsLerping = false;
 			bReplicateMovement = bOriginalReplicatesMovement;
 			return;
@@ -906,7 +918,7 @@ void UVRLeverComponent::LerpAxis(float CurrentAngle, float DeltaTime)
 		}
 		else
 		{
-			this->SetComponentTickEnabled(false);
+			UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 			bIsLerping = false;
 			bReplicateMovement = bOriginalReplicatesMovement;
 			FTransform CalcTransform = (FTransform(UVRInteractibleFunctionLibrary::SetAxisValueRot((EVRInteractibleAxis)LeverRotationAxis, TargetAngle, FRotator::ZeroRotator)) * InitialRelativeTransform);
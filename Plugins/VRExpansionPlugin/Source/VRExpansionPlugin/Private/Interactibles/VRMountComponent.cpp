@@ -1,6 +1,7 @@
 // Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
 
 #include "Interactibles/VRMountComponent.h"
+#include "Interactibles/VRInteractibleTickSubsystem.h"
 #include "Net/UnrealNetwork.h"
 
 //=============================================================================
@@ -77,6 +78,16 @@ void UVRMountComponent::BeginPlay()
 {
 	// Call the base class 
 	Super::BeginPlay();
+
+	// Hand our updates over to the batched interactible ticking
+	UVRInteractibleTickSubsystem::RegisterInteractible(this);
+}
+
+void UVRMountComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UVRInteractibleTickSubsystem::UnregisterInteractible(this);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UVRMountComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
@@ -409,12 +420,12 @@ void UVRMountComponent::OnGrip_Implementation(UGripMotionControllerComponent * G
 		
 
 
-	this->SetComponentTickEnabled(true);
+	UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, true);
 }
 
 void UVRMountComponent::OnGripRelease_Implementation(UGripMotionControllerComponent * ReleasingController, const FBPActorGripInformation & GripInformation, bool bWasSocketed)
 {
-		this->SetComponentTickEnabled(false);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 }
 
 void UVRMountComponent::SetGripPriority(int NewGripPriority)
@@ -1,6 +1,7 @@
 // Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
 
 #include "Interactibles/VRSliderComponent.h"
+#include "Interactibles/VRInteractibleTickSubsystem.h"
 #include "Net/UnrealNetwork.h"
 
   //=============================================================================
@@ -116,11 +117,21 @@ void UVRSliderComponent::BeginPlay()
 	// Call the base class 
 	Super::BeginPlay();
 
+	// Hand our updates over to the batched interactible ticking
+	UVRInteractibleTickSubsystem::RegisterInteractible(this);
+
 	CalculateSliderProgress();
 
 	bOriginalReplicatesMovement = bReplicateMovement;
 }
 
+void UVRSliderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UVRInteractibleTickSubsystem::UnregisterInteractible(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void UVRSliderComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	// Call supers tick (though I don't think any of the base classes to this actually implement it)
@@ -133,7 +144,7 @@ void UVRSliderComponent::TickComponent(float DeltaTime, enum ELevelTick TickType
 		OnSliderFinishedLerping.Broadcast(CurrentSliderProgress);
 		ReceiveSliderFinishedLerping(CurrentSliderProgress);
 
-		this->SetComponentTickEnabled(false);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 		bReplicateMovement = bOriginalReplicatesMovement;
 
 		return;
@@ -190,7 +201,7 @@ void UVRSliderComponent::TickComponent(float DeltaTime, enum ELevelTick TickType
 			OnSliderFinishedLerping.Broadcast(CurrentSliderProgress);
 			ReceiveSliderFinishedLerping(CurrentSliderProgress);
 
-			this->SetComponentTickEnabled(false);
+			UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 			bReplicateMovement = bOriginalReplicatesMovement;
 		}
 		
@@ -410,14 +421,14 @@ void UVRSliderComponent::OnGripRelease_Implementation(UGripMotionControllerCompo
 	if (SliderBehaviorWhenReleased != EVRInteractibleSliderDropBehavior::Stay)
 	{
 		bIsLerping = true;
-		this->SetComponentTickEnabled(true);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, true);
 
 		if(MovementReplicationSetting != EGripMovementReplicationSettings::ForceServerSideMovement)
 			bReplicateMovement = false;
 	}
 	else
 	{
-		this->SetComponentTickEnabled(false);
+		UVRInteractibleTickSubsystem::SetInteractibleTickEnabled(this, false);
 		bReplicateMovement = bOriginalReplicatesMovement;
 	}
 
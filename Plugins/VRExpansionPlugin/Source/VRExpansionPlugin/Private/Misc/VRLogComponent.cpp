@@ -13,6 +13,8 @@ UVRLogComponent::UVRLogComponent(const FObjectInitializer& ObjectInitializer)
 	PrimaryComponentTick.bCanEverTick = false;
 	MaxLineLength = 130;
 	MaxStoredMessages = 10000;
+	MaxCapturedVerbosity = EBPVRLogVerbosity::VRLog_All;
+	LastDrawnScrollPos = INDEX_NONE;
 }
 
 //=============================================================================
@@ -22,6 +24,26 @@ UVRLogComponent::~UVRLogComponent()
 }
 
 
+void UVRLogComponent::SetLogCaptureFilter(EBPVRLogVerbosity NewMaxCapturedVerbosity, const TArray<FName>& NewExcludedCategories)
+{
+	MaxCapturedVerbosity = NewMaxCapturedVerbosity;
+	ExcludedCategories = NewExcludedCategories;
+
+	switch (MaxCapturedVerbosity)
+	{
+	case EBPVRLogVerbosity::VRLog_Error: OutputLogHistory.MaxCapturedVerbosity = ELogVerbosity::Error; break;
+	case EBPVRLogVerbosity::VRLog_Warning: OutputLogHistory.MaxCapturedVerbosity = ELogVerbosity::Warning; break;
+	case EBPVRLogVerbosity::VRLog_Display: OutputLogHistory.MaxCapturedVerbosity = ELogVerbosity::Display; break;
+	case EBPVRLogVerbosity::VRLog_Log: OutputLogHistory.MaxCapturedVerbosity = ELogVerbosity::Log; break;
+	case EBPVRLogVerbosity::VRLog_Verbose: OutputLogHistory.MaxCapturedVerbosity = ELogVerbosity::Verbose; break;
+	case EBPVRLogVerbosity::VRLog_All:
+	default: OutputLogHistory.MaxCapturedVerbosity = ELogVerbosity::All; break;
+	}
+
+	OutputLogHistory.ExcludedCategories.Reset();
+	OutputLogHistory.ExcludedCategories.Append(ExcludedCategories);
+}
+
 void UVRLogComponent::SetConsoleText(FString Text)
 {
 	UConsole* ViewportConsole = (GEngine->GameViewport != nullptr) ? GEngine->GameViewport->ViewportConsole : nullptr;
@@ -66,9 +88,17 @@ void UVRLogComponent::AppendTextToConsole(FString Text, bool bReturnAtEnd)
 
 bool UVRLogComponent::DrawConsoleToRenderTarget2D(EBPVRConsoleDrawType DrawType, UTextureRenderTarget2D * Texture, float ScrollOffset, bool bForceDraw)
 {
-	if (!bForceDraw && DrawType == EBPVRConsoleDrawType::VRConsole_Draw_OutputLogOnly && !OutputLogHistory.bIsDirty)
+	if (DrawType == EBPVRConsoleDrawType::VRConsole_Draw_OutputLogOnly)
 	{
-		return false;
+		// Nothing visible changed since the last draw into this texture, keep what is already in it
+		const int32 ScrollPos = GetOutputLogScrollPos(ScrollOffset);
+		if (!bForceDraw && !OutputLogHistory.bIsDirty && ScrollPos == LastDrawnScrollPos && LastDrawnTexture.Get() == Texture)
+		{
+			return false;
+		}
+
+		LastDrawnScrollPos = ScrollPos;
+		LastDrawnTexture = Texture;
 	}
 	//LastRenderedOutputLogSize 
 
@@ -163,36 +193,199 @@ void UVRLogComponent::DrawOutputLog(bool bUpperHalf, UCanvas* Canvas, float Scro
 
 	FCanvasTextItem ConsoleText(FVector2D(0, 0 + Height - 5 - yl), FText::FromString(TEXT("")), Font, FColor::Emerald);
 
-	const TArray< TSharedPtr<FVRLogMessage> > LoggedMessages = OutputLogHistory.GetMessages();
-	
-	int32 ScrollPos = 0;
+	const int32 ScrollPos = GetOutputLogScrollPos(ScrollOffset);
 
-	if(ScrollOffset > 0 && LoggedMessages.Num() > 1)
-		ScrollPos = FMath::Clamp(FMath::RoundToInt(LoggedMessages.Num() * ScrollOffset ) , 0, LoggedMessages.Num() - 1);
-
-	float Xpos = 0.0f;
+	// Only walk the lines that fit on the texture, text and color were cached when the message was captured
 	float Ypos = 0.0f;
-	for (int i = LoggedMessages.Num() - (1 + ScrollPos); i >= 0 && Ypos <= Height - yl; i--)//auto &Message : LoggedMessages)
+	for (int i = ScrollPos; i < OutputLogHistory.Num() && Ypos <= Height - yl; i++)
 	{
-		switch (LoggedMessages[i]->Verbosity)
-		{
-
-		case ELogVerbosity::Error:
-		case ELogVerbosity::Fatal: ConsoleText.SetColor(FLinearColor(0.7f,0.1f,0.1f)); break;
-		case ELogVerbosity::Warning: ConsoleText.SetColor(FLinearColor(0.5f,0.5f,0.0f)); break;
+		const TSharedPtr<FVRLogMessage>& LoggedMessage = OutputLogHistory.GetMessageFromNewest(i);
 
-		case ELogVerbosity::Log:
-		default: ConsoleText.SetColor(FLinearColor(0.8f,0.8f,0.8f));
-		}
+		ConsoleText.SetColor(LoggedMessage->DisplayColor);
+		ConsoleText.Text = LoggedMessage->DisplayText;
 
 		Ypos += yl;
-		ConsoleText.Text = FText::Format(NSLOCTEXT("VRLogComponent", "ConsoleFormat", "{0}"), FText::FromString(*LoggedMessages[i]->Message));
 		Canvas->DrawItem(ConsoleText, 0, Height - Ypos);
 	}
 
 	OutputLogHistory.bIsDirty = false;
 }
 
+int32 UVRLogComponent::GetOutputLogScrollPos(float ScrollOffset) const
+{
+	const int32 NumMessages = OutputLogHistory.Num();
+
+	if (ScrollOffset > 0 && NumMessages > 1)
+		return FMath::Clamp(FMath::RoundToInt(NumMessages * ScrollOffset), 0, NumMessages - 1);
+
+	return 0;
+}
+
+void FVROutputLogHistory::SetMaxStoredMessages(int32 NewMaxStoredMessages)
+{
+	NewMaxStoredMessages = FMath::Max(NewMaxStoredMessages, 1);
+
+	if (NewMaxStoredMessages == MaxStoredMessages && Messages.Num() == MaxStoredMessages)
+		return;
+
+	// Re-linearize the newest messages into the new buffer
+	const int32 NumToKeep = FMath::Min(NumMessages, NewMaxStoredMessages);
+
+	TArray< TSharedPtr<FVRLogMessage> > NewMessages;
+	NewMessages.SetNum(NewMaxStoredMessages);
+
+	for (int32 i = 0; i < NumToKeep; ++i)
+	{
+		NewMessages[NumToKeep - 1 - i] = GetMessageFromNewest(i);
+	}
+
+	// Dropped messages have to come out of the category counts
+	for (int32 i = NumToKeep; i < NumMessages; ++i)
+	{
+		const FName Category = GetMessageFromNewest(i)->Category;
+		if (int32* Count = CategoryCounts.Find(Category))
+		{
+			if (--(*Count) <= 0)
+			{
+				CategoryCounts.Remove(Category);
+			}
+		}
+	}
+
+	Messages = MoveTemp(NewMessages);
+	MaxStoredMessages = NewMaxStoredMessages;
+	NumMessages = NumToKeep;
+	WriteIndex = NumToKeep % NewMaxStoredMessages;
+	bIsDirty = true;
+}
+
+void FVROutputLogHistory::Empty()
+{
+	for (TSharedPtr<FVRLogMessage>& Message : Messages)
+	{
+		Message.Reset();
+	}
+
+	CategoryCounts.Reset();
+	NumMessages = 0;
+	WriteIndex = 0;
+	bIsDirty = true;
+}
+
+void FVROutputLogHistory::AddMessage(TSharedPtr<FVRLogMessage>&& NewMessage)
+{
+	if (Messages.Num() != MaxStoredMessages)
+	{
+		SetMaxStoredMessages(MaxStoredMessages);
+	}
+
+	TSharedPtr<FVRLogMessage>& Slot = Messages[WriteIndex];
+
+	// Overwriting the oldest message
+	if (NumMessages == Messages.Num() && Slot.IsValid())
+	{
+		if (int32* Count = CategoryCounts.Find(Slot->Category))
+		{
+			if (--(*Count) <= 0)
+			{
+				CategoryCounts.Remove(Slot->Category);
+			}
+		}
+	}
+	else
+	{
+		++NumMessages;
+	}
+
+	CategoryCounts.FindOrAdd(NewMessage->Category)++;
+	Slot = MoveTemp(NewMessage);
+
+	WriteIndex = (WriteIndex + 1) % Messages.Num();
+	++TotalMessagesAdded;
+	bIsDirty = true;
+}
+
+bool FVROutputLogHistory::CreateLogMessages(const TCHAR* V, ELogVerbosity::Type Verbosity, const class FName& Category)
+{
+	if (Verbosity == ELogVerbosity::SetColor)
+	{
+		// Skip Color Events
+		return false;
+	}
+
+	// Filter before doing any of the string work
+	if ((Verbosity & ELogVerbosity::VerbosityMask) > MaxCapturedVerbosity || ExcludedCategories.Contains(Category))
+	{
+		return false;
+	}
+
+	FName Style;
+	if (Category == NAME_Cmd)
+	{
+		Style = FName(TEXT("Log.Command"));
+	}
+	else if (Verbosity == ELogVerbosity::Error)
+	{
+		Style = FName(TEXT("Log.Error"));
+	}
+	else if (Verbosity == ELogVerbosity::Warning)
+	{
+		Style = FName(TEXT("Log.Warning"));
+	}
+	else
+	{
+		Style = FName(TEXT("Log.Normal"));
+	}
+
+	// Forget timestamps, I don't care about them and we have limited texture space to draw too
+	static ELogTimes::Type LogTimestampMode = ELogTimes::None;
+
+	const uint64 OldTotalMessages = TotalMessagesAdded;
+
+	// handle multiline strings by breaking them apart by line
+	TArray<FTextRange> LineRanges;
+	FString CurrentLogDump = V;
+	FTextRange::CalculateLineRangesFromString(CurrentLogDump, LineRanges);
+
+	bool bIsFirstLineInMessage = true;
+	for (const FTextRange& LineRange : LineRanges)
+	{
+		if (!LineRange.IsEmpty())
+		{
+			FString Line = CurrentLogDump.Mid(LineRange.BeginIndex, LineRange.Len());
+			Line = Line.ConvertTabsToSpaces(4);
+
+			// Hard-wrap lines to avoid them being too long, each wrapped line is stored (and cached) as its own entry
+			int32 HardWrapLen = MaxLineLength;
+			for (int32 CurrentStartIndex = 0; CurrentStartIndex < Line.Len();)
+			{
+				int32 HardWrapLineLen = 0;
+				if (bIsFirstLineInMessage)
+				{
+					FString MessagePrefix = FOutputDeviceHelper::FormatLogLine(Verbosity, Category, nullptr, LogTimestampMode);
+
+					HardWrapLineLen = FMath::Min(HardWrapLen - MessagePrefix.Len(), Line.Len() - CurrentStartIndex);
+					FString HardWrapLine = Line.Mid(CurrentStartIndex, HardWrapLineLen);
+
+					AddMessage(MakeShareable(new FVRLogMessage(MakeShareable(new FString(MessagePrefix + HardWrapLine)), Verbosity, Category, Style)));
+				}
+				else
+				{
+					HardWrapLineLen = FMath::Min(HardWrapLen, Line.Len() - CurrentStartIndex);
+					FString HardWrapLine = Line.Mid(CurrentStartIndex, HardWrapLineLen);
+
+					AddMessage(MakeShareable(new FVRLogMessage(MakeShareable(new FString(MoveTemp(HardWrapLine))), Verbosity, Category, Style)));
+				}
+
+				bIsFirstLineInMessage = false;
+				CurrentStartIndex += HardWrapLineLen;
+			}
+		}
+	}
+
+	return OldTotalMessages != TotalMessagesAdded;
+}
+
 
 
 #undef LOCTEXT_NAMESPACE 
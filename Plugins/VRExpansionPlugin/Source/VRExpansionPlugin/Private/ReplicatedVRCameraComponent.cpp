@@ -76,6 +76,10 @@ void UReplicatedVRCameraComponent::GetLifetimeReplicatedProps(TArray< class FLif
 
 void UReplicatedVRCameraComponent::Server_SendCameraTransform_Implementation(FBPVRComponentPosRep NewTransform)
 {
+	// Resolve delta encoded updates, if their keyframe was lost then drop them like any other lost update
+	if (!CameraTransformDecoder.Decode(NewTransform))
+		return;
+
 	// Store new transform and trigger OnRep_Function
 	ReplicatedCameraTransform = NewTransform;
 
@@ -221,16 +225,19 @@ void UReplicatedVRCameraComponent::TickComponent(float DeltaTime, enum ELevelTic
 
 					if (GetNetMode() == NM_Client)
 					{
+						FBPVRComponentPosRep SendTransform = ReplicatedCameraTransform;
+						CameraTransformEncoder.Encode(SendTransform);
+
 						AVRBaseCharacter* OwningChar = Cast<AVRBaseCharacter>(GetOwner());
 						if (OverrideSendTransform != nullptr && OwningChar != nullptr)
 						{
-							(OwningChar->* (OverrideSendTransform))(ReplicatedCameraTransform);
+							(OwningChar->* (OverrideSendTransform))(SendTransform);
 						}
 						else
 						{
 							// Don't bother with any of this if not replicating transform
 							//if (bHasAuthority && bReplicateTransform)
-							Server_SendCameraTransform(ReplicatedCameraTransform);
+							Server_SendCameraTransform(SendTransform);
 						}
 					}
 				}
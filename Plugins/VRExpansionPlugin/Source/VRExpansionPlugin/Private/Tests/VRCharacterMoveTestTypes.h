@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "VRCharacter.h"
+#include "VRCharacterMovementComponent.h"
+#include "VRCharacterMoveTestTypes.generated.h"
+
+// Records the moves ReplicateMoveToServer sends instead of calling the ServerMove RPC, so the client send path can run without a connection
+UCLASS(Transient, NotBlueprintable, NotBlueprintType)
+class UVRCharacterMoveTestMovementComponent : public UVRCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UVRCharacterMoveTestMovementComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	virtual void CallServerMovePacked(const FSavedMove_Character* NewMove, const FSavedMove_Character* PendingMove, const FSavedMove_Character* OldMove) override;
+
+	// Clears the recorded moves
+	void ResetSentMoves();
+
+	int32 NumRPCs;
+	int32 NumMovesSent;
+
+	// Pending moves sent along with a new move, and old moves resent because they were important
+	int32 NumPendingMoves;
+	int32 NumOldMoves;
+
+	// Bits of the packed move data sent
+	int64 NumBits;
+
+	// Bits the same moves would have taken with LFDiff sent as a single NetQuantize100 vector
+	int64 NumQuantizedLFDiffBits;
+
+	// Time stamps of the new moves sent, acknowledged by the test in place of a server
+	TArray<float> SentTimeStamps;
+};
+
+// A VR character using the recording movement component
+UCLASS(Transient, NotBlueprintable, NotBlueprintType, NotPlaceable)
+class AVRCharacterMoveTestCharacter : public AVRCharacter
+{
+	GENERATED_BODY()
+
+public:
+	AVRCharacterMoveTestCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+};
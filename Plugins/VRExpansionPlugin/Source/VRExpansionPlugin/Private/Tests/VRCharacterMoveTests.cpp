@@ -0,0 +1,324 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VRCharacterMoveTestTypes.h"
+#include "CharacterMovementCompTypes.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/CoreNet.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+// Outside of the automation test guard as the recording types are compiled into every build
+UVRCharacterMoveTestMovementComponent::UVRCharacterMoveTestMovementComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	ResetSentMoves();
+}
+
+void UVRCharacterMoveTestMovementComponent::CallServerMovePacked(const FSavedMove_Character* NewMove, const FSavedMove_Character* PendingMove, const FSavedMove_Character* OldMove)
+{
+	// Fill and serialize the move data like the packed RPC does, nothing the test sends references an object so no package map is needed
+	FCharacterNetworkMoveDataContainer& MoveDataContainer = GetNetworkMoveDataContainer();
+	MoveDataContainer.ClientFillNetworkMoveData(*NewMove, PendingMove, OldMove);
+
+	FNetBitWriter Writer(nullptr, 1024 * 8);
+	MoveDataContainer.Serialize(*this, Writer, nullptr);
+
+	++NumRPCs;
+	NumPendingMoves += PendingMove ? 1 : 0;
+	NumOldMoves += OldMove ? 1 : 0;
+	NumBits += Writer.GetNumBits();
+	NumQuantizedLFDiffBits += Writer.GetNumBits();
+
+	const FSavedMove_Character* SentMoves[] = { NewMove, PendingMove, OldMove };
+	for (const FSavedMove_Character* SentMove : SentMoves)
+	{
+		if (!SentMove)
+			continue;
+
+		++NumMovesSent;
+
+		// Swap the packed LFDiff bits for a NetQuantize100 vector
+		FVRCharacterNetworkMoveData MoveData;
+		MoveData.LFDiff = static_cast<const FSavedMove_VRBaseCharacter*>(SentMove)->LFDiff;
+
+		FNetBitWriter PackedWriter(nullptr, 256 * 8);
+		MoveData.SerializeLFDiff(PackedWriter);
+
+		bool bSuccess = true;
+		FNetBitWriter QuantizedWriter(nullptr, 256 * 8);
+		FVector_NetQuantize100 QuantizedLFDiff = MoveData.LFDiff;
+		QuantizedLFDiff.NetSerialize(QuantizedWriter, nullptr, bSuccess);
+
+		NumQuantizedLFDiffBits += QuantizedWriter.GetNumBits() - PackedWriter.GetNumBits();
+	}
+
+	SentTimeStamps.Add(NewMove->TimeStamp);
+}
+
+void UVRCharacterMoveTestMovementComponent::ResetSentMoves()
+{
+	NumRPCs = 0;
+	NumMovesSent = 0;
+	NumPendingMoves = 0;
+	NumOldMoves = 0;
+	NumBits = 0;
+	NumQuantizedLFDiffBits = 0;
+	SentTimeStamps.Reset();
+}
+
+AVRCharacterMoveTestCharacter::AVRCharacterMoveTestCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UVRCharacterMoveTestMovementComponent>(ACharacter::CharacterMovementComponentName))
+{
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace VRCharacterMoveTests
+{
+	static const float TrackingRate = 90.0f;
+	static const float TraceSeconds = 40.0f;
+
+	// Frames before the test acknowledges a sent move in place of the server, about a 65ms round trip
+	static const int32 AckLatencyFrames = 6;
+
+	// Engine default for the saved move direction threshold
+	static const float AccelDotThresholdCombine = 0.996f;
+
+	// A client frame of the scripted trace
+	struct FTraceFrame
+	{
+		FVector Acceleration;
+		float Yaw;
+		FVector HMDDelta;
+		float HalfHeight;
+	};
+
+	// Stand and look around, walk forward on the thumbstick, walk while smooth turning, then walk around the room
+	static void BuildWalkAndTurnTrace(TArray<FTraceFrame>& OutTrace)
+	{
+		FRandomStream Random(2020);
+		const float MaxAcceleration = 2048.0f;
+		const float TurnRate = 90.0f;
+
+		float Yaw = 0.0f;
+
+		OutTrace.Reset(FMath::CeilToInt(TraceSeconds * TrackingRate));
+		for (int32 Frame = 0; Frame < TraceSeconds * TrackingRate; ++Frame)
+		{
+			const float Time = Frame / TrackingRate;
+			const float DeltaTime = 1.0f / TrackingRate;
+			const float Phase = FMath::Fmod(Time, 20.0f);
+
+			const bool bWalking = Phase >= 5.0f && Phase < 15.0f;
+			const bool bTurning = Phase >= 10.0f && Phase < 15.0f;
+			const bool bRoomScale = Phase >= 15.0f;
+
+			if (bTurning)
+			{
+				Yaw = FRotator::ClampAxis(Yaw + TurnRate * DeltaTime);
+			}
+
+			// Tracking noise on the HMD and a slow drift of the head over the capsule, real steps when walking around the room
+			FVector HMDDelta(Random.FRandRange(-0.03f, 0.03f), Random.FRandRange(-0.03f, 0.03f), 0.0f);
+			HMDDelta += FVector(FMath::Cos(Time * 0.5f), FMath::Sin(Time * 0.5f), 0.0f) * (bRoomScale ? 1.2f : 0.02f);
+
+			FTraceFrame& TraceFrame = OutTrace.AddDefaulted_GetRef();
+			TraceFrame.Acceleration = bWalking ? FRotator(0.0f, Yaw, 0.0f).Vector() * MaxAcceleration : FVector::ZeroVector;
+			TraceFrame.Yaw = Yaw;
+
+			// Rounded the same way the root component rounds DifferenceFromLastFrame
+			TraceFrame.HMDDelta = FVector(FMath::RoundToFloat(HMDDelta.X * 100.f) / 100.f, FMath::RoundToFloat(HMDDelta.Y * 100.f) / 100.f, 0.0f);
+			TraceFrame.HalfHeight = 88.0f + 2.0f * FMath::Sin(Time * 0.3f) + Random.FRandRange(-0.02f, 0.02f);
+		}
+	}
+
+	static UWorld* CreateTestWorld()
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+		return World;
+	}
+
+	static void DestroyTestWorld(UWorld* World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	struct FRunResult
+	{
+		int32 NumRPCs;
+		int32 NumMovesSent;
+		int32 NumCombined;
+		int64 NumBits;
+		int64 NumQuantizedLFDiffBits;
+		bool bPreallocatedMoves;
+	};
+
+	// Plays the trace through ReplicateMoveToServer of a flying VR character, acknowledging sent moves after AckLatencyFrames
+	static FRunResult Replay(UWorld* World, const TArray<FTraceFrame>& Trace, float CombineTolerance)
+	{
+		FRunResult Result = { 0, 0, 0, 0, 0, false };
+
+		AVRCharacterMoveTestCharacter* Character = World->SpawnActor<AVRCharacterMoveTestCharacter>(FVector(0.0f, 0.0f, 200.0f), FRotator::ZeroRotator);
+		UVRCharacterMoveTestMovementComponent* MovementComponent = Cast<UVRCharacterMoveTestMovementComponent>(Character->GetCharacterMovement());
+		check(MovementComponent && Character->VRRootReference);
+
+		// Flying so the trace isn't interrupted by falling and landing
+		Character->SetReplicatingMovement(true);
+		Character->VRReplicateCapsuleHeight = true;
+		MovementComponent->VRMoveCombineTolerance = CombineTolerance;
+		MovementComponent->SetMovementMode(MOVE_Flying);
+
+		FNetworkPredictionData_Client_Character* ClientData = MovementComponent->GetPredictionData_Client_Character();
+		TArray<int32> SentFrames;
+		int32 NumAcked = 0;
+
+		FVector CameraLocation = FVector::ZeroVector;
+		for (int32 Frame = 0; Frame < Trace.Num(); ++Frame)
+		{
+			const FTraceFrame& TraceFrame = Trace[Frame];
+			const float DeltaTime = 1.0f / TrackingRate;
+			World->TimeSeconds += DeltaTime;
+
+			// What the root component and camera would have tracked this frame
+			CameraLocation += TraceFrame.HMDDelta;
+			Character->SetActorRotation(FRotator(0.0f, TraceFrame.Yaw, 0.0f));
+			Character->SetCharacterHalfHeightVR(TraceFrame.HalfHeight, false);
+			Character->VRRootReference->curCameraLoc = CameraLocation;
+			Character->VRRootReference->DifferenceFromLastFrame = TraceFrame.HMDDelta;
+			MovementComponent->AdditionalVRInputVector = TraceFrame.HMDDelta;
+
+			const int32 NumSent = MovementComponent->SentTimeStamps.Num();
+			MovementComponent->ReplicateMoveToServer(DeltaTime, TraceFrame.Acceleration);
+
+			if (Frame == 0)
+			{
+				// The pool is filled by the first saved move, which was taken from it
+				Result.bPreallocatedMoves = ClientData->FreeMoves.Num() == FNetworkPredictionData_Client_VRCharacter::NumPreallocatedMoves - 1;
+			}
+
+			for (int32 Idx = NumSent; Idx < MovementComponent->SentTimeStamps.Num(); ++Idx)
+			{
+				SentFrames.Add(Frame);
+			}
+
+			// Acknowledge what the server would have by now
+			while (NumAcked < SentFrames.Num() && SentFrames[NumAcked] <= Frame - AckLatencyFrames)
+			{
+				const int32 MoveIndex = ClientData->GetSavedMoveIndex(MovementComponent->SentTimeStamps[NumAcked]);
+				if (MoveIndex != INDEX_NONE)
+				{
+					ClientData->AckMove(MoveIndex, *MovementComponent);
+				}
+				++NumAcked;
+			}
+		}
+
+		Result.NumRPCs = MovementComponent->NumRPCs;
+		Result.NumMovesSent = MovementComponent->NumMovesSent;
+		Result.NumBits = MovementComponent->NumBits;
+		Result.NumQuantizedLFDiffBits = MovementComponent->NumQuantizedLFDiffBits;
+
+		// Every frame made a saved move, which was either sent as the new or pending move, combined into the next move or is still pending
+		Result.NumCombined = Trace.Num() - MovementComponent->NumRPCs - MovementComponent->NumPendingMoves - (ClientData->PendingMove.IsValid() ? 1 : 0);
+
+		Character->Destroy();
+		return Result;
+	}
+}
+
+/**
+ * Checks the tolerance based combining of the VR deltas.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRCharacterMoveCombineDeltasTest, "VRExpansionPlugin.CharacterMovement.CombineVRDeltas", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRCharacterMoveCombineDeltasTest::RunTest(const FString& Parameters)
+{
+	using namespace VRCharacterMoveTests;
+
+	const float Tolerance = 0.05f;
+
+	TestTrue(TEXT("Zero deltas combine"), FSavedMove_VRBaseCharacter::CanCombineVRDeltas(FVector2D::ZeroVector, FVector2D::ZeroVector, AccelDotThresholdCombine, Tolerance));
+	TestTrue(TEXT("Tracking noise combines with any delta"), FSavedMove_VRBaseCharacter::CanCombineVRDeltas(FVector2D(0.02f, -0.01f), FVector2D(-3.0f, 2.0f), AccelDotThresholdCombine, Tolerance));
+	TestTrue(TEXT("Same direction combines"), FSavedMove_VRBaseCharacter::CanCombineVRDeltas(FVector2D(1.0f, 0.0f), FVector2D(2.0f, 0.01f), AccelDotThresholdCombine, Tolerance));
+	TestTrue(TEXT("Sideways deviation within tolerance combines"), FSavedMove_VRBaseCharacter::CanCombineVRDeltas(FVector2D(1.0f, 0.0f), FVector2D(0.5f, 0.04f), AccelDotThresholdCombine, Tolerance));
+	TestFalse(TEXT("Sideways deviation past tolerance doesn't combine"), FSavedMove_VRBaseCharacter::CanCombineVRDeltas(FVector2D(1.0f, 0.0f), FVector2D(0.5f, 0.5f), AccelDotThresholdCombine, Tolerance));
+	TestFalse(TEXT("Opposite directions don't combine"), FSavedMove_VRBaseCharacter::CanCombineVRDeltas(FVector2D(1.0f, 0.0f), FVector2D(-1.0f, 0.01f), AccelDotThresholdCombine, Tolerance));
+	TestFalse(TEXT("Without a tolerance noisy deltas don't combine"), FSavedMove_VRBaseCharacter::CanCombineVRDeltas(FVector2D(0.02f, -0.01f), FVector2D(-0.01f, 0.03f), AccelDotThresholdCombine, KINDA_SMALL_NUMBER));
+
+	return true;
+}
+
+/**
+ * LFDiff has to survive the packing at the 1/100th precision it is rounded to.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRCharacterMoveLFDiffPackingTest, "VRExpansionPlugin.CharacterMovement.LFDiffPacking", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRCharacterMoveLFDiffPackingTest::RunTest(const FString& Parameters)
+{
+	const FVector Values[] = { FVector::ZeroVector, FVector(0.01f, -0.02f, 0.0f), FVector(0.0f, 0.0f, 88.42f), FVector(-3.57f, 12.3f, 96.0f), FVector(250.0f, -250.0f, 0.0f) };
+
+	for (const FVector& Value : Values)
+	{
+		FVRCharacterNetworkMoveData Sent;
+		Sent.LFDiff = Value;
+
+		FNetBitWriter Writer(nullptr, 256 * 8);
+		Sent.SerializeLFDiff(Writer);
+
+		FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+		FVRCharacterNetworkMoveData Received;
+		Received.SerializeLFDiff(Reader);
+
+		TestTrue(FString::Printf(TEXT("LFDiff %s round trips"), *Value.ToString()), Received.LFDiff.Equals(Value, 0.006f));
+	}
+
+	return true;
+}
+
+/**
+ * Plays a scripted walk and turn trace through ReplicateMoveToServer and reports the ServerMove RPCs/s and move data bytes/s
+ * for exact combining with the old LFDiff serialization, exact combining with the packed LFDiff, and tolerance combining with the packed LFDiff.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRCharacterMoveBandwidthTest, "VRExpansionPlugin.CharacterMovement.ServerMoveBandwidth", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FVRCharacterMoveBandwidthTest::RunTest(const FString& Parameters)
+{
+	using namespace VRCharacterMoveTests;
+
+	const float CombineTolerance = GetDefault<UVRCharacterMovementComponent>()->VRMoveCombineTolerance;
+
+	TArray<FTraceFrame> Trace;
+	BuildWalkAndTurnTrace(Trace);
+
+	UWorld* World = CreateTestWorld();
+	const FRunResult Exact = Replay(World, Trace, 0.0f);
+	const FRunResult Combined = Replay(World, Trace, CombineTolerance);
+	DestroyTestWorld(World);
+
+	auto Report = [this](const FString& Name, const FRunResult& Result, int64 NumBits)
+	{
+		AddInfo(FString::Printf(TEXT("%s: %.1f ServerMove RPCs/s, %.1f moves/s, %d combined, %.0f bytes/s"),
+			*Name, Result.NumRPCs / TraceSeconds, Result.NumMovesSent / TraceSeconds, Result.NumCombined, NumBits / 8.0 / TraceSeconds));
+	};
+
+	Report(TEXT("Exact combining, NetQuantize100 LFDiff"), Exact, Exact.NumQuantizedLFDiffBits);
+	Report(TEXT("Exact combining, packed LFDiff"), Exact, Exact.NumBits);
+	Report(FString::Printf(TEXT("Combining within %.2f cm, packed LFDiff"), CombineTolerance), Combined, Combined.NumBits);
+
+	TestTrue(TEXT("Free moves filled on the first saved move"), Exact.bPreallocatedMoves && Combined.bPreallocatedMoves);
+	TestTrue(TEXT("Moves were sent"), Exact.NumRPCs > 0);
+	TestTrue(TEXT("Packing LFDiff sends fewer bytes"), Exact.NumBits < Exact.NumQuantizedLFDiffBits);
+	TestTrue(TEXT("Combining within tolerance combines more moves"), Combined.NumCombined > Exact.NumCombined);
+	TestTrue(TEXT("Combining within tolerance sends fewer moves"), Combined.NumMovesSent < Exact.NumMovesSent);
+	TestTrue(TEXT("Combining within tolerance sends fewer bytes"), Combined.NumBits < Exact.NumBits);
+	TestTrue(TEXT("Combining doesn't send more RPCs"), Combined.NumRPCs <= Exact.NumRPCs);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
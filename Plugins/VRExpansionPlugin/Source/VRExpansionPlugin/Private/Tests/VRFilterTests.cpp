@@ -0,0 +1,300 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VRBPDatatypes.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformTime.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace VRFilterTests
+{
+	static const float UpdateRate = 90.f;
+
+	// The per axis euro filter step before it was vectorized, used as the reference
+	struct FScalarEuroLowPassFilter
+	{
+		FScalarEuroLowPassFilter(const FBPEuroLowPassFilter& InSettings) :
+			MinCutoff(InSettings.MinCutoff),
+			DeltaCutoff(InSettings.DeltaCutoff),
+			CutoffSlope(InSettings.CutoffSlope)
+		{}
+
+		float MinCutoff;
+		float DeltaCutoff;
+		float CutoffSlope;
+
+		FBasicLowPassFilter RawFilter;
+		FBasicLowPassFilter DeltaFilter;
+
+		void ResetSmoothingFilter()
+		{
+			RawFilter.bFirstTime = true;
+			DeltaFilter.bFirstTime = true;
+		}
+
+		FVector RunFilterSmoothing(const FVector& InRawValue, const float& InDeltaTime)
+		{
+			const FVector Delta = RawFilter.bFirstTime == true ? FVector::ZeroVector : (InRawValue - RawFilter.Previous) * InDeltaTime;
+			const FVector Estimated = DeltaFilter.Filter(Delta, FVector(CalculateAlpha(DeltaCutoff, InDeltaTime)));
+
+			FVector Cutoff;
+			for (int i = 0; i < 3; i++)
+			{
+				Cutoff[i] = MinCutoff + CutoffSlope * FMath::Abs(Estimated[i]);
+			}
+
+			FVector Alpha;
+			for (int i = 0; i < 3; i++)
+			{
+				Alpha[i] = CalculateAlpha(Cutoff[i], InDeltaTime);
+			}
+			return RawFilter.Filter(InRawValue, Alpha);
+		}
+
+		static float CalculateAlpha(const float InCutoff, const double InDeltaTime)
+		{
+			const float tau = 1.0 / (2 * PI * InCutoff);
+			return 1.0 / (1.0 + tau / InDeltaTime);
+		}
+	};
+
+	// The full scan of the log used before the peak queue, the first of the largest samples by log index wins
+	static FVector ScanPeak(const TArray<FVector>& VelocitySampleLog)
+	{
+		FVector MaxValue = FVector::ZeroVector;
+		float ValueSizeSq = 0.f;
+		for (int i = 0; i < VelocitySampleLog.Num(); i++)
+		{
+			const float CurSizeSq = VelocitySampleLog[i].SizeSquared();
+			if (CurSizeSq > ValueSizeSq)
+			{
+				MaxValue = VelocitySampleLog[i];
+				ValueSizeSq = CurSizeSq;
+			}
+		}
+		return MaxValue;
+	}
+
+	// Brute force peak with the queue's tie breaking, the newest of the largest samples wins
+	static FVector NewestPeak(const FBPLowPassPeakFilter& Filter)
+	{
+		const TArray<FVector>& Log = Filter.VelocitySampleLog;
+		FVector MaxValue = FVector::ZeroVector;
+		float ValueSizeSq = 0.f;
+
+		// The log counter points at the oldest sample once the log has wrapped around
+		for (int i = 0; i < Log.Num(); i++)
+		{
+			const FVector& Sample = Log[(Filter.VelocitySampleLogCounter + i) % Log.Num()];
+			const float CurSizeSq = Sample.SizeSquared();
+			if (CurSizeSq > 0.f && CurSizeSq >= ValueSizeSq)
+			{
+				MaxValue = Sample;
+				ValueSizeSq = CurSizeSq;
+			}
+		}
+		return MaxValue;
+	}
+
+	// Small integer samples, so many of them tie in size while pointing in different directions
+	static FVector RandomTiedSample(FRandomStream& Random)
+	{
+		return FVector((float)Random.RandRange(-2, 2), (float)Random.RandRange(-2, 2), (float)Random.RandRange(-2, 2));
+	}
+
+	// A tracked hand position with sways, swings and a little sensor noise
+	static FVector TracePosition(FRandomStream& Random, float Time)
+	{
+		return FVector(
+			40.f + 25.f * FMath::Sin(Time * 1.3f) + Random.FRandRange(-0.05f, 0.05f),
+			-20.f + 30.f * FMath::Sin(Time * 7.f + 1.f) + Random.FRandRange(-0.05f, 0.05f),
+			110.f + 15.f * FMath::Sin(Time * 2.1f) + Random.FRandRange(-0.05f, 0.05f));
+	}
+}
+
+/**
+ * Checks the peak queue against a scan of the log after every sample, across log wraparound, resets and sample count changes.
+ * Equally large samples resolve to the newest one, while the old scan returned the first by log index, so only its size is compared.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRFilterPeakTest, "VRExpansionPlugin.Filters.PeakMatchesScan", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRFilterPeakTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(1337);
+	FBPLowPassPeakFilter Filter;
+	Filter.VelocitySamples = 30;
+
+	TestTrue(TEXT("Empty filter has no peak"), Filter.GetPeak().IsZero());
+
+	int32 Mismatches = 0;
+	int32 SizeMismatches = 0;
+	int32 TieBreaks = 0;
+	for (int32 i = 0; i < 3000; ++i)
+	{
+		if (i == 1000)
+		{
+			Filter.Reset();
+			TestTrue(TEXT("Reset filter has no peak"), Filter.GetPeak().IsZero());
+		}
+		else if (i == 2000)
+		{
+			Filter.VelocitySamples = 7;
+		}
+
+		// Runs of zero samples let every peak expire now and then
+		const bool bZeroRun = (i / 50) % 5 == 4;
+		Filter.AddSample(bZeroRun ? FVector::ZeroVector : VRFilterTests::RandomTiedSample(Random));
+
+		const FVector Peak = Filter.GetPeak();
+		const FVector ScannedPeak = VRFilterTests::ScanPeak(Filter.VelocitySampleLog);
+		Mismatches += Peak != VRFilterTests::NewestPeak(Filter);
+		SizeMismatches += Peak.SizeSquared() != ScannedPeak.SizeSquared();
+		TieBreaks += Peak != ScannedPeak;
+	}
+
+	TestEqual(TEXT("Peaks differing from the brute force"), Mismatches, 0);
+	TestEqual(TEXT("Peak sizes differing from the scan"), SizeMismatches, 0);
+	TestTrue(TEXT("Ties were resolved"), TieBreaks > 0);
+
+	// Two equally large samples, the newest wins and stays the peak until it leaves the log
+	Filter.Reset();
+	Filter.VelocitySamples = 4;
+	Filter.AddSample(FVector(1.f, 0.f, 0.f));
+	Filter.AddSample(FVector(0.f, 1.f, 0.f));
+	TestEqual(TEXT("Newest tied sample is the peak"), Filter.GetPeak(), FVector(0.f, 1.f, 0.f));
+	Filter.AddSample(FVector::ZeroVector);
+	Filter.AddSample(FVector::ZeroVector);
+	Filter.AddSample(FVector::ZeroVector);
+	TestEqual(TEXT("Peak kept while in the log"), Filter.GetPeak(), FVector(0.f, 1.f, 0.f));
+	Filter.AddSample(FVector::ZeroVector);
+	TestTrue(TEXT("Peak expired with the log"), Filter.GetPeak().IsZero());
+
+	return true;
+}
+
+/**
+ * Runs the vectorized euro filter and the per axis reference over the same hand trace with a jittered frame time,
+ * including a reset halfway, and checks they match.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRFilterEuroTest, "VRExpansionPlugin.Filters.EuroMatchesScalar", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRFilterEuroTest::RunTest(const FString& Parameters)
+{
+	const FBPEuroLowPassFilter Settings[] = {
+		FBPEuroLowPassFilter(),
+		FBPEuroLowPassFilter(0.1f, 0.5f, 2.0f),
+		FBPEuroLowPassFilter(5.0f, 0.0f, 0.5f) };
+
+	for (const FBPEuroLowPassFilter& Setting : Settings)
+	{
+		FRandomStream Random(1337);
+		FBPEuroLowPassFilter Filter = Setting;
+		VRFilterTests::FScalarEuroLowPassFilter Reference(Setting);
+
+		float Time = 0.f;
+		float MaxError = 0.f;
+		for (int32 i = 0; i < 2000; ++i)
+		{
+			if (i == 1000)
+			{
+				Filter.ResetSmoothingFilter();
+				Reference.ResetSmoothingFilter();
+			}
+
+			const float DeltaTime = (1.f + Random.FRandRange(-0.2f, 0.2f)) / VRFilterTests::UpdateRate;
+			Time += DeltaTime;
+			const FVector RawValue = VRFilterTests::TracePosition(Random, Time);
+
+			const FVector Result = Filter.RunFilterSmoothing(RawValue, DeltaTime);
+			const FVector Expected = Reference.RunFilterSmoothing(RawValue, DeltaTime);
+			MaxError = FMath::Max(MaxError, (Result - Expected).GetAbsMax());
+		}
+
+		TestTrue(FString::Printf(TEXT("MinCutoff %.2f CutoffSlope %.3f DeltaCutoff %.2f max error %f"), Setting.MinCutoff, Setting.CutoffSlope, Setting.DeltaCutoff, MaxError), MaxError < 0.01f);
+	}
+
+	return true;
+}
+
+/**
+ * Times the euro filter against the per axis reference, and the peak queue against scanning the log, and reports the throughput.
+ * The peak queue must beat the scan of a long log.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRFilterBenchmarkTest, "VRExpansionPlugin.Filters.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRFilterBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const int32 NumIterations = 200000;
+	const float DeltaTime = 1.f / VRFilterTests::UpdateRate;
+
+	TArray<FVector> Samples;
+	FRandomStream Random(1337);
+	Samples.Reserve(1024);
+	for (int32 i = 0; i < 1024; ++i)
+	{
+		Samples.Add(VRFilterTests::TracePosition(Random, i * DeltaTime));
+	}
+
+	// Accumulated so the optimizer can't drop the filters
+	FVector Checksum = FVector::ZeroVector;
+
+	{
+		FBPEuroLowPassFilter Filter;
+		VRFilterTests::FScalarEuroLowPassFilter Reference(Filter);
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumIterations; ++i)
+		{
+			Checksum += Filter.RunFilterSmoothing(Samples[i & 1023], DeltaTime);
+		}
+		const double VectorSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumIterations; ++i)
+		{
+			Checksum -= Reference.RunFilterSmoothing(Samples[i & 1023], DeltaTime);
+		}
+		const double ScalarSeconds = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("Euro filter: %.1f ns/sample vectorized, %.1f ns/sample per axis"),
+			VectorSeconds * 1e9 / NumIterations, ScalarSeconds * 1e9 / NumIterations));
+	}
+
+	const int32 SampleCounts[] = { 30, 90, 512 };
+	for (const int32 SampleCount : SampleCounts)
+	{
+		FBPLowPassPeakFilter Filter;
+		Filter.VelocitySamples = SampleCount;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumIterations; ++i)
+		{
+			Filter.AddSample(Samples[i & 1023]);
+			Checksum += Filter.GetPeak();
+		}
+		const double QueueSeconds = FPlatformTime::Seconds() - StartTime;
+
+		Filter.Reset();
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumIterations; ++i)
+		{
+			Filter.AddSample(Samples[i & 1023]);
+			Checksum -= VRFilterTests::ScanPeak(Filter.VelocitySampleLog);
+		}
+		const double ScanSeconds = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("Peak filter with %d samples: %.1f ns/sample queued, %.1f ns/sample scanned"),
+			SampleCount, QueueSeconds * 1e9 / NumIterations, ScanSeconds * 1e9 / NumIterations));
+
+		if (SampleCount >= 512)
+		{
+			TestTrue(FString::Printf(TEXT("Peak queue faster than the scan with %d samples"), SampleCount), QueueSeconds < ScanSeconds);
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("Checksum %s"), *Checksum.ToString()));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,316 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Grippables/GrippablePhysicsReplication.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace VRPhysicsReplicationTests
+{
+	static const float SimulatedSeconds = 20.0f;
+	static const float ClientSendRate = 30.0f;
+	static const float ServerTickRate = 60.0f;
+	static const float OneWayLatency = 0.05f;
+	static const float MaxJitter = 0.04f;
+	static const float PacketLoss = 0.05f;
+
+	// Ground truth of the client simulated object, a circle in the air while turning to face along it
+	static FRigidBodyState GetTrueState(float Time)
+	{
+		const float Radius = 50.0f;
+		const float AngularSpeed = 2.0f;
+
+		FRigidBodyState State;
+		State.Position = FVector(Radius * FMath::Cos(Time * AngularSpeed), Radius * FMath::Sin(Time * AngularSpeed), 100.0f);
+		State.LinVel = FVector(-Radius * AngularSpeed * FMath::Sin(Time * AngularSpeed), Radius * AngularSpeed * FMath::Cos(Time * AngularSpeed), 0.0f);
+		State.Quaternion = FQuat(FVector::UpVector, Time * AngularSpeed);
+		State.AngVel = FVector(0.0f, 0.0f, FMath::RadiansToDegrees(AngularSpeed));
+		State.Flags = ERigidBodyFlags::NeedsUpdate;
+		return State;
+	}
+
+	// The server side body, moved by its velocities and pulled towards the target like FPhysicsReplication::ApplyRigidBodyState
+	struct FSimulatedBody
+	{
+		FRigidBodyState State;
+
+		void ApplyCorrection(const FRigidBodyState& Target, const FRigidBodyErrorCorrection& Correction, float DeltaSeconds)
+		{
+			const FVector LinDiff = Target.Position - State.Position;
+
+			FVector AngDiffAxis;
+			float AngDiff;
+			(Target.Quaternion * State.Quaternion.Inverse()).ToAxisAndAngle(AngDiffAxis, AngDiff);
+			AngDiff = FMath::RadiansToDegrees(FMath::UnwindRadians(AngDiff));
+
+			State.LinVel = Target.LinVel + LinDiff * Correction.LinearVelocityCoefficient * DeltaSeconds;
+			State.AngVel = Target.AngVel + AngDiffAxis * AngDiff * Correction.AngularVelocityCoefficient * DeltaSeconds;
+			State.Position = FMath::Lerp(FVector(State.Position), FVector(Target.Position), Correction.PositionLerp);
+			State.Quaternion = FQuat::Slerp(State.Quaternion, Target.Quaternion, Correction.AngleLerp);
+		}
+
+		// Free floating, nothing but the corrections change its velocities
+		void Step(float DeltaSeconds)
+		{
+			State.Position += State.LinVel * DeltaSeconds;
+
+			const FVector AngVel = State.AngVel;
+			const float AngSpeed = AngVel.Size();
+			if (AngSpeed > KINDA_SMALL_NUMBER)
+			{
+				State.Quaternion = FQuat(AngVel / AngSpeed, FMath::DegreesToRadians(AngSpeed) * DeltaSeconds) * State.Quaternion;
+				State.Quaternion.Normalize();
+			}
+		}
+	};
+
+	struct FPacket
+	{
+		float ArrivalTime;
+		FRigidBodyState State;
+	};
+
+	struct FRunResult
+	{
+		// Lag (in seconds) that best lines the shown positions up with the ground truth
+		float Latency;
+		// Mean distance from the ground truth at that lag
+		float MeanError;
+		// RMS of the frame to frame acceleration that isn't in the ground truth
+		float Jitter;
+	};
+
+	// Finds the lag that best explains the shown positions and measures how far off and how jittery they are
+	static FRunResult Measure(const TArray<float>& Times, const TArray<FVector>& Shown)
+	{
+		FRunResult Result = { 0.0f, BIG_NUMBER, 0.0f };
+
+		for (int32 LagMs = 0; LagMs <= 300; ++LagMs)
+		{
+			const float Lag = LagMs * 0.001f;
+			double TotalError = 0.0;
+			for (int32 i = 0; i < Times.Num(); ++i)
+			{
+				TotalError += FVector::Dist(Shown[i], GetTrueState(Times[i] - Lag).Position);
+			}
+
+			const float MeanError = (float)(TotalError / Times.Num());
+			if (MeanError < Result.MeanError)
+			{
+				Result.MeanError = MeanError;
+				Result.Latency = Lag;
+			}
+		}
+
+		double TotalJitterSq = 0.0;
+		for (int32 i = 2; i < Times.Num(); ++i)
+		{
+			const FVector ShownAccel = Shown[i] - 2.0f * Shown[i - 1] + Shown[i - 2];
+			const FVector TrueAccel = GetTrueState(Times[i] - Result.Latency).Position - 2.0f * GetTrueState(Times[i - 1] - Result.Latency).Position + GetTrueState(Times[i - 2] - Result.Latency).Position;
+			TotalJitterSq += (ShownAccel - TrueAccel).SizeSquared();
+		}
+
+		Result.Jitter = FMath::Sqrt((float)(TotalJitterSq / FMath::Max(Times.Num() - 2, 1)));
+		return Result;
+	}
+}
+
+/**
+ * Headless run of the server side physics replication timing: a client sends states over a lossy, jittery connection and the server
+ * either applies the newest one directly (extrapolated by ping) or replays them through FVRPhysicsStateBuffer like FPhysicsReplicationVR does.
+ * Reports the latency, error and jitter of the targets for both, and runs a body through each path to count the corrections applied:
+ * the direct path corrects every tick, the buffered one goes through GetScaledErrorCorrection and skips the ticks inside its dead zone.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPhysicsReplicationLatencyTest, "VRExpansionPlugin.PhysicsReplication.LatencyAndJitter", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRPhysicsReplicationLatencyTest::RunTest(const FString& Parameters)
+{
+	using namespace VRPhysicsReplicationTests;
+
+	const UVRGlobalSettings& VRSettings = *GetDefault<UVRGlobalSettings>();
+	const FRigidBodyErrorCorrection& BaseCorrection = UPhysicsSettings::Get()->PhysicErrorCorrection;
+	const float DeltaSeconds = 1.0f / ServerTickRate;
+
+	// Build the packets the server receives
+	FRandomStream Random(42);
+	TArray<FPacket> Packets;
+	for (float SendTime = 0.0f; SendTime < SimulatedSeconds; SendTime += 1.0f / ClientSendRate)
+	{
+		if (Random.FRand() >= PacketLoss)
+		{
+			Packets.Add({ SendTime + OneWayLatency + Random.FRand() * MaxJitter, GetTrueState(SendTime) });
+		}
+	}
+
+	Packets.Sort([](const FPacket& A, const FPacket& B) { return A.ArrivalTime < B.ArrivalTime; });
+
+	// The server only measures the average round trip
+	const float PingSecondsOneWay = OneWayLatency + MaxJitter * 0.5f;
+	const float MaxExtrapolation = FMath::Min(VRSettings.PhysicsReplicationMaxExtrapolation, PingSecondsOneWay + VRSettings.PhysicsReplicationRenderDelay);
+
+	FVRPhysicsStateBuffer StateBuffer;
+	const FPacket* LatestPacket = nullptr;
+	int32 NextPacket = 0;
+
+	TArray<float> Times;
+	TArray<FVector> DirectShown;
+	TArray<FVector> BufferedShown;
+
+	FSimulatedBody DirectBody;
+	FSimulatedBody BufferedBody;
+	bool bBodiesSpawned = false;
+
+	int32 NumDirectCorrections = 0;
+	int32 NumBufferedCorrections = 0;
+	int32 NumBufferedSkipped = 0;
+	int32 NumBufferedAngleCorrections = 0;
+	double TotalDirectBodyError = 0.0;
+	double TotalBufferedBodyError = 0.0;
+
+	for (float CurrentTime = 0.0f; CurrentTime < SimulatedSeconds; CurrentTime += DeltaSeconds)
+	{
+		// Like the replicated target, only the newest arrival since the last tick is seen
+		const FPacket* ArrivedPacket = nullptr;
+		while (NextPacket < Packets.Num() && Packets[NextPacket].ArrivalTime <= CurrentTime)
+		{
+			ArrivedPacket = &Packets[NextPacket++];
+		}
+
+		if (ArrivedPacket)
+		{
+			LatestPacket = ArrivedPacket;
+			StateBuffer.LastArrivedTimeSeconds = CurrentTime;
+			StateBuffer.AddState(CurrentTime - PingSecondsOneWay, ArrivedPacket->State, VRSettings.PhysicsReplicationBufferSize);
+		}
+
+		// Wait for the buffer to fill before measuring
+		if (!LatestPacket || CurrentTime < 1.0f)
+		{
+			continue;
+		}
+
+		FRigidBodyState DirectState;
+		FVRPhysicsStateBuffer::ExtrapolateState(LatestPacket->State, PingSecondsOneWay, DirectState);
+
+		FRigidBodyState BufferedState;
+		StateBuffer.Sample(CurrentTime - VRSettings.PhysicsReplicationRenderDelay, MaxExtrapolation, BufferedState);
+
+		Times.Add(CurrentTime);
+		DirectShown.Add(DirectState.Position);
+		BufferedShown.Add(BufferedState.Position);
+
+		if (!bBodiesSpawned)
+		{
+			DirectBody.State = DirectState;
+			BufferedBody.State = BufferedState;
+			bBodiesSpawned = true;
+		}
+
+		TotalDirectBodyError += FVector::Dist(DirectBody.State.Position, DirectState.Position);
+		TotalBufferedBodyError += FVector::Dist(BufferedBody.State.Position, BufferedState.Position);
+
+		// Direct apply corrects towards every state with the project error correction
+		DirectBody.ApplyCorrection(DirectState, BaseCorrection, DeltaSeconds);
+		NumDirectCorrections++;
+
+		FRigidBodyErrorCorrection ScaledCorrection;
+		if (FPhysicsReplicationVR::GetScaledErrorCorrection(BufferedBody.State, BufferedState, BaseCorrection, VRSettings, ScaledCorrection))
+		{
+			if (FVector::Dist(BufferedBody.State.Position, BufferedState.Position) < VRSettings.PhysicsReplicationMinCorrectionError)
+			{
+				NumBufferedAngleCorrections++;
+			}
+
+			BufferedBody.ApplyCorrection(BufferedState, ScaledCorrection, DeltaSeconds);
+			NumBufferedCorrections++;
+		}
+		else
+		{
+			NumBufferedSkipped++;
+		}
+
+		DirectBody.Step(DeltaSeconds);
+		BufferedBody.Step(DeltaSeconds);
+	}
+
+	const FRunResult Direct = Measure(Times, DirectShown);
+	const FRunResult Buffered = Measure(Times, BufferedShown);
+
+	AddInfo(FString::Printf(TEXT("Direct: latency %.0f ms, mean error %.2f cm, jitter %.3f cm/frame^2"), Direct.Latency * 1000.0f, Direct.MeanError, Direct.Jitter));
+	AddInfo(FString::Printf(TEXT("Buffered (render delay %.0f ms): latency %.0f ms, mean error %.2f cm, jitter %.3f cm/frame^2"), VRSettings.PhysicsReplicationRenderDelay * 1000.0f, Buffered.Latency * 1000.0f, Buffered.MeanError, Buffered.Jitter));
+
+	TestTrue(TEXT("Buffered replication is smoother than applying the newest state"), Buffered.Jitter < Direct.Jitter);
+	TestTrue(TEXT("Buffered replication tracks the motion closer than applying the newest state"), Buffered.MeanError < Direct.MeanError);
+	TestTrue(TEXT("Buffered replication latency stays within the render delay plus the network jitter"), Buffered.Latency <= VRSettings.PhysicsReplicationRenderDelay + MaxJitter);
+
+	const int32 NumTicks = Times.Num();
+	const float DirectBodyError = (float)(TotalDirectBodyError / FMath::Max(NumTicks, 1));
+	const float BufferedBodyError = (float)(TotalBufferedBodyError / FMath::Max(NumTicks, 1));
+
+	AddInfo(FString::Printf(TEXT("Direct: %d corrections in %d ticks, body %.2f cm from its target"), NumDirectCorrections, NumTicks, DirectBodyError));
+	AddInfo(FString::Printf(TEXT("Buffered: %d corrections (%d for rotation only), %d skipped in the dead zone, body %.2f cm from its target"), NumBufferedCorrections, NumBufferedAngleCorrections, NumBufferedSkipped, BufferedBodyError));
+
+	TestEqual(TEXT("Direct apply corrects every tick"), NumDirectCorrections, NumTicks);
+	TestEqual(TEXT("Every buffered tick is either corrected or skipped"), NumBufferedCorrections + NumBufferedSkipped, NumTicks);
+	TestTrue(TEXT("Buffered replication corrects the body"), NumBufferedCorrections > 0);
+	TestTrue(TEXT("Buffered replication skips the corrections inside the dead zone"), NumBufferedSkipped > 0);
+	TestTrue(TEXT("Buffered replication applies fewer corrections than applying the newest state"), NumBufferedCorrections < NumDirectCorrections);
+	TestTrue(TEXT("Skipping the dead zone keeps the body within the full correction error of its target"), BufferedBodyError < VRSettings.PhysicsReplicationFullCorrectionError);
+
+	return true;
+}
+
+/**
+ * The dead zone of the buffered correction: small position errors are skipped unless the rotation is off by PhysicsReplicationMinCorrectionAngle,
+ * and the correction strength ramps from PhysicsReplicationMinCorrectionStrength up to the full project correction.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPhysicsReplicationDeadZoneTest, "VRExpansionPlugin.PhysicsReplication.CorrectionDeadZone", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRPhysicsReplicationDeadZoneTest::RunTest(const FString& Parameters)
+{
+	UVRGlobalSettings* VRSettings = NewObject<UVRGlobalSettings>();
+	VRSettings->PhysicsReplicationMinCorrectionError = 0.5f;
+	VRSettings->PhysicsReplicationMinCorrectionAngle = 1.0f;
+	VRSettings->PhysicsReplicationFullCorrectionError = 10.0f;
+	VRSettings->PhysicsReplicationMinCorrectionStrength = 0.25f;
+
+	FRigidBodyErrorCorrection BaseCorrection;
+	BaseCorrection.PositionLerp = 0.2f;
+	BaseCorrection.AngleLerp = 0.4f;
+	BaseCorrection.LinearVelocityCoefficient = 100.0f;
+	BaseCorrection.AngularVelocityCoefficient = 10.0f;
+
+	FRigidBodyState CurrentState;
+	CurrentState.Position = FVector::ZeroVector;
+	CurrentState.Quaternion = FQuat::Identity;
+
+	FRigidBodyState TargetState = CurrentState;
+	FRigidBodyErrorCorrection Correction;
+
+	TargetState.Position = FVector(0.2f, 0.0f, 0.0f);
+	TestFalse(TEXT("Small position error is skipped"), FPhysicsReplicationVR::GetScaledErrorCorrection(CurrentState, TargetState, BaseCorrection, *VRSettings, Correction));
+
+	TargetState.Quaternion = FQuat(FVector::UpVector, FMath::DegreesToRadians(0.5f));
+	TestFalse(TEXT("Small rotation error is skipped"), FPhysicsReplicationVR::GetScaledErrorCorrection(CurrentState, TargetState, BaseCorrection, *VRSettings, Correction));
+
+	TargetState.Quaternion = FQuat(FVector::UpVector, FMath::DegreesToRadians(2.0f));
+	TestTrue(TEXT("Rotation error past the min angle is corrected"), FPhysicsReplicationVR::GetScaledErrorCorrection(CurrentState, TargetState, BaseCorrection, *VRSettings, Correction));
+	TestEqual(TEXT("Rotation only correction uses the min strength"), Correction.AngleLerp, BaseCorrection.AngleLerp * VRSettings->PhysicsReplicationMinCorrectionStrength);
+	TestEqual(TEXT("Rotation only correction scales the velocity coefficient"), Correction.LinearVelocityCoefficient, BaseCorrection.LinearVelocityCoefficient * VRSettings->PhysicsReplicationMinCorrectionStrength);
+
+	TargetState.Quaternion = FQuat::Identity;
+	TargetState.Position = FVector(0.0f, (VRSettings->PhysicsReplicationMinCorrectionError + VRSettings->PhysicsReplicationFullCorrectionError) * 0.5f, 0.0f);
+	TestTrue(TEXT("Position error past the dead zone is corrected"), FPhysicsReplicationVR::GetScaledErrorCorrection(CurrentState, TargetState, BaseCorrection, *VRSettings, Correction));
+	TestEqual(TEXT("Halfway error uses the halfway strength"), Correction.PositionLerp, BaseCorrection.PositionLerp * (VRSettings->PhysicsReplicationMinCorrectionStrength + 1.0f) * 0.5f, KINDA_SMALL_NUMBER);
+
+	TargetState.Position = FVector(0.0f, 0.0f, VRSettings->PhysicsReplicationFullCorrectionError * 2.0f);
+	TestTrue(TEXT("Large position error is corrected"), FPhysicsReplicationVR::GetScaledErrorCorrection(CurrentState, TargetState, BaseCorrection, *VRSettings, Correction));
+	TestEqual(TEXT("Large error uses the full position correction"), Correction.PositionLerp, BaseCorrection.PositionLerp);
+	TestEqual(TEXT("Large error uses the full angle correction"), Correction.AngleLerp, BaseCorrection.AngleLerp);
+	TestEqual(TEXT("Large error uses the full linear velocity correction"), Correction.LinearVelocityCoefficient, BaseCorrection.LinearVelocityCoefficient);
+	TestEqual(TEXT("Large error uses the full angular velocity correction"), Correction.AngularVelocityCoefficient, BaseCorrection.AngularVelocityCoefficient);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,299 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VRBPDatatypes.h"
+#include "VRGlobalSettings.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/CoreNet.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace VRPosRepEncodingTests
+{
+	static const int32 UpdateRate = 90;
+	static const int32 NumUpdates = UpdateRate * 60;
+
+	// A synthetic minute of tracked hand motion relative to the tracking origin, sways and swings with a few room scale steps and teleports.
+	// There is no recorded controller trace to replay here, so the sensor noise and teleport cadence are approximations.
+	static void BuildMotionTrace(TArray<FTransform>& OutTrace)
+	{
+		FRandomStream Random(1337);
+		FVector Offset = FVector::ZeroVector;
+
+		OutTrace.Reset(NumUpdates);
+		for (int32 i = 0; i < NumUpdates; ++i)
+		{
+			const float Time = (float)i / UpdateRate;
+
+			if (i > 0 && i % (UpdateRate * 7) == 0)
+			{
+				// Teleport, the tracked space moves with the player but the relative offset snaps
+				Offset = FVector(Random.FRandRange(-150.f, 150.f), Random.FRandRange(-150.f, 150.f), 0.f);
+			}
+
+			const FVector Position = Offset + FVector(
+				40.f + 25.f * FMath::Sin(Time * 1.3f) + Random.FRandRange(-0.05f, 0.05f),
+				-20.f + 30.f * FMath::Sin(Time * 0.7f + 1.f) + Random.FRandRange(-0.05f, 0.05f),
+				110.f + 15.f * FMath::Sin(Time * 2.1f) + Random.FRandRange(-0.05f, 0.05f));
+
+			const FRotator Rotation(
+				20.f * FMath::Sin(Time * 1.1f),
+				FMath::Fmod(Time * 25.f, 360.f) - 180.f,
+				35.f * FMath::Sin(Time * 0.9f + 2.f));
+
+			OutTrace.Add(FTransform(Rotation, Position));
+		}
+	}
+
+	// Sets bAllowDeltaEncodedPosRep for the scope of a test, the project setting is put back afterwards
+	struct FScopedAllowDeltaEncoding
+	{
+		bool bPreviousValue;
+
+		FScopedAllowDeltaEncoding(bool bAllow)
+		{
+			UVRGlobalSettings* VRSettings = GetMutableDefault<UVRGlobalSettings>();
+			bPreviousValue = VRSettings->bAllowDeltaEncodedPosRep;
+			VRSettings->bAllowDeltaEncodedPosRep = bAllow;
+		}
+
+		~FScopedAllowDeltaEncoding()
+		{
+			GetMutableDefault<UVRGlobalSettings>()->bAllowDeltaEncodedPosRep = bPreviousValue;
+		}
+	};
+
+	static FBPVRComponentPosRep MakeRep(EVRPosRepEncoding EncodingMode, const FTransform& Transform)
+	{
+		FBPVRComponentPosRep Rep;
+		Rep.EncodingMode = EncodingMode;
+		Rep.Position = Transform.GetLocation();
+		Rep.Rotation = Transform.Rotator();
+		return Rep;
+	}
+
+	// Sends Rep through the same NetSerialize path the RPCs use, returns the number of bits written
+	static int64 SendRep(FBPVRComponentPosRep& Rep, FBPVRComponentPosRep& OutReceived)
+	{
+		bool bSuccess = true;
+		FNetBitWriter Writer(nullptr, 1024 * 8);
+		Rep.NetSerialize(Writer, nullptr, bSuccess);
+
+		const int64 NumBits = Writer.GetNumBits();
+		FNetBitReader Reader(nullptr, Writer.GetData(), NumBits);
+		OutReceived.NetSerialize(Reader, nullptr, bSuccess);
+		return NumBits;
+	}
+
+	// Whether the decoded transform is what the sender quantized Expected to
+	static bool MatchesQuantized(const FBPVRComponentPosRep& Decoded, const FTransform& Expected)
+	{
+		FBPVRComponentPosRep Sent = MakeRep(EVRPosRepEncoding::Absolute, Expected);
+		FBPVRComponentPosRep Received = Decoded;
+
+		const FVector PositionError = Received.Position - Sent.QuantizePosition(Sent.Position);
+		const FIntVector RotationError = Sent.WrapRotationDelta(Received.QuantizeRotation(Received.Rotation) - Sent.QuantizeRotation(Sent.Rotation));
+
+		return PositionError.GetAbsMax() < 0.5f / Sent.GetPositionScale() && RotationError == FIntVector::ZeroValue;
+	}
+
+	static const TCHAR* GetEncodingName(EVRPosRepEncoding EncodingMode)
+	{
+		switch (EncodingMode)
+		{
+		case EVRPosRepEncoding::DeltaFromKeyframe: return TEXT("DeltaFromKeyframe");
+		case EVRPosRepEncoding::PredictedFromKeyframe: return TEXT("PredictedFromKeyframe");
+		default: return TEXT("Absolute");
+		}
+	}
+}
+
+/**
+ * Replays the motion trace through each encoding mode and reports the bits per update, every update has to decode back to the quantized input.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPosRepEncodingBandwidthTest, "VRExpansionPlugin.PosRepEncoding.Bandwidth", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRPosRepEncodingBandwidthTest::RunTest(const FString& Parameters)
+{
+	using namespace VRPosRepEncodingTests;
+
+	FScopedAllowDeltaEncoding AllowDeltaEncoding(true);
+
+	TArray<FTransform> Trace;
+	BuildMotionTrace(Trace);
+
+	const EVRPosRepEncoding EncodingModes[] = { EVRPosRepEncoding::Absolute, EVRPosRepEncoding::DeltaFromKeyframe, EVRPosRepEncoding::PredictedFromKeyframe };
+
+	double AbsoluteBitsPerUpdate = 0.0;
+	for (EVRPosRepEncoding EncodingMode : EncodingModes)
+	{
+		FBPVRPosRepEncoder Encoder;
+		FBPVRPosRepDecoder Decoder;
+
+		int64 TotalBits = 0;
+		int32 NumKeyframes = 0;
+		int32 NumMismatches = 0;
+
+		for (const FTransform& Transform : Trace)
+		{
+			FBPVRComponentPosRep Rep = MakeRep(EncodingMode, Transform);
+			Encoder.Encode(Rep);
+			NumKeyframes += Rep.bIsKeyframe ? 1 : 0;
+
+			FBPVRComponentPosRep Received;
+			TotalBits += SendRep(Rep, Received);
+
+			if (!Decoder.Decode(Received) || !MatchesQuantized(Received, Transform))
+			{
+				++NumMismatches;
+			}
+		}
+
+		const double BitsPerUpdate = (double)TotalBits / Trace.Num();
+		if (EncodingMode == EVRPosRepEncoding::Absolute)
+		{
+			AbsoluteBitsPerUpdate = BitsPerUpdate;
+		}
+
+		AddInfo(FString::Printf(TEXT("%s: %.2f bits/update (%.1f%% of absolute), %d keyframes over %d updates"),
+			GetEncodingName(EncodingMode), BitsPerUpdate, AbsoluteBitsPerUpdate > 0.0 ? 100.0 * BitsPerUpdate / AbsoluteBitsPerUpdate : 100.0, NumKeyframes, Trace.Num()));
+
+		TestEqual(FString::Printf(TEXT("%s updates decoded to the quantized input"), GetEncodingName(EncodingMode)), NumMismatches, 0);
+
+		if (EncodingMode != EVRPosRepEncoding::Absolute)
+		{
+			TestTrue(FString::Printf(TEXT("%s is smaller than absolute"), GetEncodingName(EncodingMode)), BitsPerUpdate < AbsoluteBitsPerUpdate);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Drops runs of updates including several keyframes in a row, a delta must never resolve against a keyframe other than the one it was encoded from.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPosRepEncodingKeyframeLossTest, "VRExpansionPlugin.PosRepEncoding.KeyframeLoss", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRPosRepEncodingKeyframeLossTest::RunTest(const FString& Parameters)
+{
+	using namespace VRPosRepEncodingTests;
+
+	FScopedAllowDeltaEncoding AllowDeltaEncoding(true);
+
+	TArray<FTransform> Trace;
+	BuildMotionTrace(Trace);
+
+	for (EVRPosRepEncoding EncodingMode : { EVRPosRepEncoding::DeltaFromKeyframe, EVRPosRepEncoding::PredictedFromKeyframe })
+	{
+		// Up to a full cycle of keyframe IDs minus one can go missing while the deltas around them still arrive
+		for (int32 KeyframesToDrop = 1; KeyframesToDrop < FBPVRPosRepDecoder::NumKeyframeIDs; ++KeyframesToDrop)
+		{
+			FBPVRPosRepEncoder Encoder;
+			FBPVRPosRepDecoder Decoder;
+			FRandomStream Random(KeyframesToDrop);
+
+			int32 NumDropped = 0;
+			int32 NumRejected = 0;
+			int32 NumWrong = 0;
+			int32 KeyframesLeftToDrop = 0;
+
+			for (int32 i = 0; i < Trace.Num(); ++i)
+			{
+				FBPVRComponentPosRep Rep = MakeRep(EncodingMode, Trace[i]);
+				Encoder.Encode(Rep);
+
+				// Start a burst of lost keyframes every ten seconds, on top of some general unreliable loss
+				if (i > 0 && i % (UpdateRate * 10) == 0)
+				{
+					KeyframesLeftToDrop = KeyframesToDrop;
+				}
+
+				if (Rep.bIsKeyframe && KeyframesLeftToDrop > 0)
+				{
+					--KeyframesLeftToDrop;
+					++NumDropped;
+					continue;
+				}
+
+				if (Random.FRand() < 0.05f)
+				{
+					++NumDropped;
+					continue;
+				}
+
+				FBPVRComponentPosRep Received;
+				SendRep(Rep, Received);
+
+				if (!Decoder.Decode(Received))
+				{
+					++NumRejected;
+				}
+				else if (!MatchesQuantized(Received, Trace[i]))
+				{
+					++NumWrong;
+				}
+			}
+
+			TestEqual(FString::Printf(TEXT("%s with %d keyframes lost in a row resolved no delta against the wrong keyframe"), GetEncodingName(EncodingMode), KeyframesToDrop), NumWrong, 0);
+			TestTrue(FString::Printf(TEXT("%s with %d keyframes lost in a row rejected the orphaned deltas"), GetEncodingName(EncodingMode), KeyframesToDrop), NumRejected > 0);
+			TestTrue(FString::Printf(TEXT("%s with %d keyframes lost in a row still decoded most updates"), GetEncodingName(EncodingMode), KeyframesToDrop), NumDropped + NumRejected < Trace.Num() / 2);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * With delta encoding disallowed an absolute update has to be exactly the header and payload it was before the delta flag existed,
+ * and the delta modes have to fall back to sending absolute.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRPosRepEncodingAbsoluteSizeTest, "VRExpansionPlugin.PosRepEncoding.AbsoluteSize", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVRPosRepEncodingAbsoluteSizeTest::RunTest(const FString& Parameters)
+{
+	using namespace VRPosRepEncodingTests;
+
+	TArray<FTransform> Trace;
+	BuildMotionTrace(Trace);
+
+	int32 NumWrongSize = 0;
+	int32 NumMismatches = 0;
+	int32 NumDeltasSent = 0;
+
+	for (const FTransform& Transform : Trace)
+	{
+		int64 FlaggedBits = 0;
+		{
+			FScopedAllowDeltaEncoding AllowDeltaEncoding(true);
+			FBPVRComponentPosRep Rep = MakeRep(EVRPosRepEncoding::Absolute, Transform);
+			FBPVRComponentPosRep Received;
+			FlaggedBits = SendRep(Rep, Received);
+		}
+
+		FScopedAllowDeltaEncoding AllowDeltaEncoding(false);
+
+		FBPVRComponentPosRep Rep = MakeRep(EVRPosRepEncoding::Absolute, Transform);
+		FBPVRComponentPosRep Received;
+		if (SendRep(Rep, Received) != FlaggedBits - 1)
+		{
+			++NumWrongSize;
+		}
+
+		if (!MatchesQuantized(Received, Transform))
+		{
+			++NumMismatches;
+		}
+
+		FBPVRPosRepEncoder Encoder;
+		FBPVRComponentPosRep DeltaRep = MakeRep(EVRPosRepEncoding::PredictedFromKeyframe, Transform);
+		Encoder.Encode(DeltaRep);
+		NumDeltasSent += DeltaRep.bIsDelta ? 1 : 0;
+	}
+
+	TestEqual(TEXT("Absolute updates without the delta flag are one bit smaller"), NumWrongSize, 0);
+	TestEqual(TEXT("Absolute updates without the delta flag decoded to the quantized input"), NumMismatches, 0);
+	TestEqual(TEXT("Delta modes send absolute when delta encoding is disallowed"), NumDeltasSent, 0);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -1,6 +1,7 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "VRBPDatatypes.h"
+#include "VRGlobalSettings.h"
 
 namespace VRDataTypeCVARs
 {
@@ -91,51 +92,436 @@ bool FTransform_NetQuantize::NetSerialize(FArchive& Ar, class UPackageMap* Map,
 	return bOutSuccess;
 }
 
-// ** Euro Low Pass Filter ** //
+// ** Component position replication ** //
 
-void FBPEuroLowPassFilter::ResetSmoothingFilter()
+FIntVector FBPVRComponentPosRep::QuantizeRotation(const FRotator& InRotation)
 {
-	RawFilter.bFirstTime = true;
-	DeltaFilter.bFirstTime = true;
+	switch (RotationQuantizationLevel)
+	{
+	case EVRRotationQuantization::RoundTo10Bits:
+	{
+		return FIntVector(
+			CompressAxisTo10BitShort(InRotation.Pitch) & 0x3FF,
+			CompressAxisTo10BitShort(InRotation.Yaw) & 0x3FF,
+			CompressAxisTo10BitShort(InRotation.Roll) & 0x3FF);
+	}break;
+
+	case EVRRotationQuantization::RoundToShort:
+	default:
+	{
+		return FIntVector(
+			FRotator::CompressAxisToShort(InRotation.Pitch),
+			FRotator::CompressAxisToShort(InRotation.Yaw),
+			FRotator::CompressAxisToShort(InRotation.Roll));
+	}break;
+	}
 }
 
-FVector FBPEuroLowPassFilter::RunFilterSmoothing(const FVector &InRawValue, const float &InDeltaTime)
+FRotator FBPVRComponentPosRep::DecompressRotation(const FIntVector& InQuantizedRotation)
 {
-	// Calculate the delta, if this is the first time then there is no delta
-	const FVector Delta = RawFilter.bFirstTime == true ? FVector::ZeroVector : (InRawValue - RawFilter.Previous) * InDeltaTime;
+	switch (RotationQuantizationLevel)
+	{
+	case EVRRotationQuantization::RoundTo10Bits:
+	{
+		return FRotator(
+			DecompressAxisFrom10BitShort(InQuantizedRotation.X & 0x3FF),
+			DecompressAxisFrom10BitShort(InQuantizedRotation.Y & 0x3FF),
+			DecompressAxisFrom10BitShort(InQuantizedRotation.Z & 0x3FF));
+	}break;
 
-	// Filter the delta to get the estimated
-	const FVector Estimated = DeltaFilter.Filter(Delta, FVector(CalculateAlpha(DeltaCutoff, InDeltaTime)));
+	case EVRRotationQuantization::RoundToShort:
+	default:
+	{
+		return FRotator(
+			FRotator::DecompressAxisFromShort(InQuantizedRotation.X & 0xFFFF),
+			FRotator::DecompressAxisFromShort(InQuantizedRotation.Y & 0xFFFF),
+			FRotator::DecompressAxisFromShort(InQuantizedRotation.Z & 0xFFFF));
+	}break;
+	}
+}
 
-	// Use the estimated to calculate the cutoff
-	const FVector Cutoff = CalculateCutoff(Estimated);
+FIntVector FBPVRComponentPosRep::WrapRotationDelta(const FIntVector& InDelta) const
+{
+	const int32 NumValues = RotationQuantizationLevel == EVRRotationQuantization::RoundTo10Bits ? 1024 : 65536;
+	const int32 Mask = NumValues - 1;
+	const int32 HalfRange = NumValues / 2;
 
-	// Filter passed value 
-	return RawFilter.Filter(InRawValue, CalculateAlpha(Cutoff, InDeltaTime));
+	auto WrapAxis = [Mask, NumValues, HalfRange](int32 Delta)
+	{
+		Delta &= Mask;
+		return Delta >= HalfRange ? Delta - NumValues : Delta;
+	};
+
+	return FIntVector(WrapAxis(InDelta.X), WrapAxis(InDelta.Y), WrapAxis(InDelta.Z));
 }
 
-const FVector FBPEuroLowPassFilter::CalculateCutoff(const FVector& InValue)
+bool FBPVRComponentPosRep::SerializePosition(FArchive& Ar, FVector& InOutPosition)
 {
-	FVector Result;
-	for (int i = 0; i < 3; i++)
+	/**
+	*	Valid range 100: 2^22 / 100 = +/- 41,943.04 (419.43 meters)
+	*	Valid range 10: 2^18 / 10 = +/- 26,214.4 (262.144 meters)
+	*	Pos rep is assumed to be in relative space for a tracked component, these numbers should be fine
+	*	The packed vector only sends as many bits per component as the largest component needs, so deltas come out small
+	*/
+	switch (QuantizationLevel)
 	{
-		Result[i] = MinCutoff + CutoffSlope * FMath::Abs(InValue[i]);
+	case EVRVectorQuantization::RoundTwoDecimals: return SerializePackedVector<100, 22/*30*/>(InOutPosition, Ar); break;
+	case EVRVectorQuantization::RoundOneDecimal: return SerializePackedVector<10, 18/*24*/>(InOutPosition, Ar); break;
 	}
-	return Result;
+
+	return false;
 }
 
-const FVector FBPEuroLowPassFilter::CalculateAlpha(const FVector& InCutoff, const double InDeltaTime) const
+void FBPVRComponentPosRep::SerializeRotationDelta(FArchive& Ar, FIntVector& InOutDelta)
 {
-	FVector Result;
-	for (int i = 0; i < 3; i++)
+	// Signed values with a shared bit count, 0 bits if there was no change at all
+	// A wrapped short delta needs at most 17 bits with the sign
+	uint32 NumBits = 0;
+
+	if (Ar.IsSaving())
+	{
+		const int32 MaxAbs = FMath::Max3(FMath::Abs(InOutDelta.X), FMath::Abs(InOutDelta.Y), FMath::Abs(InOutDelta.Z));
+		NumBits = MaxAbs > 0 ? FMath::CeilLogTwo(MaxAbs + 1) + 1 : 0;
+	}
+
+	Ar.SerializeInt(NumBits, 18);
+
+	if (NumBits > 0)
+	{
+		const int32 Bias = 1 << (NumBits - 1);
+		for (int32 i = 0; i < 3; ++i)
+		{
+			uint32 Packed = Ar.IsSaving() ? (uint32)(InOutDelta[i] + Bias) : 0;
+			Ar.SerializeInt(Packed, 1u << NumBits);
+			InOutDelta[i] = (int32)Packed - Bias;
+		}
+	}
+	else
+	{
+		InOutDelta = FIntVector::ZeroValue;
+	}
+}
+
+bool FBPVRComponentPosRep::SerializeAbsolute(FArchive& Ar)
+{
+	bool bOutSuccess = SerializePosition(Ar, Position);
+
+	// No longer using their built in rotation rep, as controllers will rarely if ever be at 0 rot on an axis and 
+	// so the 1 bit overhead per axis is just that, overhead
+	//Rotation.SerializeCompressedShort(Ar);
+
+	uint16 ShortPitch = 0;
+	uint16 ShortYaw = 0;
+	uint16 ShortRoll = 0;
+
+	if (Ar.IsSaving())
+	{
+		switch (RotationQuantizationLevel)
+		{
+		case EVRRotationQuantization::RoundTo10Bits:
+		{
+			ShortPitch = CompressAxisTo10BitShort(Rotation.Pitch);
+			ShortYaw = CompressAxisTo10BitShort(Rotation.Yaw);
+			ShortRoll = CompressAxisTo10BitShort(Rotation.Roll);
+
+			Ar.SerializeBits(&ShortPitch, 10);
+			Ar.SerializeBits(&ShortYaw, 10);
+			Ar.SerializeBits(&ShortRoll, 10);
+		}break;
+
+		case EVRRotationQuantization::RoundToShort:
+		{
+			ShortPitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+			ShortYaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+			ShortRoll = FRotator::CompressAxisToShort(Rotation.Roll);
+
+			Ar << ShortPitch;
+			Ar << ShortYaw;
+			Ar << ShortRoll;
+		}break;
+		}
+	}
+	else // If loading
+	{
+		switch (RotationQuantizationLevel)
+		{
+		case EVRRotationQuantization::RoundTo10Bits:
+		{
+			Ar.SerializeBits(&ShortPitch, 10);
+			Ar.SerializeBits(&ShortYaw, 10);
+			Ar.SerializeBits(&ShortRoll, 10);
+
+			Rotation.Pitch = DecompressAxisFrom10BitShort(ShortPitch);
+			Rotation.Yaw = DecompressAxisFrom10BitShort(ShortYaw);
+			Rotation.Roll = DecompressAxisFrom10BitShort(ShortRoll);
+		}break;
+
+		case EVRRotationQuantization::RoundToShort:
+		{
+			Ar << ShortPitch;
+			Ar << ShortYaw;
+			Ar << ShortRoll;
+
+			Rotation.Pitch = FRotator::DecompressAxisFromShort(ShortPitch);
+			Rotation.Yaw = FRotator::DecompressAxisFromShort(ShortYaw);
+			Rotation.Roll = FRotator::DecompressAxisFromShort(ShortRoll);
+		}break;
+		}
+	}
+
+	return bOutSuccess;
+}
+
+bool FBPVRComponentPosRep::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	// Defines the level of Quantization
+	//uint8 Flags = (uint8)QuantizationLevel;
+	Ar.SerializeBits(&QuantizationLevel, 1); // Only two values 0:1
+	Ar.SerializeBits(&RotationQuantizationLevel, 1); // Only two values 0:1
+
+	// The delta flag is only on the wire when the project allows delta encoding, absolute reps keep their original size otherwise
+	if (GetDefault<UVRGlobalSettings>()->bAllowDeltaEncodedPosRep)
+	{
+		uint8 bDeltaEncoded = bIsDelta;
+		Ar.SerializeBits(&bDeltaEncoded, 1);
+		bIsDelta = !!bDeltaEncoded;
+	}
+	else
+	{
+		bIsDelta = false;
+	}
+
+	if (!bIsDelta)
+	{
+		bOutSuccess &= SerializeAbsolute(Ar);
+		return bOutSuccess;
+	}
+
+	uint8 bKeyframe = bIsKeyframe;
+	uint8 bPredictedUpdate = bPredicted;
+	Ar.SerializeBits(&KeyframeID, 4);
+	Ar.SerializeBits(&bKeyframe, 1);
+	Ar.SerializeBits(&bPredictedUpdate, 1);
+	bIsKeyframe = !!bKeyframe;
+	bPredicted = !!bPredictedUpdate;
+
+	if (bIsKeyframe)
+	{
+		bOutSuccess &= SerializeAbsolute(Ar);
+
+		if (bPredicted)
+		{
+			bOutSuccess &= SerializePosition(Ar, KeyframeVelocity);
+			SerializeRotationDelta(Ar, KeyframeRotationVelocity);
+		}
+	}
+	else
+	{
+		if (bPredicted)
+		{
+			Ar.SerializeBits(&UpdatesSinceKeyframe, 6);
+		}
+
+		bOutSuccess &= SerializePosition(Ar, Position);
+		SerializeRotationDelta(Ar, RotationDelta);
+	}
+
+	return bOutSuccess;
+}
+
+namespace VRPosRepEncoding
+{
+	// Matches the per component bit count that WritePackedVector will pick for the value
+	FORCEINLINE uint32 GetPackedVectorBits(const FVector& Value, float Scale)
+	{
+		const int32 MaxAbs = FMath::Max3(FMath::Abs(FMath::RoundToInt(Value.X * Scale)), FMath::Abs(FMath::RoundToInt(Value.Y * Scale)), FMath::Abs(FMath::RoundToInt(Value.Z * Scale)));
+		return FMath::CeilLogTwo(1 + MaxAbs);
+	}
+}
+
+void FBPVRPosRepEncoder::Reset()
+{
+	bHasKeyframe = false;
+	KeyframeID = 0;
+	UpdatesSinceKeyframe = 0;
+	KeyframePosition = FVector::ZeroVector;
+	KeyframeRotation = FIntVector::ZeroValue;
+	KeyframeVelocity = FVector::ZeroVector;
+	KeyframeRotationVelocity = FIntVector::ZeroValue;
+
+	bHasLastUpdate = false;
+	LastPosition = FVector::ZeroVector;
+	LastRotation = FIntVector::ZeroValue;
+}
+
+void FBPVRPosRepEncoder::Encode(FBPVRComponentPosRep& InOutRep)
+{
+	if (InOutRep.EncodingMode == EVRPosRepEncoding::Absolute || !GetDefault<UVRGlobalSettings>()->bAllowDeltaEncodedPosRep)
+	{
+		InOutRep.bIsDelta = false;
+		return;
+	}
+
+	const bool bPredict = InOutRep.EncodingMode == EVRPosRepEncoding::PredictedFromKeyframe;
+
+	// Work off of the values that the receiver will actually decode so that both ends share the same reference
+	const FVector QuantizedPosition = InOutRep.QuantizePosition(InOutRep.Position);
+	const FIntVector QuantizedRotation = InOutRep.QuantizeRotation(InOutRep.Rotation);
+
+	InOutRep.bIsDelta = true;
+	InOutRep.bPredicted = bPredict;
+
+	bool bSendKeyframe = !bHasKeyframe || (UpdatesSinceKeyframe + 1) >= FMath::Clamp<uint8>(InOutRep.KeyframeInterval, 1, 63);
+
+	FVector PositionDelta = FVector::ZeroVector;
+	FIntVector RotationDelta = FIntVector::ZeroValue;
+	const uint8 NextUpdate = UpdatesSinceKeyframe + 1;
+
+	if (!bSendKeyframe)
+	{
+		FVector ReferencePosition = KeyframePosition;
+		FIntVector ReferenceRotation = KeyframeRotation;
+
+		if (bPredict)
+		{
+			ReferencePosition += KeyframeVelocity * NextUpdate;
+			ReferenceRotation += KeyframeRotationVelocity * NextUpdate;
+		}
+
+		PositionDelta = InOutRep.QuantizePosition(QuantizedPosition - ReferencePosition);
+		RotationDelta = InOutRep.WrapRotationDelta(QuantizedRotation - ReferenceRotation);
+
+		// Teleports or large prediction misses, a keyframe is cheaper and resets the reference
+		const float Scale = InOutRep.GetPositionScale();
+		if (VRPosRepEncoding::GetPackedVectorBits(PositionDelta, Scale) >= VRPosRepEncoding::GetPackedVectorBits(QuantizedPosition, Scale))
+		{
+			bSendKeyframe = true;
+		}
+	}
+
+	if (bSendKeyframe)
+	{
+		KeyframeID = bHasKeyframe ? ((KeyframeID + 1) % FBPVRPosRepDecoder::NumKeyframeIDs) : 0;
+		UpdatesSinceKeyframe = 0;
+		bHasKeyframe = true;
+
+		if (bPredict && bHasLastUpdate)
+		{
+			KeyframeVelocity = InOutRep.QuantizePosition(QuantizedPosition - LastPosition);
+			KeyframeRotationVelocity = InOutRep.WrapRotationDelta(QuantizedRotation - LastRotation);
+		}
+		else
+		{
+			KeyframeVelocity = FVector::ZeroVector;
+			KeyframeRotationVelocity = FIntVector::ZeroValue;
+		}
+
+		KeyframePosition = QuantizedPosition;
+		KeyframeRotation = QuantizedRotation;
+
+		InOutRep.bIsKeyframe = true;
+		InOutRep.Position = QuantizedPosition;
+		InOutRep.KeyframeVelocity = KeyframeVelocity;
+		InOutRep.KeyframeRotationVelocity = KeyframeRotationVelocity;
+	}
+	else
+	{
+		UpdatesSinceKeyframe = NextUpdate;
+
+		InOutRep.bIsKeyframe = false;
+		InOutRep.Position = PositionDelta;
+		InOutRep.RotationDelta = RotationDelta;
+	}
+
+	InOutRep.KeyframeID = KeyframeID;
+	InOutRep.UpdatesSinceKeyframe = UpdatesSinceKeyframe;
+
+	LastPosition = QuantizedPosition;
+	LastRotation = QuantizedRotation;
+	bHasLastUpdate = true;
+}
+
+void FBPVRPosRepDecoder::Reset()
+{
+	KeyframePosition = FVector::ZeroVector;
+	KeyframeRotation = FIntVector::ZeroValue;
+	KeyframeVelocity = FVector::ZeroVector;
+	KeyframeRotationVelocity = FIntVector::ZeroValue;
+	KeyframeID = 0;
+	bHasKeyframe = false;
+}
+
+bool FBPVRPosRepDecoder::Decode(FBPVRComponentPosRep& InOutRep)
+{
+	if (!InOutRep.bIsDelta)
+		return true;
+
+	if (InOutRep.bIsKeyframe)
+	{
+		// Replacing the keyframe drops every older one, deltas against a lost keyframe then fail the ID check below
+		KeyframePosition = InOutRep.Position;
+		KeyframeRotation = InOutRep.QuantizeRotation(InOutRep.Rotation);
+		KeyframeVelocity = InOutRep.bPredicted ? InOutRep.KeyframeVelocity : FVector::ZeroVector;
+		KeyframeRotationVelocity = InOutRep.bPredicted ? InOutRep.KeyframeRotationVelocity : FIntVector::ZeroValue;
+		KeyframeID = InOutRep.KeyframeID;
+		bHasKeyframe = true;
+	}
+	else
+	{
+		if (!bHasKeyframe || InOutRep.KeyframeID != KeyframeID)
+			return false;
+
+		const int32 NumPredictedUpdates = InOutRep.bPredicted ? InOutRep.UpdatesSinceKeyframe : 0;
+
+		InOutRep.Position = KeyframePosition + (KeyframeVelocity * NumPredictedUpdates) + InOutRep.Position;
+		InOutRep.Rotation = InOutRep.DecompressRotation(KeyframeRotation + (KeyframeRotationVelocity * NumPredictedUpdates) + InOutRep.RotationDelta);
+	}
+
+	// Everything past here treats this as a normal absolute transform (the server replicates it on in that form)
+	InOutRep.bIsDelta = false;
+	InOutRep.bIsKeyframe = false;
+	InOutRep.bPredicted = false;
+	return true;
+}
+
+// ** Euro Low Pass Filter ** //
+
+void FBPEuroLowPassFilter::ResetSmoothingFilter()
+{
+	RawFilter.bFirstTime = true;
+	DeltaFilter.bFirstTime = true;
+}
+
+FVector FBPEuroLowPassFilter::RunFilterSmoothing(const FVector &InRawValue, const float &InDeltaTime)
+{
+	// All three axes are filtered at once
+	const VectorRegister RawValue = VectorLoadFloat3(&InRawValue);
+	const VectorRegister TwoPiDeltaTime = VectorSetFloat1(2.0f * PI * InDeltaTime);
+
+	// Calculate the delta, if this is the first time then there is no delta
+	VectorRegister Delta = GlobalVectorConstants::FloatZero;
+	if (!RawFilter.bFirstTime)
 	{
-		Result[i] = CalculateAlpha(InCutoff[i], InDeltaTime);
+		Delta = VectorMultiply(VectorSubtract(RawValue, VectorLoadFloat3(&RawFilter.Previous)), VectorSetFloat1(InDeltaTime));
 	}
+
+	// Filter the delta to get the estimated
+	const VectorRegister Estimated = DeltaFilter.Filter(Delta, CalculateAlpha(VectorSetFloat1(DeltaCutoff), TwoPiDeltaTime));
+
+	// Use the estimated to calculate the cutoff
+	const VectorRegister Cutoff = VectorMultiplyAdd(VectorSetFloat1(CutoffSlope), VectorAbs(Estimated), VectorSetFloat1(MinCutoff));
+
+	// Filter passed value 
+	FVector Result;
+	VectorStoreFloat3(RawFilter.Filter(RawValue, CalculateAlpha(Cutoff, TwoPiDeltaTime)), &Result);
 	return Result;
 }
 
-const float FBPEuroLowPassFilter::CalculateAlpha(const float InCutoff, const double InDeltaTime) const
+VectorRegister FBPEuroLowPassFilter::CalculateAlpha(const VectorRegister& InCutoff, const VectorRegister& InTwoPiDeltaTime)
 {
-	const float tau = 1.0 / (2 * PI * InCutoff);
-	return 1.0 / (1.0 + tau / InDeltaTime);
+	// 1 / (1 + tau / DeltaTime) with tau = 1 / (2 * PI * Cutoff), without the divisions by the cutoff and delta time
+	const VectorRegister Scaled = VectorMultiply(InCutoff, InTwoPiDeltaTime);
+	return VectorDivide(Scaled, VectorAdd(Scaled, GlobalVectorConstants::FloatOne));
 }
\ No newline at end of file
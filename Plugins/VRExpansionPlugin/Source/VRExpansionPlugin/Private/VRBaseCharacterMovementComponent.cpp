@@ -36,6 +36,7 @@ UVRBaseCharacterMovementComponent::UVRBaseCharacterMovementComponent(const FObje
 	bApplyAdditionalVRInputVectorAsNegative = true;
 	bHadExtremeInput = false;
 	bHoldPositionOnTrackingLossThresholdHit = false;
+	VRMoveCombineTolerance = 0.05f;
 
 	VRClimbingStepHeight = 96.0f;
 	VRClimbingEdgeRejectDistance = 5.0f;
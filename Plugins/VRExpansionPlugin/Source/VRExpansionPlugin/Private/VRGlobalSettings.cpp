@@ -4,6 +4,16 @@
 UVRGlobalSettings::UVRGlobalSettings(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer),
 	MaxCCDPasses(1),
+	bUsePhysicsReplicationBuffer(true),
+	PhysicsReplicationBufferSize(16),
+	PhysicsReplicationRenderDelay(0.05f),
+	PhysicsReplicationMaxExtrapolation(0.25f),
+	PhysicsReplicationMinCorrectionError(0.5f),
+	PhysicsReplicationMinCorrectionAngle(1.0f),
+	PhysicsReplicationFullCorrectionError(10.0f),
+	PhysicsReplicationMinCorrectionStrength(0.25f),
+	bAllowDeltaEncodedPosRep(false),
+	bUseInteractibleTickSubsystem(true),
 	OneEuroMinCutoff(2.0f),
 	OneEuroCutoffSlope(0.007f),
 	OneEuroDeltaCutoff(1.0f),
@@ -542,6 +542,10 @@ public:
 	virtual uint8 GetCompressedFlags() const override;
 	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* Character, float MaxDelta) const override;
 	virtual bool IsImportantMove(const FSavedMovePtr& LastAckedMove) const override;
+
+	// Returns true if two consecutive HMD deltas can be sent as their sum without deviating from the original path by more than Tolerance
+	// DotThreshold is the direction check used when neither delta is within tolerance (AccelDotThresholdCombine)
+	static bool CanCombineVRDeltas(const FVector2D& OldDelta, const FVector2D& NewDelta, float DotThreshold, float Tolerance);
 };
 
 // Using this fixes the problem where the character capsule isn't reset after a scoped movement update revert (pretty much just in StepUp operations)
@@ -574,6 +578,9 @@ public:
 	virtual ~FVRCharacterNetworkMoveData();
 	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
 	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+
+	// Packs LFDiff as an X/Y HMD delta plus an optional capsule half height
+	void SerializeLFDiff(FArchive& Ar);
 };
 
 struct VREXPANSIONPLUGIN_API FVRCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
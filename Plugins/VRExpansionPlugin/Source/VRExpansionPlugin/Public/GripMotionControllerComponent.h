@@ -702,6 +702,10 @@ public:
 	// Used in Tick() to accumulate before sending updates, didn't want to use a timer in this case, also used for remotes to lerp position
 	float ControllerNetUpdateCount;
 
+	// Delta encoding state for the transform RPCs, see EncodingMode on ReplicatedControllerTransform
+	FBPVRPosRepEncoder ControllerTransformEncoder;
+	FBPVRPosRepDecoder ControllerTransformDecoder;
+
 	// Whether to smooth (lerp) between ticks for the replicated motion, DOES NOTHING if update rate is larger than FPS!
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "GripMotionController|Networking")
 		bool bSmoothReplicatedMotion;
@@ -39,6 +39,37 @@
 
 //#if PHYSICS_INTERFACE_PHYSX
 
+DECLARE_STATS_GROUP(TEXT("VRPhysicsReplication"), STATGROUP_VRPhysicsReplication, STATCAT_Advanced);
+
+// A received physics state and the (server) time it is estimated to have been generated at
+struct FVRBufferedPhysicsState
+{
+	float Timestamp;
+	FRigidBodyState State;
+};
+
+// Timestamped history of the states received for a single replicated object, oldest first
+struct FVRPhysicsStateBuffer
+{
+	TArray<FVRBufferedPhysicsState> States;
+
+	// Arrival time of the last state added, used to detect when the target was updated
+	float LastArrivedTimeSeconds;
+
+	FVRPhysicsStateBuffer() :
+		LastArrivedTimeSeconds(-1.0f)
+	{}
+
+	void AddState(float Timestamp, const FRigidBodyState& State, int32 MaxStates);
+
+	// Samples the buffer at SampleTime, interpolating between the states that surround it or extrapolating
+	// from the newest one (by at most MaxExtrapolation seconds). Returns true if the result was extrapolated.
+	bool Sample(float SampleTime, float MaxExtrapolation, FRigidBodyState& OutState) const;
+
+	static void InterpolateState(const FRigidBodyState& From, const FRigidBodyState& To, float Alpha, FRigidBodyState& OutState);
+	static void ExtrapolateState(const FRigidBodyState& From, float Seconds, FRigidBodyState& OutState);
+};
+
 class FPhysicsReplicationVR : public FPhysicsReplication
 {
 public:
@@ -47,6 +78,20 @@ public:
 	static bool IsInitialized();
 
 	virtual void OnTick(float DeltaSeconds, TMap<TWeakObjectPtr<UPrimitiveComponent>, FReplicatedPhysicsTarget>& ComponentsToTargets) override;
+
+	// Returns the round trip time (in ms) to the player that owns the actor, 0 if it is locally owned
+	static float GetOwningPlayerPing(const AActor* OwningActor);
+
+	// Scales the error correction by how far CurrentState is from TargetState, returns false if it is within the dead zone
+	static bool GetScaledErrorCorrection(const FRigidBodyState& CurrentState, const FRigidBodyState& TargetState, const FRigidBodyErrorCorrection& BaseCorrection, const UVRGlobalSettings& VRSettings, FRigidBodyErrorCorrection& OutCorrection);
+
+private:
+
+	// Received state history per replicated object, only used if bUsePhysicsReplicationBuffer is enabled
+	TMap<TWeakObjectPtr<UPrimitiveComponent>, FVRPhysicsStateBuffer> StateBuffers;
+
+	// Scales the error correction by how far the body currently is from its target, returns false if it is within the dead zone
+	static bool GetScaledErrorCorrection(const FBodyInstance* BI, const FRigidBodyState& TargetState, const FRigidBodyErrorCorrection& BaseCorrection, const UVRGlobalSettings& VRSettings, FRigidBodyErrorCorrection& OutCorrection);
 };
 
 class IPhysicsReplicationFactoryVR : public IPhysicsReplicationFactory
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "VRInteractibleTickSubsystem.generated.h"
+
+DECLARE_STATS_GROUP(TEXT("VRInteractibles"), STATGROUP_VRInteractibles, STATCAT_Advanced);
+
+class UVRInteractibleTickSubsystem;
+
+/**
+* Tick function that updates the active interactibles in a single batch. This executes in PrePhysics.
+**/
+USTRUCT()
+struct FVRInteractibleBatchTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+		UVRInteractibleTickSubsystem* Target;
+
+	/**
+	* Abstract function to execute the tick.
+	* @param DeltaTime - frame time to advance, in seconds.
+	* @param TickType - kind of tick for this frame.
+	* @param CurrentThread - thread we are executing on, useful to pass along as new tasks are created.
+	* @param MyCompletionGraphEvent - completion event for this task. Useful for holding the completetion of this task until certain child tasks are complete.
+	*/
+	virtual void ExecuteTick(float DeltaTime, enum ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	/** Abstract function to describe this tick. Used to print messages about illegal cycles in the dependency graph. */
+	virtual FString DiagnosticMessage() override;
+	/** Function used to describe this tick for active tick reporting. **/
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FVRInteractibleBatchTickFunction> : public TStructOpsTypeTraitsBase2<FVRInteractibleBatchTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+// Batches the updates of the interactible components (levers, dials, sliders, buttons and mounts).
+// Interactibles register on BeginPlay, after which turning their "tick" on and off only moves them in and out of
+// the active list (held, lerping or carrying momentum) instead of registering / unregistering a component tick function.
+// The active list is then updated in a single loop each frame by a PrePhysics tick function.
+// The tick prerequisites of the active interactibles (the grip controllers holding them) are copied to the batch tick function,
+// so held interactibles still update after the controllers that move them.
+// Can be disabled with bUseInteractibleTickSubsystem in the VRGlobalSettings, interactibles will then tick themselves again.
+UCLASS()
+class VREXPANSIONPLUGIN_API UVRInteractibleTickSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UVRInteractibleTickSubsystem() :
+		Super(),
+		bIsTickingInteractibles(false),
+		bNeedsCompaction(false),
+		bPrerequisitesDirty(false)
+	{
+		BatchTickFunction.TickGroup = TG_PrePhysics;
+		BatchTickFunction.bCanEverTick = true;
+		BatchTickFunction.bStartWithTickEnabled = false;
+		BatchTickFunction.Target = this;
+	}
+
+	// Registers the interactible with its worlds subsystem, does nothing if the subsystem is disabled in the global settings
+	static void RegisterInteractible(UActorComponent* Interactible);
+
+	// Removes the interactible from its worlds subsystem
+	static void UnregisterInteractible(UActorComponent* Interactible);
+
+	// Replacement for SetComponentTickEnabled in the interactibles, if the interactible is registered with the subsystem then
+	// this toggles it in the active list, otherwise it falls back to toggling the components own tick function.
+	static void SetInteractibleTickEnabled(UActorComponent* Interactible, bool bEnabled);
+
+	bool AddInteractible(UActorComponent* Interactible);
+	bool RemoveInteractible(UActorComponent* Interactible);
+	void SetInteractibleActive(UActorComponent* Interactible, bool bActive);
+
+	bool IsInteractibleRegistered(const UActorComponent* Interactible) const;
+	bool IsInteractibleActive(const UActorComponent* Interactible) const;
+
+	// Returns the number of interactibles registered with the subsystem
+	UFUNCTION(BlueprintPure, Category = "VRInteractibleTickSubsystem")
+		int32 GetNumRegisteredInteractibles() const;
+
+	// Returns the number of interactibles currently being updated (held, lerping or carrying momentum)
+	UFUNCTION(BlueprintPure, Category = "VRInteractibleTickSubsystem")
+		int32 GetNumActiveInteractibles() const;
+
+	virtual void Deinitialize() override;
+
+	// Updates the active interactibles, called by the batch tick function
+	void TickInteractibles(float DeltaTime);
+
+private:
+
+	FVRInteractibleBatchTickFunction BatchTickFunction;
+
+	// Registered interactibles and their index in ActiveInteractibles, INDEX_NONE if they are currently settled
+	// Weak so that an interactible destroyed without un-registering can't be mistaken for a new one at the same address
+	TMap<TWeakObjectPtr<UActorComponent>, int32> RegisteredInteractibles;
+
+	// Dense list of the interactibles to update this frame
+	UPROPERTY()
+		TArray<UActorComponent*> ActiveInteractibles;
+
+	// Set while looping the active list, removals are deferred until the loop is finished
+	bool bIsTickingInteractibles;
+	bool bNeedsCompaction;
+
+	// Set when the active list changed, the batch tick function prerequisites are rebuilt outside of the loop
+	bool bPrerequisitesDirty;
+
+	// Prerequisites copied from the active interactibles, so that they can be removed again once the interactibles settle
+	TArray<FTickPrerequisite> BatchPrerequisites;
+
+	void RegisterBatchTickFunction();
+	void UpdateBatchTickFunction();
+	void CompactActiveInteractibles();
+	void PruneRegisteredInteractibles();
+	void UpdateStats() const;
+};
@@ -22,9 +22,21 @@ enum class EBPVRConsoleDrawType : uint8
 };
 
 
+UENUM(BlueprintType)
+enum class EBPVRLogVerbosity : uint8
+{
+	VRLog_Error,
+	VRLog_Warning,
+	VRLog_Display,
+	VRLog_Log,
+	VRLog_Verbose,
+	VRLog_All
+};
+
 /**
 * A single log message for the output log, holding a message and
 * a style, for color and bolding of the message.
+* Messages are already hard wrapped when captured, so each one is a single drawn line.
 */
 struct FVRLogMessage
 {
@@ -33,12 +45,17 @@ struct FVRLogMessage
 	FName Category;
 	FName Style;
 
+	// Cached at capture so that drawing doesn't have to rebuild them every redraw
+	FText DisplayText;
+	FLinearColor DisplayColor;
+
 	FVRLogMessage(const TSharedRef<FString>& NewMessage, FName NewCategory, FName NewStyle = NAME_None)
 		: Message(NewMessage)
 		, Verbosity(ELogVerbosity::Log)
 		, Category(NewCategory)
 		, Style(NewStyle)
 	{
+		CacheDisplayValues();
 	}
 
 	FVRLogMessage(const TSharedRef<FString>& NewMessage, ELogVerbosity::Type NewVerbosity, FName NewCategory, FName NewStyle = NAME_None)
@@ -47,11 +64,28 @@ struct FVRLogMessage
 		, Category(NewCategory)
 		, Style(NewStyle)
 	{
+		CacheDisplayValues();
+	}
+
+	void CacheDisplayValues()
+	{
+		DisplayText = FText::FromString(*Message);
+
+		switch (Verbosity)
+		{
+		case ELogVerbosity::Error:
+		case ELogVerbosity::Fatal: DisplayColor = FLinearColor(0.7f, 0.1f, 0.1f); break;
+		case ELogVerbosity::Warning: DisplayColor = FLinearColor(0.5f, 0.5f, 0.0f); break;
+
+		case ELogVerbosity::Log:
+		default: DisplayColor = FLinearColor(0.8f, 0.8f, 0.8f);
+		}
 	}
 };
 
 // Custom Log output history class to hold the VR logs.
 /** This class is to capture all log output even if the log window is closed */
+// Messages are stored in a fixed capacity ring buffer, filtering by verbosity / category is done on capture.
 class FVROutputLogHistory : public FOutputDevice
 {
 public:
@@ -60,11 +94,21 @@ public:
 	bool bIsDirty;
 	int32 MaxLineLength;
 
+	// Messages more verbose than this are not captured
+	ELogVerbosity::Type MaxCapturedVerbosity;
+
+	// Categories that are not captured
+	TSet<FName> ExcludedCategories;
+
 	FVROutputLogHistory()
 	{
 		MaxLineLength = 130;
 		bIsDirty = false;
 		MaxStoredMessages = 1000;
+		MaxCapturedVerbosity = ELogVerbosity::All;
+		WriteIndex = 0;
+		NumMessages = 0;
+		TotalMessagesAdded = 0;
 		GLog->AddOutputDevice(this);
 		GLog->SerializeBacklog(this);
 	}
@@ -78,115 +122,61 @@ public:
 		}
 	}
 
-	/** Gets all captured messages */
-	const TArray< TSharedPtr<FVRLogMessage> >& GetMessages() const
+	// Resizes the ring buffer, keeping the newest messages
+	void SetMaxStoredMessages(int32 NewMaxStoredMessages);
+
+	/** Gets the number of currently stored messages */
+	int32 Num() const
 	{
-		return Messages;
+		return NumMessages;
 	}
+
+	/** Gets a stored message, 0 being the newest */
+	const TSharedPtr<FVRLogMessage>& GetMessageFromNewest(int32 Index) const
+	{
+		check(Index >= 0 && Index < NumMessages);
+		return Messages[(WriteIndex - 1 - Index + Messages.Num()) % Messages.Num()];
+	}
+
+	/** Total number of messages ever captured, changes whenever the stored messages do */
+	uint64 GetTotalMessagesAdded() const
+	{
+		return TotalMessagesAdded;
+	}
+
+	/** Number of currently stored messages for the category */
+	int32 GetNumMessagesInCategory(FName Category) const
+	{
+		const int32* Count = CategoryCounts.Find(Category);
+		return Count ? *Count : 0;
+	}
+
+	void Empty();
 
 protected:
 
 	virtual void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const class FName& Category) override
 	{
 		// Capture all incoming messages and store them in history
-		CreateLogMessages(V, Verbosity, Category, Messages);
+		CreateLogMessages(V, Verbosity, Category);
 	}
 
-	bool CreateLogMessages(const TCHAR* V, ELogVerbosity::Type Verbosity, const class FName& Category, TArray< TSharedPtr<FVRLogMessage> >& OutMessages)
-	{
-		if (Verbosity == ELogVerbosity::SetColor)
-		{
-			// Skip Color Events
-			return false;
-		}
-		else
-		{
-			FName Style;
-			if (Category == NAME_Cmd)
-			{
-				Style = FName(TEXT("Log.Command"));
-			}
-			else if (Verbosity == ELogVerbosity::Error)
-			{
-				Style = FName(TEXT("Log.Error"));
-			}
-			else if (Verbosity == ELogVerbosity::Warning)
-			{
-				Style = FName(TEXT("Log.Warning"));
-			}
-			else
-			{
-				Style = FName(TEXT("Log.Normal"));
-			}
-
-			// Forget timestamps, I don't care about them and we have limited texture space to draw too
-			// Determine how to format timestamps
-			static ELogTimes::Type LogTimestampMode = ELogTimes::None;
-			/*if (UObjectInitialized() && !GExitPurge)
-			{
-			// Logging can happen very late during shutdown, even after the UObject system has been torn down, hence the init check above
-			LogTimestampMode = GetDefault<UEditorStyleSettings>()->LogTimestampMode;
-			}*/
-
-			const int32 OldNumMessages = OutMessages.Num();
-
-			// handle multiline strings by breaking them apart by line
-			TArray<FTextRange> LineRanges;
-			FString CurrentLogDump = V;
-			FTextRange::CalculateLineRangesFromString(CurrentLogDump, LineRanges);
-
-			bool bIsFirstLineInMessage = true;
-			for (const FTextRange& LineRange : LineRanges)
-			{
-				if (!LineRange.IsEmpty())
-				{
-					FString Line = CurrentLogDump.Mid(LineRange.BeginIndex, LineRange.Len());
-					Line = Line.ConvertTabsToSpaces(4);
-
-					// Hard-wrap lines to avoid them being too long
-					/*static const */int32 HardWrapLen = MaxLineLength;
-					for (int32 CurrentStartIndex = 0; CurrentStartIndex < Line.Len();)
-					{
-						int32 HardWrapLineLen = 0;
-						if (bIsFirstLineInMessage)
-						{
-							FString MessagePrefix = FOutputDeviceHelper::FormatLogLine(Verbosity, Category, nullptr, LogTimestampMode);
-
-							HardWrapLineLen = FMath::Min(HardWrapLen - MessagePrefix.Len(), Line.Len() - CurrentStartIndex);
-							FString HardWrapLine = Line.Mid(CurrentStartIndex, HardWrapLineLen);
-
-							OutMessages.Add(MakeShareable(new FVRLogMessage(MakeShareable(new FString(MessagePrefix + HardWrapLine)), Verbosity, Category, Style)));
-						}
-						else
-						{
-							HardWrapLineLen = FMath::Min(HardWrapLen, Line.Len() - CurrentStartIndex);
-							FString HardWrapLine = Line.Mid(CurrentStartIndex, HardWrapLineLen);
-
-							OutMessages.Add(MakeShareable(new FVRLogMessage(MakeShareable(new FString(MoveTemp(HardWrapLine))), Verbosity, Category, Style)));
-						}
-
-						bIsFirstLineInMessage = false;
-						CurrentStartIndex += HardWrapLineLen;
-					}
-				}
-			}
-
-			int numMessages = OutMessages.Num();
-			if (numMessages > MaxStoredMessages)
-			{
-				OutMessages.RemoveAt(0, numMessages - MaxStoredMessages, true);
-			}
-			if (OldNumMessages != numMessages)
-				bIsDirty = true;
-
-			return OldNumMessages != numMessages;//OutMessages.Num();
-		}
-	}
+	bool CreateLogMessages(const TCHAR* V, ELogVerbosity::Type Verbosity, const class FName& Category);
+
+	void AddMessage(TSharedPtr<FVRLogMessage>&& NewMessage);
 
 private:
 
-	/** All log messages since this module has been started */
+	/** Ring buffer of the last MaxStoredMessages log lines */
 	TArray< TSharedPtr<FVRLogMessage> > Messages;
+
+	// Slot the next message will be written to, and how many slots are filled
+	int32 WriteIndex;
+	int32 NumMessages;
+	uint64 TotalMessagesAdded;
+
+	// Stored message count per category
+	TMap<FName, int32> CategoryCounts;
 };
 
 /**
@@ -209,8 +199,9 @@ public:
 	virtual void PostInitProperties() override
 	{
 		Super::PostInitProperties();
-		OutputLogHistory.MaxStoredMessages = FMath::Clamp(MaxStoredMessages, 100, 100000);
+		OutputLogHistory.SetMaxStoredMessages(FMath::Clamp(MaxStoredMessages, 100, 100000));
 		OutputLogHistory.MaxLineLength = FMath::Clamp(MaxLineLength, 50, 1000);
+		SetLogCaptureFilter(MaxCapturedVerbosity, ExcludedCategories);
 	}
 
 	UPROPERTY(BlueprintReadWrite,EditAnywhere, Category = "VRLogComponent|Console")
@@ -219,6 +210,18 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "VRLogComponent|Console")
 		int32 MaxStoredMessages;
 
+	// Messages more verbose than this are not captured into the output log
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "VRLogComponent|Console")
+		EBPVRLogVerbosity MaxCapturedVerbosity;
+
+	// Log categories that are not captured into the output log
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "VRLogComponent|Console")
+		TArray<FName> ExcludedCategories;
+
+	// Sets which messages are captured into the output log from now on, already stored messages are kept
+	UFUNCTION(BlueprintCallable, Category = "VRLogComponent|Console")
+		void SetLogCaptureFilter(EBPVRLogVerbosity NewMaxCapturedVerbosity, const TArray<FName>& NewExcludedCategories);
+
 	// Sets the console input text, can be used to clear the console or enter full or partial commands
 	UFUNCTION(BlueprintCallable, Category = "VRLogComponent|Console", meta = (bIgnoreSelf = "true"))
 		void SetConsoleText(FString Text);
@@ -239,4 +242,12 @@ public:
 	void DrawConsole(bool bLowerHalfOnly, UCanvas* Canvas);
 	void DrawOutputLog(bool bUpperHalfOnly, UCanvas* Canvas, float ScrollOffset);
 
+private:
+
+	// What the output log was last drawn with, it is only redrawn when one of these or the stored messages change
+	int32 LastDrawnScrollPos;
+	TWeakObjectPtr<UTextureRenderTarget2D> LastDrawnTexture;
+
+	int32 GetOutputLogScrollPos(float ScrollOffset) const;
+
 };
\ No newline at end of file
@@ -97,6 +97,10 @@ public:
 	// Used in Tick() to accumulate before sending updates, didn't want to use a timer in this case.
 	float NetUpdateCount;
 
+	// Delta encoding state for the transform RPCs, see EncodingMode on ReplicatedCameraTransform
+	FBPVRPosRepEncoder CameraTransformEncoder;
+	FBPVRPosRepDecoder CameraTransformDecoder;
+
 	// I'm sending it unreliable because it is being resent pretty often
 	UFUNCTION(Unreliable, Server, WithValidation)
 	void Server_SendCameraTransform(FBPVRComponentPosRep NewTransform);
@@ -144,6 +144,21 @@ public:
 		return Result;
 	}
 
+	/** Calculate all three axes at once */
+	VectorRegister Filter(const VectorRegister& InValue, const VectorRegister& InAlpha)
+	{
+		VectorRegister Result = InValue;
+		if (!bFirstTime)
+		{
+			const VectorRegister PreviousValue = VectorLoadFloat3(&Previous);
+			Result = VectorMultiplyAdd(InAlpha, VectorSubtract(InValue, PreviousValue), PreviousValue);
+		}
+
+		bFirstTime = false;
+		VectorStoreFloat3(Result, &Previous);
+		return Result;
+	}
+
 	/** The previous filtered value */
 	FVector Previous;
 
@@ -196,9 +211,7 @@ public:
 
 private:
 
-	const FVector CalculateCutoff(const FVector& InValue);
-	const FVector CalculateAlpha(const FVector& InCutoff, const double InDeltaTime) const;
-	const float CalculateAlpha(const float InCutoff, const double InDeltaTime) const;
+	static VectorRegister CalculateAlpha(const VectorRegister& InCutoff, const VectorRegister& InTwoPiDeltaTime);
 
 	FBasicLowPassFilter RawFilter;
 	FBasicLowPassFilter DeltaFilter;
@@ -230,7 +243,10 @@ public:
 	/** Default constructor */
 	FBPLowPassPeakFilter() :
 		VelocitySamples(30),
-		VelocitySampleLogCounter(0)
+		VelocitySampleLogCounter(0),
+		PeakSampleCount(0),
+		PeakQueueHead(0),
+		PeakQueueNum(0)
 	{}
 
 	// This is the number of samples to keep active
@@ -245,6 +261,7 @@ public:
 	void Reset()
 	{
 		VelocitySampleLog.Reset(VelocitySamples);
+		PeakQueueNum = 0;
 	}
 
 	void AddSample(FVector NewSample)
@@ -257,9 +274,14 @@ public:
 			VelocitySampleLog.Reset(VelocitySamples);
 			VelocitySampleLog.AddZeroed(VelocitySamples);
 			VelocitySampleLogCounter = 0;
+
+			PeakQueue.SetNumUninitialized(VelocitySamples);
+			PeakQueueHead = 0;
+			PeakQueueNum = 0;
 		}
 
 		VelocitySampleLog[VelocitySampleLogCounter] = NewSample;
+		PushPeakSample(VelocitySampleLogCounter, NewSample.SizeSquared());
 		++VelocitySampleLogCounter;
 
 		if (VelocitySampleLogCounter >= VelocitySamples)
@@ -268,21 +290,58 @@ public:
 
 	FVector GetPeak() const
 	{
-		FVector MaxValue = FVector::ZeroVector;
-		float ValueSizeSq = 0.f;
-		float CurSizeSq = 0.f;
+		// The front of the queue is always the largest sample still in the log, the newest one if several are equally large
+		if (PeakQueueNum == 0)
+			return FVector::ZeroVector;
+
+		return VelocitySampleLog[PeakQueue[PeakQueueHead].LogIndex];
+	}
+
+private:
+
+	struct FPeakSample
+	{
+		int32 LogIndex;
+		uint32 SampleIndex;
+		float SizeSq;
+	};
+
+	// Monotonic queue of the samples in the log which can still become the peak, ordered from oldest and largest to newest and smallest
+	TArray<FPeakSample> PeakQueue;
+
+	// Total samples added, wraps around safely since only differences are used
+	uint32 PeakSampleCount;
+	int32 PeakQueueHead;
+	int32 PeakQueueNum;
+
+	void PushPeakSample(int32 LogIndex, float SizeSq)
+	{
+		const int32 Capacity = PeakQueue.Num();
 
-		for (int i = 0; i < VelocitySampleLog.Num(); i++)
+		// The oldest sample drops out of the queue once it has been overwritten in the log
+		if (PeakQueueNum > 0 && PeakSampleCount - PeakQueue[PeakQueueHead].SampleIndex >= (uint32)VelocitySamples)
 		{
-			CurSizeSq = VelocitySampleLog[i].SizeSquared();
-			if (CurSizeSq > ValueSizeSq)
-			{
-				MaxValue = VelocitySampleLog[i];
-				ValueSizeSq = CurSizeSq;
-			}
+			PeakQueueHead = (PeakQueueHead + 1) % Capacity;
+			--PeakQueueNum;
+		}
+
+		// Samples older and no larger than the new one can never be the peak again
+		while (PeakQueueNum > 0 && PeakQueue[(PeakQueueHead + PeakQueueNum - 1) % Capacity].SizeSq <= SizeSq)
+		{
+			--PeakQueueNum;
+		}
+
+		// Zero samples are never the peak
+		if (SizeSq > 0.f)
+		{
+			FPeakSample& NewPeakSample = PeakQueue[(PeakQueueHead + PeakQueueNum) % Capacity];
+			NewPeakSample.LogIndex = LogIndex;
+			NewPeakSample.SampleIndex = PeakSampleCount;
+			NewPeakSample.SizeSq = SizeSq;
+			++PeakQueueNum;
 		}
 
-		return MaxValue;
+		++PeakSampleCount;
 	}
 };
 
@@ -555,6 +614,17 @@ enum class EVRRotationQuantization : uint8
 };
 
 
+UENUM()
+enum class EVRPosRepEncoding : uint8
+{
+	/** Every update sends the full packed position and rotation. */
+	Absolute = 0,
+	/** Updates send the offset from the last keyframe, with a full keyframe every KeyframeInterval updates. */
+	DeltaFromKeyframe = 1,
+	/** Updates send the offset from a constant velocity prediction off of the last keyframe. */
+	PredictedFromKeyframe = 2
+};
+
 USTRUCT()
 struct VREXPANSIONPLUGIN_API FBPVRComponentPosRep
 {
@@ -575,6 +645,27 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = Replication, AdvancedDisplay)
 		EVRRotationQuantization RotationQuantizationLevel;
 
+	// How the owning client encodes this transform when sending it to the server.
+	// The delta modes only apply to the client -> server RPCs, the server always replicates the resolved absolute transform.
+	// They also need bAllowDeltaEncodedPosRep in the VRGlobalSettings, otherwise everything is sent absolute.
+	UPROPERTY(EditDefaultsOnly, Category = Replication, AdvancedDisplay)
+		EVRPosRepEncoding EncodingMode;
+
+	// Number of updates between full keyframes when using one of the delta encoding modes
+	UPROPERTY(EditDefaultsOnly, Category = Replication, AdvancedDisplay, meta = (ClampMin = "1", ClampMax = "63", UIMin = "1", UIMax = "63"))
+		uint8 KeyframeInterval;
+
+	// Wire state, filled in by FBPVRPosRepEncoder on the copy being sent and resolved by FBPVRPosRepDecoder on receipt.
+	// When bIsDelta is set and this isn't a keyframe, Position holds the offset from the reference and RotationDelta the quantized axis offsets.
+	bool bIsDelta;
+	bool bIsKeyframe;
+	bool bPredicted;
+	uint8 KeyframeID;
+	uint8 UpdatesSinceKeyframe;
+	FIntVector RotationDelta;
+	FVector KeyframeVelocity;
+	FIntVector KeyframeRotationVelocity;
+
 	FORCEINLINE uint16 CompressAxisTo10BitShort(float Angle)
 	{
 		// map [0->360) to [0->1024) and mask off any winding
@@ -590,109 +681,51 @@ public:
 
 	FBPVRComponentPosRep():
 		QuantizationLevel(EVRVectorQuantization::RoundTwoDecimals),
-		RotationQuantizationLevel(EVRRotationQuantization::RoundToShort)
+		RotationQuantizationLevel(EVRRotationQuantization::RoundToShort),
+		EncodingMode(EVRPosRepEncoding::Absolute),
+		KeyframeInterval(10),
+		bIsDelta(false),
+		bIsKeyframe(false),
+		bPredicted(false),
+		KeyframeID(0),
+		UpdatesSinceKeyframe(0),
+		RotationDelta(FIntVector::ZeroValue),
+		KeyframeVelocity(FVector::ZeroVector),
+		KeyframeRotationVelocity(FIntVector::ZeroValue)
 	{
 		//QuantizationLevel = EVRVectorQuantization::RoundTwoDecimals;
 		Position = FVector::ZeroVector;
 		Rotation = FRotator::ZeroRotator;
 	}
 
-	/** Network serialization */
-	// Doing a custom NetSerialize here because this is sent via RPCs and should change on every update
-	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	FORCEINLINE float GetPositionScale() const
 	{
-		bOutSuccess = true;
-
-		// Defines the level of Quantization
-		//uint8 Flags = (uint8)QuantizationLevel;
-		Ar.SerializeBits(&QuantizationLevel, 1); // Only two values 0:1
-		Ar.SerializeBits(&RotationQuantizationLevel, 1); // Only two values 0:1
-
-		// No longer using their built in rotation rep, as controllers will rarely if ever be at 0 rot on an axis and 
-		// so the 1 bit overhead per axis is just that, overhead
-		//Rotation.SerializeCompressedShort(Ar);
-
-		uint16 ShortPitch = 0;
-		uint16 ShortYaw = 0;
-		uint16 ShortRoll = 0;
-		
-		/**
-		*	Valid range 100: 2^22 / 100 = +/- 41,943.04 (419.43 meters)
-		*	Valid range 10: 2^18 / 10 = +/- 26,214.4 (262.144 meters)
-		*	Pos rep is assumed to be in relative space for a tracked component, these numbers should be fine
-		*/
-		if (Ar.IsSaving())
-		{		
-			switch (QuantizationLevel)
-			{
-			case EVRVectorQuantization::RoundTwoDecimals: bOutSuccess &= SerializePackedVector<100, 22/*30*/>(Position, Ar); break;
-			case EVRVectorQuantization::RoundOneDecimal: bOutSuccess &= SerializePackedVector<10, 18/*24*/>(Position, Ar); break;
-			}
-
-			switch (RotationQuantizationLevel)
-			{
-			case EVRRotationQuantization::RoundTo10Bits:
-			{
-				ShortPitch = CompressAxisTo10BitShort(Rotation.Pitch);
-				ShortYaw = CompressAxisTo10BitShort(Rotation.Yaw);
-				ShortRoll = CompressAxisTo10BitShort(Rotation.Roll);
-
-				Ar.SerializeBits(&ShortPitch, 10);
-				Ar.SerializeBits(&ShortYaw, 10);
-				Ar.SerializeBits(&ShortRoll, 10);
-			}break;
-
-			case EVRRotationQuantization::RoundToShort:
-			{
-				ShortPitch = FRotator::CompressAxisToShort(Rotation.Pitch);
-				ShortYaw = FRotator::CompressAxisToShort(Rotation.Yaw);
-				ShortRoll = FRotator::CompressAxisToShort(Rotation.Roll);
-
-				Ar << ShortPitch;
-				Ar << ShortYaw;
-				Ar << ShortRoll;
-			}break;
-			}
-		}
-		else // If loading
-		{
-			//QuantizationLevel = (EVRVectorQuantization)Flags;
+		return QuantizationLevel == EVRVectorQuantization::RoundTwoDecimals ? 100.f : 10.f;
+	}
 
-			switch (QuantizationLevel)
-			{
-			case EVRVectorQuantization::RoundTwoDecimals: bOutSuccess &= SerializePackedVector<100, 22/*30*/>(Position, Ar); break;
-			case EVRVectorQuantization::RoundOneDecimal: bOutSuccess &= SerializePackedVector<10, 18/*24*/>(Position, Ar); break;
-			}
+	// Rounds a position to what the receiving end would decode at our quantization level
+	FORCEINLINE FVector QuantizePosition(const FVector& InPosition) const
+	{
+		const float Scale = GetPositionScale();
+		return FVector(FMath::RoundToInt(InPosition.X * Scale) / Scale, FMath::RoundToInt(InPosition.Y * Scale) / Scale, FMath::RoundToInt(InPosition.Z * Scale) / Scale);
+	}
 
-			switch (RotationQuantizationLevel)
-			{
-			case EVRRotationQuantization::RoundTo10Bits:
-			{
-				Ar.SerializeBits(&ShortPitch, 10);
-				Ar.SerializeBits(&ShortYaw, 10);
-				Ar.SerializeBits(&ShortRoll, 10);
+	// Converts a rotation to the integer axis values that get sent at our rotation quantization level
+	FIntVector QuantizeRotation(const FRotator& InRotation);
+	FRotator DecompressRotation(const FIntVector& InQuantizedRotation);
 
-				Rotation.Pitch = DecompressAxisFrom10BitShort(ShortPitch);
-				Rotation.Yaw = DecompressAxisFrom10BitShort(ShortYaw);
-				Rotation.Roll = DecompressAxisFrom10BitShort(ShortRoll);
-			}break;
+	// Wraps the difference between two quantized rotations into the signed range of our rotation quantization level
+	FIntVector WrapRotationDelta(const FIntVector& InDelta) const;
 
-			case EVRRotationQuantization::RoundToShort:
-			{
-				Ar << ShortPitch;
-				Ar << ShortYaw;
-				Ar << ShortRoll;
-
-				Rotation.Pitch = FRotator::DecompressAxisFromShort(ShortPitch);
-				Rotation.Yaw = FRotator::DecompressAxisFromShort(ShortYaw);
-				Rotation.Roll = FRotator::DecompressAxisFromShort(ShortRoll);
-			}break;
-			}
-		}
+	/** Network serialization */
+	// Doing a custom NetSerialize here because this is sent via RPCs and should change on every update
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
 
-		return bOutSuccess;
-	}
+private:
 
+	bool SerializeAbsolute(FArchive& Ar);
+	bool SerializePosition(FArchive& Ar, FVector& InOutPosition);
+	static void SerializeRotationDelta(FArchive& Ar, FIntVector& InOutDelta);
 };
 
 template<>
@@ -705,6 +738,69 @@ struct TStructOpsTypeTraits< FBPVRComponentPosRep > : public TStructOpsTypeTrait
 	};
 };
 
+// Sender side of the delta encoding for FBPVRComponentPosRep, one per sending component.
+// Deltas are always taken against the last keyframe rather than the last update so that a lost unreliable RPC
+// only loses that update instead of corrupting everything until the next keyframe.
+struct VREXPANSIONPLUGIN_API FBPVRPosRepEncoder
+{
+public:
+
+	FBPVRPosRepEncoder()
+	{
+		Reset();
+	}
+
+	void Reset();
+
+	// Converts the absolute transform in InOutRep into its wire form for its EncodingMode
+	void Encode(FBPVRComponentPosRep& InOutRep);
+
+private:
+
+	bool bHasKeyframe;
+	uint8 KeyframeID;
+	uint8 UpdatesSinceKeyframe;
+	FVector KeyframePosition;
+	FIntVector KeyframeRotation;
+	FVector KeyframeVelocity;
+	FIntVector KeyframeRotationVelocity;
+
+	bool bHasLastUpdate;
+	FVector LastPosition;
+	FIntVector LastRotation;
+};
+
+// Receiving side of the delta encoding for FBPVRComponentPosRep, one per receiving component.
+struct VREXPANSIONPLUGIN_API FBPVRPosRepDecoder
+{
+public:
+
+	// Keyframe IDs are sent in 4 bits
+	static const int32 NumKeyframeIDs = 16;
+
+	FBPVRPosRepDecoder()
+	{
+		Reset();
+	}
+
+	void Reset();
+
+	// Resolves InOutRep back into an absolute transform, returns false if it doesn't reference the last keyframe received
+	// in which case the update should be dropped like any other lost unreliable update.
+	// Only the last keyframe is kept, so a delta can only resolve against a stale keyframe with the same ID if
+	// NumKeyframeIDs keyframes in a row were lost while one of the following deltas still arrived.
+	bool Decode(FBPVRComponentPosRep& InOutRep);
+
+private:
+
+	FVector KeyframePosition;
+	FIntVector KeyframeRotation;
+	FVector KeyframeVelocity;
+	FIntVector KeyframeRotationVelocity;
+	uint8 KeyframeID;
+	bool bHasKeyframe;
+};
+
 UENUM(Blueprintable)
 enum class EGripCollisionType : uint8
 {
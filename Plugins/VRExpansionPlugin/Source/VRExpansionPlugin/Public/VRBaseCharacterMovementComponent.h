@@ -158,6 +158,11 @@ public:
 	// Will force the HMD to stay in its original spot prior to the tracking jump
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRMovement")
 		bool bHoldPositionOnTrackingLossThresholdHit;
+
+	// Moves whose VR deltas (HMD movement since last frame and capsule height) differ by less than this (in cm) can be combined
+	// into a single network move. Differences this small are lost to the move quantization anyway.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRMovement|Networking", meta = (ClampMin = "0.0", UIMin = "0", ClampMax = "5.0", UIMax = "5"))
+		float VRMoveCombineTolerance;
 
 	// Rewind the relative movement that we had with the HMD, this is exposed to Blueprint so that custom movement modes can use it to rewind prior to movement actions.
 	// Returns the Vector required to get back to the original position (for custom movement modes)
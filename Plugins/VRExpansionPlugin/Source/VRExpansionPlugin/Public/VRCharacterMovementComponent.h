@@ -305,14 +305,41 @@ class VREXPANSIONPLUGIN_API FNetworkPredictionData_Client_VRCharacter : public F
 public:
 	FNetworkPredictionData_Client_VRCharacter(const UCharacterMovementComponent& ClientMovement)
 		: FNetworkPredictionData_Client_Character(ClientMovement)
+		, bPreallocatedMoves(false)
 	{
 
 	}
 
-	FSavedMovePtr AllocateNewMove()
+	// Number of saved moves created on the first CreateSavedMove, later moves pull from these before allocating
+	static const int32 NumPreallocatedMoves = 32;
+
+	virtual FSavedMovePtr CreateSavedMove() override
+	{
+		// Fill the free move pool on first use, VR moves are created every frame and we never want to hit the allocator mid game.
+		// Not done in the constructor as AllocateNewMove wouldn't dispatch to a subclass's move type there.
+		if (!bPreallocatedMoves)
+		{
+			bPreallocatedMoves = true;
+			SavedMoves.Reserve(MaxSavedMoveCount);
+			FreeMoves.Reserve(MaxFreeMoveCount);
+
+			for (int32 i = 0; i < NumPreallocatedMoves && FreeMoves.Num() < MaxFreeMoveCount; ++i)
+			{
+				FreeMoves.Push(AllocateNewMove());
+			}
+		}
+
+		return FNetworkPredictionData_Client_Character::CreateSavedMove();
+	}
+
+	virtual FSavedMovePtr AllocateNewMove() override
 	{
 		return FSavedMovePtr(new FSavedMove_VRCharacter());
 	}
+
+private:
+
+	bool bPreallocatedMoves;
 };
 
 
@@ -122,6 +122,53 @@ public:
 	UPROPERTY(config, EditAnywhere, Category = "Physics")
 		int MaxCCDPasses;
 
+	// If true the server buffers the client authoritative physics states it receives and replays them with interpolation
+	// at PhysicsReplicationRenderDelay, extrapolating (bounded by ping) when the buffer runs dry.
+	// If false the latest received state is applied directly as before.
+	UPROPERTY(config, EditAnywhere, Category = "Physics|Replication")
+		bool bUsePhysicsReplicationBuffer;
+
+	// Max number of timestamped states kept per replicated object
+	UPROPERTY(config, EditAnywhere, Category = "Physics|Replication", meta = (ClampMin = "2", UIMin = "2", ClampMax = "64", UIMax = "64", editcondition = "bUsePhysicsReplicationBuffer"))
+		int32 PhysicsReplicationBufferSize;
+
+	// How far behind the estimated send time (in seconds) the buffered states are replayed, higher values hide more jitter
+	// at the cost of latency. 0 replays the newest state extrapolated forward by the one way ping.
+	UPROPERTY(config, EditAnywhere, Category = "Physics|Replication", meta = (ClampMin = "0.0", UIMin = "0.0", ClampMax = "0.5", UIMax = "0.5", editcondition = "bUsePhysicsReplicationBuffer"))
+		float PhysicsReplicationRenderDelay;
+
+	// Maximum time (in seconds) a state is extrapolated forward when there is no newer state to interpolate towards
+	UPROPERTY(config, EditAnywhere, Category = "Physics|Replication", meta = (ClampMin = "0.0", UIMin = "0.0", ClampMax = "1.0", UIMax = "1.0", editcondition = "bUsePhysicsReplicationBuffer"))
+		float PhysicsReplicationMaxExtrapolation;
+
+	// Positional error (in cm) below which no correction is applied, avoids fighting the local simulation over tiny differences
+	UPROPERTY(config, EditAnywhere, Category = "Physics|Replication", meta = (ClampMin = "0.0", UIMin = "0.0", editcondition = "bUsePhysicsReplicationBuffer"))
+		float PhysicsReplicationMinCorrectionError;
+
+	// Rotational error (in degrees) that still gets corrected when the positional error is inside PhysicsReplicationMinCorrectionError
+	UPROPERTY(config, EditAnywhere, Category = "Physics|Replication", meta = (ClampMin = "0.0", UIMin = "0.0", ClampMax = "180.0", UIMax = "180.0", editcondition = "bUsePhysicsReplicationBuffer"))
+		float PhysicsReplicationMinCorrectionAngle;
+
+	// Positional error (in cm) at which the full project error correction strength is used
+	UPROPERTY(config, EditAnywhere, Category = "Physics|Replication", meta = (ClampMin = "0.0", UIMin = "0.0", editcondition = "bUsePhysicsReplicationBuffer"))
+		float PhysicsReplicationFullCorrectionError;
+
+	// Scale applied to the project error correction when the error is just above PhysicsReplicationMinCorrectionError,
+	// ramps up to 1.0 at PhysicsReplicationFullCorrectionError
+	UPROPERTY(config, EditAnywhere, Category = "Physics|Replication", meta = (ClampMin = "0.0", UIMin = "0.0", ClampMax = "1.0", UIMax = "1.0", editcondition = "bUsePhysicsReplicationBuffer"))
+		float PhysicsReplicationMinCorrectionStrength;
+
+	// If true the FBPVRComponentPosRep header carries an extra bit so that components can use the delta EncodingModes.
+	// If false every transform RPC is sent absolute with the original header, leave this off unless something uses the delta modes.
+	// This is read on both ends of the RPC so it has to be the same on client and server.
+	UPROPERTY(config, EditAnywhere, Category = "Replication")
+		bool bAllowDeltaEncodedPosRep;
+
+	// If true then the interactibles (levers, dials, sliders, buttons, mounts) are updated in a batch by the VRInteractibleTickSubsystem
+	// instead of enabling and disabling their own component ticks
+	UPROPERTY(config, EditAnywhere, Category = "Interactibles")
+		bool bUseInteractibleTickSubsystem;
+
 	// List of surfaces and their properties for the melee script
 	UPROPERTY(config, EditAnywhere, Category = "MeleeSettings")
 		TArray<FBPHitSurfaceProperties> MeleeSurfaceSettings;
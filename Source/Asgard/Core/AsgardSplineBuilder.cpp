@@ -0,0 +1,362 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "AsgardSplineBuilder.h"
+
+namespace AsgardSplineBuilder
+{
+	/** Same 5 point Legendre-Gauss quadrature a spline component uses to measure its segments. */
+	static const float LegendreGaussAbscissae[] = { 0.0f, -0.5384693101056831f, 0.5384693101056831f, -0.9061798459386640f, 0.9061798459386640f };
+	static const float LegendreGaussWeights[] = { 0.5688888888888889f, 0.4786286704993665f, 0.4786286704993665f, 0.2369268850561891f, 0.2369268850561891f };
+
+	/** Alphas sampled on a segment before refining the closest location. */
+	static const int32 NumClosestSamples = 4;
+	static const int32 NumClosestRefinements = 3;
+
+	/** Segments searched past the closest one before stopping, so a short detour away from the location doesn't end the search. */
+	static const int32 NumClosestLookaheadSegments = 3;
+
+	static bool IsCurveMode(EInterpCurveMode InterpMode)
+	{
+		return InterpMode != CIM_Linear && InterpMode != CIM_Constant;
+	}
+}
+
+void FAsgardSplinePoints::Reset(int32 NumPoints)
+{
+	Locations.Reset(NumPoints);
+	ArriveTangents.Reset(NumPoints);
+	LeaveTangents.Reset(NumPoints);
+	InterpModes.Reset(NumPoints);
+	UpVectors.Reset();
+}
+
+void FAsgardSplinePoints::Add(const FVector& Location, const FVector& Tangent, EInterpCurveMode InterpMode)
+{
+	Locations.Add(Location);
+	ArriveTangents.Add(Tangent);
+	LeaveTangents.Add(Tangent);
+	InterpModes.Add(InterpMode);
+}
+
+void FAsgardSplinePoints::AutoSetTangents()
+{
+	// Matches FInterpCurve::AutoSetTangents with no tension and moving endpoints, the spline component defaults
+	const int32 LastIdx = Num() - 1;
+	for (int32 Idx = 0; Idx <= LastIdx; Idx++)
+	{
+		const int32 PrevIdx = Idx == 0 ? (bClosedLoop ? LastIdx : 0) : Idx - 1;
+		const int32 NextIdx = Idx == LastIdx ? (bClosedLoop ? 0 : LastIdx) : Idx + 1;
+
+		switch (InterpModes[Idx])
+		{
+		case CIM_CurveAuto:
+		case CIM_CurveAutoClamped:
+			if (AsgardSplineBuilder::IsCurveMode(InterpModes[PrevIdx]))
+			{
+				// Input keys are the point indices, only the ends of an open spline are one key apart from their neighbours
+				const float KeyRange = (PrevIdx == Idx || NextIdx == Idx) ? 1.0f : 2.0f;
+				const FVector Tangent = (Locations[NextIdx] - Locations[PrevIdx]) / KeyRange;
+				ArriveTangents[Idx] = Tangent;
+				LeaveTangents[Idx] = Tangent;
+			}
+			else
+			{
+				// Following a line or constant, keep its tangents to avoid discontinuities
+				ArriveTangents[Idx] = ArriveTangents[PrevIdx];
+				LeaveTangents[Idx] = LeaveTangents[PrevIdx];
+			}
+			break;
+		case CIM_Linear:
+			ArriveTangents[Idx] = Locations[NextIdx] - Locations[Idx];
+			LeaveTangents[Idx] = ArriveTangents[Idx];
+			break;
+		case CIM_Constant:
+			ArriveTangents[Idx] = FVector::ZeroVector;
+			LeaveTangents[Idx] = FVector::ZeroVector;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+FVector FAsgardSplinePoints::GetLocationOnSegment(int32 SegmentIndex, float Alpha) const
+{
+	const int32 EndIdx = GetSegmentEndIndex(SegmentIndex);
+	if (!AsgardSplineBuilder::IsCurveMode(InterpModes[SegmentIndex]))
+	{
+		return FMath::Lerp(Locations[SegmentIndex], Locations[EndIdx], Alpha);
+	}
+	return FMath::CubicInterp(Locations[SegmentIndex], LeaveTangents[SegmentIndex], Locations[EndIdx], ArriveTangents[EndIdx], Alpha);
+}
+
+float FAsgardSplinePoints::GetSegmentLength(int32 SegmentIndex) const
+{
+	const int32 EndIdx = GetSegmentEndIndex(SegmentIndex);
+	const FVector& P0 = Locations[SegmentIndex];
+	const FVector& T0 = LeaveTangents[SegmentIndex];
+	const FVector& P1 = Locations[EndIdx];
+	const FVector& T1 = ArriveTangents[EndIdx];
+
+	if (!AsgardSplineBuilder::IsCurveMode(InterpModes[SegmentIndex]))
+	{
+		return (P1 - P0).Size();
+	}
+
+	// Coefficients of the derivative of the segment
+	const FVector Coeff1 = ((P0 - P1) * 2.0f + T0 + T1) * 3.0f;
+	const FVector Coeff2 = (P1 - P0) * 6.0f - T0 * 4.0f - T1 * 2.0f;
+	const FVector Coeff3 = T0;
+
+	float Length = 0.0f;
+	for (int32 Idx = 0; Idx < UE_ARRAY_COUNT(AsgardSplineBuilder::LegendreGaussAbscissae); Idx++)
+	{
+		const float Alpha = 0.5f * (1.0f + AsgardSplineBuilder::LegendreGaussAbscissae[Idx]);
+		const FVector Derivative = (Coeff1 * Alpha + Coeff2) * Alpha + Coeff3;
+		Length += Derivative.Size() * AsgardSplineBuilder::LegendreGaussWeights[Idx];
+	}
+	return Length * 0.5f;
+}
+
+void FAsgardSplinePoints::GetSegmentLengths(TArray<float>& OutLengths) const
+{
+	const int32 NumSegs = NumSegments();
+	OutLengths.SetNumUninitialized(NumSegs);
+	for (int32 Idx = 0; Idx < NumSegs; Idx++)
+	{
+		OutLengths[Idx] = GetSegmentLength(Idx);
+	}
+}
+
+float FAsgardSplinePoints::FindClosestAlphaOnSegment(const FVector& Location, int32 SegmentIndex, float MinAlpha) const
+{
+	const int32 EndIdx = GetSegmentEndIndex(SegmentIndex);
+	const FVector& P0 = Locations[SegmentIndex];
+	const FVector& P1 = Locations[EndIdx];
+
+	if (!AsgardSplineBuilder::IsCurveMode(InterpModes[SegmentIndex]))
+	{
+		const FVector Segment = P1 - P0;
+		const float SizeSquared = Segment.SizeSquared();
+		const float Alpha = SizeSquared > SMALL_NUMBER ? ((Location - P0) | Segment) / SizeSquared : 0.0f;
+		return FMath::Clamp(Alpha, MinAlpha, 1.0f);
+	}
+
+	const FVector& T0 = LeaveTangents[SegmentIndex];
+	const FVector& T1 = ArriveTangents[EndIdx];
+
+	// Start from the closest of a few samples
+	float BestAlpha = MinAlpha;
+	float BestDistSquared = BIG_NUMBER;
+	for (int32 Idx = 0; Idx <= AsgardSplineBuilder::NumClosestSamples; Idx++)
+	{
+		const float Alpha = FMath::Lerp(MinAlpha, 1.0f, float(Idx) / AsgardSplineBuilder::NumClosestSamples);
+		const float DistSquared = FVector::DistSquared(FMath::CubicInterp(P0, T0, P1, T1, Alpha), Location);
+		if (DistSquared < BestDistSquared)
+		{
+			BestDistSquared = DistSquared;
+			BestAlpha = Alpha;
+		}
+	}
+
+	// Then refine it with Newton's method on the derivative of the squared distance
+	for (int32 Idx = 0; Idx < AsgardSplineBuilder::NumClosestRefinements; Idx++)
+	{
+		const FVector Delta = FMath::CubicInterp(P0, T0, P1, T1, BestAlpha) - Location;
+		const FVector Derivative = FMath::CubicInterpDerivative(P0, T0, P1, T1, BestAlpha);
+		const FVector SecondDerivative = FMath::CubicInterpSecondDerivative(P0, T0, P1, T1, BestAlpha);
+		const float Numerator = Delta | Derivative;
+		const float Denominator = Derivative.SizeSquared() + (Delta | SecondDerivative);
+		if (FMath::Abs(Denominator) < SMALL_NUMBER)
+		{
+			break;
+		}
+		BestAlpha = FMath::Clamp(BestAlpha - Numerator / Denominator, MinAlpha, 1.0f);
+	}
+
+	return BestAlpha;
+}
+
+FVector FAsgardSplinePoints::FindLocationClosestForward(const FVector& Location, int32& InOutSegment, float& InOutAlpha) const
+{
+	const int32 NumSegs = NumSegments();
+	if (NumSegs == 0)
+	{
+		return Num() > 0 ? Locations[0] : Location;
+	}
+
+	InOutSegment = FMath::Clamp(InOutSegment, 0, NumSegs - 1);
+
+	float BestAlpha = FindClosestAlphaOnSegment(Location, InOutSegment, InOutAlpha);
+	FVector BestLocation = GetLocationOnSegment(InOutSegment, BestAlpha);
+	float BestDistSquared = FVector::DistSquared(BestLocation, Location);
+
+	// Keep walking while one of the few segments after the closest so far gets closer
+	for (int32 SegmentIndex = InOutSegment + 1;
+		SegmentIndex < NumSegs && SegmentIndex - InOutSegment <= AsgardSplineBuilder::NumClosestLookaheadSegments;
+		SegmentIndex++)
+	{
+		const float Alpha = FindClosestAlphaOnSegment(Location, SegmentIndex, 0.0f);
+		const FVector SegmentLocation = GetLocationOnSegment(SegmentIndex, Alpha);
+		const float DistSquared = FVector::DistSquared(SegmentLocation, Location);
+		if (DistSquared >= BestDistSquared)
+		{
+			continue;
+		}
+
+		InOutSegment = SegmentIndex;
+		BestAlpha = Alpha;
+		BestLocation = SegmentLocation;
+		BestDistSquared = DistSquared;
+	}
+
+	InOutAlpha = BestAlpha;
+	return BestLocation;
+}
+
+void FAsgardSplinePoints::ReadFromSpline(const USplineComponent* Spline)
+{
+	const ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
+	const int32 NumPoints = Spline->GetNumberOfSplinePoints();
+
+	Reset(NumPoints);
+	bClosedLoop = Spline->IsClosedLoop();
+
+	for (int32 Idx = 0; Idx < NumPoints; Idx++)
+	{
+		Locations.Add(Spline->GetLocationAtSplinePoint(Idx, CoordinateSpace));
+		ArriveTangents.Add(Spline->GetArriveTangentAtSplinePoint(Idx, CoordinateSpace));
+		LeaveTangents.Add(Spline->GetLeaveTangentAtSplinePoint(Idx, CoordinateSpace));
+		InterpModes.Add(ConvertSplinePointTypeToInterpCurveMode(Spline->GetSplinePointType(Idx)));
+	}
+}
+
+void FAsgardSplinePoints::WriteToSpline(USplineComponent* Spline) const
+{
+	const FTransform& ComponentTransform = Spline->GetComponentTransform();
+	const FVector DefaultUpVector = Spline->GetDefaultUpVector(ESplineCoordinateSpace::Local);
+	const int32 NumPoints = Num();
+
+	FSplineCurves& Curves = Spline->SplineCurves;
+	Curves.Position.Points.Reset(NumPoints);
+	Curves.Rotation.Points.Reset(NumPoints);
+	Curves.Scale.Points.Reset(NumPoints);
+
+	for (int32 Idx = 0; Idx < NumPoints; Idx++)
+	{
+		const float InputKey = static_cast<float>(Idx);
+
+		Curves.Position.Points.Emplace(
+			InputKey,
+			ComponentTransform.InverseTransformPosition(Locations[Idx]),
+			ComponentTransform.InverseTransformVector(ArriveTangents[Idx]),
+			ComponentTransform.InverseTransformVector(LeaveTangents[Idx]),
+			InterpModes[Idx]);
+
+		FQuat Rotation = FQuat::Identity;
+		if (UpVectors.IsValidIndex(Idx))
+		{
+			Rotation = FQuat::FindBetween(DefaultUpVector, ComponentTransform.InverseTransformVector(UpVectors[Idx].GetSafeNormal()));
+		}
+		Curves.Rotation.Points.Emplace(InputKey, Rotation, FQuat::Identity, FQuat::Identity, CIM_CurveAuto);
+
+		Curves.Scale.Points.Emplace(InputKey, FVector(1.0f), FVector::ZeroVector, FVector::ZeroVector, CIM_CurveAuto);
+	}
+
+	Spline->UpdateSpline();
+}
+
+void FAsgardSplineBuilder::BuildOffsetPoints(
+	const USplineComponent* BaseSpline,
+	const float RotFromUp,
+	const float OffsetDist,
+	FAsgardSplinePoints& OutOffsetPoints)
+{
+	const ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
+	const int32 NumPoints = BaseSpline->GetNumberOfSplinePoints();
+
+	OutOffsetPoints.Reset(NumPoints);
+	OutOffsetPoints.bClosedLoop = BaseSpline->IsClosedLoop();
+
+	// The base spline doesn't change while building, read it once
+	TArray<FVector> BaseTangents;
+	BaseTangents.Reserve(NumPoints);
+	for (int32 Idx = 0; Idx < NumPoints; Idx++)
+	{
+		const FVector UpVectorScaled = OffsetDist * BaseSpline->GetUpVectorAtSplinePoint(Idx, CoordinateSpace);
+		const FVector TanAtPoint = BaseSpline->GetTangentAtSplinePoint(Idx, CoordinateSpace);
+		const FVector OffsetVector = UpVectorScaled.RotateAngleAxis(RotFromUp, TanAtPoint.GetSafeNormal());
+
+		OutOffsetPoints.Add(
+			OffsetVector + BaseSpline->GetLocationAtSplinePoint(Idx, CoordinateSpace),
+			TanAtPoint,
+			ConvertSplinePointTypeToInterpCurveMode(BaseSpline->GetSplinePointType(Idx)));
+		BaseTangents.Add(TanAtPoint);
+	}
+
+	// Points using the base spline's auto tangents start with the tangents the component would give them
+	OutOffsetPoints.AutoSetTangents();
+
+	const int32 NumSegments = OutOffsetPoints.NumSegments();
+	if (NumSegments == 0)
+	{
+		return;
+	}
+
+	TArray<float> BaseSegmentLengths;
+	BaseSegmentLengths.SetNumUninitialized(NumSegments);
+	for (int32 Idx = 0; Idx < NumSegments; Idx++)
+	{
+		BaseSegmentLengths[Idx] = BaseSpline->GetDistanceAlongSplineAtSplinePoint(Idx + 1) - BaseSpline->GetDistanceAlongSplineAtSplinePoint(Idx);
+	}
+
+	// Scale the base tangents by how much longer or shorter each offset segment is than its base segment
+	TArray<float> OffsetSegmentLengths;
+	for (int32 Pass = 0; Pass < NumTangentFixPasses; Pass++)
+	{
+		OutOffsetPoints.GetSegmentLengths(OffsetSegmentLengths);
+
+		for (int32 Idx = 0; Idx < NumPoints; Idx++)
+		{
+			// The ends of an open spline only have one segment
+			const int32 ArriveSegment = Idx > 0 ? Idx - 1 : (OutOffsetPoints.bClosedLoop ? NumSegments - 1 : 0);
+			const int32 LeaveSegment = FMath::Min(Idx, NumSegments - 1);
+
+			const float ArriveRatio = BaseSegmentLengths[ArriveSegment] > KINDA_SMALL_NUMBER ? OffsetSegmentLengths[ArriveSegment] / BaseSegmentLengths[ArriveSegment] : 1.0f;
+			const float LeaveRatio = BaseSegmentLengths[LeaveSegment] > KINDA_SMALL_NUMBER ? OffsetSegmentLengths[LeaveSegment] / BaseSegmentLengths[LeaveSegment] : 1.0f;
+
+			OutOffsetPoints.ArriveTangents[Idx] = BaseTangents[Idx] * ArriveRatio;
+			OutOffsetPoints.LeaveTangents[Idx] = BaseTangents[Idx] * LeaveRatio;
+			OutOffsetPoints.InterpModes[Idx] = CIM_CurveUser;
+		}
+	}
+}
+
+void FAsgardSplineBuilder::BuildCorrectedPoints(
+	const USplineComponent* BaseSpline,
+	const FAsgardSplinePoints& OffsetPoints,
+	const int32 NumSegments,
+	const float SegmentLength,
+	FAsgardSplinePoints& OutCorrectedPoints)
+{
+	const ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
+	const int32 LastIdx = NumSegments + (BaseSpline->IsClosedLoop() ? -1 : 0);
+
+	OutCorrectedPoints.Reset(LastIdx + 1);
+	OutCorrectedPoints.UpVectors.Reserve(LastIdx + 1);
+	OutCorrectedPoints.bClosedLoop = BaseSpline->IsClosedLoop();
+
+	// Points are placed in order along the base spline, so their closest offset locations only move forward
+	int32 OffsetSegment = 0;
+	float OffsetAlpha = 0.0f;
+	for (int32 Idx = 0; Idx <= LastIdx; Idx++)
+	{
+		const float Distance = Idx * SegmentLength;
+		const FVector Location = BaseSpline->GetLocationAtDistanceAlongSpline(Distance, CoordinateSpace);
+		const FVector Tangent = SegmentLength * BaseSpline->GetTangentAtDistanceAlongSpline(Distance, CoordinateSpace).GetSafeNormal();
+		OutCorrectedPoints.Add(Location, Tangent, CIM_CurveUser);
+
+		const FVector LocationOffset = OffsetPoints.FindLocationClosestForward(Location, OffsetSegment, OffsetAlpha);
+		OutCorrectedPoints.UpVectors.Add((LocationOffset - Location).GetSafeNormal());
+	}
+}
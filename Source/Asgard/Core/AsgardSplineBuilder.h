@@ -0,0 +1,96 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/Engine/Classes/Components/SplineComponent.h"
+
+/**
+ * Spline points in world space.
+ * Splines are built on these arrays and committed to a spline component once,
+ * instead of updating the component and its reparam table after every change.
+ */
+struct ASGARD_API FAsgardSplinePoints
+{
+	TArray<FVector> Locations;
+	TArray<FVector> ArriveTangents;
+	TArray<FVector> LeaveTangents;
+	TArray<TEnumAsByte<EInterpCurveMode>> InterpModes;
+
+	/** Up vector of each point. If empty, points keep the default rotation. */
+	TArray<FVector> UpVectors;
+
+	bool bClosedLoop = false;
+
+	int32 Num() const { return Locations.Num(); }
+
+	int32 NumSegments() const { return bClosedLoop ? Num() : FMath::Max(Num() - 1, 0); }
+
+	/** Removes all points and reserves space for NumPoints. */
+	void Reset(int32 NumPoints = 0);
+
+	/** Adds a point with the same arrive and leave tangent. */
+	void Add(const FVector& Location, const FVector& Tangent, EInterpCurveMode InterpMode);
+
+	/** Computes the tangents of auto points the same way a spline component does when it is updated. */
+	void AutoSetTangents();
+
+	/** Location on a segment, Alpha being in [0, 1]. */
+	FVector GetLocationOnSegment(int32 SegmentIndex, float Alpha) const;
+
+	/** Length of a segment, integrated the same way a spline component measures its segments. */
+	float GetSegmentLength(int32 SegmentIndex) const;
+
+	/** Fills OutLengths with the length of every segment. */
+	void GetSegmentLengths(TArray<float>& OutLengths) const;
+
+	/**
+	 * Finds the location closest to Location, never going back from the segment and alpha of the previous search.
+	 * Walks forward while one of the next few segments gets closer, so consecutive searches along the spline only look at a few
+	 * segments and a short detour away from Location doesn't stop the search early.
+	 * @param InOutSegment Segment to start from, set to the segment of the closest location.
+	 * @param InOutAlpha Alpha to start from on InOutSegment, set to the alpha of the closest location.
+	 */
+	FVector FindLocationClosestForward(const FVector& Location, int32& InOutSegment, float& InOutAlpha) const;
+
+	/** Copies the points of a spline component. */
+	void ReadFromSpline(const USplineComponent* Spline);
+
+	/** Replaces the points of a spline component and updates it once. */
+	void WriteToSpline(USplineComponent* Spline) const;
+
+private:
+	/** Closest alpha to Location on a segment, in [MinAlpha, 1]. */
+	float FindClosestAlphaOnSegment(const FVector& Location, int32 SegmentIndex, float MinAlpha) const;
+
+	int32 GetSegmentEndIndex(int32 SegmentIndex) const { return SegmentIndex == Num() - 1 ? 0 : SegmentIndex + 1; }
+};
+
+/** Builds offset and twist corrected splines from raw points. */
+class ASGARD_API FAsgardSplineBuilder
+{
+public:
+	/**
+	 * Offsets every point of the base spline by OffsetDist, rotated by RotFromUp around the tangent from the point's up vector.
+	 * Tangents are then scaled by the ratio of the offset and base segment lengths so the offset spline follows the base spline.
+	 */
+	static void BuildOffsetPoints(
+		const USplineComponent* BaseSpline,
+		const float RotFromUp,
+		const float OffsetDist,
+		FAsgardSplinePoints& OutOffsetPoints);
+
+	/**
+	 * Subdivides the base spline into NumSegments segments of SegmentLength.
+	 * The up vector of each point points to the closest location on the offset spline.
+	 */
+	static void BuildCorrectedPoints(
+		const USplineComponent* BaseSpline,
+		const FAsgardSplinePoints& OffsetPoints,
+		const int32 NumSegments,
+		const float SegmentLength,
+		FAsgardSplinePoints& OutCorrectedPoints);
+
+	/** Number of times the offset tangents are scaled, each pass using the segment lengths of the previous one. */
+	static constexpr int32 NumTangentFixPasses = 3;
+};
@@ -1,6 +1,7 @@
 ﻿// Copyright © 2020 Justin Camden All Rights Reserved
 
 #include "AsgardSplineLibrary.h"
+#include "AsgardSplineBuilder.h"
 #include "Runtime/Engine/Classes/Components/SplineMeshComponent.h"
 
 void UAsgardSplineLibrary::CalculateSplineSegmentNumAndLength(
@@ -68,34 +69,73 @@ void UAsgardSplineLibrary::MatchSplineMeshToSpline(
 	checkf(Spline != nullptr, TEXT("MatchSplineMeshToSpline failed! Spline was null."));
 	checkf(SplineMesh != nullptr, TEXT("MatchSplineMeshToSpline failed! SplineMesh was null."));
 
-	FVector StartLocation;
-	FVector StartTangent;
-	FVector EndLocation;
-	FVector EndTangent;
-	CalculateSplineSegmentStartAndEnd(Spline, StartLocation, StartTangent, EndLocation, EndTangent, SegmentIndex, SegmentLength, ESplineCoordinateSpace::Local);
-	SplineMesh->SetStartAndEnd(StartLocation, StartTangent, EndLocation, EndTangent, false);
+	FAsgardSplineMeshSegment Segment;
+	CalculateSplineMeshSegment(SegmentIndex, SegmentLength, Spline, StartScale, EndScale, Roll, Segment);
+	ApplySplineMeshSegment(SplineMesh, Segment, UpdateMesh);
+
+	return;
+}
+
+void UAsgardSplineLibrary::CalculateSplineMeshSegment(
+	const int32 SegmentIndex,
+	const float SegmentLength,
+	const USplineComponent* Spline,
+	const FVector2D& StartScale,
+	const FVector2D& EndScale,
+	const float Roll,
+	FAsgardSplineMeshSegment& OutSegment)
+{
+	checkf(Spline != nullptr, TEXT("CalculateSplineMeshSegment failed! Spline was null."));
+
+	CalculateSplineSegmentStartAndEnd(Spline, OutSegment.StartLocation, OutSegment.StartTangent, OutSegment.EndLocation, OutSegment.EndTangent, SegmentIndex, SegmentLength, ESplineCoordinateSpace::Local);
 
 	FVector UpDirection = Spline->GetUpVectorAtDistanceAlongSpline(SegmentIndex * SegmentLength, ESplineCoordinateSpace::World);
 	FTransform OwnerTransform = Spline->GetOwner()->GetActorTransform();
-	UpDirection = OwnerTransform.InverseTransformVectorNoScale(UpDirection);
-	SplineMesh->SetSplineUpDir(UpDirection, true);
+	OutSegment.UpDirection = OwnerTransform.InverseTransformVectorNoScale(UpDirection);
 
 	float Rotation = CalculateSplineUpRotation(Spline, SegmentIndex, SegmentLength);
 
-	Roll = FMath::DegreesToRadians(Roll);
-	Rotation = Rotation + Roll;
-	SplineMesh->SetStartRoll(FMath::DegreesToRadians(Roll), false);
-	SplineMesh->SetEndRoll(Rotation, false);
+	float RollRadians = FMath::DegreesToRadians(Roll);
+	OutSegment.StartRoll = FMath::DegreesToRadians(RollRadians);
+	OutSegment.EndRoll = Rotation + RollRadians;
+
+	OutSegment.StartScale = StartScale;
+	OutSegment.EndScale = EndScale;
+}
+
+void UAsgardSplineLibrary::ApplySplineMeshSegment(
+	USplineMeshComponent* SplineMesh,
+	const FAsgardSplineMeshSegment& Segment,
+	bool UpdateMesh)
+{
+	checkf(SplineMesh != nullptr, TEXT("ApplySplineMeshSegment failed! SplineMesh was null."));
+
+	SplineMesh->SetStartAndEnd(Segment.StartLocation, Segment.StartTangent, Segment.EndLocation, Segment.EndTangent, false);
+	SplineMesh->SetSplineUpDir(Segment.UpDirection, true);
+
+	SplineMesh->SetStartRoll(Segment.StartRoll, false);
+	SplineMesh->SetEndRoll(Segment.EndRoll, false);
 
-	SplineMesh->SetStartScale(StartScale, false);
-	SplineMesh->SetEndScale(EndScale, false);
+	SplineMesh->SetStartScale(Segment.StartScale, false);
+	SplineMesh->SetEndScale(Segment.EndScale, false);
 
 	if (UpdateMesh)
 	{
 		SplineMesh->UpdateMesh();
 	}
+}
 
-	return;
+bool FAsgardSplineMeshSegment::Equals(const FAsgardSplineMeshSegment& Other, float Tolerance) const
+{
+	return StartLocation.Equals(Other.StartLocation, Tolerance)
+		&& StartTangent.Equals(Other.StartTangent, Tolerance)
+		&& EndLocation.Equals(Other.EndLocation, Tolerance)
+		&& EndTangent.Equals(Other.EndTangent, Tolerance)
+		&& UpDirection.Equals(Other.UpDirection, Tolerance)
+		&& FMath::IsNearlyEqual(StartRoll, Other.StartRoll, Tolerance)
+		&& FMath::IsNearlyEqual(EndRoll, Other.EndRoll, Tolerance)
+		&& StartScale.Equals(Other.StartScale, Tolerance)
+		&& EndScale.Equals(Other.EndScale, Tolerance);
 }
 
 void UAsgardSplineLibrary::BuildOffsetSpline(
@@ -107,64 +147,9 @@ void UAsgardSplineLibrary::BuildOffsetSpline(
 	checkf(BaseSpline != nullptr, TEXT("BuildOffsetSpline failed! BaseSpline was null."));
 	checkf(OffsetSpline != nullptr, TEXT("BuildOffsetSpline failed! OffsetSpline was null."));
 
-	ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
-	OffsetSpline->ClearSplinePoints(true);
-	int32 LastIdx = BaseSpline->GetNumberOfSplinePoints() - 1;
-
-	FVector UpVectorScaled;
-	FVector TanAtPoint;
-	FVector OffsetVector;
-	FVector PointLocation;
-
-	for (int Idx = 0; Idx <= LastIdx; Idx++)
-	{
-		UpVectorScaled = OffsetDist * (BaseSpline->GetUpVectorAtSplinePoint(Idx, CoordinateSpace));
-		TanAtPoint = (BaseSpline->GetTangentAtSplinePoint(Idx, CoordinateSpace));
-		OffsetVector = UpVectorScaled.RotateAngleAxis(RotFromUp, TanAtPoint.GetSafeNormal());
-		PointLocation = OffsetVector + (BaseSpline->GetLocationAtSplinePoint(Idx, CoordinateSpace));
-		OffsetSpline->AddSplinePointAtIndex(PointLocation, Idx, CoordinateSpace, false);
-
-		OffsetSpline->SetTangentAtSplinePoint(Idx, TanAtPoint, CoordinateSpace, false);
-
-		OffsetSpline->SetSplinePointType(Idx, BaseSpline->GetSplinePointType(Idx), false);
-	}
-
-	OffsetSpline->UpdateSpline();
-
-	// Fix tangents
-	FVector ArriveTan;
-	FVector LeaveTan;
-	FVector BaseTan;
-	int32 ArriveIndex;
-	int32 ArriveLoopingIdx;
-	int32 LeaveLoopingIdx;
-	for (int32 OuterIdx = 0; OuterIdx <= 2; OuterIdx++)
-	{
-		for (int InnerIdx = 0; InnerIdx <= LastIdx; InnerIdx++)
-		{
-			BaseTan = BaseSpline->GetTangentAtSplinePoint(InnerIdx, CoordinateSpace);
-
-			ArriveIndex = FMath::Clamp(int32(InnerIdx - 1), 0, int32(LastIdx + 1));
-			ArriveLoopingIdx = ((InnerIdx - 1) < 0 ? LastIdx : 0);
-			ArriveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
-									OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))) /
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
-									BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))));
-
-			LeaveLoopingIdx = (LastIdx == InnerIdx ? 1 : 0);
-			LeaveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
-									(OffsetSpline->GetSplineLength() * LeaveLoopingIdx))) /
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
-									(BaseSpline->GetSplineLength() * LeaveLoopingIdx))));
-
-			OffsetSpline->SetTangentsAtSplinePoint(InnerIdx, ArriveTan, LeaveTan, CoordinateSpace, false);
-		}
-		OffsetSpline->UpdateSpline();
-	}
+	FAsgardSplinePoints OffsetPoints;
+	FAsgardSplineBuilder::BuildOffsetPoints(BaseSpline, RotFromUp, OffsetDist, OffsetPoints);
+	OffsetPoints.WriteToSpline(OffsetSpline);
 }
 
 void UAsgardSplineLibrary::BuildCorrectedSpline(
@@ -180,24 +165,13 @@ void UAsgardSplineLibrary::BuildCorrectedSpline(
 	int32 NumSplineSegments;
 	float SplineSegmentLength;
 	CalculateSplineSegmentNumAndLength(BaseSpline, NumSplineSegments, SplineSegmentLength, IdealSegmentLength);
-	CorrectedSpline->ClearSplinePoints(true);
-	int32 LastIdx = NumSplineSegments + (BaseSpline->IsClosedLoop() ? -1 : 0);
-	FVector Location;
-	FVector LocationOffset;
-	FVector Tangent;
-	ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
-	for (int32 Idx = 0; Idx <= LastIdx; Idx++)
-	{
-		Location = BaseSpline->GetLocationAtDistanceAlongSpline(Idx * SplineSegmentLength, CoordinateSpace);
-		CorrectedSpline->AddSplinePointAtIndex(Location, Idx, CoordinateSpace, false);
 
-		LocationOffset = OffsetSpline->FindLocationClosestToWorldLocation(Location, CoordinateSpace);
-		CorrectedSpline->SetUpVectorAtSplinePoint(Idx, (LocationOffset - Location).GetSafeNormal(), CoordinateSpace, false);
+	FAsgardSplinePoints OffsetPoints;
+	OffsetPoints.ReadFromSpline(OffsetSpline);
 
-		Tangent = SplineSegmentLength * ((BaseSpline->GetTangentAtDistanceAlongSpline(Idx * SplineSegmentLength, CoordinateSpace)).GetSafeNormal());
-		CorrectedSpline->SetTangentAtSplinePoint(Idx, Tangent, CoordinateSpace, false);
-	}
-	CorrectedSpline->UpdateSpline();
+	FAsgardSplinePoints CorrectedPoints;
+	FAsgardSplineBuilder::BuildCorrectedPoints(BaseSpline, OffsetPoints, NumSplineSegments, SplineSegmentLength, CorrectedPoints);
+	CorrectedPoints.WriteToSpline(CorrectedSpline);
 }
 
 void UAsgardSplineLibrary::FixSplineTwist(
@@ -214,81 +188,14 @@ void UAsgardSplineLibrary::FixSplineTwist(
 	checkf(OffsetSpline != nullptr, TEXT("FixSplineTwist failed! BaseSpline was null."));
 	checkf(CorrectedSpline != nullptr, TEXT("FixSplineTwist failed! BaseSpline was null."));
 
-	ESplineCoordinateSpace::Type CoordinateSpace = ESplineCoordinateSpace::World;
-	OffsetSpline->ClearSplinePoints(true);
-	int32 LastIdx = BaseSpline->GetNumberOfSplinePoints() - 1;
-
-	FVector UpVectorScaled;
-	FVector TanAtPoint;
-	FVector OffsetVector;
-	FVector PointLocation;
-
-	for (int Idx = 0; Idx <= LastIdx; Idx++)
-	{
-		UpVectorScaled = OffsetDist * (BaseSpline->GetUpVectorAtSplinePoint(Idx, CoordinateSpace));
-		TanAtPoint = (BaseSpline->GetTangentAtSplinePoint(Idx, CoordinateSpace));
-		OffsetVector = UpVectorScaled.RotateAngleAxis(OffsetRotFromUp, TanAtPoint.GetSafeNormal());
-		PointLocation = OffsetVector + (BaseSpline->GetLocationAtSplinePoint(Idx, CoordinateSpace));
-		OffsetSpline->AddSplinePointAtIndex(PointLocation, Idx, CoordinateSpace, false);
-
-		OffsetSpline->SetTangentAtSplinePoint(Idx, TanAtPoint, CoordinateSpace, false);
-
-		OffsetSpline->SetSplinePointType(Idx, BaseSpline->GetSplinePointType(Idx), false);
-	}
-
-	OffsetSpline->UpdateSpline();
-
-	// Fix tangents
-	FVector ArriveTan;
-	FVector LeaveTan;
-	FVector BaseTan;
-	int32 ArriveIndex;
-	int32 ArriveLoopingIdx;
-	int32 LeaveLoopingIdx;
-	for (int32 OuterIdx = 0; OuterIdx <= 2; OuterIdx++)
-	{
-		for (int InnerIdx = 0; InnerIdx <= LastIdx; InnerIdx++)
-		{
-			BaseTan = BaseSpline->GetTangentAtSplinePoint(InnerIdx, CoordinateSpace);
-
-			ArriveIndex = FMath::Clamp(int32(InnerIdx - 1), 0, int32(LastIdx + 1));
-			ArriveLoopingIdx = ((InnerIdx - 1) < 0 ? LastIdx : 0);
-			ArriveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
-									OffsetSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))) /
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveIndex) +
-									BaseSpline->GetDistanceAlongSplineAtSplinePoint(ArriveLoopingIdx))));
-
-			LeaveLoopingIdx = (LastIdx == InnerIdx ? 1 : 0);
-			LeaveTan = BaseTan * ((OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(OffsetSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
-									(OffsetSpline->GetSplineLength() * LeaveLoopingIdx))) /
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx) -
-									(BaseSpline->GetDistanceAlongSplineAtSplinePoint(InnerIdx + 1) +
-									(BaseSpline->GetSplineLength() * LeaveLoopingIdx))));
-
-			OffsetSpline->SetTangentsAtSplinePoint(InnerIdx, ArriveTan, LeaveTan, CoordinateSpace, false);
-		}
-		OffsetSpline->UpdateSpline();
-	}
+	// The corrected spline is built from the offset points directly, the offset spline is only updated for its users
+	FAsgardSplinePoints OffsetPoints;
+	FAsgardSplineBuilder::BuildOffsetPoints(BaseSpline, OffsetRotFromUp, OffsetDist, OffsetPoints);
+	OffsetPoints.WriteToSpline(OffsetSpline);
 
 	CalculateSplineSegmentNumAndLength(BaseSpline, OutNumSegments, OutSegmentLength, IdealSegmentLength);
-	CorrectedSpline->ClearSplinePoints(true);
-	LastIdx = OutNumSegments + (BaseSpline->IsClosedLoop() ? -1 : 0);
-	FVector Location;
-	FVector LocationOffset;
-	FVector Tangent;
-	for (int32 Idx = 0; Idx <= LastIdx; Idx++)
-	{
-		Location = BaseSpline->GetLocationAtDistanceAlongSpline(Idx * OutSegmentLength, CoordinateSpace);
-		CorrectedSpline->AddSplinePointAtIndex(Location, Idx, CoordinateSpace, false);
 
-		LocationOffset = OffsetSpline->FindLocationClosestToWorldLocation(Location, CoordinateSpace);
-		CorrectedSpline->SetUpVectorAtSplinePoint(Idx, (LocationOffset - Location).GetSafeNormal(), CoordinateSpace, false);
-
-		Tangent = OutSegmentLength* ((BaseSpline->GetTangentAtDistanceAlongSpline(Idx * OutSegmentLength, CoordinateSpace)).GetSafeNormal());
-		CorrectedSpline->SetTangentAtSplinePoint(Idx, Tangent, CoordinateSpace, false);
-	}
-	CorrectedSpline->UpdateSpline();
+	FAsgardSplinePoints CorrectedPoints;
+	FAsgardSplineBuilder::BuildCorrectedPoints(BaseSpline, OffsetPoints, OutNumSegments, OutSegmentLength, CorrectedPoints);
+	CorrectedPoints.WriteToSpline(CorrectedSpline);
 }
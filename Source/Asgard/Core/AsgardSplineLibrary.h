@@ -7,6 +7,24 @@
 #include "Runtime/Engine/Classes/Components/SplineComponent.h"
 #include "AsgardSplineLibrary.generated.h"
 
+class USplineMeshComponent;
+
+/** Everything needed to pose a spline mesh along one segment of a spline. */
+struct FAsgardSplineMeshSegment
+{
+	FVector StartLocation;
+	FVector StartTangent;
+	FVector EndLocation;
+	FVector EndTangent;
+	FVector UpDirection;
+	float StartRoll;
+	float EndRoll;
+	FVector2D StartScale;
+	FVector2D EndScale;
+
+	bool Equals(const FAsgardSplineMeshSegment& Other, float Tolerance = KINDA_SMALL_NUMBER) const;
+};
+
 /**
  * Library of functions for working with splines.
  */
@@ -56,6 +74,22 @@ public:
 			float Roll = 0.0f,
 			bool UpdateMesh = false);
 
+	/** Calculates how MatchSplineMeshToSpline poses a spline mesh, without touching the spline mesh. */
+	static void CalculateSplineMeshSegment(
+		const int32 SegmentIndex,
+		const float SegmentLength,
+		const USplineComponent* Spline,
+		const FVector2D& StartScale,
+		const FVector2D& EndScale,
+		const float Roll,
+		FAsgardSplineMeshSegment& OutSegment);
+
+	/** Poses a spline mesh along a segment calculated by CalculateSplineMeshSegment. */
+	static void ApplySplineMeshSegment(
+		USplineMeshComponent* SplineMesh,
+		const FAsgardSplineMeshSegment& Segment,
+		bool UpdateMesh = false);
+
 	/** Input a Spline to offset with offset distance and rotation from the spline's up vector at each point. */
 	UFUNCTION(BlueprintCallable, Category = "Asgard|SplineLibrary")
 		static void BuildOffsetSpline(
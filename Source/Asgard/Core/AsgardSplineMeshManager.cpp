@@ -0,0 +1,178 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "AsgardSplineMeshManager.h"
+#include "Runtime/Engine/Classes/Components/SplineMeshComponent.h"
+#include "Engine/StaticMesh.h"
+
+// Sets default values for this component's properties
+UAsgardSplineMeshManager::UAsgardSplineMeshManager()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	Mesh = nullptr;
+	IdealSegmentLength = 100.0f;
+	StartScale = FVector2D(1.0f, 1.0f);
+	EndScale = FVector2D(1.0f, 1.0f);
+	Roll = 0.0f;
+	bPosesInvalidated = false;
+}
+
+void UAsgardSplineMeshManager::UpdateSplineMeshes(USplineComponent* Spline, int32& OutNumUpdated, int32& OutNumReused)
+{
+	checkf(Spline != nullptr, TEXT("UpdateSplineMeshes failed! Spline was null."));
+
+	OutNumUpdated = 0;
+	OutNumReused = 0;
+
+	// Poses are relative to the spline, they can't be compared to the poses of another spline
+	if (LastSpline.Get() != Spline)
+	{
+		ClearSplineMeshes();
+		LastSpline = Spline;
+	}
+
+	const bool bMeshChanged = LastMesh.Get() != Mesh;
+	const bool bForceUpdate = bMeshChanged || bPosesInvalidated;
+	LastMesh = Mesh;
+	bPosesInvalidated = false;
+
+	int32 NumSegments;
+	float SegmentLength;
+	UAsgardSplineLibrary::CalculateSplineSegmentNumAndLength(Spline, NumSegments, SegmentLength, IdealSegmentLength);
+
+	// Pool the segments past the end of the spline
+	while (ActiveSegments.Num() > NumSegments)
+	{
+		ReleaseSegment(ActiveSegments.Pop(false));
+		SegmentPoses.Pop(false);
+	}
+
+	FAsgardSplineMeshSegment Pose;
+	for (int32 SegmentIndex = 0; SegmentIndex < NumSegments; SegmentIndex++)
+	{
+		UAsgardSplineLibrary::CalculateSplineMeshSegment(SegmentIndex, SegmentLength, Spline, StartScale, EndScale, Roll, Pose);
+
+		if (SegmentIndex < ActiveSegments.Num())
+		{
+			USplineMeshComponent* Segment = ActiveSegments[SegmentIndex];
+
+			// Segments are exposed by GetSplineMeshes, so they may have been destroyed outside of the manager
+			if (!IsValid(Segment))
+			{
+				Segment = AcquireSegment(Spline);
+				ActiveSegments[SegmentIndex] = Segment;
+				UAsgardSplineLibrary::ApplySplineMeshSegment(Segment, Pose, true);
+				SegmentPoses[SegmentIndex] = Pose;
+				OutNumUpdated++;
+				continue;
+			}
+
+			if (bMeshChanged)
+			{
+				Segment->SetStaticMesh(Mesh);
+			}
+			else if (!bForceUpdate && Pose.Equals(SegmentPoses[SegmentIndex]))
+			{
+				OutNumReused++;
+				continue;
+			}
+
+			UAsgardSplineLibrary::ApplySplineMeshSegment(Segment, Pose, true);
+			SegmentPoses[SegmentIndex] = Pose;
+		}
+		else
+		{
+			USplineMeshComponent* Segment = AcquireSegment(Spline);
+			UAsgardSplineLibrary::ApplySplineMeshSegment(Segment, Pose, true);
+			ActiveSegments.Add(Segment);
+			SegmentPoses.Add(Pose);
+		}
+
+		OutNumUpdated++;
+	}
+}
+
+void UAsgardSplineMeshManager::ClearSplineMeshes()
+{
+	while (ActiveSegments.Num() > 0)
+	{
+		ReleaseSegment(ActiveSegments.Pop(false));
+	}
+	SegmentPoses.Reset();
+}
+
+void UAsgardSplineMeshManager::InvalidateSplineMeshes()
+{
+	bPosesInvalidated = true;
+}
+
+void UAsgardSplineMeshManager::OnComponentDestroyed(bool bDestroyingHierarchy)
+{
+	for (USplineMeshComponent* Segment : ActiveSegments)
+	{
+		if (IsValid(Segment))
+		{
+			Segment->DestroyComponent();
+		}
+	}
+	for (USplineMeshComponent* Segment : PooledSegments)
+	{
+		if (IsValid(Segment))
+		{
+			Segment->DestroyComponent();
+		}
+	}
+	ActiveSegments.Empty();
+	PooledSegments.Empty();
+	PooledCollisionEnabled.Empty();
+	SegmentPoses.Empty();
+
+	Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
+
+USplineMeshComponent* UAsgardSplineMeshManager::AcquireSegment(USplineComponent* Spline)
+{
+	USplineMeshComponent* Segment = nullptr;
+	ECollisionEnabled::Type CollisionEnabled = ECollisionEnabled::NoCollision;
+	while (!IsValid(Segment) && PooledSegments.Num() > 0)
+	{
+		Segment = PooledSegments.Pop(false);
+		CollisionEnabled = PooledCollisionEnabled.Pop(false);
+	}
+
+	if (IsValid(Segment))
+	{
+		if (Segment->GetAttachParent() != Spline)
+		{
+			Segment->AttachToComponent(Spline, FAttachmentTransformRules::KeepRelativeTransform);
+		}
+		Segment->SetVisibility(true);
+		Segment->SetCollisionEnabled(CollisionEnabled);
+	}
+	else
+	{
+		Segment = NewObject<USplineMeshComponent>(GetOwner());
+		Segment->SetMobility(EComponentMobility::Movable);
+		Segment->SetupAttachment(Spline);
+		Segment->RegisterComponent();
+	}
+
+	if (Segment->GetStaticMesh() != Mesh)
+	{
+		Segment->SetStaticMesh(Mesh);
+	}
+
+	return Segment;
+}
+
+void UAsgardSplineMeshManager::ReleaseSegment(USplineMeshComponent* Segment)
+{
+	if (IsValid(Segment))
+	{
+		// Hidden segments must not keep blocking traces and overlaps, the setting is restored when the segment is reused
+		PooledCollisionEnabled.Add(Segment->GetCollisionEnabled());
+		Segment->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Segment->SetVisibility(false);
+		PooledSegments.Add(Segment);
+	}
+}
@@ -0,0 +1,97 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AsgardSplineLibrary.h"
+#include "AsgardSplineMeshManager.generated.h"
+
+class UStaticMesh;
+class USplineMeshComponent;
+
+/**
+ * Keeps a set of spline mesh segments matched to a spline.
+ * Segments are only re-posed when their start, end, up direction, roll or scale changed since the last update,
+ * and segments no longer needed are hidden, have their collision disabled and are pooled instead of destroyed.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class ASGARD_API UAsgardSplineMeshManager : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:	
+	// Sets default values for this component's properties
+	UAsgardSplineMeshManager();
+
+	/** The mesh used by every segment. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SplineMeshManager")
+	UStaticMesh* Mesh;
+
+	/** Segments are as close to this length as possible while evenly dividing the spline. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SplineMeshManager", meta = (ClampMin = "1.0"))
+	float IdealSegmentLength;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SplineMeshManager")
+	FVector2D StartScale;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SplineMeshManager")
+	FVector2D EndScale;
+
+	/** Roll of every segment, in degrees. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|SplineMeshManager")
+	float Roll;
+
+	/**
+	* Matches the segments to the spline, creating or pooling segments as the number of segments changes.
+	* Segments are attached to the spline.
+	* @param OutNumUpdated Segments which were re-posed, including new segments.
+	* @param OutNumReused Segments which kept their previous pose.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Asgard|SplineMeshManager")
+	void UpdateSplineMeshes(USplineComponent* Spline, int32& OutNumUpdated, int32& OutNumReused);
+
+	/** Hides and pools all segments. */
+	UFUNCTION(BlueprintCallable, Category = "Asgard|SplineMeshManager")
+	void ClearSplineMeshes();
+
+	/** Forgets the previous poses so the next update re-poses every segment. */
+	UFUNCTION(BlueprintCallable, Category = "Asgard|SplineMeshManager")
+	void InvalidateSplineMeshes();
+
+	UFUNCTION(BlueprintPure, Category = "Asgard|SplineMeshManager")
+	const TArray<USplineMeshComponent*>& GetSplineMeshes() const { return ActiveSegments; }
+
+protected:
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+
+private:
+	/** Takes a segment from the pool and restores its collision, or creates one if the pool is empty. */
+	USplineMeshComponent* AcquireSegment(USplineComponent* Spline);
+
+	/** Hides a segment, disables its collision and adds it to the pool. */
+	void ReleaseSegment(USplineMeshComponent* Segment);
+
+	/** Segments currently matched to the spline, in order. */
+	UPROPERTY(Transient)
+	TArray<USplineMeshComponent*> ActiveSegments;
+
+	/** Hidden segments waiting to be reused. */
+	UPROPERTY(Transient)
+	TArray<USplineMeshComponent*> PooledSegments;
+
+	/** The collision each pooled segment had before it was released. */
+	TArray<TEnumAsByte<ECollisionEnabled::Type>> PooledCollisionEnabled;
+
+	/** The pose of each active segment at the last update. */
+	TArray<FAsgardSplineMeshSegment> SegmentPoses;
+
+	/** The spline the segments were matched to at the last update. */
+	TWeakObjectPtr<USplineComponent> LastSpline;
+
+	/** The mesh the segments were using at the last update. */
+	TWeakObjectPtr<UStaticMesh> LastMesh;
+
+	/** Set by InvalidateSplineMeshes. */
+	bool bPosesInvalidated;
+};
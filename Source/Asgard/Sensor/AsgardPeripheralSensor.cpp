@@ -2,6 +2,36 @@
 
 #include "AsgardPeripheralSensor.h"
 
+DECLARE_CYCLE_STAT(TEXT("AsgardPeripheralSensor Tick"), STAT_ASGARD_PeripheralSensorTick, STATGROUP_ASGARD_PeripheralSensor);
+
+namespace AsgardPeripheralSensor
+{
+	/** Approximation of Atan2 in degrees, within a quarter of a degree. */
+	FORCEINLINE float FastAtan2Degrees(float Y, float X)
+	{
+		const float AbsY = FMath::Abs(Y);
+		const float AbsX = FMath::Abs(X);
+		if (AbsX < SMALL_NUMBER && AbsY < SMALL_NUMBER)
+		{
+			return 0.0f;
+		}
+
+		// Approximate atan on [0, 1], then unfold it to the other octants
+		const bool bSteep = AbsY > AbsX;
+		const float Ratio = bSteep ? AbsX / AbsY : AbsY / AbsX;
+		float Angle = Ratio * (45.0f + 15.642f * (1.0f - Ratio));
+		if (bSteep)
+		{
+			Angle = 90.0f - Angle;
+		}
+		if (X < 0.0f)
+		{
+			Angle = 180.0f - Angle;
+		}
+		return Y < 0.0f ? -Angle : Angle;
+	}
+}
+
 UAsgardPeripheralSensor::UAsgardPeripheralSensor(const FObjectInitializer& ObjectInitializer /*= FObjectInitializer::Get()*/)
 	:Super(ObjectInitializer)
 {
@@ -10,6 +40,10 @@ UAsgardPeripheralSensor::UAsgardPeripheralSensor(const FObjectInitializer& Objec
 	Min3DAngleFromSensor = 45.0f;
 	Min2DAngleBetweenTrackedPoints = 45.0f;
 	MinDistanceFromSensor = 5.0f;
+	RollBinSize = 5.0f;
+	BinSmoothingSpeed = 0.0f;
+	ClosestPointRequeryDistance = 1.0f;
+	CacheTick = 0;
 }
 
 void UAsgardPeripheralSensor::BeginPlay()
@@ -20,112 +54,183 @@ void UAsgardPeripheralSensor::BeginPlay()
 
 void UAsgardPeripheralSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_PeripheralSensorTick);
+
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
 	RollAnglesToNearestTrackedPoints.Reset();
-	// If components are detected
-	if (GetDetectedComponents().Num() > 0)
+	CacheTick++;
+
+	// Size the bins, they are kept between frames for smoothing
+	const float BinSize = FMath::Clamp(RollBinSize, 1.0f, 90.0f);
+	const int32 NumBins = FMath::CeilToInt(360.0f / BinSize);
+	if (BinDistances.Num() != NumBins)
+	{
+		BinDistances.Init(-1.0f, NumBins);
+		BinRollAngles.Init(0.0f, NumBins);
+	}
+	FrameBinDistances.Init(-1.0f, NumBins);
+	FrameBinRollAngles.SetNumUninitialized(NumBins);
+
+	// Cache variables
+	const FTransform& SelfTransform = GetComponentTransform();
+	FVector SelfLocation = SelfTransform.GetLocation();
+	FVector SelfForward = SelfTransform.GetUnitAxis(EAxis::X);
+	FVector SelfRight = SelfTransform.GetUnitAxis(EAxis::Y);
+	FVector SelfUp = SelfTransform.GetUnitAxis(EAxis::Z);
+	float MaxForwardCos = FMath::Cos(FMath::DegreesToRadians(Min3DAngleFromSensor));
+
+	// Put the nearest point of each detected component in its roll angle bin
+	for (UPrimitiveComponent* DetectedComponent : GetDetectedComponents())
 	{
-		// Cache variables
-		TMap<FVector, float> DistancesByDirection;
-		const FTransform& SelfTransform = GetComponentTransform();
-		FVector SelfLocation = SelfTransform.GetLocation();
-		FVector SelfForward = SelfTransform.GetUnitAxis(EAxis::X);
-		float MinForwardAngle = FMath::DegreesToRadians(Min3DAngleFromSensor);
-
-		// For each detected component
-		for (UPrimitiveComponent* DetectedComponent : GetDetectedComponents())
+		if (IsValid(DetectedComponent))
 		{
-			if (DetectedComponent)
-			{
-				// Get the closest point and distance
-				FVector OutPointOnBody;
-				float DistanceFromSelf = DetectedComponent->GetClosestPointOnCollision(SelfLocation, OutPointOnBody);
+			// Get the closest point and distance
+			FVector PointOnBody;
+			float DistanceFromSelf = GetClosestPoint(DetectedComponent, SelfLocation, PointOnBody);
 
-				// If the point is far enough away
-				if (DistanceFromSelf > MinDistanceFromSensor)
+			// If the point is far enough away
+			if (DistanceFromSelf > MinDistanceFromSensor)
+			{
+				// If the point is angled enough away from the center of the Sensor, compared without normalizing the direction
+				FVector Direction = PointOnBody - SelfLocation;
+				if (FMath::Abs(FVector::DotProduct(Direction, SelfForward)) < MaxForwardCos * DistanceFromSelf)
 				{
-					// If the point is angled enough away from the center of the Sensor
-					OutPointOnBody = (OutPointOnBody - SelfLocation).GetSafeNormal();
-					float AngleFromForward = FMath::Acos(FMath::Abs(FVector::DotProduct(OutPointOnBody, SelfForward)));
-					if (AngleFromForward > MinForwardAngle)
+					float RollAngle = AsgardPeripheralSensor::FastAtan2Degrees(FVector::DotProduct(Direction, SelfRight), FVector::DotProduct(Direction, SelfUp));
+					int32 BinIndex = GetBinIndex(RollAngle);
+					if (FrameBinDistances[BinIndex] < 0.0f || DistanceFromSelf < FrameBinDistances[BinIndex])
 					{
-						// Add to potential points and distances
-						auto ExistingEntry = DistancesByDirection.Find(OutPointOnBody);
-						if (ExistingEntry != nullptr)
-						{
-							if (*ExistingEntry < DistanceFromSelf)
-							{
-								*ExistingEntry = DistanceFromSelf;
-							}
-						}
-						else
-						{
-							DistancesByDirection.Add(OutPointOnBody, DistanceFromSelf);
-						}
+						FrameBinDistances[BinIndex] = DistanceFromSelf;
+						FrameBinRollAngles[BinIndex] = RollAngle;
 					}
 				}
 			}
 		}
+	}
+
+	// Forget the closest points of components which aren't detected anymore or were destroyed
+	for (auto It = ClosestPointCache.CreateIterator(); It; ++It)
+	{
+		if (It.Value().LastTick != CacheTick || !It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
 
-		// If there is at least one potential point
-		if (DistancesByDirection.Num() > 0)
+	// Update the bins, smoothing the distances of bins which were already occupied
+	for (int32 BinIndex = 0; BinIndex < NumBins; BinIndex++)
+	{
+		if (FrameBinDistances[BinIndex] < 0.0f)
+		{
+			BinDistances[BinIndex] = -1.0f;
+			continue;
+		}
+
+		if (BinSmoothingSpeed > 0.0f && BinDistances[BinIndex] >= 0.0f)
+		{
+			BinDistances[BinIndex] = FMath::FInterpTo(BinDistances[BinIndex], FrameBinDistances[BinIndex], DeltaTime, BinSmoothingSpeed);
+		}
+		else
+		{
+			BinDistances[BinIndex] = FrameBinDistances[BinIndex];
+		}
+		BinRollAngles[BinIndex] = FrameBinRollAngles[BinIndex];
+	}
+
+	// Pick the nearest bins, skipping bins too close to an already picked bin
+	TArray<int32, TInlineAllocator<8>> TrackedBins;
+	int32 MaxPoints = MaxTrackedPoints > 0 ? MaxTrackedPoints : NumBins;
+	while (TrackedBins.Num() < MaxPoints)
+	{
+		int32 NearestBin = INDEX_NONE;
+		float NearestDistance = BIG_NUMBER;
+		for (int32 BinIndex = 0; BinIndex < NumBins; BinIndex++)
 		{
-			// Sort the points by distance
-			DistancesByDirection.ValueSort([](const float A, const float B) {
-				return A < B;
-				});
-
-			// Cache variables
-			TArray<FVector> TrackedPoints;
-			TrackedPoints.Reserve(MaxTrackedPoints);
-			float MinAngleFromPoint = FMath::DegreesToRadians(Min2DAngleBetweenTrackedPoints);
-
-			// For each potential point
-			for (auto& DistanceByPoint : DistancesByDirection)
+			float BinDistance = BinDistances[BinIndex];
+			if (BinDistance < 0.0f || BinDistance >= NearestDistance || TrackedBins.Contains(BinIndex))
 			{
-				// Project and normalize the point
-				FVector ProjectedPointNormalized = DistanceByPoint.Key;
-				ProjectedPointNormalized = SelfTransform.InverseTransformVectorNoScale(ProjectedPointNormalized);
-				ProjectedPointNormalized.X = 0.0f;
-				ProjectedPointNormalized = ProjectedPointNormalized.GetSafeNormal();
-				
-				// Check the angle to the point against the angle from
-				bool bTooCloseToTrackedPoint = false;
-				for (FVector& CurrPoint : TrackedPoints)
-				{
-					// If the angle is too close to a currently tracked point, abort the loop
-					if (FMath::Acos(FVector::DotProduct(CurrPoint, ProjectedPointNormalized)) < MinAngleFromPoint)
-					{
-						bTooCloseToTrackedPoint = true;
-						break;
-					}
-				}
+				continue;
+			}
 
-				// If the angle was far enough away from any currently tracked points, add it to the list of tracked points
-				if (!bTooCloseToTrackedPoint)
+			bool bTooCloseToTrackedPoint = false;
+			for (int32 TrackedBin : TrackedBins)
+			{
+				if (FMath::Abs(FMath::FindDeltaAngleDegrees(BinRollAngles[TrackedBin], BinRollAngles[BinIndex])) < Min2DAngleBetweenTrackedPoints)
 				{
-					TrackedPoints.Emplace(ProjectedPointNormalized);
-
-					// If we have reached the limited of tracked points, break the loop
-					if (MaxTrackedPoints > 0 && TrackedPoints.Num() >= MaxTrackedPoints)
-					{
-						break;
-					}
+					bTooCloseToTrackedPoint = true;
+					break;
 				}
 			}
 
-			// Calculate the roll angle to each tracked point
-			for (FVector& TrackedPoint : TrackedPoints)
+			if (!bTooCloseToTrackedPoint)
 			{
-				float ValueToAdd = FMath::RadiansToDegrees(FMath::Atan2(TrackedPoint.Y, TrackedPoint.Z));
-				RollAnglesToNearestTrackedPoints.Add(ValueToAdd);
+				NearestBin = BinIndex;
+				NearestDistance = BinDistance;
 			}
-			RollAnglesToNearestTrackedPoints.Sort([](const float A, const float B) {
-				return A < B;
-				});
+		}
+
+		if (NearestBin == INDEX_NONE)
+		{
+			break;
+		}
+		TrackedBins.Add(NearestBin);
+	}
+
+	// Bins are ordered by roll angle, so the angles come out sorted
+	for (int32 BinIndex = 0; BinIndex < NumBins && RollAnglesToNearestTrackedPoints.Num() < TrackedBins.Num(); BinIndex++)
+	{
+		if (TrackedBins.Contains(BinIndex))
+		{
+			RollAnglesToNearestTrackedPoints.Add(BinRollAngles[BinIndex]);
 		}
 	}
 
 	return;
 }
+
+float UAsgardPeripheralSensor::GetNearestDistanceAtRollAngle(float RollAngle) const
+{
+	if (BinDistances.Num() == 0)
+	{
+		return -1.0f;
+	}
+	return BinDistances[GetBinIndex(FRotator::NormalizeAxis(RollAngle))];
+}
+
+float UAsgardPeripheralSensor::GetClosestPoint(UPrimitiveComponent* Component, const FVector& SelfLocation, FVector& OutPointOnBody)
+{
+	FCachedClosestPoint* Cached = ClosestPointCache.Find(Component);
+	if (Cached
+		&& FVector::DistSquared(Cached->QueryLocation, SelfLocation) <= FMath::Square(ClosestPointRequeryDistance)
+		&& Cached->ComponentTransform.Equals(Component->GetComponentTransform()))
+	{
+		Cached->LastTick = CacheTick;
+		OutPointOnBody = Cached->PointOnBody;
+
+		// No collision or inside the collision, nothing changed since the query
+		if (Cached->Distance <= 0.0f)
+		{
+			return Cached->Distance;
+		}
+		return (Cached->PointOnBody - SelfLocation).Size();
+	}
+
+	if (Cached == nullptr)
+	{
+		Cached = &ClosestPointCache.Add(Component);
+	}
+
+	Cached->ComponentTransform = Component->GetComponentTransform();
+	Cached->QueryLocation = SelfLocation;
+	Cached->Distance = Component->GetClosestPointOnCollision(SelfLocation, Cached->PointOnBody);
+	Cached->LastTick = CacheTick;
+
+	OutPointOnBody = Cached->PointOnBody;
+	return Cached->Distance;
+}
+
+int32 UAsgardPeripheralSensor::GetBinIndex(float RollAngle) const
+{
+	const int32 NumBins = BinDistances.Num();
+	return FMath::Clamp(FMath::FloorToInt((RollAngle + 180.0f) * NumBins / 360.0f), 0, NumBins - 1);
+}
@@ -6,6 +6,9 @@
 #include "Asgard/Sensor/AsgardSphereSensor.h"
 #include "AsgardPeripheralSensor.generated.h"
 
+// Stats group
+DECLARE_STATS_GROUP(TEXT("AsgardPeripheralSensor"), STATGROUP_ASGARD_PeripheralSensor, STATCAT_Advanced);
+
 /**
  *	Class used to sense primitives around the periphery of the player's Sensor without triggering overlap or hit events.
  */
@@ -50,10 +53,70 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|PeripheralSensor")
 	float Min2DAngleBetweenTrackedPoints;
 
+	/**
+	* The size in degrees of each roll angle bin around the Sensor.
+	* Only the nearest point in each bin is kept, so this should not be larger than Min2DAngleBetweenTrackedPoints.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|PeripheralSensor", meta = (ClampMin = "1.0", ClampMax = "90.0"))
+	float RollBinSize;
+
+	/**
+	* How quickly the distance in each bin follows the nearest point, smoothing out jittering distances.
+	* Ignored if <= 0.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|PeripheralSensor")
+	float BinSmoothingSpeed;
+
+	/**
+	* The closest point on a primitive which didn't move is only queried again after the Sensor moved this far.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asgard|PeripheralSensor")
+	float ClosestPointRequeryDistance;
+
+	/**
+	* Returns the distance to the nearest point in the bin containing RollAngle.
+	* Returns -1 if there is no point in the bin.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Asgard|PeripheralSensor")
+	float GetNearestDistanceAtRollAngle(float RollAngle) const;
+
 private:
+	/** The closest point on a detected primitive, kept until the primitive or the Sensor moves. */
+	struct FCachedClosestPoint
+	{
+		FTransform ComponentTransform;
+		FVector QueryLocation;
+		FVector PointOnBody;
+		float Distance;
+		/** The sensor tick the point was last used, points not used by a tick are forgotten at the end of it. */
+		uint32 LastTick;
+	};
+
+	/** Returns the closest point on the primitive, querying its collision only if it or the Sensor moved. */
+	float GetClosestPoint(UPrimitiveComponent* Component, const FVector& SelfLocation, FVector& OutPointOnBody);
+
+	/** Returns the bin containing a roll angle in [-180, 180]. */
+	int32 GetBinIndex(float RollAngle) const;
+
 	/**
 	* Current list of the nearest points on tracked primitives.
 	*/
 	UPROPERTY(BlueprintReadOnly, Category = "Asgard|PeripheralSensor", meta = (AllowPrivateAccess = "true"))
 	TArray<float> RollAnglesToNearestTrackedPoints;
+
+	/** Distance to the nearest point in each roll angle bin, -1 for empty bins. */
+	TArray<float> BinDistances;
+
+	/** Roll angle of the nearest point in each bin. */
+	TArray<float> BinRollAngles;
+
+	/** Nearest point in each bin found this frame, before smoothing. */
+	TArray<float> FrameBinDistances;
+	TArray<float> FrameBinRollAngles;
+
+	/** Weakly keyed so destroyed components never alias a new component allocated at the same address. */
+	TMap<TWeakObjectPtr<UPrimitiveComponent>, FCachedClosestPoint> ClosestPointCache;
+
+	/** Counts ticks for FCachedClosestPoint::LastTick. */
+	uint32 CacheTick;
 };
@@ -0,0 +1,356 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "Asgard/Core/AsgardOptionsSubsystem.h"
+#include "Asgard/Core/AsgardOptions.h"
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "TimerManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Async/TaskGraphInterfaces.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AsgardOptionsSubsystemTests
+{
+	/** Keeps the player's options files and puts them back when the test ends. */
+	struct FScopedOptionsFilesBackup
+	{
+		FScopedOptionsFilesBackup()
+		{
+			bHadFile = FFileHelper::LoadFileToArray(FileData, *UAsgardOptionsSubsystem::GetOptionsFilePath(), FILEREAD_Silent);
+			bHadTempFile = FFileHelper::LoadFileToArray(TempFileData, *UAsgardOptionsSubsystem::GetOptionsTempFilePath(), FILEREAD_Silent);
+		}
+
+		~FScopedOptionsFilesBackup()
+		{
+			Restore(UAsgardOptionsSubsystem::GetOptionsFilePath(), bHadFile, FileData);
+			Restore(UAsgardOptionsSubsystem::GetOptionsTempFilePath(), bHadTempFile, TempFileData);
+		}
+
+	private:
+		static void Restore(const FString& FilePath, bool bHadFile, const TArray<uint8>& Data)
+		{
+			if (bHadFile)
+			{
+				FFileHelper::SaveArrayToFile(Data, *FilePath);
+			}
+			else
+			{
+				IFileManager::Get().Delete(*FilePath, false, true, true);
+			}
+		}
+
+		bool bHadFile;
+		bool bHadTempFile;
+		TArray<uint8> FileData;
+		TArray<uint8> TempFileData;
+	};
+
+	/** A game instance with its subsystems initialized, the options start loading right away. */
+	static UGameInstance* CreateGameInstance()
+	{
+		UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+		GameInstance->Init();
+		return GameInstance;
+	}
+
+	/** Runs the game thread tasks until the options have been read and applied. */
+	static bool WaitForOptionsLoaded(UAsgardOptionsSubsystem* OptionsSubsystem)
+	{
+		const double TimeoutTime = FPlatformTime::Seconds() + 10.0;
+		while (!OptionsSubsystem->AreOptionsLoaded() && FPlatformTime::Seconds() < TimeoutTime)
+		{
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+			FPlatformProcess::Sleep(0.001f);
+		}
+		return OptionsSubsystem->AreOptionsLoaded();
+	}
+
+	/** Advances the game instance timers by one frame, the timer manager only ticks once per frame. */
+	static void TickTimers(UGameInstance* GameInstance, float DeltaTime)
+	{
+		GFrameCounter++;
+		GameInstance->GetTimerManager().Tick(DeltaTime);
+	}
+
+	/** Waits for the options file write in progress to finish. */
+	static bool WaitForOptionsWritten(UAsgardOptionsSubsystem* OptionsSubsystem)
+	{
+		const double TimeoutTime = FPlatformTime::Seconds() + 10.0;
+		while (OptionsSubsystem->IsWritingOptions() && FPlatformTime::Seconds() < TimeoutTime)
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+		return !OptionsSubsystem->IsWritingOptions();
+	}
+
+	/** Saved options which differ from the defaults in every field. */
+	static UAsgardOptions* CreateChangedOptions()
+	{
+		UAsgardOptions* Options = Cast<UAsgardOptions>(UGameplayStatics::CreateSaveGameObject(UAsgardOptions::StaticClass()));
+		Options->Handedness = EAsgardBinaryHand::LeftHand;
+		Options->DefaultGroundMovementMode = EAsgardGroundMovementMode::SmoothWalk;
+		Options->WalkOrientationMode = EAsgardOrientationMode::RightController;
+		Options->TeleportToLocationDefaultMode = EAsgardTeleportMode::Instant;
+		Options->TeleportToRotationDefaultMode = EAsgardTeleportMode::Smooth;
+		Options->TeleportTurnAngleInterval = 30.0f;
+		return Options;
+	}
+
+	/** Reads the options file the way the subsystem does. */
+	static UAsgardOptions* LoadOptionsFile(const FString& FilePath)
+	{
+		TArray<uint8> FileData;
+		if (!FFileHelper::LoadFileToArray(FileData, *FilePath, FILEREAD_Silent))
+		{
+			return nullptr;
+		}
+		return Cast<UAsgardOptions>(UGameplayStatics::LoadGameFromMemory(FileData));
+	}
+}
+
+/**
+ * Hammers the options setters, checks changes are batched into few writes and the options file holds the last options.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardOptionsWritesTest, "Asgard.OptionsSubsystem.Writes",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardOptionsWritesTest::RunTest(const FString& Parameters)
+{
+	using namespace AsgardOptionsSubsystemTests;
+
+	FScopedOptionsFilesBackup Backup;
+	IFileManager::Get().Delete(*UAsgardOptionsSubsystem::GetOptionsFilePath(), false, true, true);
+	IFileManager::Get().Delete(*UAsgardOptionsSubsystem::GetOptionsTempFilePath(), false, true, true);
+
+	UGameInstance* GameInstance = CreateGameInstance();
+	UAsgardOptionsSubsystem* OptionsSubsystem = GameInstance->GetSubsystem<UAsgardOptionsSubsystem>();
+	if (!OptionsSubsystem)
+	{
+		AddError(TEXT("The options subsystem was not created."));
+		return false;
+	}
+
+	TestTrue(TEXT("Options loaded"), WaitForOptionsLoaded(OptionsSubsystem));
+
+	// No options file yet, the defaults are waiting for the save delay
+	TestEqual(TEXT("Nothing written before the save delay"), OptionsSubsystem->GetNumOptionsWrites(), 0);
+
+	const int32 NumBatches = 20;
+	const int32 NumChangesPerBatch = 50;
+	int32 NumWritesBefore = OptionsSubsystem->GetNumOptionsWrites();
+	for (int32 Batch = 0; Batch < NumBatches; Batch++)
+	{
+		for (int32 Idx = 0; Idx < NumChangesPerBatch; Idx++)
+		{
+			const int32 Change = Batch * NumChangesPerBatch + Idx;
+			OptionsSubsystem->SetHandedness(Change % 2 == 0 ? EAsgardBinaryHand::LeftHand : EAsgardBinaryHand::RightHand);
+			OptionsSubsystem->SetWalkOrientationMode((EAsgardOrientationMode)(Change % 3));
+			OptionsSubsystem->SetTeleportTurnAngleInterval(float(Change % 180));
+		}
+
+		TestEqual(TEXT("Setters don't write"), OptionsSubsystem->GetNumOptionsWrites(), NumWritesBefore);
+
+		// A flush while the previous write is still running waits for the save delay instead of writing
+		OptionsSubsystem->FlushOptions();
+		TestTrue(TEXT("At most one write per flush"), OptionsSubsystem->GetNumOptionsWrites() <= NumWritesBefore + 1);
+		NumWritesBefore = OptionsSubsystem->GetNumOptionsWrites();
+	}
+
+	// Shutting down waits for the write in progress and writes the last changes
+	GameInstance->Shutdown();
+
+	const int32 NumWrites = OptionsSubsystem->GetNumOptionsWrites();
+	AddInfo(FString::Printf(TEXT("%d option changes written in %d writes."), NumBatches * NumChangesPerBatch * 3, NumWrites));
+	TestTrue(TEXT("Changes were written"), NumWrites > 0);
+	TestTrue(TEXT("At most one write per flush and one on shutdown"), NumWrites <= NumBatches + 1);
+
+	const int32 LastChange = NumBatches * NumChangesPerBatch - 1;
+	UAsgardOptions* SavedOptions = LoadOptionsFile(UAsgardOptionsSubsystem::GetOptionsFilePath());
+	if (!SavedOptions)
+	{
+		AddError(TEXT("The options file could not be read."));
+		return false;
+	}
+
+	TestTrue(TEXT("Saved handedness"), SavedOptions->Handedness == (LastChange % 2 == 0 ? EAsgardBinaryHand::LeftHand : EAsgardBinaryHand::RightHand));
+	TestTrue(TEXT("Saved walk orientation"), SavedOptions->WalkOrientationMode == (EAsgardOrientationMode)(LastChange % 3));
+	TestEqual(TEXT("Saved teleport turn angle"), SavedOptions->TeleportTurnAngleInterval, float(LastChange % 180));
+	TestFalse(TEXT("No temporary file left"), IFileManager::Get().FileExists(*UAsgardOptionsSubsystem::GetOptionsTempFilePath()));
+
+	return true;
+}
+
+/**
+ * Simulates a write interrupted between removing the options file and moving the temporary file, the options must still load.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardOptionsTempFileRecoveryTest, "Asgard.OptionsSubsystem.TempFileRecovery",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardOptionsTempFileRecoveryTest::RunTest(const FString& Parameters)
+{
+	using namespace AsgardOptionsSubsystemTests;
+
+	FScopedOptionsFilesBackup Backup;
+	IFileManager::Get().Delete(*UAsgardOptionsSubsystem::GetOptionsFilePath(), false, true, true);
+
+	UAsgardOptions* Options = CreateChangedOptions();
+
+	TArray<uint8> SaveData;
+	TestTrue(TEXT("Options serialized"), UGameplayStatics::SaveGameToMemory(Options, SaveData));
+	TestTrue(TEXT("Temporary file written"), FFileHelper::SaveArrayToFile(SaveData, *UAsgardOptionsSubsystem::GetOptionsTempFilePath()));
+
+	UGameInstance* GameInstance = CreateGameInstance();
+	UAsgardOptionsSubsystem* OptionsSubsystem = GameInstance->GetSubsystem<UAsgardOptionsSubsystem>();
+	if (!OptionsSubsystem)
+	{
+		AddError(TEXT("The options subsystem was not created."));
+		return false;
+	}
+
+	TestTrue(TEXT("Options loaded"), WaitForOptionsLoaded(OptionsSubsystem));
+	TestTrue(TEXT("Handedness recovered"), OptionsSubsystem->GetHandedness() == EAsgardBinaryHand::LeftHand);
+	TestTrue(TEXT("Ground movement recovered"), OptionsSubsystem->GetDefaultGroundMovementMode() == EAsgardGroundMovementMode::SmoothWalk);
+	TestTrue(TEXT("Walk orientation recovered"), OptionsSubsystem->GetWalkOrientationMode() == EAsgardOrientationMode::RightController);
+	TestTrue(TEXT("Teleport to location recovered"), OptionsSubsystem->GetTeleportToLocationDefaultMode() == EAsgardTeleportMode::Instant);
+	TestTrue(TEXT("Teleport to rotation recovered"), OptionsSubsystem->GetTeleportToRotationDefaultMode() == EAsgardTeleportMode::Smooth);
+	TestEqual(TEXT("Teleport turn angle recovered"), OptionsSubsystem->GetTeleportTurnAngleInterval(), 30.0f);
+
+	// The recovered options are not a change, they don't need writing again
+	TestEqual(TEXT("Recovering doesn't write"), OptionsSubsystem->GetNumOptionsWrites(), 0);
+
+	GameInstance->Shutdown();
+
+	TestTrue(TEXT("Options file restored"), IFileManager::Get().FileExists(*UAsgardOptionsSubsystem::GetOptionsFilePath()));
+	TestFalse(TEXT("Temporary file moved"), IFileManager::Get().FileExists(*UAsgardOptionsSubsystem::GetOptionsTempFilePath()));
+
+	return true;
+}
+
+/**
+ * Advances the timer manager through the save delay, changes within the delay must be written together once it has passed.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardOptionsSaveDelayTest, "Asgard.OptionsSubsystem.SaveDelay",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardOptionsSaveDelayTest::RunTest(const FString& Parameters)
+{
+	using namespace AsgardOptionsSubsystemTests;
+
+	FScopedOptionsFilesBackup Backup;
+	IFileManager::Get().Delete(*UAsgardOptionsSubsystem::GetOptionsFilePath(), false, true, true);
+	IFileManager::Get().Delete(*UAsgardOptionsSubsystem::GetOptionsTempFilePath(), false, true, true);
+
+	UGameInstance* GameInstance = CreateGameInstance();
+	UAsgardOptionsSubsystem* OptionsSubsystem = GameInstance->GetSubsystem<UAsgardOptionsSubsystem>();
+	if (!OptionsSubsystem)
+	{
+		AddError(TEXT("The options subsystem was not created."));
+		return false;
+	}
+
+	TestTrue(TEXT("Options loaded"), WaitForOptionsLoaded(OptionsSubsystem));
+
+	// Without an options file the defaults are saved, which starts the save delay
+	const float SaveDelay = OptionsSubsystem->SaveDelay;
+	TickTimers(GameInstance, SaveDelay * 0.4f);
+	TestEqual(TEXT("Nothing written early in the save delay"), OptionsSubsystem->GetNumOptionsWrites(), 0);
+
+	// Changes during the delay neither write nor restart it
+	OptionsSubsystem->SetHandedness(EAsgardBinaryHand::LeftHand);
+	OptionsSubsystem->SetTeleportTurnAngleInterval(90.0f);
+	TickTimers(GameInstance, SaveDelay * 0.4f);
+	TestEqual(TEXT("Nothing written within the save delay"), OptionsSubsystem->GetNumOptionsWrites(), 0);
+
+	TickTimers(GameInstance, SaveDelay * 0.4f);
+	TestEqual(TEXT("Defaults and changes written together after the save delay"), OptionsSubsystem->GetNumOptionsWrites(), 1);
+	TestTrue(TEXT("Write finished"), WaitForOptionsWritten(OptionsSubsystem));
+
+	UAsgardOptions* SavedOptions = LoadOptionsFile(UAsgardOptionsSubsystem::GetOptionsFilePath());
+	if (!SavedOptions)
+	{
+		AddError(TEXT("The options file could not be read."));
+		return false;
+	}
+	TestTrue(TEXT("Saved handedness"), SavedOptions->Handedness == EAsgardBinaryHand::LeftHand);
+	TestEqual(TEXT("Saved teleport turn angle"), SavedOptions->TeleportTurnAngleInterval, 90.0f);
+
+	// Without changes the timer isn't running and nothing is written
+	TickTimers(GameInstance, SaveDelay * 2.0f);
+	TestEqual(TEXT("Nothing written without changes"), OptionsSubsystem->GetNumOptionsWrites(), 1);
+
+	// The next change starts a new delay
+	OptionsSubsystem->SetWalkOrientationMode(EAsgardOrientationMode::RightController);
+	TickTimers(GameInstance, SaveDelay * 0.9f);
+	TestEqual(TEXT("Nothing written within the second save delay"), OptionsSubsystem->GetNumOptionsWrites(), 1);
+	TickTimers(GameInstance, SaveDelay * 0.2f);
+	TestEqual(TEXT("Written after the second save delay"), OptionsSubsystem->GetNumOptionsWrites(), 2);
+
+	GameInstance->Shutdown();
+	TestEqual(TEXT("Nothing left to write on shutdown"), OptionsSubsystem->GetNumOptionsWrites(), 2);
+
+	return true;
+}
+
+/**
+ * Changes made before the saved options finish loading must keep their value without losing the rest of the saved options.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardOptionsChangedWhileLoadingTest, "Asgard.OptionsSubsystem.ChangedWhileLoading",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardOptionsChangedWhileLoadingTest::RunTest(const FString& Parameters)
+{
+	using namespace AsgardOptionsSubsystemTests;
+
+	FScopedOptionsFilesBackup Backup;
+	IFileManager::Get().Delete(*UAsgardOptionsSubsystem::GetOptionsTempFilePath(), false, true, true);
+
+	TArray<uint8> SaveData;
+	TestTrue(TEXT("Options serialized"), UGameplayStatics::SaveGameToMemory(CreateChangedOptions(), SaveData));
+	TestTrue(TEXT("Options file written"), FFileHelper::SaveArrayToFile(SaveData, *UAsgardOptionsSubsystem::GetOptionsFilePath()));
+
+	UGameInstance* GameInstance = CreateGameInstance();
+	UAsgardOptionsSubsystem* OptionsSubsystem = GameInstance->GetSubsystem<UAsgardOptionsSubsystem>();
+	if (!OptionsSubsystem)
+	{
+		AddError(TEXT("The options subsystem was not created."));
+		return false;
+	}
+
+	// The loaded options are applied on the game thread, which hasn't run yet
+	TestFalse(TEXT("Options still loading"), OptionsSubsystem->AreOptionsLoaded());
+	OptionsSubsystem->SetWalkOrientationMode(EAsgardOrientationMode::Character);
+	OptionsSubsystem->SetTeleportTurnAngleInterval(90.0f);
+
+	TestTrue(TEXT("Options loaded"), WaitForOptionsLoaded(OptionsSubsystem));
+	TestTrue(TEXT("Changed walk orientation kept"), OptionsSubsystem->GetWalkOrientationMode() == EAsgardOrientationMode::Character);
+	TestEqual(TEXT("Changed teleport turn angle kept"), OptionsSubsystem->GetTeleportTurnAngleInterval(), 90.0f);
+	TestTrue(TEXT("Saved handedness loaded"), OptionsSubsystem->GetHandedness() == EAsgardBinaryHand::LeftHand);
+	TestTrue(TEXT("Saved ground movement loaded"), OptionsSubsystem->GetDefaultGroundMovementMode() == EAsgardGroundMovementMode::SmoothWalk);
+	TestTrue(TEXT("Saved teleport to location loaded"), OptionsSubsystem->GetTeleportToLocationDefaultMode() == EAsgardTeleportMode::Instant);
+	TestTrue(TEXT("Saved teleport to rotation loaded"), OptionsSubsystem->GetTeleportToRotationDefaultMode() == EAsgardTeleportMode::Smooth);
+
+	// Shutting down writes the changes merged into the saved options
+	GameInstance->Shutdown();
+	TestEqual(TEXT("Merged options written once"), OptionsSubsystem->GetNumOptionsWrites(), 1);
+
+	UAsgardOptions* SavedOptions = LoadOptionsFile(UAsgardOptionsSubsystem::GetOptionsFilePath());
+	if (!SavedOptions)
+	{
+		AddError(TEXT("The options file could not be read."));
+		return false;
+	}
+	TestTrue(TEXT("Saved walk orientation changed"), SavedOptions->WalkOrientationMode == EAsgardOrientationMode::Character);
+	TestEqual(TEXT("Saved teleport turn angle changed"), SavedOptions->TeleportTurnAngleInterval, 90.0f);
+	TestTrue(TEXT("Saved handedness kept"), SavedOptions->Handedness == EAsgardBinaryHand::LeftHand);
+	TestTrue(TEXT("Saved ground movement kept"), SavedOptions->DefaultGroundMovementMode == EAsgardGroundMovementMode::SmoothWalk);
+	TestTrue(TEXT("Saved teleport to location kept"), SavedOptions->TeleportToLocationDefaultMode == EAsgardTeleportMode::Instant);
+	TestTrue(TEXT("Saved teleport to rotation kept"), SavedOptions->TeleportToRotationDefaultMode == EAsgardTeleportMode::Smooth);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
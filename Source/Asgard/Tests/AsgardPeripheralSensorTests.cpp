@@ -0,0 +1,139 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "Asgard/Sensor/AsgardPeripheralSensor.h"
+#include "Asgard/Tests/AsgardTestWorld.h"
+#include "Misc/AutomationTest.h"
+#include "Components/SphereComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "GameFramework/Actor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AsgardPeripheralSensorTests
+{
+	/** Ticks measured for each case of the benchmark. */
+	static const int32 NumBenchmarkTicks = 200;
+
+	/** Distance of the tracked components from the sensor, inside the sensor radius and outside the minimum distance. */
+	static const float ComponentShellRadius = 80.0f;
+
+	/** Spawns NumComponents blocking spheres evenly spread on a shell around the origin. */
+	static void SpawnTrackedComponents(UWorld* World, int32 NumComponents, TArray<AActor*>& OutActors)
+	{
+		for (int32 Idx = 0; Idx < NumComponents; Idx++)
+		{
+			// Fibonacci sphere, so any number of components is spread evenly around the sensor
+			const float Z = 1.0f - (Idx + 0.5f) * 2.0f / NumComponents;
+			const float Radius = FMath::Sqrt(1.0f - Z * Z);
+			const float Angle = Idx * PI * (3.0f - FMath::Sqrt(5.0f));
+			const FVector Location = FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, Z) * ComponentShellRadius;
+
+			AActor* Actor = World->SpawnActor<AActor>(Location, FRotator::ZeroRotator);
+			USphereComponent* Sphere = NewObject<USphereComponent>(Actor);
+			Sphere->InitSphereRadius(2.0f);
+			Sphere->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+			Actor->SetRootComponent(Sphere);
+			Sphere->RegisterComponent();
+			Sphere->SetWorldLocation(Location);
+			OutActors.Add(Actor);
+		}
+	}
+
+	/** Ticks the sensor and returns the average microseconds per tick. */
+	static double TickSensor(UAsgardPeripheralSensor* Sensor, int32 NumTicks, const FVector& MovePerTick)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Idx = 0; Idx < NumTicks; Idx++)
+		{
+			if (!MovePerTick.IsZero())
+			{
+				Sensor->AddWorldOffset(MovePerTick);
+			}
+			Sensor->TickComponent(1.0f / 90.0f, LEVELTICK_All, nullptr);
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1000000.0 / NumTicks;
+	}
+
+	/** Times the sensor tracking NumComponents components, sitting still and moving. */
+	static bool RunPeripheralSensorBenchmark(FAutomationTestBase& Test, int32 NumComponents)
+	{
+		// A world with physics, so the sensor can query overlaps and closest points
+		UWorld* World = AsgardTests::CreateTestWorld();
+
+		TArray<AActor*> TrackedActors;
+		SpawnTrackedComponents(World, NumComponents, TrackedActors);
+
+		AActor* SensorActor = World->SpawnActor<AActor>(FVector::ZeroVector, FRotator::ZeroRotator);
+		UAsgardPeripheralSensor* Sensor = NewObject<UAsgardPeripheralSensor>(SensorActor);
+		Sensor->Radius = ComponentShellRadius + 10.0f;
+		Sensor->bUseAsyncOverlapTests = false;
+		Sensor->MaxTrackedPoints = 4;
+		SensorActor->SetRootComponent(Sensor);
+		Sensor->RegisterComponent();
+
+		// First tick detects the components and fills the closest point cache
+		Sensor->TickComponent(1.0f / 90.0f, LEVELTICK_All, nullptr);
+		Test.TestEqual(TEXT("Every component detected"), Sensor->GetDetectedComponents().Num(), NumComponents);
+
+		// Still: closest points come from the cache. Moving: every closest point is queried again.
+		const double StillTime = TickSensor(Sensor, NumBenchmarkTicks, FVector::ZeroVector);
+		const double MovingTime = TickSensor(Sensor, NumBenchmarkTicks, FVector(0.0f, 0.0f, 0.01f));
+		const double RequeryTime = TickSensor(Sensor, NumBenchmarkTicks / 4, FVector(0.0f, 0.0f, 2.0f));
+
+		Test.AddInfo(FString::Printf(TEXT("%d components: %.1fus per tick still, %.1fus moving under the requery distance, %.1fus requerying"),
+			NumComponents, StillTime, MovingTime, RequeryTime));
+
+		bool bAnyBinOccupied = false;
+		for (float RollAngle = -180.0f; RollAngle < 180.0f; RollAngle += Sensor->RollBinSize)
+		{
+			bAnyBinOccupied |= Sensor->GetNearestDistanceAtRollAngle(RollAngle) >= 0.0f;
+		}
+		Test.TestTrue(TEXT("Points tracked"), bAnyBinOccupied);
+
+		// Destroy half the components, the sensor must forget them without touching the destroyed components
+		for (int32 Idx = 0; Idx < TrackedActors.Num(); Idx += 2)
+		{
+			TrackedActors[Idx]->Destroy();
+		}
+		TickSensor(Sensor, 2, FVector::ZeroVector);
+		Test.TestEqual(TEXT("Destroyed components lost"), Sensor->GetDetectedComponents().Num(), NumComponents / 2);
+
+		AsgardTests::DestroyTestWorld(World);
+		return true;
+	}
+}
+
+/**
+ * Peripheral sensor tick cost with 10 tracked components.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardPeripheralSensorBenchmark10Test, "Asgard.PeripheralSensor.Benchmark10",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardPeripheralSensorBenchmark10Test::RunTest(const FString& Parameters)
+{
+	return AsgardPeripheralSensorTests::RunPeripheralSensorBenchmark(*this, 10);
+}
+
+/**
+ * Peripheral sensor tick cost with 100 tracked components.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardPeripheralSensorBenchmark100Test, "Asgard.PeripheralSensor.Benchmark100",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardPeripheralSensorBenchmark100Test::RunTest(const FString& Parameters)
+{
+	return AsgardPeripheralSensorTests::RunPeripheralSensorBenchmark(*this, 100);
+}
+
+/**
+ * Peripheral sensor tick cost with 500 tracked components.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardPeripheralSensorBenchmark500Test, "Asgard.PeripheralSensor.Benchmark500",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardPeripheralSensorBenchmark500Test::RunTest(const FString& Parameters)
+{
+	return AsgardPeripheralSensorTests::RunPeripheralSensorBenchmark(*this, 500);
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,164 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "Asgard/Core/AsgardSplineBuilder.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AsgardSplineBuilderTests
+{
+	/** Samples per segment of the brute force search. */
+	static const int32 NumBruteForceSamples = 64;
+
+	/** Queries made per segment, walking forward along the spline like FAsgardSplineBuilder::BuildCorrectedPoints. */
+	static const int32 NumQueriesPerSegment = 8;
+
+	/** A winding curve which keeps going forward on X, so the closest location to a query near the curve is unique. */
+	static void BuildWindingSpline(int32 NumPoints, FAsgardSplinePoints& OutPoints)
+	{
+		OutPoints.Reset(NumPoints);
+		for (int32 Idx = 0; Idx < NumPoints; Idx++)
+		{
+			const FVector Location(Idx * 100.0f, FMath::Sin(Idx * 0.3f) * 200.0f, FMath::Cos(Idx * 0.17f) * 100.0f);
+			OutPoints.Add(Location, FVector::ZeroVector, CIM_CurveAuto);
+		}
+		OutPoints.AutoSetTangents();
+	}
+
+	/** Closest location on the whole spline by sampling every segment. */
+	static FVector FindLocationClosestBruteForce(const FAsgardSplinePoints& Points, const FVector& Location)
+	{
+		FVector BestLocation = Points.Locations[0];
+		float BestDistSquared = BIG_NUMBER;
+		for (int32 SegmentIndex = 0; SegmentIndex < Points.NumSegments(); SegmentIndex++)
+		{
+			for (int32 Idx = 0; Idx <= NumBruteForceSamples; Idx++)
+			{
+				const FVector SampleLocation = Points.GetLocationOnSegment(SegmentIndex, float(Idx) / NumBruteForceSamples);
+				const float DistSquared = FVector::DistSquared(SampleLocation, Location);
+				if (DistSquared < BestDistSquared)
+				{
+					BestDistSquared = DistSquared;
+					BestLocation = SampleLocation;
+				}
+			}
+		}
+		return BestLocation;
+	}
+
+	/** Times forward searches against the brute force search and checks they find the same distance. */
+	static bool RunClosestForwardBenchmark(FAutomationTestBase& Test, int32 NumPoints)
+	{
+		FAsgardSplinePoints Points;
+		BuildWindingSpline(NumPoints, Points);
+
+		// Queries sit above the curve, as the offset spline sits beside the base spline
+		TArray<FVector> Queries;
+		Queries.Reserve(Points.NumSegments() * NumQueriesPerSegment);
+		for (int32 SegmentIndex = 0; SegmentIndex < Points.NumSegments(); SegmentIndex++)
+		{
+			for (int32 Idx = 0; Idx < NumQueriesPerSegment; Idx++)
+			{
+				Queries.Add(Points.GetLocationOnSegment(SegmentIndex, float(Idx) / NumQueriesPerSegment) + FVector(0.0f, 0.0f, 50.0f));
+			}
+		}
+
+		TArray<FVector> ForwardResults;
+		ForwardResults.Reserve(Queries.Num());
+		int32 Segment = 0;
+		float Alpha = 0.0f;
+		const double ForwardStart = FPlatformTime::Seconds();
+		for (const FVector& Query : Queries)
+		{
+			ForwardResults.Add(Points.FindLocationClosestForward(Query, Segment, Alpha));
+		}
+		const double ForwardTime = FPlatformTime::Seconds() - ForwardStart;
+
+		TArray<FVector> BruteForceResults;
+		BruteForceResults.Reserve(Queries.Num());
+		const double BruteForceStart = FPlatformTime::Seconds();
+		for (const FVector& Query : Queries)
+		{
+			BruteForceResults.Add(FindLocationClosestBruteForce(Points, Query));
+		}
+		const double BruteForceTime = FPlatformTime::Seconds() - BruteForceStart;
+
+		// The forward search refines the closest alpha, so it can only be closer than the sampled brute force result
+		int32 NumMisses = 0;
+		for (int32 Idx = 0; Idx < Queries.Num(); Idx++)
+		{
+			const float ForwardDist = FVector::Dist(ForwardResults[Idx], Queries[Idx]);
+			const float BruteForceDist = FVector::Dist(BruteForceResults[Idx], Queries[Idx]);
+			if (ForwardDist > BruteForceDist + 1.0f)
+			{
+				NumMisses++;
+			}
+		}
+
+		Test.AddInfo(FString::Printf(TEXT("%d points, %d queries: forward %.3fms (%.2fus per query), brute force %.3fms, %.1fx faster"),
+			NumPoints, Queries.Num(), ForwardTime * 1000.0, ForwardTime * 1000000.0 / Queries.Num(), BruteForceTime * 1000.0,
+			BruteForceTime / FMath::Max(ForwardTime, (double)SMALL_NUMBER)));
+
+		Test.TestEqual(TEXT("Forward search finds the closest location"), NumMisses, 0);
+		Test.TestEqual(TEXT("Forward search reaches the last segment"), Segment, Points.NumSegments() - 1);
+		return NumMisses == 0;
+	}
+}
+
+/**
+ * The forward search keeps going when the next segment heads away from the location and a later one comes back closer.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardSplineClosestForwardDetourTest, "Asgard.SplineBuilder.ClosestForward.Detour",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardSplineClosestForwardDetourTest::RunTest(const FString& Parameters)
+{
+	// Along X, then up and back down across the location
+	FAsgardSplinePoints Points;
+	Points.Add(FVector(0.0f, 0.0f, 0.0f), FVector::ZeroVector, CIM_Linear);
+	Points.Add(FVector(200.0f, 0.0f, 0.0f), FVector::ZeroVector, CIM_Linear);
+	Points.Add(FVector(200.0f, 500.0f, 0.0f), FVector::ZeroVector, CIM_Linear);
+	Points.Add(FVector(300.0f, 500.0f, 0.0f), FVector::ZeroVector, CIM_Linear);
+	Points.Add(FVector(300.0f, -100.0f, 0.0f), FVector::ZeroVector, CIM_Linear);
+	Points.Add(FVector(500.0f, -100.0f, 0.0f), FVector::ZeroVector, CIM_Linear);
+	Points.AutoSetTangents();
+
+	int32 Segment = 0;
+	float Alpha = 0.0f;
+	const FVector Closest = Points.FindLocationClosestForward(FVector(300.0f, 0.0f, 0.0f), Segment, Alpha);
+
+	TestEqual(TEXT("Closest segment"), Segment, 3);
+	TestTrue(TEXT("Closest location"), Closest.Equals(FVector(300.0f, 0.0f, 0.0f), KINDA_SMALL_NUMBER));
+	TestEqual(TEXT("Closest alpha"), Alpha, 500.0f / 600.0f, KINDA_SMALL_NUMBER);
+
+	// Never goes back from where the previous search ended
+	const FVector Behind = Points.FindLocationClosestForward(FVector(0.0f, 0.0f, 0.0f), Segment, Alpha);
+	TestTrue(TEXT("Stays forward"), Segment >= 3);
+	TestTrue(TEXT("Not the start of the spline"), !Behind.Equals(FVector::ZeroVector, 1.0f));
+
+	return true;
+}
+
+/**
+ * Forward searches along a 100 point spline, compared with a brute force search over every segment.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardSplineClosestForward100Test, "Asgard.SplineBuilder.ClosestForward.Benchmark100",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardSplineClosestForward100Test::RunTest(const FString& Parameters)
+{
+	return AsgardSplineBuilderTests::RunClosestForwardBenchmark(*this, 100);
+}
+
+/**
+ * Forward searches along a 1000 point spline, compared with a brute force search over every segment.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardSplineClosestForward1000Test, "Asgard.SplineBuilder.ClosestForward.Benchmark1000",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FAsgardSplineClosestForward1000Test::RunTest(const FString& Parameters)
+{
+	return AsgardSplineBuilderTests::RunClosestForwardBenchmark(*this, 1000);
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
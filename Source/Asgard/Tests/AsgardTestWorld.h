@@ -0,0 +1,32 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AsgardTests
+{
+	/** A game world with physics which has begun play, for tests which spawn actors. */
+	inline UWorld* CreateTestWorld()
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+		return World;
+	}
+
+	/** Destroys a world made by CreateTestWorld along with its world context. */
+	inline void DestroyTestWorld(UWorld* World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,102 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "Asgard/VRCharacter/AsgardVRPoseCache.h"
+#include "Asgard/Tests/AsgardTestWorld.h"
+#include "Misc/AutomationTest.h"
+#include "VRBaseCharacter.h"
+#include "ReplicatedVRCameraComponent.h"
+#include "GripMotionControllerComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Regenerates the offset component transform of a character without a transform update, the way the VR root and movement do,
+* and checks the VR pose follows it.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardVRPoseCacheOffsetTransformTest, "Asgard.VRPoseCache.OffsetTransform", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FAsgardVRPoseCacheOffsetTransformTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = AsgardTests::CreateTestWorld();
+	AVRBaseCharacter* Character = World->SpawnActor<AVRBaseCharacter>(FVector::ZeroVector, FRotator::ZeroRotator);
+	if (!TestNotNull(TEXT("Character"), Character))
+	{
+		AsgardTests::DestroyTestWorld(World);
+		return false;
+	}
+
+	UAsgardVRPoseCache* PoseCache = NewObject<UAsgardVRPoseCache>(Character);
+	PoseCache->RegisterComponent();
+
+	Character->OffsetComponentToWorld = FTransform(FRotator(0.0f, 0.0f, 0.0f), FVector(100.0f, 0.0f, 0.0f));
+	const FAsgardVRPoseFrame& Pose = PoseCache->GetPose(EAsgardVRPoseSource::VR);
+	TestTrue(TEXT("Initial location"), Pose.Location.Equals(FVector(100.0f, 0.0f, 0.0f)));
+	TestTrue(TEXT("Initial forward"), Pose.Forward.Equals(FVector::ForwardVector));
+
+	// Only the offset component transform changes, no transform update is broadcast
+	Character->OffsetComponentToWorld = FTransform(FRotator(0.0f, 90.0f, 0.0f), FVector(0.0f, 200.0f, 0.0f));
+	const FAsgardVRPoseFrame& MovedPose = PoseCache->GetPose(EAsgardVRPoseSource::VR);
+	TestTrue(TEXT("Regenerated location"), MovedPose.Location.Equals(FVector(0.0f, 200.0f, 0.0f)));
+	TestTrue(TEXT("Regenerated forward"), MovedPose.Forward.Equals(FVector::RightVector, KINDA_SMALL_NUMBER));
+	TestTrue(TEXT("Regenerated yaw"), FMath::IsNearlyEqual(MovedPose.YawRotation.Yaw, 90.0f, KINDA_SMALL_NUMBER));
+
+	// The null component is the VR pose as well
+	TestTrue(TEXT("Component pose location"), PoseCache->GetComponentPose(nullptr).Location.Equals(FVector(0.0f, 200.0f, 0.0f)));
+
+	PoseCache->DestroyComponent();
+	AsgardTests::DestroyTestWorld(World);
+	return true;
+}
+
+/**
+* Moves the camera and a controller both silently and through their transform updates,
+* a pose must be reused until its component broadcasts a transform update and recalculated right after.
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsgardVRPoseCacheTransformUpdatedTest, "Asgard.VRPoseCache.TransformUpdated", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FAsgardVRPoseCacheTransformUpdatedTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = AsgardTests::CreateTestWorld();
+	AVRBaseCharacter* Character = World->SpawnActor<AVRBaseCharacter>(FVector::ZeroVector, FRotator::ZeroRotator);
+	if (!TestNotNull(TEXT("Character"), Character) || !TestNotNull(TEXT("Camera"), Character->VRReplicatedCamera) || !TestNotNull(TEXT("Left controller"), Character->LeftMotionController))
+	{
+		AsgardTests::DestroyTestWorld(World);
+		return false;
+	}
+
+	UAsgardVRPoseCache* PoseCache = NewObject<UAsgardVRPoseCache>(Character);
+	PoseCache->RegisterComponent();
+
+	UReplicatedVRCameraComponent* Camera = Character->VRReplicatedCamera;
+	UGripMotionControllerComponent* LeftController = Character->LeftMotionController;
+
+	const FVector CameraLocation = PoseCache->GetPose(EAsgardVRPoseSource::Camera).Location;
+	const FVector ControllerLocation = PoseCache->GetHandPose(EAsgardBinaryHand::LeftHand).Location;
+
+	// Setting the component to world directly doesn't broadcast a transform update, so the cached poses have to be reused
+	Camera->SetComponentToWorld(FTransform(FRotator::ZeroRotator, CameraLocation + FVector(0.0f, 0.0f, 50.0f)));
+	LeftController->SetComponentToWorld(FTransform(FRotator::ZeroRotator, ControllerLocation + FVector(0.0f, 50.0f, 0.0f)));
+	TestTrue(TEXT("Camera pose reused"), PoseCache->GetPose(EAsgardVRPoseSource::Camera).Location.Equals(CameraLocation));
+	TestTrue(TEXT("Controller pose reused"), PoseCache->GetHandPose(EAsgardBinaryHand::LeftHand).Location.Equals(ControllerLocation));
+
+	// Moving the camera invalidates its pose and leaves the controller pose cached
+	Camera->SetWorldLocationAndRotation(FVector(10.0f, 20.0f, 170.0f), FRotator(0.0f, 90.0f, 0.0f));
+	const FAsgardVRPoseFrame& CameraPose = PoseCache->GetPose(EAsgardVRPoseSource::Camera);
+	TestTrue(TEXT("Moved camera location"), CameraPose.Location.Equals(FVector(10.0f, 20.0f, 170.0f)));
+	TestTrue(TEXT("Moved camera forward"), CameraPose.Forward.Equals(FVector::RightVector, KINDA_SMALL_NUMBER));
+	TestTrue(TEXT("Controller pose kept"), PoseCache->GetHandPose(EAsgardBinaryHand::LeftHand).Location.Equals(ControllerLocation));
+
+	// Moving the controller invalidates its pose
+	LeftController->SetWorldLocation(FVector(30.0f, -40.0f, 100.0f));
+	TestTrue(TEXT("Moved controller location"), PoseCache->GetHandPose(EAsgardBinaryHand::LeftHand).Location.Equals(FVector(30.0f, -40.0f, 100.0f)));
+	TestTrue(TEXT("Controller component pose"), PoseCache->GetComponentPose(LeftController).Location.Equals(FVector(30.0f, -40.0f, 100.0f)));
+
+	// Moving the root moves every source with it
+	Character->SetActorLocation(FVector(500.0f, 0.0f, 0.0f));
+	TestTrue(TEXT("Camera pose follows the root"), PoseCache->GetPose(EAsgardVRPoseSource::Camera).Location.Equals(Camera->GetComponentLocation()));
+	TestTrue(TEXT("Controller pose follows the root"), PoseCache->GetHandPose(EAsgardBinaryHand::LeftHand).Location.Equals(LeftController->GetComponentLocation()));
+
+	PoseCache->DestroyComponent();
+	AsgardTests::DestroyTestWorld(World);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -3,6 +3,7 @@
 
 #include "AsgardVRCharacter.h"
 #include "AsgardVRMovementComponent.h"
+#include "AsgardVRPoseCache.h"
 #include "Asgard/Core/AsgardInputBindings.h"
 #include "Asgard/Core/AsgardCollisionProfiles.h"
 #include "Asgard/Core/AsgardTraceChannels.h"
@@ -124,6 +125,9 @@ AAsgardVRCharacter::AAsgardVRCharacter(const FObjectInitializer& ObjectInitializ
 
 	// Collision profiles
 	GetCapsuleComponent()->SetCollisionProfileName(UAsgardCollisionProfiles::VRRoot());
+
+	// Pose cache
+	PoseCache = CreateDefaultSubobject<UAsgardVRPoseCache>(TEXT("PoseCache"));
 }
 
 void AAsgardVRCharacter::BeginPlay()
@@ -1353,8 +1357,9 @@ void AAsgardVRCharacter::UpdateSmoothFlight()
 				bShouldApplyInput = true;
 
 				// Get the forward and right Flight vectors
-				FVector FlightForward = SmoothFlightOrientationComponent->GetForwardVector();
-				FVector FlightRight = SmoothFlightOrientationComponent->GetRightVector();
+				const FAsgardVRPoseFrame& FlightPose = PoseCache->GetComponentPose(SmoothFlightOrientationComponent);
+				FVector FlightForward = FlightPose.Forward;
+				FVector FlightRight = FlightPose.Right;
 
 				// Scale the input vector by the forward, backward, and strafing multipliers
 				FlightInput *= FVector(FlightInput.X > 0.0f ? SmoothFlightInputForwardMultiplier : SmoothFlightInputBackwardMultiplier, SmoothFlightInputStrafeMultiplier, 0.0f);
@@ -1371,12 +1376,12 @@ void AAsgardVRCharacter::UpdateSmoothFlight()
 			if (bIsFlightThrusterLeftActive)
 			{
 				bShouldApplyInput = true;
-				FlightInput += LeftMotionController->GetForwardVector() * FlightControllerThrusterInputMultiplier;
+				FlightInput += PoseCache->GetPose(EAsgardVRPoseSource::LeftController).Forward * FlightControllerThrusterInputMultiplier;
 			}
 			if (bIsFlightThrusterRightActive)
 			{
 				bShouldApplyInput = true;
-				FlightInput += RightMotionController->GetForwardVector() * FlightControllerThrusterInputMultiplier;
+				FlightInput += PoseCache->GetPose(EAsgardVRPoseSource::RightController).Forward * FlightControllerThrusterInputMultiplier;
 			}
 		}
 
@@ -1611,18 +1616,22 @@ void AAsgardVRCharacter::UpdatePrecisionTeleport(float DeltaSeconds)
 {
 	if (CanTeleport())
 	{
+		// Get the pose of the orientation component, and whether it is pitched up too high
+		const FAsgardVRPoseFrame& OrientationPose = PoseCache->GetComponentPose(PrecisionTeleportOrientationComponent);
+		bool bIsPitchTooHigh = PrecisionTeleportTraceDirectionMaxPitch < 90.0f
+			&& OrientationPose.Forward.Z > FMath::Sin(FMath::DegreesToRadians(PrecisionTeleportTraceDirectionMaxPitch));
+
 		// Updating trace direction
 		// If interpolated
 		if (PrecisionTeleportTraceDirectionMaxErrorAngle > 0.0f && PrecisionTeleportTraceDirectionAngleLerpSpeed > 0.0f)
 		{
-			FVector NewPrecisionTeleportDirection = PrecisionTeleportOrientationComponent->GetForwardVector();
+			FVector NewPrecisionTeleportDirection = OrientationPose.Forward;
 
 			// If the pitch angle is high...
-			if (PrecisionTeleportTraceDirectionMaxPitch < 90.0f
-				&& FMath::RadiansToDegrees(FMath::Acos(FVector::DotProduct(NewPrecisionTeleportDirection, FVector::UpVector))) < 90.0f - PrecisionTeleportTraceDirectionMaxPitch)
+			if (bIsPitchTooHigh)
 			{
 				// Make a new vector from the yaw and a fixed pitch
-				NewPrecisionTeleportDirection = UKismetMathLibrary::CreateVectorFromYawPitch(FMath::RadiansToDegrees(FMath::Atan2(NewPrecisionTeleportDirection.Y, NewPrecisionTeleportDirection.X)), PrecisionTeleportTraceDirectionMaxPitch);
+				NewPrecisionTeleportDirection = UKismetMathLibrary::CreateVectorFromYawPitch(OrientationPose.Rotation.Yaw, PrecisionTeleportTraceDirectionMaxPitch);
 			}
 
 			// Calculate the angular difference from the last trace direction
@@ -1652,20 +1661,19 @@ void AAsgardVRCharacter::UpdatePrecisionTeleport(float DeltaSeconds)
 		// Else if instant
 		else
 		{
-			PrecisionTeleportTraceDirection = PrecisionTeleportOrientationComponent->GetForwardVector();
+			PrecisionTeleportTraceDirection = OrientationPose.Forward;
 
 			// If the pitch angle is high...
-			if (PrecisionTeleportTraceDirectionMaxPitch < 90.0f
-				&& FMath::RadiansToDegrees(FMath::Acos(FVector::DotProduct(PrecisionTeleportTraceDirection, FVector::UpVector))) < 90.0f - PrecisionTeleportTraceDirectionMaxPitch)
+			if (bIsPitchTooHigh)
 			{
 					// Make a new vector from the yaw and a fixed pitch
-					PrecisionTeleportTraceDirection = UKismetMathLibrary::CreateVectorFromYawPitch(FMath::RadiansToDegrees(FMath::Atan2(PrecisionTeleportTraceDirection.Y, PrecisionTeleportTraceDirection.X)), PrecisionTeleportTraceDirectionMaxPitch);
+					PrecisionTeleportTraceDirection = UKismetMathLibrary::CreateVectorFromYawPitch(OrientationPose.Rotation.Yaw, PrecisionTeleportTraceDirectionMaxPitch);
 			}
 		}
 
 		// Perform the teleport trace
 		bIsPrecisionTeleportLocationValid = TraceForTeleportLocation(
-			PrecisionTeleportOrientationComponent->GetComponentLocation(),
+			OrientationPose.Location,
 			PrecisionTeleportTraceDirection * PrecisionTeleportTraceMagnitude,
 			bPrecisionTeleportLocationRequiresNavmeshPath,
 			PrecisionTeleportTraceChannel,
@@ -1684,30 +1692,23 @@ void AAsgardVRCharacter::UpdatePrecisionTeleport(float DeltaSeconds)
 bool AAsgardVRCharacter::CalculateOrientedFlattenedDirectionalVectors(FVector& OutForward, FVector& OutRight, USceneComponent* OrientationComponent, float MaxAbsPitch) const
 {
 	// If no orientation component, get the VR right and forward vectors
+	const FAsgardVRPoseFrame& OrientationPose = PoseCache->GetComponentPose(OrientationComponent);
 	if (!OrientationComponent)
 	{
-		OutForward = GetVRForwardVector();
-		OutRight = GetVRRightVector();
+		OutForward = OrientationPose.Forward;
+		OutRight = OrientationPose.Right;
 		return true;
 	}
 
-	// Otherwise, get the vectors from the orientation component
-	FVector Forward = WalkOrientationComponent->GetForwardVector();
-
 	// Guard against the forward vector being nearly up or down
-	if (MaxAbsPitch < 90.0f
-		&& FMath::Abs(FVector::DotProduct(Forward, FVector::UpVector)) > FMath::Sin(FMath::DegreesToRadians(WalkForwardMaxAbsPitch)))
+	if (!OrientationPose.IsForwardWithinPitch(MaxAbsPitch))
 	{
 		return false;
 	}
 
-	// Flatten the forward vector
-	Forward.Z = 0.0f;
-	Forward = Forward.GetSafeNormal();
-	OutForward = Forward;
-
-	// Calculcate right vector
-	OutRight = FVector::CrossProduct(FVector::UpVector, Forward);
+	// Otherwise, get the flattened vectors from the orientation component
+	OutForward = OrientationPose.FlattenedForward;
+	OutRight = OrientationPose.FlattenedRight;
 
 	return true;
 }
@@ -1715,7 +1716,7 @@ bool AAsgardVRCharacter::CalculateOrientedFlattenedDirectionalVectors(FVector& O
 void AAsgardVRCharacter::StartPrecisionTeleport()
 {
 	bIsPrecisionTeleportLocationValid = false;
-	PrecisionTeleportTraceDirection = PrecisionTeleportOrientationComponent->GetForwardVector();
+	PrecisionTeleportTraceDirection = PoseCache->GetComponentPose(PrecisionTeleportOrientationComponent).Forward;
 	bIsPrecisionTeleportActive = true;
 	
 	return;
@@ -43,6 +43,7 @@ enum class EAsgard2DAxis : uint8
 
 // Forward declarations
 class UAsgardVRMovementComponent;
+class UAsgardVRPoseCache;
 
 
 /** Base class for the player avatar. */
@@ -466,6 +467,10 @@ protected:
 	UPROPERTY(Category = AsgardVRCharacter, VisibleAnywhere, Transient, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	UAsgardVRMovementComponent* AsgardVRMovementRef;
 
+	/** Caches the poses of the camera and controllers used to orient movement. */
+	UPROPERTY(Category = AsgardVRCharacter, VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	UAsgardVRPoseCache* PoseCache;
+
 	/** Whether the character can currently teleport. */
 	UFUNCTION(BlueprintNativeEvent, Category = AsgardVRCharacter)
 	bool CanTeleport();
@@ -0,0 +1,206 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#include "AsgardVRPoseCache.h"
+#include "VRBaseCharacter.h"
+
+// Stat cycles
+DECLARE_CYCLE_STAT(TEXT("AsgardVRPoseCache CalculatePose"), STAT_ASGARD_VRPoseCacheCalculatePose, STATGROUP_ASGARD_VRPoseCache);
+
+// Stat counters
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardVRPoseCache Poses Calculated"), STAT_ASGARD_VRPoseCachePosesCalculated, STATGROUP_ASGARD_VRPoseCache);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AsgardVRPoseCache Poses Reused"), STAT_ASGARD_VRPoseCachePosesReused, STATGROUP_ASGARD_VRPoseCache);
+
+bool FAsgardVRPoseFrame::IsForwardWithinPitch(float MaxAbsPitch) const
+{
+	return MaxAbsPitch >= 90.0f || FMath::Abs(Forward.Z) <= FMath::Sin(FMath::DegreesToRadians(MaxAbsPitch));
+}
+
+// Sets default values for this component's properties
+UAsgardVRPoseCache::UAsgardVRPoseCache()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	OwningCharacter = nullptr;
+	InvalidatePoses();
+}
+
+void UAsgardVRPoseCache::OnRegister()
+{
+	Super::OnRegister();
+	OwningCharacter = Cast<AVRBaseCharacter>(GetOwner());
+	BindSources();
+}
+
+void UAsgardVRPoseCache::OnUnregister()
+{
+	UnbindSources();
+	Super::OnUnregister();
+}
+
+const FAsgardVRPoseFrame& UAsgardVRPoseCache::GetPose(EAsgardVRPoseSource Source)
+{
+	checkf(Source != EAsgardVRPoseSource::Max, TEXT("GetPose failed! Source was Max."));
+	const int32 Index = (int32)Source;
+	FAsgardVRPoseFrame& Pose = Poses[Index];
+
+	checkf(OwningCharacter != nullptr, TEXT("GetPose failed! OwningCharacter was null."));
+
+	// The offset component transform is regenerated without a transform update, so the VR pose is also compared against it
+	if (bPoseValid[Index] && (Source != EAsgardVRPoseSource::VR || VRPoseTransform.Equals(OwningCharacter->OffsetComponentToWorld, 0.0f)))
+	{
+		INC_DWORD_STAT(STAT_ASGARD_VRPoseCachePosesReused);
+		return Pose;
+	}
+
+	if (Source == EAsgardVRPoseSource::VR)
+	{
+		VRPoseTransform = OwningCharacter->OffsetComponentToWorld;
+		CalculatePose(VRPoseTransform, Pose);
+	}
+	else if (USceneComponent* SourceComponent = GetSourceComponent(Source))
+	{
+		CalculatePose(SourceComponent->GetComponentTransform(), Pose);
+	}
+	else
+	{
+		CalculatePose(FTransform::Identity, Pose);
+	}
+	bPoseValid[Index] = true;
+
+	return Pose;
+}
+
+const FAsgardVRPoseFrame& UAsgardVRPoseCache::GetHandPose(EAsgardBinaryHand Hand)
+{
+	return GetPose(Hand == EAsgardBinaryHand::LeftHand ? EAsgardVRPoseSource::LeftController : EAsgardVRPoseSource::RightController);
+}
+
+const FAsgardVRPoseFrame& UAsgardVRPoseCache::GetComponentPose(const USceneComponent* Component)
+{
+	if (!Component)
+	{
+		return GetPose(EAsgardVRPoseSource::VR);
+	}
+
+	for (int32 Index = (int32)EAsgardVRPoseSource::Camera; Index < (int32)EAsgardVRPoseSource::Max; Index++)
+	{
+		if (Component == GetSourceComponent((EAsgardVRPoseSource)Index))
+		{
+			return GetPose((EAsgardVRPoseSource)Index);
+		}
+	}
+
+	CalculatePose(Component->GetComponentTransform(), UncachedPose);
+	return UncachedPose;
+}
+
+void UAsgardVRPoseCache::InvalidatePoses()
+{
+	for (bool& bValid : bPoseValid)
+	{
+		bValid = false;
+	}
+}
+
+void UAsgardVRPoseCache::BindSources()
+{
+	UnbindSources();
+	if (!OwningCharacter)
+	{
+		return;
+	}
+
+	// The VR pose follows both the root and the camera, and the controllers are attached to the root
+	USceneComponent* Sources[] = {
+		OwningCharacter->GetRootComponent(),
+		OwningCharacter->VRReplicatedCamera,
+		OwningCharacter->LeftMotionController,
+		OwningCharacter->RightMotionController };
+	for (USceneComponent* Source : Sources)
+	{
+		if (Source)
+		{
+			Source->TransformUpdated.AddUObject(this, &UAsgardVRPoseCache::OnSourceTransformUpdated);
+			BoundSources.Add(Source);
+		}
+	}
+
+	InvalidatePoses();
+}
+
+void UAsgardVRPoseCache::UnbindSources()
+{
+	for (TWeakObjectPtr<USceneComponent>& Source : BoundSources)
+	{
+		if (Source.IsValid())
+		{
+			Source->TransformUpdated.RemoveAll(this);
+		}
+	}
+	BoundSources.Reset();
+}
+
+void UAsgardVRPoseCache::OnSourceTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	// A moving root moves every source with it
+	if (OwningCharacter && UpdatedComponent == OwningCharacter->GetRootComponent())
+	{
+		InvalidatePoses();
+		return;
+	}
+
+	// The VR pose follows the camera
+	bPoseValid[(int32)EAsgardVRPoseSource::VR] = false;
+	for (int32 Index = (int32)EAsgardVRPoseSource::Camera; Index < (int32)EAsgardVRPoseSource::Max; Index++)
+	{
+		if (UpdatedComponent == GetSourceComponent((EAsgardVRPoseSource)Index))
+		{
+			bPoseValid[Index] = false;
+		}
+	}
+}
+
+USceneComponent* UAsgardVRPoseCache::GetSourceComponent(EAsgardVRPoseSource Source) const
+{
+	if (!OwningCharacter)
+	{
+		return nullptr;
+	}
+
+	switch (Source)
+	{
+		case EAsgardVRPoseSource::Camera:
+		{
+			return OwningCharacter->VRReplicatedCamera;
+		}
+		case EAsgardVRPoseSource::LeftController:
+		{
+			return OwningCharacter->LeftMotionController;
+		}
+		case EAsgardVRPoseSource::RightController:
+		{
+			return OwningCharacter->RightMotionController;
+		}
+		default:
+		{
+			return nullptr;
+		}
+	}
+}
+
+void UAsgardVRPoseCache::CalculatePose(const FTransform& Transform, FAsgardVRPoseFrame& OutPose)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ASGARD_VRPoseCacheCalculatePose);
+	INC_DWORD_STAT(STAT_ASGARD_VRPoseCachePosesCalculated);
+
+	const FQuat Rotation = Transform.GetRotation();
+	OutPose.Location = Transform.GetLocation();
+	OutPose.Rotation = Rotation.Rotator();
+	OutPose.Forward = Rotation.GetForwardVector();
+	OutPose.Right = Rotation.GetRightVector();
+	OutPose.Up = Rotation.GetUpVector();
+
+	// Flatten the forward vector and calculate the matching right vector
+	OutPose.FlattenedForward = FVector(OutPose.Forward.X, OutPose.Forward.Y, 0.0f).GetSafeNormal();
+	OutPose.FlattenedRight = FVector::CrossProduct(FVector::UpVector, OutPose.FlattenedForward);
+	OutPose.YawRotation = FRotator(0.0f, OutPose.Rotation.Yaw, 0.0f);
+}
@@ -0,0 +1,112 @@
+﻿// Copyright © 2020 Justin Camden All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Asgard/Core/AsgardOptionsTypes.h"
+#include "AsgardVRPoseCache.generated.h"
+
+// Stats group
+DECLARE_STATS_GROUP(TEXT("AsgardVRPoseCache"), STATGROUP_ASGARD_VRPoseCache, STATCAT_Advanced);
+
+// Forward declarations
+class AVRBaseCharacter;
+
+/** The poses which can be cached. */
+enum class EAsgardVRPoseSource : uint8
+{
+	/** The HMD offset capsule of the character. */
+	VR,
+	Camera,
+	LeftController,
+	RightController,
+	Max
+};
+
+/** A pose and the directional vectors derived from it. */
+struct FAsgardVRPoseFrame
+{
+	FVector Location;
+	FRotator Rotation;
+	FVector Forward;
+	FVector Right;
+	FVector Up;
+
+	/** The forward vector flattened onto the X and Y axis. Zero if the forward points straight up or down. */
+	FVector FlattenedForward;
+
+	/** The right vector matching FlattenedForward. */
+	FVector FlattenedRight;
+
+	/** The rotation with only its yaw. */
+	FRotator YawRotation;
+
+	/** Returns whether the forward vector is no more than MaxAbsPitch degrees above or below the horizon. */
+	bool IsForwardWithinPitch(float MaxAbsPitch) const;
+};
+
+/**
+* Caches the poses of the VR camera, the motion controllers and the character,
+* so the directional vectors derived from them are only calculated once per transform update.
+* A pose is invalidated whenever the component it comes from moves.
+* The VR pose is regenerated by the VR root and movement without a transform update,
+* so it is instead validated against the transform it was calculated from.
+*/
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class ASGARD_API UAsgardVRPoseCache : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:	
+	// Sets default values for this component's properties
+	UAsgardVRPoseCache();
+
+	virtual void OnRegister() override;
+
+	virtual void OnUnregister() override;
+
+	/** Returns the pose of a source, calculating it if its source moved since it was last requested. */
+	const FAsgardVRPoseFrame& GetPose(EAsgardVRPoseSource Source);
+
+	/** Returns the pose of the controller in a hand. */
+	const FAsgardVRPoseFrame& GetHandPose(EAsgardBinaryHand Hand);
+
+	/**
+	* Returns the pose of a component.
+	* Null returns the VR pose, and components which aren't a cached source are calculated every call.
+	*/
+	const FAsgardVRPoseFrame& GetComponentPose(const USceneComponent* Component);
+
+	/** Invalidates every pose, for when the owner was moved without a transform update. */
+	void InvalidatePoses();
+
+private:
+	/** Binds to the transform updates of the owner's camera, controllers and root. */
+	void BindSources();
+
+	/** Unbinds from the transform updates of the bound sources. */
+	void UnbindSources();
+
+	void OnSourceTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	/** Returns the component a pose comes from, or null for the VR pose. */
+	USceneComponent* GetSourceComponent(EAsgardVRPoseSource Source) const;
+
+	static void CalculatePose(const FTransform& Transform, FAsgardVRPoseFrame& OutPose);
+
+	UPROPERTY(Transient)
+	AVRBaseCharacter* OwningCharacter;
+
+	/** Components whose transform updates are bound. */
+	TArray<TWeakObjectPtr<USceneComponent>> BoundSources;
+
+	FAsgardVRPoseFrame Poses[(int32)EAsgardVRPoseSource::Max];
+	bool bPoseValid[(int32)EAsgardVRPoseSource::Max];
+
+	/** The offset component transform the VR pose was calculated from. */
+	FTransform VRPoseTransform;
+
+	/** Pose of a component which isn't a cached source. */
+	FAsgardVRPoseFrame UncachedPose;
+};